@@ -24,6 +24,8 @@
 #include "./nmt/Config.h"
 #include "./nmt/train/Trainer.h"
 #include "./nmt/translate/Translator.h"
+#include "./nmt/translate/Server.h"
+#include "./niutensor/tensor/test/Benchmark.h"
 
 using namespace nmt;
 
@@ -42,8 +44,19 @@ int main(int argc, const char** argv)
 
     srand(config.common.seed);
 
+    /* create the thread pool for the CPU operations */
+    if (config.common.devID < 0 && config.common.nthread > 1) {
+        globalPRunner = new XPRunner();
+        globalPRunner->Init(MIN(config.common.nthread, MAX_THREAD_NUM), config.common.pinCore);
+    }
+
+    /* micro-benchmarks of the tensor operators */
+    if (config.common.benchmark) {
+        Benchmark(argc, argv);
+    }
+
     /* training */
-    if (strcmp(config.training.trainFN, "") != 0) {
+    else if (strcmp(config.training.trainFN, "") != 0) {
 
         NMTModel model;
         model.InitModel(config);
@@ -53,6 +66,21 @@ int main(int argc, const char** argv)
         trainer.Run();
     }
 
+    /* translation server */
+    else if (config.translation.serve || config.translation.port > 0) {
+
+        /* disable gradient flow */
+        DISABLE_GRAD;
+
+        NMTModel model;
+        model.InitModel(config);
+        model.SetTrainingFlag(false);
+
+        TranslationServer server;
+        server.Init(config, model);
+        server.Run();
+    }
+
     /* translation */
     else if (strcmp(config.translation.inputFN, "") != 0) {
 
@@ -73,8 +101,13 @@ int main(int argc, const char** argv)
         fprintf(stderr, "neural machine translation system. \n\n");
         fprintf(stderr, "   Run this program with \"-train\" for training!\n");
         fprintf(stderr, "Or run this program with \"-input\" for translation!\n");
+        fprintf(stderr, "Or run this program with \"-serve\" or \"-port\" for a translation server!\n");
+        fprintf(stderr, "Or run this program with \"-benchmark true\" for the benchmarks of the tensor operators!\n");
     }
 
+    delete globalPRunner;
+    globalPRunner = NULL;
+
     LOG("Duration of main: %f", (std::clock() - mainStart) / (double)CLOCKS_PER_SEC);
 
     return 0;
@@ -63,6 +63,20 @@ void XLossGrad::MakeGrad(XTensor * node, bool isEfficient)
 
         gold = income.tails[1];
 
+        /* the gold standard is given by the label indices, and the
+           gradient of the logits is computed in a single step */
+        if (operID == LOSS_CROSSENTROPY_SPARSE) {
+            if (income.tailNum == 3)
+                padding = income.tails[2];
+            delete dedy;
+            output->grad = NewTensor(output);
+            _CrossEntropySparseBackward(output->grad, output, gold, padding, income.GetParam(0));
+
+            node->visitMark = NODE_FINISHED;
+            node->isGradFinished = true;
+            return;
+        }
+
         /* gold's data address is shared with dedy */
         output->grad->data = gold->data;
 
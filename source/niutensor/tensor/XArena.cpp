@@ -0,0 +1,269 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ *
+ */
+
+#include <string.h>
+#include "XArena.h"
+#include "XGlobal.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* constructor */
+XArena::XArena()
+{
+    chunkSize = ARENA_CHUNK_SIZE;
+    allocNum = 0;
+    releaseNum = 0;
+    resetNum = 0;
+    usedSize = 0;
+    peakSize = 0;
+    reservedSize = 0;
+    curChunk = 0;
+    memset(freeLists, 0, sizeof(freeLists));
+}
+
+/* de-constructor */
+XArena::~XArena()
+{
+    Free();
+}
+
+/*
+initialize the arena
+>> myChunkSize - the minimal size of a chunk
+*/
+void XArena::Init(MTYPE myChunkSize)
+{
+    Free();
+
+    chunkSize = myChunkSize > 0 ? myChunkSize : ARENA_CHUNK_SIZE;
+    allocNum = 0;
+    releaseNum = 0;
+    resetNum = 0;
+    peakSize = 0;
+}
+
+/*
+allocate a piece of memory. The piece of the last release of the same
+size class is reused if there is one.
+>> size - size of the required memory
+<< return - the piece (aligned to ARENA_ALIGNMENT bytes)
+*/
+void * XArena::Alloc(MTYPE size)
+{
+    int c = GetClass(size);
+    MTYPE classSize = GetClassSize(c);
+    void * p = freeLists[c];
+
+    if (p != NULL)
+        freeLists[c] = *(void**)p;
+    else
+        p = Cut(classSize);
+
+    allocNum++;
+    usedSize += classSize;
+    if (usedSize > peakSize)
+        peakSize = usedSize;
+
+    return p;
+}
+
+/*
+release a piece of memory (it goes to the free list of its size class)
+>> p - the piece
+>> size - size of the piece (as in the allocation)
+*/
+void XArena::Release(void * p, MTYPE size)
+{
+    if (p == NULL)
+        return;
+
+    int c = GetClass(size);
+
+    *(void**)p = freeLists[c];
+    freeLists[c] = p;
+
+    releaseNum++;
+    usedSize -= GetClassSize(c);
+}
+
+/*
+allocate a piece of memory in the buffer
+>> size - size of the required memory
+<< return - the piece
+*/
+void * XArena::AllocBuf(MTYPE size)
+{
+    void * p = Alloc(size);
+    bufStack.push_back(p);
+    return p;
+}
+
+/*
+release the last piece of memory in the buffer
+>> size - size of the piece (as in the allocation)
+*/
+void XArena::ReleaseBuf(MTYPE size)
+{
+    CheckNTErrors(!bufStack.empty(), "No piece of memory in the buffer!");
+
+    void * p = bufStack.back();
+    bufStack.pop_back();
+    Release(p, size);
+}
+
+/*
+free all the pieces at once. The chunks are kept for the next use, and
+they are merged into one if there are more than one.
+*/
+void XArena::Reset()
+{
+    if (chunks.size() > 1) {
+        MTYPE size = reservedSize;
+        Free();
+        AddChunk(size);
+    }
+    else if (chunks.size() == 1) {
+        chunks[0].used = 0;
+    }
+
+    curChunk = 0;
+    memset(freeLists, 0, sizeof(freeLists));
+    bufStack.clear();
+    usedSize = 0;
+    resetNum++;
+}
+
+/* free the chunks */
+void XArena::Free()
+{
+    for (size_t i = 0; i < chunks.size(); i++)
+        delete[] chunks[i].mem;
+    chunks.clear();
+
+    curChunk = 0;
+    memset(freeLists, 0, sizeof(freeLists));
+    bufStack.clear();
+    usedSize = 0;
+    reservedSize = 0;
+}
+
+/*
+show the statistics
+>> file - where to print
+*/
+void XArena::ShowUsage(FILE * file)
+{
+    fprintf(file, "arena mem:%.1fMB used:%.1fMB peak:%.1fMB alloc:%llu release:%llu reset:%llu\n",
+            (DTYPE)reservedSize / MILLION, (DTYPE)usedSize / MILLION, (DTYPE)peakSize / MILLION,
+            allocNum, releaseNum, resetNum);
+}
+
+/*
+get the size class of a request. The sizes up to 256 bytes are rounded up
+to multiples of 64 bytes (classes 0-3), and each power of two above is
+split into four classes.
+>> size - size of the request
+<< return - the size class
+*/
+int XArena::GetClass(MTYPE size)
+{
+    if (size <= 256)
+        return size == 0 ? 0 : (int)((size + 63) / 64) - 1;
+
+    MTYPE v = size - 1;
+    int msb = 0;
+    while ((v >> msb) > 1)
+        msb++;
+
+    MTYPE base = (MTYPE)1 << msb;
+    int sub = (int)((v - base) / (base >> 2));
+
+    return 4 + (msb - 8) * 4 + sub;
+}
+
+/*
+get the size of a class
+>> c - the size class
+<< return - the largest request of the class
+*/
+MTYPE XArena::GetClassSize(int c)
+{
+    if (c < 4)
+        return (MTYPE)(c + 1) * 64;
+
+    int msb = 8 + (c - 4) / 4;
+    int sub = (c - 4) % 4;
+    MTYPE base = (MTYPE)1 << msb;
+
+    return base + (MTYPE)(sub + 1) * (base >> 2);
+}
+
+/*
+cut a piece from the chunks. A new chunk is added if the piece does not
+fit the rest of the chunks, and it is at least as large as all the chunks
+before, so that the arena needs few chunks.
+>> size - size of the piece (a multiple of ARENA_ALIGNMENT)
+<< return - the piece
+*/
+void * XArena::Cut(MTYPE size)
+{
+    for (int i = curChunk; i < (int)chunks.size(); i++) {
+        XArenaChunk & chunk = chunks[i];
+        if (chunk.size - chunk.used >= size) {
+            void * p = chunk.base + chunk.used;
+            chunk.used += size;
+            curChunk = i;
+            return p;
+        }
+    }
+
+    AddChunk(MAX(MAX(chunkSize, size), reservedSize));
+
+    XArenaChunk & chunk = chunks.back();
+    chunk.used = size;
+    curChunk = (int)chunks.size() - 1;
+
+    return chunk.base;
+}
+
+/*
+add a new chunk
+>> size - size of the chunk
+*/
+void XArena::AddChunk(MTYPE size)
+{
+    XArenaChunk chunk;
+    chunk.mem = new char[size + ARENA_ALIGNMENT];
+    CheckNTErrors(chunk.mem != NULL, "Cannot allocate the memory of the arena!");
+
+    MTYPE offset = (MTYPE)chunk.mem % ARENA_ALIGNMENT;
+    chunk.base = chunk.mem + (offset > 0 ? ARENA_ALIGNMENT - offset : 0);
+    chunk.size = size;
+    chunk.used = 0;
+
+    chunks.push_back(chunk);
+    reservedSize += size;
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
@@ -0,0 +1,152 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A size-class arena for the memory on CPUs. A request is rounded up to a
+ * size class (four classes for each power of two), and a released piece is
+ * kept in the free list of its class for the next request of the same
+ * class. New pieces are cut from large chunks in a bump-pointer manner.
+ * The arena is used by a single thread, so it has no lock, and all the
+ * pieces can be freed at once (e.g., at the end of a decoding step).
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ *
+ */
+
+#ifndef __XARENA_H__
+#define __XARENA_H__
+
+#include <stdio.h>
+#include <vector>
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+typedef unsigned long long MTYPE;
+
+/* alignment of the pieces (in bytes) */
+#define ARENA_ALIGNMENT 64
+
+/* number of size classes */
+#define ARENA_CLASS_NUM 232
+
+/* the default size of a chunk */
+#define ARENA_CHUNK_SIZE 16 * 1024 * 1024
+
+/* a chunk of the arena */
+struct XArenaChunk
+{
+    /* the memory that is allocated from the system */
+    char * mem;
+
+    /* the beginning of the chunk (aligned) */
+    char * base;
+
+    /* size of the chunk */
+    MTYPE size;
+
+    /* size of the used memory in this chunk */
+    MTYPE used;
+};
+
+/* the size-class arena */
+class XArena
+{
+public:
+    /* the minimal size of a chunk */
+    MTYPE chunkSize;
+
+    /* number of allocations */
+    MTYPE allocNum;
+
+    /* number of releases */
+    MTYPE releaseNum;
+
+    /* number of times that the arena is reset */
+    MTYPE resetNum;
+
+    /* size of the memory in use */
+    MTYPE usedSize;
+
+    /* peak size of the memory in use */
+    MTYPE peakSize;
+
+    /* size of the chunks */
+    MTYPE reservedSize;
+
+private:
+    /* the chunks */
+    std::vector<XArenaChunk> chunks;
+
+    /* id of the chunk that new pieces are cut from */
+    int curChunk;
+
+    /* free lists of the size classes (the next piece is kept in the first bytes of a piece) */
+    void * freeLists[ARENA_CLASS_NUM];
+
+    /* the pieces of the buffer (allocated and released in a stack manner) */
+    std::vector<void*> bufStack;
+
+public:
+    /* constructor */
+    XArena();
+
+    /* de-constructor */
+    ~XArena();
+
+    /* initialize the arena */
+    void Init(MTYPE myChunkSize);
+
+    /* allocate a piece of memory */
+    void * Alloc(MTYPE size);
+
+    /* release a piece of memory */
+    void Release(void * p, MTYPE size);
+
+    /* allocate a piece of memory in the buffer */
+    void * AllocBuf(MTYPE size);
+
+    /* release the last piece of memory in the buffer */
+    void ReleaseBuf(MTYPE size);
+
+    /* free all the pieces at once */
+    void Reset();
+
+    /* free the chunks */
+    void Free();
+
+    /* show the statistics */
+    void ShowUsage(FILE * file);
+
+    /* get the size class of a request */
+    static int GetClass(MTYPE size);
+
+    /* get the size of a class */
+    static MTYPE GetClassSize(int c);
+
+private:
+    /* cut a piece from the chunks */
+    void * Cut(MTYPE size);
+
+    /* add a new chunk */
+    void AddChunk(MTYPE size);
+};
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
@@ -27,6 +27,7 @@
 #include "XGlobal.h"
 #include "XUtility.h"
 #include "XMem.h"
+#include "XArena.h"
 
 /* the nts (NiuTrans.Tensor) namespace */
 namespace nts{
@@ -41,6 +42,9 @@ XMemManager GMems;
 
 XMem * GMem;
 
+/* the memory pool that the current thread uses on CPUs (NULL for the shared one) */
+static thread_local XMem * threadCPUMem = NULL;
+
 /* constructor */
 XMem::XMem()
 {
@@ -66,6 +70,7 @@ constructor
 >> myMode - mode of running the memory pool
             UNI_FREE: free all the space at the end of using the memory pool
             FREE_ON_THE_FLY: normal "malloc" and "free" mode
+            SIZE_CLASS: size-class free lists for a single thread
 >> myBlockSize - size of a memory block
 >> myBlockNum  - number of memory blocks
 >> myBufSize - size of buffer
@@ -115,6 +120,7 @@ initialize it
 >> myMode - mode of running the memory pool
             UNI_FREE: free all the space at the end of using the memory pool
             FREE_ON_THE_FLY: normal "malloc" and "free" mode
+            SIZE_CLASS: size-class free lists for a single thread
 >> myBlockSize - size of a memory block
 >> myBlockNum  - number of memory blocks
 >> myBufSize - size of buffer
@@ -142,7 +148,15 @@ void XMem::Initialize(int myDevID, MEMPOOL_MODE myMode, MTYPE myBlockSize, int m
     curBlockID = 0;
     finalBlockID = 0;
 
-    if(myDevID < 0){
+    if(myMode == SIZE_CLASS){
+        /* the pieces (and the buffer) are in the chunks of the arena, and
+           the size of a block is the size of a chunk */
+        CheckNTErrors(myDevID < 0, "The size-class mode is only for CPUs!");
+        arena = new XArena();
+        arena->Init(myBlockSize);
+        myBufSize = 0;
+    }
+    else if(myDevID < 0){
         buf = new char[(unsigned int)myBufSize];
     }
     else{
@@ -194,6 +208,9 @@ void XMem::Free()
     bufSize = 0;
     bufUsed = 0;
 
+    delete arena;
+    arena = NULL;
+
     devID = -1;
 }
 
@@ -385,6 +402,10 @@ require a piece of memory
 */
 void * XMem::Alloc(int myDevID, MTYPE mySize)
 {
+    /* the arena is used by one thread, so there is no lock */
+    if(mode == SIZE_CLASS)
+        return arena->Alloc(mySize);
+
     void * p = NULL;
 
     MUTEX_LOCK(allocMutex);
@@ -531,6 +552,14 @@ require a piece of memory in the buffer
 */
 void * XMem::AllocBuf(int myDevID, MTYPE mySize, int pitch)
 {
+    if(mode == SIZE_CLASS)
+        return arena->AllocBuf(mySize);
+
+    /* the buffer of the shared pool is replaced by that of the thread */
+    XMem * threadMem = GMems.GetThreadMem(this);
+    if(threadMem != this)
+        return threadMem->AllocBuf(myDevID, mySize, pitch);
+
     MTYPE backOffset = 0;
 
     /* NOTE THAT this is tricky because we lock the buffer
@@ -577,6 +606,11 @@ release a piece of memory
 */
 void XMem::Release(int myDevID, void * p, MTYPE size)
 {
+    if(mode == SIZE_CLASS){
+        arena->Release(p, size);
+        return;
+    }
+
     MUTEX_LOCK(allocMutex);
     if(mode == FREE_ON_THE_FLY)
         ReleaseStandard(myDevID, p, size);
@@ -591,6 +625,17 @@ release a piece of memory in the buffer
 */
 void XMem::ReleaseBuf(int myDevID, MTYPE mySize, int pitch)
 {
+    if(mode == SIZE_CLASS){
+        arena->ReleaseBuf(mySize);
+        return;
+    }
+
+    XMem * threadMem = GMems.GetThreadMem(this);
+    if(threadMem != this){
+        threadMem->ReleaseBuf(myDevID, mySize, pitch);
+        return;
+    }
+
     CheckNTErrors((bufUsed >= mySize), 
                   "Cannot allocate the memory. Please specify a larger buffer in XMem!");
 
@@ -1295,6 +1340,9 @@ void XMem::Clear()
         curBlock = blocks;
         curBlockID = 0;
     }
+    else if (mode == SIZE_CLASS) {
+        arena->Reset();
+    }
     else {
         ShowNTErrors("Something is wrong!");
     }
@@ -1534,6 +1582,11 @@ void XMem::CreateBLASHandle()
 /* show profile of the memory pool */
 void XMem::ShowMemUsage(FILE * file)
 {
+    if(mode == SIZE_CLASS){
+        arena->ShowUsage(file);
+        return;
+    }
+
     MTYPE blockUsed = 0;
     MTYPE blockTotal = 0;
 
@@ -1567,12 +1620,17 @@ cublasHandle_t * XMem::GetCublasHandle()
 /* constructor */
 XMemManager::XMemManager()
 {
+    nThreadMem = 0;
+    MUTEX_INIT(threadMemMutex);
     Initialize();
 }
 
 /* de-constructor */
 XMemManager::~XMemManager()
 {
+    for (int i = 0; i < nThreadMem; i++)
+        delete threadMems[i];
+    MUTEX_DELE(threadMemMutex);
 }
 
 /* get memory size */
@@ -1678,7 +1736,10 @@ void XMemManager::Free()
 XMem * XMemManager::GetMem(const int devID)
 {
     XMem * mem = NULL;
-    if (devID < 0){
+    if (devID < 0 && threadCPUMem != NULL){
+        mem = threadCPUMem;
+    }
+    else if (devID < 0){
         if(!CPUMems[0].isInitialized){
             MTYPE freeMem = GetAvailableMemory();
             MTYPE myBufSize = 0;
@@ -1712,6 +1773,56 @@ XMem * XMemManager::GetMem(const int devID)
     return mem;
 }
 
+/*
+create a memory pool for a thread (in the size-class mode). The pool is
+owned by the manager, so that it lives longer than the tensors that are
+allocated in it, e.g., the members of a model.
+>> myBlockSize - size of a chunk of the pool
+<< return - the memory pool
+*/
+XMem * XMemManager::NewThreadMem(MTYPE myBlockSize)
+{
+    MUTEX_LOCK(threadMemMutex);
+
+    CheckNTErrors(nThreadMem < MAX_THREAD_MEM_NUM, "Too many memory pools of threads!");
+
+    XMem * mem = new XMem(-1, SIZE_CLASS, myBlockSize, 1, 0);
+    mem->SetName("thread");
+    threadMems[nThreadMem++] = mem;
+
+    MUTEX_UNLOCK(threadMemMutex);
+
+    return mem;
+}
+
+/*
+set the memory pool that the current thread uses on CPUs. The tensors that
+are (re)allocated on the thread then go to this pool rather than the shared
+one, e.g., a size-class pool for each translation thread.
+>> mem - the memory pool (NULL for the shared pool)
+*/
+void XMemManager::SetThreadMem(XMem * mem)
+{
+    CheckNTErrors(mem == NULL || mem->devID < 0, "The memory pool of a thread must be on CPUs!");
+    threadCPUMem = mem;
+}
+
+/*
+get the memory pool that the current thread uses instead of a given one.
+The shared CPU pool and the pools of threads are replaced by the pool of
+the current thread, and other pools are kept.
+>> mem - the memory pool
+<< return - the memory pool to use
+*/
+XMem * XMemManager::GetThreadMem(XMem * mem)
+{
+    if (mem == NULL || mem->devID >= 0)
+        return mem;
+    if (mem != CPUMems && mem->mode != SIZE_CLASS)
+        return mem;
+    return GetMem(-1);
+}
+
 /* get global memory size */
 int XMemManager::GetMemSize(const int devID, MTYPE * myBlockSize, int * myBlockNum, MTYPE * myBufSize)
 {
@@ -65,15 +65,19 @@ typedef long long          INT_64;
 #define MIN_BLOCK_NUM_FOR_MEMPOOL 1024
 #define MAX_CPU_MEM_NUM 16
 #define MAX_GPU_MEM_NUM 16
+#define MAX_THREAD_MEM_NUM 128
 
 /* 
 mode of runnig a memory pool 
 - UNI_FREE: free all memory space when the memory allocation is no use
 - FREE_ON_THE_FLY: run in normal "malloc" and "free" ways
+- SIZE_CLASS: keep the released memory in free lists of size classes (see XArena).
+              The memory pool is used by a single thread and has no lock (CPUs only)
 */
-enum MEMPOOL_MODE {UNI_FREE, FREE_ON_THE_FLY};
+enum MEMPOOL_MODE {UNI_FREE, FREE_ON_THE_FLY, SIZE_CLASS};
     
 struct MPieceNode;
+class XArena;
 
 /* header of a memory piece (FREE_ON_THE_FLY) */
 struct MHeader
@@ -217,6 +221,9 @@ public:
     /* indicates whether the memory pool is initialized */
     bool isInitialized;
 
+    /* the arena of the size-class mode */
+    XArena * arena;
+
 #ifdef USE_CUDA
     /* handle used for cublas */
     cublasHandle_t cublasHandle;
@@ -459,6 +466,15 @@ private:
     /* number of gpu memory pools */
     int nGPUMem;
 
+    /* memory pools of threads (in the size-class mode) */
+    XMem * threadMems[MAX_THREAD_MEM_NUM];
+
+    /* number of memory pools of threads */
+    int nThreadMem;
+
+    /* a mutex for creating the memory pools of threads */
+    MUTEX_HANDLE threadMemMutex;
+
 public:
     /* constructor */
     XMemManager();
@@ -484,6 +500,15 @@ public:
     /* get global memory pool */
     XMem * GetMem(const int devID);
 
+    /* create a memory pool for a thread */
+    XMem * NewThreadMem(MTYPE myBlockSize);
+
+    /* set the memory pool that the current thread uses on CPUs */
+    void SetThreadMem(XMem * mem);
+
+    /* get the memory pool that the current thread uses instead of a given one */
+    XMem * GetThreadMem(XMem * mem);
+
     /* get global memory size */
     int GetMemSize(const int devID, MTYPE * myBlockSize, int * myBlockNum, MTYPE * myBufSize);
 
@@ -0,0 +1,399 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A container of tensors for saving and loading models (see XModelFile.h).
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "XModelFile.h"
+#include "XUtility.h"
+#include "core/movement/CopyValues.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* the lookup table of CRC-32 */
+static unsigned int crcTable[256];
+static bool crcTableReady = false;
+
+/* build the lookup table of CRC-32 (polynomial 0xEDB88320) */
+static void BuildCRCTable()
+{
+    for (unsigned int i = 0; i < 256; i++) {
+        unsigned int c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+        crcTable[i] = c;
+    }
+    crcTableReady = true;
+}
+
+/*
+checksum (CRC-32) of a block of data
+>> data - the data
+>> size - size of the data (in bytes)
+>> crc - the checksum of the preceding data (for computing the checksum block by block)
+<< return - the checksum
+*/
+unsigned int ComputeChecksum(const void * data, MTYPE size, unsigned int crc)
+{
+    if (!crcTableReady)
+        BuildCRCTable();
+
+    const unsigned char * p = (const unsigned char*)data;
+    unsigned int c = crc ^ 0xFFFFFFFFU;
+    for (MTYPE i = 0; i < size; i++)
+        c = crcTable[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+
+    return c ^ 0xFFFFFFFFU;
+}
+
+/* round up an offset to the alignment */
+static MTYPE AlignOffset(MTYPE offset)
+{
+    return (offset + XMODEL_FILE_ALIGNMENT - 1) / XMODEL_FILE_ALIGNMENT * XMODEL_FILE_ALIGNMENT;
+}
+
+/* move the file pointer to a position (that might be beyond 2GB) */
+static void SeekFile(FILE * file, MTYPE offset)
+{
+#ifdef _WIN32
+    int r = _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+    int r = fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+    CheckNTErrors(r == 0, "Cannot seek in the model file!");
+}
+
+/* write zeros until the file pointer reaches a position */
+static void PadFile(FILE * file, MTYPE from, MTYPE to)
+{
+    char zeros[XMODEL_FILE_ALIGNMENT];
+    memset(zeros, 0, sizeof(zeros));
+    CheckNTErrors(to - from <= XMODEL_FILE_ALIGNMENT, "Wrong padding size!");
+    if (to > from)
+        fwrite(zeros, 1, (size_t)(to - from), file);
+}
+
+/* checksum of the header (all fields before the checksum itself) */
+static unsigned int GetHeaderChecksum(const XModelFileHeader * header)
+{
+    return ComputeChecksum(header, offsetof(XModelFileHeader, headerChecksum));
+}
+
+/* constructor */
+XModelFile::XModelFile()
+{
+    memset(&header, 0, sizeof(header));
+    entries = NULL;
+    meta = NULL;
+    file = NULL;
+    mapped = NULL;
+    mappedSize = 0;
+    verify = true;
+}
+
+/* de-constructor */
+XModelFile::~XModelFile()
+{
+    Close();
+}
+
+/*
+check whether a file is a model file of this format
+>> fn - name of the file
+<< return - true if the file starts with the magic number
+*/
+bool XModelFile::IsModelFile(const char * fn)
+{
+    FILE * f = fopen(fn, "rb");
+    if (f == NULL)
+        return false;
+
+    char magic[8];
+    size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+
+    return n == sizeof(magic) && !memcmp(magic, XMODEL_FILE_MAGIC, sizeof(magic));
+}
+
+/*
+write a list of tensors (and the meta data) into a model file
+>> fn - name of the file
+>> tensors - the tensors (the name of a tensor is "param<i>" if it has no name)
+>> metaData - the meta data (e.g., configurations of the model)
+>> metaSize - size of the meta data (in bytes)
+*/
+void XModelFile::Write(const char * fn, TensorList & tensors, const void * metaData, MTYPE metaSize)
+{
+    FILE * f = fopen(fn, "wb");
+    CheckNTErrors(f, "Cannot open the model file!");
+
+    int tensorNum = tensors.Size();
+    XModelFileHeader head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, XMODEL_FILE_MAGIC, sizeof(head.magic));
+    head.version = XMODEL_FILE_VERSION;
+    head.tensorNum = tensorNum;
+    head.alignment = XMODEL_FILE_ALIGNMENT;
+    head.entrySize = sizeof(XModelFileEntry);
+    head.metaOffset = AlignOffset(sizeof(XModelFileHeader));
+    head.metaSize = metaSize;
+    head.indexOffset = AlignOffset(head.metaOffset + metaSize);
+    head.dataOffset = AlignOffset(head.indexOffset + (MTYPE)tensorNum * sizeof(XModelFileEntry));
+
+    XModelFileEntry * index = new XModelFileEntry[tensorNum];
+    memset(index, 0, sizeof(XModelFileEntry) * tensorNum);
+
+    /* the data of the tensors first, then we know the checksums */
+    SeekFile(f, head.dataOffset);
+    MTYPE offset = head.dataOffset;
+    for (int i = 0; i < tensorNum; i++) {
+        XTensor * t = tensors[i];
+        XModelFileEntry &entry = index[i];
+
+        CheckNTErrors(!t->isSparse, "Sparse tensors are not supported in model files!");
+
+        if (strlen(t->name) > 0)
+            strncpy(entry.name, t->name, XMODEL_FILE_NAME_SIZE - 1);
+        else
+            sprintf(entry.name, "param%d", i);
+        entry.dataType = (int)t->dataType;
+        entry.order = t->order;
+        memcpy(entry.dimSize, t->dimSize, sizeof(int) * t->order);
+        entry.offset = offset;
+        entry.size = (MTYPE)t->unitNum * t->unitSize;
+
+        XTensor tmp;
+        const void * data = t->data;
+        if (t->devID >= 0) {
+            InitTensorOnCPU(&tmp, t);
+            _CopyValues(t, &tmp);
+            data = tmp.data;
+        }
+
+        entry.checksum = ComputeChecksum(data, entry.size);
+        CheckNTErrors(fwrite(data, 1, (size_t)entry.size, f) == entry.size, "Cannot write the model file!");
+
+        MTYPE next = AlignOffset(offset + entry.size);
+        if (i < tensorNum - 1)
+            PadFile(f, offset + entry.size, next);
+        else
+            next = offset + entry.size;
+        offset = next;
+    }
+    head.dataSize = offset - head.dataOffset;
+
+    head.metaChecksum = ComputeChecksum(metaData, metaSize);
+    head.indexChecksum = ComputeChecksum(index, (MTYPE)tensorNum * sizeof(XModelFileEntry));
+    head.headerChecksum = GetHeaderChecksum(&head);
+
+    /* the header, the meta data and the index */
+    SeekFile(f, 0);
+    fwrite(&head, sizeof(head), 1, f);
+    PadFile(f, sizeof(head), head.metaOffset);
+    if (metaSize > 0)
+        fwrite(metaData, 1, (size_t)metaSize, f);
+    PadFile(f, head.metaOffset + metaSize, head.indexOffset);
+    fwrite(index, sizeof(XModelFileEntry), tensorNum, f);
+    PadFile(f, head.indexOffset + (MTYPE)tensorNum * sizeof(XModelFileEntry), head.dataOffset);
+
+    CheckNTErrors(fclose(f) == 0, "Cannot write the model file!");
+
+    delete[] index;
+}
+
+/*
+open a model file
+>> fn - name of the file
+>> useMMap - map the file into the memory (the tensors can then share
+             the data with the file), or read it via the file stream
+*/
+void XModelFile::Open(const char * fn, bool useMMap)
+{
+    Close();
+
+    file = fopen(fn, "rb");
+    CheckNTErrors(file, "Cannot open the model file!");
+
+    CheckNTErrors(fread(&header, sizeof(header), 1, file) == 1, "Incomplete model file!");
+    CheckNTErrors(!memcmp(header.magic, XMODEL_FILE_MAGIC, sizeof(header.magic)), "Not a model file!");
+    CheckNTErrors(header.version <= XMODEL_FILE_VERSION, "The model file is of a newer version!");
+    CheckNTErrors(header.entrySize == sizeof(XModelFileEntry), "Unknown layout of the model file!");
+    CheckNTErrors(header.headerChecksum == GetHeaderChecksum(&header), "The model file header is corrupted!");
+
+    MTYPE indexSize = (MTYPE)header.tensorNum * sizeof(XModelFileEntry);
+
+#ifndef _WIN32
+    if (useMMap) {
+        int fd = fileno(file);
+        struct stat st;
+        CheckNTErrors(fstat(fd, &st) == 0, "Cannot get the size of the model file!");
+        CheckNTErrors((MTYPE)st.st_size >= header.dataOffset + header.dataSize, "Incomplete model file!");
+
+        /* a private mapping, i.e., pages are shared by processes until someone writes to them */
+        void * p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        CheckNTErrors(p != MAP_FAILED, "Cannot map the model file into the memory!");
+
+        mapped = (char*)p;
+        mappedSize = (MTYPE)st.st_size;
+        meta = mapped + header.metaOffset;
+        entries = (XModelFileEntry*)(mapped + header.indexOffset);
+
+        fclose(file);
+        file = NULL;
+    }
+#endif
+
+    /* the tensors are checked when they are read from the stream, but not
+       when they are mapped, which would read the whole file at once */
+    verify = (mapped == NULL);
+
+    if (mapped == NULL) {
+        meta = new char[header.metaSize + 1];
+        entries = new XModelFileEntry[header.tensorNum];
+        SeekFile(file, header.metaOffset);
+        CheckNTErrors(fread(meta, 1, (size_t)header.metaSize, file) == header.metaSize, "Incomplete model file!");
+        SeekFile(file, header.indexOffset);
+        CheckNTErrors(fread(entries, sizeof(XModelFileEntry), header.tensorNum, file) == (size_t)header.tensorNum,
+                      "Incomplete model file!");
+    }
+
+    CheckNTErrors(header.metaChecksum == ComputeChecksum(meta, header.metaSize), "The meta data is corrupted!");
+    CheckNTErrors(header.indexChecksum == ComputeChecksum(entries, indexSize), "The tensor index is corrupted!");
+}
+
+/* close the file */
+void XModelFile::Close()
+{
+#ifndef _WIN32
+    if (mapped != NULL) {
+        munmap(mapped, (size_t)mappedSize);
+        mapped = NULL;
+        mappedSize = 0;
+        meta = NULL;
+        entries = NULL;
+    }
+#endif
+
+    delete[] meta;
+    delete[] entries;
+    meta = NULL;
+    entries = NULL;
+
+    if (file != NULL)
+        fclose(file);
+    file = NULL;
+}
+
+/* check whether the file is mapped into the memory */
+bool XModelFile::IsMapped()
+{
+    return mapped != NULL;
+}
+
+/* get the number of tensors */
+int XModelFile::GetTensorNum()
+{
+    return header.tensorNum;
+}
+
+/* get the index entry of the i-th tensor */
+XModelFileEntry * XModelFile::GetEntry(int i)
+{
+    CheckNTErrors(i >= 0 && i < header.tensorNum, "Tensor index is out of range!");
+    return entries + i;
+}
+
+/*
+find a tensor by its name
+>> name - name of the tensor
+<< return - the position of the tensor in the index (-1 if it is not found)
+*/
+int XModelFile::Find(const char * name)
+{
+    for (int i = 0; i < header.tensorNum; i++) {
+        if (!strncmp(entries[i].name, name, XMODEL_FILE_NAME_SIZE))
+            return i;
+    }
+    return -1;
+}
+
+/* get the size of the whole file (the user can append more data after it) */
+MTYPE XModelFile::GetFileSize()
+{
+    return header.dataOffset + header.dataSize;
+}
+
+/*
+read the i-th tensor into a given tensor
+>> i - the position of the tensor in the index
+>> tensor - the tensor to keep the data, which must be of the same
+            shape and data type as that in the file
+>> share - let the tensor use the mapped data directly rather than
+           a copy of it (only for tensors on CPUs with a mapped file)
+*/
+void XModelFile::ReadTensor(int i, XTensor * tensor, bool share)
+{
+    XModelFileEntry * entry = GetEntry(i);
+
+    CheckNTErrors(entry->dataType == (int)tensor->dataType, "Unmatched data type of the tensor in the model file!");
+    CheckNTErrors(entry->order == tensor->order, "Unmatched order of the tensor in the model file!");
+    for (int d = 0; d < tensor->order; d++)
+        CheckNTErrors(entry->dimSize[d] == tensor->dimSize[d], "Unmatched shape of the tensor in the model file!");
+    CheckNTErrors(entry->size == (MTYPE)tensor->unitNum * tensor->unitSize, "Unmatched size of the tensor in the model file!");
+    CheckNTErrors(entry->offset + entry->size <= GetFileSize(), "The tensor is out of the model file!");
+
+    if (mapped != NULL) {
+        char * data = mapped + entry->offset;
+        if (verify)
+            CheckNTErrors(entry->checksum == ComputeChecksum(data, entry->size), "The tensor data is corrupted!");
+
+        if (share && tensor->devID < 0) {
+            tensor->DestroyData();
+            tensor->data = data;
+            tensor->isShared = true;
+            tensor->isInGlobalMem = false;
+        }
+        else
+            tensor->SetData(data, tensor->unitNum);
+    }
+    else {
+        char * data = new char[entry->size];
+        SeekFile(file, entry->offset);
+        CheckNTErrors(fread(data, 1, (size_t)entry->size, file) == entry->size, "Incomplete model file!");
+        if (verify)
+            CheckNTErrors(entry->checksum == ComputeChecksum(data, entry->size), "The tensor data is corrupted!");
+        tensor->SetData(data, tensor->unitNum);
+        delete[] data;
+    }
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
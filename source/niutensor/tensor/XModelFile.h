@@ -0,0 +1,195 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A container of tensors for saving and loading models. The file is laid out
+ * as follows:
+ *
+ *   header | meta data | index | tensor 0 | tensor 1 | ...
+ *
+ * The header records the version and where each part starts. The meta data
+ * is an opaque block (e.g., model configurations) for the user. The index
+ * keeps the name, data type, shape, offset and checksum of every tensor.
+ * Tensors are aligned to XMODEL_FILE_ALIGNMENT bytes so that a file mapped into
+ * the memory can be used as the data arrays of the tensors directly.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ *
+ */
+
+#ifndef __XMODELFILE_H__
+#define __XMODELFILE_H__
+
+#include "XTensor.h"
+#include "XList.h"
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* the magic number at the beginning of the file */
+#define XMODEL_FILE_MAGIC "NIUMODEL"
+
+/* the version of the file format */
+#define XMODEL_FILE_VERSION 1
+
+/* alignment of the tensors in the file (in bytes) */
+#define XMODEL_FILE_ALIGNMENT 64
+
+/* the maximum length of a tensor name in the index */
+#define XMODEL_FILE_NAME_SIZE 64
+
+/* the header of a model file */
+struct XModelFileHeader
+{
+    /* the magic number (XMODEL_FILE_MAGIC) */
+    char magic[8];
+
+    /* the version of the file format */
+    int version;
+
+    /* number of tensors */
+    int tensorNum;
+
+    /* alignment of the tensors */
+    int alignment;
+
+    /* size of an index entry (to check the layout of the structures) */
+    int entrySize;
+
+    /* offset and size of the meta data */
+    MTYPE metaOffset;
+    MTYPE metaSize;
+
+    /* offset of the index */
+    MTYPE indexOffset;
+
+    /* offset and size of the tensor data */
+    MTYPE dataOffset;
+    MTYPE dataSize;
+
+    /* checksums of the meta data and the index */
+    unsigned int metaChecksum;
+    unsigned int indexChecksum;
+
+    /* checksum of the fields above */
+    unsigned int headerChecksum;
+
+    /* padding */
+    unsigned int reserved;
+};
+
+/* an entry of the tensor index */
+struct XModelFileEntry
+{
+    /* name of the tensor */
+    char name[XMODEL_FILE_NAME_SIZE];
+
+    /* data type */
+    int dataType;
+
+    /* number of dimensions */
+    int order;
+
+    /* size of each dimension */
+    int dimSize[MAX_TENSOR_DIM_NUM];
+
+    /* offset of the data (from the beginning of the file) */
+    MTYPE offset;
+
+    /* size of the data (in bytes) */
+    MTYPE size;
+
+    /* checksum of the data */
+    unsigned int checksum;
+
+    /* padding */
+    unsigned int reserved;
+};
+
+/* a model file that is read via the memory mapping or the file stream */
+class XModelFile
+{
+public:
+    /* the header */
+    XModelFileHeader header;
+
+    /* the tensor index */
+    XModelFileEntry * entries;
+
+    /* the meta data */
+    char * meta;
+
+    /* the file stream (if the file is not mapped) */
+    FILE * file;
+
+    /* the beginning of the mapped file (NULL if the file is not mapped) */
+    char * mapped;
+
+    /* size of the mapped file */
+    MTYPE mappedSize;
+
+    /* indicates whether the checksums of the tensors are checked when they are read.
+       It is set when the file is opened: on for the file stream, and off for
+       a mapped file, as checking the data would touch every page of the mapping
+       (the header and the index are always checked). */
+    bool verify;
+
+public:
+    /* constructor */
+    XModelFile();
+
+    /* de-constructor */
+    ~XModelFile();
+
+    /* check whether a file is a model file of this format */
+    static bool IsModelFile(const char * fn);
+
+    /* write a list of tensors (and the meta data) into a model file */
+    static void Write(const char * fn, TensorList & tensors, const void * metaData, MTYPE metaSize);
+
+    /* open a model file (and map it into the memory if required) */
+    void Open(const char * fn, bool useMMap);
+
+    /* close the file */
+    void Close();
+
+    /* check whether the file is mapped into the memory */
+    bool IsMapped();
+
+    /* get the number of tensors */
+    int GetTensorNum();
+
+    /* get the index entry of a tensor */
+    XModelFileEntry * GetEntry(int i);
+
+    /* find a tensor by its name (-1 if it is not found) */
+    int Find(const char * name);
+
+    /* get the size of the whole file */
+    MTYPE GetFileSize();
+
+    /* read the i-th tensor into a given tensor */
+    void ReadTensor(int i, XTensor * tensor, bool share);
+};
+
+/* checksum (CRC-32) of a block of data */
+unsigned int ComputeChecksum(const void * data, MTYPE size, unsigned int crc = 0);
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
@@ -128,6 +128,7 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 
 #define LOSS_BASE               FUNCTION_BASE * 2
 #define LOSS_CROSSENTROPY       LOSS_BASE + 1
+#define LOSS_CROSSENTROPY_SPARSE LOSS_CROSSENTROPY + 1
 
 /* get operator name */
 const char * GetOPName(int type);
@@ -34,7 +34,8 @@ namespace nts{
 The XPRunner maintains a the parallel processing resources, e.g., a pool
 of threads. It can provide the parallel computation interface for someone
 that needs to do something parallel, e.g., speed-up matrix operation by
-multi-threading.
+multi-threading. The jobs are run by a work-stealing thread pool (see
+XThreadPool.h), and the thread that calls the runner runs jobs as well.
 */
 
 XPRunner * globalPRunner = NULL;
@@ -50,38 +51,26 @@ XPRunner::XPRunner()
     method = PRUNNER_SINGLE;
 
     /* multi-threading */
-    threads = NULL;
+    pool = NULL;
     threadNum = 0;
     minimumOPNum = INT_MAX;
-    MUTEX_INIT(mutex);
     isMultiThreaded = true;
-    availableThreadNum = 0;
-    runningThreadNum = 0;
-    runningThreads = new int[MAX_THREAD_NUM];
-    memset(runningThreads, 0 ,sizeof(int) * MAX_THREAD_NUM);
-    runningStates = new int[MAX_THREAD_NUM];
-    memset(runningStates, 0 ,sizeof(int) * MAX_THREAD_NUM);
-    availableThreads = new int[MAX_THREAD_NUM];
-    memset(availableThreads, 0 ,sizeof(int) * MAX_THREAD_NUM);
 }
 
 /* deconstructor */
 XPRunner::~XPRunner()
 {
     KillThreads();
-    MUTEX_DELE(mutex);
-    delete[] runningThreads;
-    delete[] runningStates;
-    delete[] availableThreads;
 }
 
 /* 
 initialization 
 >> myThreadNum - number of required threads
+>> pinCores - pin the threads to cores
 */
-void XPRunner::Init(int myThreadNum)
+void XPRunner::Init(int myThreadNum, bool pinCores)
 {
-    CreateThreads(myThreadNum);
+    CreateThreads(myThreadNum, pinCores);
 
     if(myThreadNum > 0)
         method = PRUNNER_MULTIPLE;
@@ -95,56 +84,57 @@ methods for multi-threading
 /* 
 initialization 
 >> tNum - number of required threads
+>> pinCores - pin the threads to cores
 */
-void XPRunner::CreateThreads(int tNum)
+void XPRunner::CreateThreads(int tNum, bool pinCores)
 {
     if(tNum > MAX_THREAD_NUM){
         XPRINT2(0, stderr, "[XPRunner::CreateThreads] Error! Too many threads[%d>%d]!\n", tNum, MAX_THREAD_NUM);
         exit(1);
     }
 
-    threads = new XThread[tNum];
-    for(int i = 0; i < tNum; i++){
-        if(!threads[i].Start()){
-            XPRINT1(0, stderr, "[XPRunner::CreateThreads] Error! cannot create thread %d\n", i);
-            exit(1);
-        }
-    }
+    KillThreads();
 
-#ifdef _WIN32
-    Sleep(300);
-#else
-    usleep(300 * 1000);
-#endif
+    /* the thread that calls the runner works as well */
+    pool = new XThreadPool();
+    pool->Init(MAX(tNum - 1, 0), pinCores);
 
     threadNum = tNum;
 
     minimumOPNum = MIN_OPERATION_NUM;
-
-
 }
 
 /* kill all threads */
 void XPRunner::KillThreads()
 {
-    for(int i = 0; i < threadNum; i++){
-        //threads[i].End();
-    }
-#ifdef    _WIN32
-    //Sleep(300);
-#else
-    //sleep(0.3);
-#endif
-    delete[] threads;
-    threads = NULL;
+    delete pool;
+    pool = NULL;
 }
 
+/* the job list of XPRunner::Run */
+struct XRunnerJobs
+{
+    XList * functions;
+    XList * args;
+};
+
+/* run the jobs [begin, end) of a job list */
+static void RunJobs(void * arg, int begin, int end)
+{
+    XRunnerJobs * jobs = (XRunnerJobs*)arg;
+    for(int i = begin; i < end; i++){
+        TFunction function = (TFunction)jobs->functions->GetItem(i);
+        function((XList*)jobs->args->GetItem(i));
+    }
+}
 
 /* 
-run a set of jobs in parallel 
+run a set of jobs in parallel. Each job is a task of the pool, and idle
+threads steal the jobs that are not started, so it returns as soon as all
+the jobs are finished.
 >> jobFunctions - the function for each job
 >> jobArgs - the list of arguments for each job
->> sleepTime - time to sleep (in ms) for each round
+>> sleepTime - not used (it is kept for compatibility)
 */
 void XPRunner::Run(XList * jobFunctions, XList * jobArgs, float sleepTime)
 {
@@ -153,97 +143,34 @@ void XPRunner::Run(XList * jobFunctions, XList * jobArgs, float sleepTime)
         exit(1);
     }
 
-    runningThreadNum = 0;
-    availableThreadNum = 0;
-
-    memset(runningStates, 0, sizeof(int) * MAX_THREAD_NUM);
-
-    int c = jobFunctions->count;
-    int unfinished = c;
-
-    MUTEX_LOCK(mutex);
+    CheckNTErrors(jobFunctions->count == jobArgs->count, "Unmatched job lists!");
 
-    while(unfinished > 0){
+    XRunnerJobs jobs;
+    jobs.functions = jobFunctions;
+    jobs.args = jobArgs;
 
-        /* get the list of threads that are ready to process the job */
-        for(int i = 0; i < threadNum; i++){
-            if(runningStates[i] == 2 && threads[i].jobCount == 0){
-                /* a job has been finished*/
-                unfinished--;
-                availableThreads[availableThreadNum++] = i;
-                runningStates[i] = 1;
-#ifdef _WIN32
-                MUTEX_LOCK(threads[i].workingMutex);
-                COND_RESET(threads[i].jobCond);
-                MUTEX_UNLOCK(threads[i].workingMutex);
-#endif
-            }
-            else if(runningStates[i] == 0 && threads[i].jobCount == 0){
-                availableThreads[availableThreadNum++] = i;
-                runningStates[i] = 1;
-#ifdef _WIN32
-                MUTEX_LOCK(threads[i].workingMutex);
-                COND_RESET(threads[i].jobCond);
-                MUTEX_UNLOCK(threads[i].workingMutex);
-#endif
-            }
-        }
-
-        /* assign the jobs */
-        for(int i = availableThreadNum - 1; i >= 0 && c > 0; i--){
-            /* the function to run*/
-            TFunction function = (TFunction)jobFunctions->GetItem(jobArgs->count - c);
-
-            /* the arguments that are passed to the function */
-            XList * args = (XList*)jobArgs->GetItem(jobArgs->count - c);
-
-            /* thread */
-            XThread * thread  = threads + availableThreads[i];
-
-            thread->SetFunc(function, args);
-
-            MUTEX_LOCK(thread->workingMutex);
-            thread->working = 1;
-            MUTEX_UNLOCK(thread->workingMutex);
-
-#ifdef USE_PTHREAD
-            MUTEX_LOCK(thread->mutex);
-            thread->jobCount++;
-            MUTEX_UNLOCK(thread->mutex);
-            //COND_BROADCAST(thread->cond);
-            COND_SIGNAL(thread->cond);
-            //MUTEX_UNLOCK(thread->mutex);
-#else
-#ifdef _WIN32
-            /* reset various locks */
-            MUTEX_LOCK(thread->workingMutex);
-            thread->jobCount++;
-            COND_RESET(thread->jobCond);
-            //COND_RESET(thread->gCond);
-            MUTEX_UNLOCK(thread->workingMutex);
-
-            /* inform the job */
-            //ResumeThread(threads[i].hnd);
-            COND_SIGNAL(thread->jobCond);
-#endif
-#endif
-
-            /* a job is under processing */
-            c--;
-            availableThreadNum--;
-            runningStates[availableThreads[i]] = 2;
-        }
+    pool->ParallelFor(0, jobFunctions->count, 1, RunJobs, &jobs);
+}
 
-        if(sleepTime > 0){
-#ifdef _WIN32
-            Sleep((DWORD)sleepTime);
-#else
-            sleep(sleepTime/1000);
-#endif
-        }
+/*
+run a function over the items [begin, end) in parallel. The range is split
+in tasks of no less than "grain" items, and this can be called in a job
+of the runner (i.e., nested parallelism).
+>> begin - the first item
+>> end - the end of the items (not included)
+>> grain - the minimum number of items of a task (it is chosen by
+           the runner if grain <= 0)
+>> function - the function that processes a range of items
+>> arg - the argument of the function
+*/
+void XPRunner::ParallelFor(int begin, int end, int grain, XRangeFunction function, void * arg)
+{
+    if(pool == NULL){
+        function(arg, begin, end);
+        return;
     }
 
-    MUTEX_UNLOCK(mutex);
+    pool->ParallelFor(begin, end, grain, function, arg);
 }
 
 /* 
@@ -254,7 +181,8 @@ int XPRunner::GetJobNum(int size)
 {
     int jobNum = int((float)size/minimumOPNum);
 
-    return MIN(jobNum, threadNum);
+    /* more jobs than threads so that idle threads can steal the rest */
+    return MIN(jobNum, threadNum * JOBS_PER_THREAD);
 }
 
 } /* end of the nts (NiuTrans.Tensor) namespace */
@@ -25,6 +25,7 @@
 #define __XPRUNNER_H__
 
 #include "XThread.h"
+#include "XThreadPool.h"
 #include "XList.h"
 
 /* the nts (NiuTrans.Tensor) namespace */
@@ -32,7 +33,10 @@ namespace nts{
 
 #define MIN_OPERATION_NUM 1024 * 4
 #define MAX_JOB_NUM 32
-#define MAX_THREAD_NUM 32
+#define MAX_THREAD_NUM 128
+
+/* number of jobs per thread for a big operation (for load balancing) */
+#define JOBS_PER_THREAD 2
 
 #define PRUNNER_SINGLE 0
 #define PRUNNER_MULTIPLE 1
@@ -42,7 +46,8 @@ namespace nts{
 The XPRunner maintains a the parallel processing resources, e.g., a pool
 of threads. It can provide the parallel computation interface for someone
 that needs to do something parallel, e.g., speed-up matrix operation by
-multi-threading.
+multi-threading. The jobs are run by a work-stealing thread pool (see
+XThreadPool.h), and the thread that calls the runner runs jobs as well.
 */
 class XPRunner
 {
@@ -53,15 +58,12 @@ public:
     */
     int method;
 public:
-    /* a set of threads */
-    XThread * threads;
+    /* the pool of worker threads */
+    XThreadPool * pool;
 
-    /* max number of threads */
+    /* max number of threads (including the thread that calls the runner) */
     int threadNum;
 
-    /* a mutex lock */
-    MUTEX_HANDLE mutex;
-
     /* 
     Minimum number of atomic operations for a thread.
     It is used to avoid large overhead of too many "tiny" jobs.
@@ -71,21 +73,6 @@ public:
     /* if multi-threading is activated */
     bool isMultiThreaded;
 
-    /* list of running threads */
-    int * runningThreads;
-
-     /* list of threads states */
-    int * runningStates;
-
-    /* number of running threads */
-    int runningThreadNum;
-
-    /* list of available threads */
-    int * availableThreads;
-
-    /* number of available threads */
-    int availableThreadNum;
-
 /* general methods */
 public:
     /* constructor */
@@ -95,12 +82,12 @@ public:
     ~XPRunner();
 
     /* initialization */
-    void Init(int myThreadNum);
+    void Init(int myThreadNum, bool pinCores = false);
 
 /* methods for multi-threading */
 public:
     /* initialization */
-    void CreateThreads(int tNum);
+    void CreateThreads(int tNum, bool pinCores = false);
 
     /* kill all running threads in the pool */
     void KillThreads();
@@ -108,6 +95,9 @@ public:
     /* run a set of jobs in parallel */
     void Run(XList * jobFunctions, XList * jobArgs, float sleepTime = 0);
 
+    /* run a function over the items [begin, end) in parallel */
+    void ParallelFor(int begin, int end, int grain, XRangeFunction function, void * arg);
+
     /* get the number of parallel jobs to run */
     int GetJobNum(int size);
 };
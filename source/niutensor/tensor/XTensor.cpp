@@ -286,10 +286,11 @@ void XTensor::DestroyData()
         XMemFree(devID, data);
     else if(data != NULL && isInGlobalMem)
         FreeData(this, mem);
-    else if(data != NULL)
+    else if(data != NULL && !isShared)
         mem->Release(data, GetDataSizeInChar(), signature);
     
     data = NULL;
+    isShared = false;
 
     if(dataHost != NULL)
         delete[] (char*)dataHost;
@@ -392,8 +393,10 @@ XTensor& XTensor::operator= (const XTensor& tensor)
             _CopyValues(&tensor, this);
         }
 
-        /* copy member variables */
+        /* copy member variables (the data array is still owned as before) */
+        bool shared = isShared;
         ShallowCopy(tensor);
+        isShared = shared;
 
         isInit = true;
         isTmp = false;
@@ -1439,14 +1442,17 @@ resize a tensor with a specified tensor size
 bool XTensor::Resize(const int myOrder, const int* myDimSize, 
                      const TENSOR_DATA_TYPE myDataType, const float myDenseRatio)
 {
-    /* free old mem */
-    if(data != NULL){
+    /* free old mem (the shared data array is not ours to free) */
+    if(data != NULL && !isShared){
         if (mem == NULL)
             XMemFree(devID, data);
         else
             mem->Release(data, GetDataSizeInChar(), signature);
     }
+    isShared = false;
 
+    /* a tensor on CPUs goes to the memory pool of the current thread if it has one */
+    mem = GMems.GetThreadMem(mem);
     signature = mem != NULL ? mem->GetSignature() : 0;
     
     order = myOrder;
@@ -89,10 +89,6 @@ After that, we wait again if there is no new job.
 */
 void XThread::Run()
 {
-    if (function == NULL) {
-        ShowNTErrors("You are running a thread with no function specified!");
-    }
-
 #ifdef _WIN32
     //COND_RESET(gCond);
 #endif    
@@ -119,6 +115,12 @@ void XThread::Run()
             break;
         }
 
+        /* the thread is started before any job is assigned,
+           so we check the function only when a job comes */
+        if (function == NULL) {
+            ShowNTErrors("You are running a thread with no function specified!");
+        }
+
         /* do what you want to do*/
         function(&argv);
 
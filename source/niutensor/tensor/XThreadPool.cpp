@@ -0,0 +1,307 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ *
+ */
+
+#include "XThreadPool.h"
+#include "XGlobal.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* number of rounds a worker looks for tasks before it sleeps */
+#define POOL_SPIN_ROUNDS 64
+
+/* number of chunks per thread when the grain size is chosen by the pool */
+#define POOL_CHUNKS_PER_THREAD 8
+
+/* the pool and the worker id of the current thread (-1 for non-worker threads) */
+static thread_local XThreadPool * currentPool = NULL;
+static thread_local int currentWorker = -1;
+
+/* constructor */
+XThreadPool::XThreadPool()
+{
+    queuedNum = 0;
+    sleepingNum = 0;
+    nextWorker = 0;
+    toStop = false;
+    pinned = false;
+}
+
+/* de-constructor */
+XThreadPool::~XThreadPool()
+{
+    Stop();
+}
+
+/*
+create the workers
+>> workerNum - number of worker threads
+>> pinCores - pin the workers to cores (on linux)
+*/
+void XThreadPool::Init(int workerNum, bool pinCores)
+{
+    CheckNTErrors(workers.empty(), "The thread pool has been initialized!");
+
+    toStop = false;
+    pinned = pinCores;
+
+    for (int i = 0; i < workerNum; i++)
+        workers.push_back(new Worker());
+
+    /* the deques must exist before any worker starts to steal */
+    for (int i = 0; i < workerNum; i++)
+        workers[i]->thread = std::thread(&XThreadPool::WorkerLoop, this, i);
+}
+
+/* stop and join the workers */
+void XThreadPool::Stop()
+{
+    if (workers.empty())
+        return;
+
+    toStop = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCond.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (workers[i]->thread.joinable())
+            workers[i]->thread.join();
+        delete workers[i];
+    }
+    workers.clear();
+}
+
+/* number of workers */
+int XThreadPool::GetWorkerNum()
+{
+    return (int)workers.size();
+}
+
+/*
+run a function over the items [begin, end) in parallel. The calling thread
+runs tasks until all the items are processed, and it can be a worker of
+the pool (i.e., a parallel-for can be called in another one).
+>> begin - the first item
+>> end - the end of the items (not included)
+>> grain - a task with no more items than it is not split further
+           (it is chosen by the pool if grain <= 0)
+>> function - the function that processes a range of items
+>> arg - the argument of the function
+*/
+void XThreadPool::ParallelFor(int begin, int end, int grain, XRangeFunction function, void * arg)
+{
+    if (end <= begin)
+        return;
+
+    int itemNum = end - begin;
+    int threadNum = (int)workers.size() + 1;
+
+    if (grain <= 0)
+        grain = MAX(1, itemNum / (threadNum * POOL_CHUNKS_PER_THREAD));
+
+    if (workers.empty() || itemNum <= grain) {
+        function(arg, begin, end);
+        return;
+    }
+
+    XTaskGroup group;
+    group.pending = 1;
+
+    XTask task;
+    task.function = function;
+    task.arg = arg;
+    task.begin = begin;
+    task.end = end;
+    task.grain = grain;
+    task.group = &group;
+
+    RunTask(task);
+
+    /* help the others until all the tasks of the group are finished */
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        XTask t;
+        if (Take(t))
+            RunTask(t);
+        else
+            std::this_thread::yield();
+    }
+}
+
+/*
+the loop of a worker
+>> id - id of the worker
+*/
+void XThreadPool::WorkerLoop(int id)
+{
+    currentPool = this;
+    currentWorker = id;
+
+    if (pinned)
+        PinToCore(id);
+
+    while (!toStop.load()) {
+        XTask task;
+        if (Take(task)) {
+            RunTask(task);
+            continue;
+        }
+
+        /* look for tasks for a while before sleeping */
+        bool hasTask = false;
+        for (int i = 0; i < POOL_SPIN_ROUNDS && !hasTask; i++) {
+            std::this_thread::yield();
+            hasTask = queuedNum.load() > 0;
+        }
+        if (hasTask)
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingNum++;
+        sleepCond.wait(lock, [this] { return toStop.load() || queuedNum.load() > 0; });
+        sleepingNum--;
+    }
+
+    currentPool = NULL;
+    currentWorker = -1;
+}
+
+/*
+add a task to the pool. A worker adds it to the back of its own deque, and
+other threads add it to the deques of the workers in turn.
+>> task - the task
+*/
+void XThreadPool::Push(const XTask & task)
+{
+    int self = currentPool == this ? currentWorker : -1;
+    Worker * worker = self >= 0 ? workers[self] : workers[nextWorker++ % workers.size()];
+
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->tasks.push_back(task);
+    }
+
+    queuedNum++;
+
+    /* wake up a sleeping worker (the lock makes sure that it is waiting) */
+    if (sleepingNum.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        sleepCond.notify_one();
+    }
+}
+
+/*
+get a task. A worker takes the last task of its own deque first, and then
+steals the first task (i.e., the largest one) from the others.
+>> task - the task
+<< return - whether we get one
+*/
+bool XThreadPool::Take(XTask & task)
+{
+    int self = currentPool == this ? currentWorker : -1;
+    int n = (int)workers.size();
+
+    if (self >= 0) {
+        Worker * worker = workers[self];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (!worker->tasks.empty()) {
+            task = worker->tasks.back();
+            worker->tasks.pop_back();
+            queuedNum--;
+            return true;
+        }
+    }
+
+    if (queuedNum.load() <= 0)
+        return false;
+
+    int start = self >= 0 ? self + 1 : (int)(nextWorker.load() % n);
+    for (int i = 0; i < n; i++) {
+        int victim = (start + i) % n;
+        if (victim == self)
+            continue;
+
+        Worker * worker = workers[victim];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (!worker->tasks.empty()) {
+            task = worker->tasks.front();
+            worker->tasks.pop_front();
+            queuedNum--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+run a task. A large task is split in halves, and the second halves are
+added to the pool for the others to steal.
+>> task - the task
+*/
+void XThreadPool::RunTask(XTask & task)
+{
+    while (task.end - task.begin > task.grain) {
+        int mid = task.begin + (task.end - task.begin) / 2;
+
+        XTask right = task;
+        right.begin = mid;
+        task.end = mid;
+
+        task.group->pending.fetch_add(1, std::memory_order_relaxed);
+        Push(right);
+    }
+
+    task.function(task.arg, task.begin, task.end);
+
+    task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+/*
+pin a worker to a core. The calling thread of a parallel-for is usually on
+the first core, so worker i goes to core i + 1.
+>> id - id of the worker
+*/
+void XThreadPool::PinToCore(int id)
+{
+#ifdef __linux__
+    int coreNum = (int)std::thread::hardware_concurrency();
+    if (coreNum <= 0)
+        return;
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET((id + 1) % coreNum, &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+#endif
+}
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
@@ -0,0 +1,151 @@
+/* NiuTrans.Tensor - an open-source tensor library
+ * Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+ * All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *
+ * A work-stealing thread pool. Each worker has its own deque of tasks: it
+ * pushes and pops tasks at the back, and idle workers steal tasks from the
+ * front of the others. A parallel-for is a range task that is split in
+ * halves lazily, so that big chunks are stolen first and small chunks stay
+ * with the thread that made them. The thread that waits for a parallel-for
+ * runs tasks too, which makes nested parallel-for calls safe.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ *
+ */
+
+#ifndef __XTHREADPOOL_H__
+#define __XTHREADPOOL_H__
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+/* the nts (NiuTrans.Tensor) namespace */
+namespace nts{
+
+/* a function that processes the items [begin, end) of a parallel-for */
+typedef void (*XRangeFunction) (void * arg, int begin, int end);
+
+/* a set of tasks that a caller waits for */
+struct XTaskGroup
+{
+    /* number of tasks that are not finished */
+    std::atomic<int> pending;
+};
+
+/* a task, i.e., a range of items of a parallel-for */
+struct XTask
+{
+    /* the function to run */
+    XRangeFunction function;
+
+    /* the argument of the function */
+    void * arg;
+
+    /* the range of items */
+    int begin;
+    int end;
+
+    /* the range is not split if it has no more items than this */
+    int grain;
+
+    /* the group of the task */
+    XTaskGroup * group;
+};
+
+/* a work-stealing thread pool */
+class XThreadPool
+{
+private:
+    /* a worker thread and its deque of tasks */
+    struct Worker
+    {
+        /* the thread */
+        std::thread thread;
+
+        /* a lock to protect the deque */
+        std::mutex mutex;
+
+        /* tasks of the worker */
+        std::deque<XTask> tasks;
+    };
+
+    /* the workers */
+    std::vector<Worker*> workers;
+
+    /* number of tasks in all the deques */
+    std::atomic<int> queuedNum;
+
+    /* number of workers that are sleeping */
+    std::atomic<int> sleepingNum;
+
+    /* where the next task from a non-worker thread goes */
+    std::atomic<unsigned int> nextWorker;
+
+    /* a flag to stop the workers */
+    std::atomic<bool> toStop;
+
+    /* a lock and a condition for sleeping workers */
+    std::mutex sleepMutex;
+    std::condition_variable sleepCond;
+
+    /* whether the workers are pinned to cores */
+    bool pinned;
+
+public:
+    /* constructor */
+    XThreadPool();
+
+    /* de-constructor */
+    ~XThreadPool();
+
+    /* create the workers */
+    void Init(int workerNum, bool pinCores = false);
+
+    /* stop and join the workers */
+    void Stop();
+
+    /* number of workers */
+    int GetWorkerNum();
+
+    /* run a function over the items [begin, end) in parallel */
+    void ParallelFor(int begin, int end, int grain, XRangeFunction function, void * arg);
+
+private:
+    /* the loop of a worker */
+    void WorkerLoop(int id);
+
+    /* add a task to the pool */
+    void Push(const XTask & task);
+
+    /* get a task from the deque of the thread or steal one from the others */
+    bool Take(XTask & task);
+
+    /* run a task (and split it if it is large) */
+    void RunTask(XTask & task);
+
+    /* pin a worker to a core */
+    void PinToCore(int id);
+};
+
+} /* end of the nts (NiuTrans.Tensor) namespace */
+
+#endif
@@ -32,10 +32,13 @@
 #include "arithmetic/MatrixMul.h"
 #include "arithmetic/MatrixMul2D.h"
 #include "arithmetic/MatrixMul2DMultiTheading.h"
+#include "arithmetic/MatrixMul2DPacked.h"
 #include "arithmetic/MatrixMul2DParallel.h"
+#include "arithmetic/MatrixMulINT8.h"
 #include "arithmetic/MatrixMulBatched.h"
 #include "arithmetic/Multiply.h"
 #include "arithmetic/MultiplyDim.h"
+#include "arithmetic/SingleQueryAttention.h"
 #include "arithmetic/Sub.h"
 #include "arithmetic/Sum.h"
 #include "arithmetic/SumDim.h"
@@ -47,6 +50,8 @@
 #include "getandset/Select.h"
 #include "getandset/SetData.h"
 
+#include "math/AdamUpdate.h"
+#include "math/AddNormalize.h"
 #include "math/Binary.h"
 #include "math/Clip.h"
 #include "math/Compare.h"
@@ -89,6 +94,7 @@
 
 #include "sort/Sort.h"
 #include "sort/TopK.h"
+#include "sort/LogSoftmaxTopK.h"
 
 #include "utilities/CheckData.h"
 #include "utilities/FlushToMem.h"
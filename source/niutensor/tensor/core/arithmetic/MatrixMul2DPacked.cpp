@@ -0,0 +1,1074 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../../XTensor.h"
+#include "MatrixMul2DPacked.h"
+#include "../utilities/XMatrixSegment.h"
+
+/* the SIMD micro-kernels are compiled with per-function target attributes,
+   so that the binary still runs on CPUs without AVX2 or AVX-512 */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(DOUBELPRICSION)
+#define GEMM_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* the largest register block among all micro-kernels */
+#define GEMM_MAX_MR 8
+#define GEMM_MAX_NR 32
+
+/*
+a micro-kernel computes a mr * nr block of c from a packed sliver of a
+(kc * mr) and a packed sliver of b (kc * nr), i.e.,
+c = a * b * alpha + c * beta
+(c is not read when beta = 0)
+*/
+typedef void (*GEMMKernel)(int kc, const DTYPE * a, const DTYPE * b, DTYPE * c, int ldc, DTYPE alpha, DTYPE beta);
+
+/* description of a micro-kernel */
+struct GEMMKernelInfo
+{
+    /* name of the kernel */
+    const char * name;
+
+    /* number of rows in a register block */
+    int mr;
+
+    /* number of columns in a register block */
+    int nr;
+
+    /* the kernel function */
+    GEMMKernel kernel;
+};
+
+/* the generic micro-kernel (4 * 8). The compiler is free to vectorize the inner loop. */
+static void _GEMMKernelGeneric(int kc, const DTYPE * a, const DTYPE * b, DTYPE * c, int ldc, DTYPE alpha, DTYPE beta)
+{
+    DTYPE acc[4][8];
+    memset(acc, 0, sizeof(acc));
+
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < 4; i++) {
+            DTYPE ai = a[i];
+            for (int j = 0; j < 8; j++)
+                acc[i][j] += ai * b[j];
+        }
+        a += 4;
+        b += 8;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        DTYPE * ci = c + i * ldc;
+        if (beta == 0) {
+            for (int j = 0; j < 8; j++)
+                ci[j] = acc[i][j] * alpha;
+        }
+        else {
+            for (int j = 0; j < 8; j++)
+                ci[j] = acc[i][j] * alpha + ci[j] * beta;
+        }
+    }
+}
+
+#ifdef GEMM_X86_SIMD
+
+/* accumulate a row of the 6 * 16 block */
+#define AVX2_ROW_FMA(i, c0, c1) \
+    { __m256 ai = _mm256_broadcast_ss(a + i); \
+      c0 = _mm256_fmadd_ps(ai, b0, c0); \
+      c1 = _mm256_fmadd_ps(ai, b1, c1); }
+
+/* write a row of the 6 * 16 block back to c */
+#define AVX2_ROW_STORE(i, c0, c1) \
+    if (beta == 0) { \
+        _mm256_storeu_ps(c + i * ldc, _mm256_mul_ps(c0, va)); \
+        _mm256_storeu_ps(c + i * ldc + 8, _mm256_mul_ps(c1, va)); \
+    } \
+    else { \
+        _mm256_storeu_ps(c + i * ldc, _mm256_fmadd_ps(_mm256_loadu_ps(c + i * ldc), vb, _mm256_mul_ps(c0, va))); \
+        _mm256_storeu_ps(c + i * ldc + 8, _mm256_fmadd_ps(_mm256_loadu_ps(c + i * ldc + 8), vb, _mm256_mul_ps(c1, va))); \
+    }
+
+/* the AVX2 micro-kernel (6 * 16) that keeps 12 accumulators in the ymm registers */
+__attribute__((target("avx2,fma")))
+static void _GEMMKernelAVX2(int kc, const float * a, const float * b, float * c, int ldc, float alpha, float beta)
+{
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+        AVX2_ROW_FMA(0, c00, c01);
+        AVX2_ROW_FMA(1, c10, c11);
+        AVX2_ROW_FMA(2, c20, c21);
+        AVX2_ROW_FMA(3, c30, c31);
+        AVX2_ROW_FMA(4, c40, c41);
+        AVX2_ROW_FMA(5, c50, c51);
+        a += 6;
+        b += 16;
+    }
+
+    __m256 va = _mm256_set1_ps(alpha);
+    __m256 vb = _mm256_set1_ps(beta);
+    AVX2_ROW_STORE(0, c00, c01);
+    AVX2_ROW_STORE(1, c10, c11);
+    AVX2_ROW_STORE(2, c20, c21);
+    AVX2_ROW_STORE(3, c30, c31);
+    AVX2_ROW_STORE(4, c40, c41);
+    AVX2_ROW_STORE(5, c50, c51);
+}
+
+/* accumulate a row of the 8 * 32 block */
+#define AVX512_ROW_FMA(i, c0, c1) \
+    { __m512 ai = _mm512_set1_ps(a[i]); \
+      c0 = _mm512_fmadd_ps(ai, b0, c0); \
+      c1 = _mm512_fmadd_ps(ai, b1, c1); }
+
+/* write a row of the 8 * 32 block back to c */
+#define AVX512_ROW_STORE(i, c0, c1) \
+    if (beta == 0) { \
+        _mm512_storeu_ps(c + i * ldc, _mm512_mul_ps(c0, va)); \
+        _mm512_storeu_ps(c + i * ldc + 16, _mm512_mul_ps(c1, va)); \
+    } \
+    else { \
+        _mm512_storeu_ps(c + i * ldc, _mm512_fmadd_ps(_mm512_loadu_ps(c + i * ldc), vb, _mm512_mul_ps(c0, va))); \
+        _mm512_storeu_ps(c + i * ldc + 16, _mm512_fmadd_ps(_mm512_loadu_ps(c + i * ldc + 16), vb, _mm512_mul_ps(c1, va))); \
+    }
+
+/* the AVX-512 micro-kernel (8 * 32) that keeps 16 accumulators in the zmm registers */
+__attribute__((target("avx512f")))
+static void _GEMMKernelAVX512(int kc, const float * a, const float * b, float * c, int ldc, float alpha, float beta)
+{
+    __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+    __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+    __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+    __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+    __m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+    __m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+    __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+    __m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+
+    for (int p = 0; p < kc; p++) {
+        __m512 b0 = _mm512_loadu_ps(b);
+        __m512 b1 = _mm512_loadu_ps(b + 16);
+        AVX512_ROW_FMA(0, c00, c01);
+        AVX512_ROW_FMA(1, c10, c11);
+        AVX512_ROW_FMA(2, c20, c21);
+        AVX512_ROW_FMA(3, c30, c31);
+        AVX512_ROW_FMA(4, c40, c41);
+        AVX512_ROW_FMA(5, c50, c51);
+        AVX512_ROW_FMA(6, c60, c61);
+        AVX512_ROW_FMA(7, c70, c71);
+        a += 8;
+        b += 32;
+    }
+
+    __m512 va = _mm512_set1_ps(alpha);
+    __m512 vb = _mm512_set1_ps(beta);
+    AVX512_ROW_STORE(0, c00, c01);
+    AVX512_ROW_STORE(1, c10, c11);
+    AVX512_ROW_STORE(2, c20, c21);
+    AVX512_ROW_STORE(3, c30, c31);
+    AVX512_ROW_STORE(4, c40, c41);
+    AVX512_ROW_STORE(5, c50, c51);
+    AVX512_ROW_STORE(6, c60, c61);
+    AVX512_ROW_STORE(7, c70, c71);
+}
+
+#endif // GEMM_X86_SIMD
+
+/* all micro-kernels (indexed by GEMM_KERNEL_*) */
+static GEMMKernelInfo gemmKernels[] = {
+    {"generic", 4, 8, _GEMMKernelGeneric},
+#ifdef GEMM_X86_SIMD
+    {"avx2", 6, 16, _GEMMKernelAVX2},
+    {"avx512", 8, 32, _GEMMKernelAVX512},
+#endif
+};
+
+/* the micro-kernel in use (GEMM_KERNEL_AUTO means not decided yet) */
+static int gemmKernelType = GEMM_KERNEL_AUTO;
+
+/*
+check whether the CPU can run a given micro-kernel
+>> kernelType - GEMM_KERNEL_GENERIC, GEMM_KERNEL_AVX2 or GEMM_KERNEL_AVX512
+*/
+bool IsGEMMKernelSupported(int kernelType)
+{
+    if (kernelType == GEMM_KERNEL_GENERIC)
+        return true;
+#ifdef GEMM_X86_SIMD
+    __builtin_cpu_init();
+    if (kernelType == GEMM_KERNEL_AVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (kernelType == GEMM_KERNEL_AVX512)
+        return __builtin_cpu_supports("avx512f");
+#endif
+    return false;
+}
+
+/*
+select the micro-kernel
+>> kernelType - GEMM_KERNEL_GENERIC, GEMM_KERNEL_AVX2, GEMM_KERNEL_AVX512,
+                or GEMM_KERNEL_AUTO for the best one that the CPU supports
+*/
+void SetGEMMKernel(int kernelType)
+{
+    if (kernelType == GEMM_KERNEL_AUTO) {
+        if (IsGEMMKernelSupported(GEMM_KERNEL_AVX512))
+            kernelType = GEMM_KERNEL_AVX512;
+        else if (IsGEMMKernelSupported(GEMM_KERNEL_AVX2))
+            kernelType = GEMM_KERNEL_AVX2;
+        else
+            kernelType = GEMM_KERNEL_GENERIC;
+    }
+
+    CheckNTErrors(IsGEMMKernelSupported(kernelType), "The GEMM kernel is not supported by the CPU!");
+
+    gemmKernelType = kernelType;
+}
+
+/* get the micro-kernel in use */
+int GetGEMMKernel()
+{
+    if (gemmKernelType == GEMM_KERNEL_AUTO)
+        SetGEMMKernel(GEMM_KERNEL_AUTO);
+
+    return gemmKernelType;
+}
+
+/* get the name of the micro-kernel in use */
+const char * GetGEMMKernelName()
+{
+    return gemmKernels[GetGEMMKernel()].name;
+}
+
+/*
+allocate a buffer aligned to the cache line
+>> size - number of items
+>> raw - the pointer that is released by free()
+<< return - the aligned buffer
+*/
+static DTYPE * AllocPackBuffer(int size, void ** raw)
+{
+    *raw = malloc(sizeof(DTYPE) * size + 64);
+    CheckNTErrors(*raw != NULL, "Cannot allocate the packing buffer!");
+    return (DTYPE*)(((size_t)*raw + 63) & ~(size_t)63);
+}
+
+/* a packing buffer that a thread keeps, so that it is not allocated in every multiplication */
+struct GEMMPackBuffer
+{
+    /* the memory that is allocated from the system */
+    void * raw;
+
+    /* the buffer (aligned to the cache line) */
+    DTYPE * data;
+
+    /* number of items in the buffer */
+    int size;
+
+    /* indicates whether the buffer is in use (for the shared op(b)) */
+    bool busy;
+
+    /* constructor */
+    GEMMPackBuffer()
+    {
+        raw = NULL;
+        data = NULL;
+        size = 0;
+        busy = false;
+    }
+
+    /* de-constructor */
+    ~GEMMPackBuffer()
+    {
+        free(raw);
+    }
+
+    /*
+    get a buffer of a given size (it grows if needed)
+    >> mySize - number of items
+    */
+    DTYPE * Get(int mySize)
+    {
+        if (mySize > size) {
+            free(raw);
+            data = AllocPackBuffer(mySize, &raw);
+            size = mySize;
+        }
+        return data;
+    }
+};
+
+/* the buffers of the blocks of op(a) and op(b) that are packed by the current thread */
+static thread_local GEMMPackBuffer threadPackA;
+static thread_local GEMMPackBuffer threadPackB;
+
+/* the buffer of the whole op(b) that the current thread packs for the jobs of a multiplication */
+static thread_local GEMMPackBuffer threadPackShared;
+
+/*
+pack a mc * kc block of op(a) into slivers of mr rows. In each sliver
+the mr items of the same column are continuous. The margin is padded with 0.
+>> transposed - indicates whether a is transposed
+>> mc - number of rows
+>> kc - number of columns
+>> a - the upper-left corner of the block
+>> lda - leading dimension of a
+>> mr - rows of a sliver
+>> buf - the packed buffer
+*/
+static void PackBlockA(bool transposed, int mc, int kc, const DTYPE * a, int lda, int mr, DTYPE * buf)
+{
+    for (int i0 = 0; i0 < mc; i0 += mr) {
+        int rows = MIN(mr, mc - i0);
+        if (transposed) {
+            for (int p = 0; p < kc; p++) {
+                const DTYPE * ap = a + p * lda + i0;
+                for (int i = 0; i < rows; i++)
+                    buf[i] = ap[i];
+                for (int i = rows; i < mr; i++)
+                    buf[i] = 0;
+                buf += mr;
+            }
+        }
+        else {
+            for (int p = 0; p < kc; p++) {
+                const DTYPE * ap = a + i0 * lda + p;
+                for (int i = 0; i < rows; i++)
+                    buf[i] = ap[i * lda];
+                for (int i = rows; i < mr; i++)
+                    buf[i] = 0;
+                buf += mr;
+            }
+        }
+    }
+}
+
+/*
+pack a kc * nc block of op(b) into slivers of nr columns. In each sliver
+the nr items of the same row are continuous. The margin is padded with 0.
+>> transposed - indicates whether b is transposed
+>> kc - number of rows
+>> nc - number of columns
+>> b - the upper-left corner of the block
+>> ldb - leading dimension of b
+>> nr - columns of a sliver
+>> buf - the packed buffer
+*/
+static void PackBlockB(bool transposed, int kc, int nc, const DTYPE * b, int ldb, int nr, DTYPE * buf)
+{
+    for (int j0 = 0; j0 < nc; j0 += nr) {
+        int cols = MIN(nr, nc - j0);
+        if (transposed) {
+            for (int p = 0; p < kc; p++) {
+                const DTYPE * bp = b + j0 * ldb + p;
+                for (int j = 0; j < cols; j++)
+                    buf[j] = bp[j * ldb];
+                for (int j = cols; j < nr; j++)
+                    buf[j] = 0;
+                buf += nr;
+            }
+        }
+        else {
+            for (int p = 0; p < kc; p++) {
+                const DTYPE * bp = b + p * ldb + j0;
+                for (int j = 0; j < cols; j++)
+                    buf[j] = bp[j];
+                for (int j = cols; j < nr; j++)
+                    buf[j] = 0;
+                buf += nr;
+            }
+        }
+    }
+}
+
+/*
+pack the columns col1...col2 of op(b) block by block. For each block of
+GEMM_KC rows (from row pc), the block is packed at buf + pc * paddedN,
+which is the layout that _GEMMBlocked reads the panels of a packed op(b)
+from, and column j of the block is in the sliver at j * kc.
+>> transposed - indicates whether b is transposed
+>> k - number of rows of op(b)
+>> col1 - the first column (a multiple of nr)
+>> col2 - the column after the last one
+>> b - matrix b
+>> ldb - leading dimension of b
+>> nr - columns of a sliver
+>> paddedN - number of columns after padding to whole slivers
+>> buf - the packed buffer
+*/
+static void PackMatrixB(bool transposed, int k, int col1, int col2, const DTYPE * b, int ldb,
+                        int nr, int paddedN, DTYPE * buf)
+{
+    for (int pc = 0; pc < k; pc += GEMM_KC) {
+        int kc = MIN(GEMM_KC, k - pc);
+        const DTYPE * bBlock = transposed ? b + col1 * ldb + pc : b + pc * ldb + col1;
+        PackBlockB(transposed, kc, col2 - col1, bBlock, ldb, nr, buf + pc * paddedN + col1 * kc);
+    }
+}
+
+/*
+apply the epilogue to a block of c, i.e., c = f(c + bias) + residual
+>> epilogue - the epilogue
+>> c - the upper-left corner of the block
+>> ldc - leading dimension of c
+>> row - the row of c that the block begins with
+>> col - the column of c that the block begins with
+>> rows - number of rows of the block
+>> cols - number of columns of the block
+*/
+static void ApplyEpilogue(const GEMMEpilogue * epilogue, DTYPE * c, int ldc,
+                          int row, int col, int rows, int cols)
+{
+    const DTYPE * bias = epilogue->bias != NULL ? epilogue->bias + col : NULL;
+
+    for (int i = 0; i < rows; i++) {
+        DTYPE * ci = c + i * ldc;
+        const DTYPE * ri = epilogue->residual != NULL ?
+                           epilogue->residual + (size_t)(row + i) * epilogue->ldr + col : NULL;
+        for (int j = 0; j < cols; j++) {
+            DTYPE v = ci[j];
+            if (bias != NULL)
+                v += bias[j];
+            if (epilogue->rectify)
+                v = v > 0 ? v : 0;
+            if (ri != NULL)
+                v += ri[j];
+            ci[j] = v;
+        }
+    }
+}
+
+/*
+the blocked matrix multiplication on raw buffers (row-major)
+c = op(a) * op(b) * alpha + c * beta
+where op(a) is m * k, op(b) is k * n and c is m * n.
+The computation is blocked as follows: c is split into column panels
+of GEMM_NC, k is split into GEMM_KC, and op(a) is split into row panels of
+GEMM_MC. Each panel of op(b) stays in the L3/L2 cache and each panel
+of op(a) stays in the L2 cache while the micro-kernel runs on them.
+If op(b) is packed in advance (see XPackedMatrix), the panels are read
+from the packed data instead of being packed here. The packing buffers
+are kept by the thread and reused in the next calls. The epilogue (if
+any) is applied to each register block in the last block of k, right
+after the micro-kernel writes it.
+>> info - the micro-kernel
+>> transposedA - indicates whether a is transposed
+>> transposedB - indicates whether b is transposed
+>> m - number of rows of c
+>> n - number of columns of c
+>> k - the inner dimension
+>> alpha - a coefficient
+>> a - matrix a
+>> lda - leading dimension of a
+>> b - matrix b (not used if packedB is not NULL)
+>> ldb - leading dimension of b
+>> packedB - op(b) that is packed in advance (NULL if it is not packed)
+>> packedN - number of columns of the packed op(b) (padded to whole slivers)
+>> packedCol - the column of the packed op(b) that c begins with (a multiple of nr)
+>> beta - another coefficient
+>> c - matrix c
+>> ldc - leading dimension of c
+>> epilogue - the epilogue (NULL if there is no epilogue), whose bias and
+              residual begin with the column and the row that c begins with
+*/
+static void _GEMMBlocked(const GEMMKernelInfo * info, bool transposedA, bool transposedB,
+                         int m, int n, int k, DTYPE alpha, const DTYPE * a, int lda,
+                         const DTYPE * b, int ldb, const DTYPE * packedB, int packedN, int packedCol,
+                         DTYPE beta, DTYPE * c, int ldc, const GEMMEpilogue * epilogue)
+{
+    if (m <= 0 || n <= 0)
+        return;
+
+    /* nothing to multiply */
+    if (k <= 0) {
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++)
+                c[i * ldc + j] = beta == 0 ? 0 : c[i * ldc + j] * beta;
+        }
+        if (epilogue != NULL)
+            ApplyEpilogue(epilogue, c, ldc, 0, 0, m, n);
+        return;
+    }
+
+    GEMMKernel kernel = info->kernel;
+    int mr = info->mr;
+    int nr = info->nr;
+
+    int kcMax = MIN(k, GEMM_KC);
+    int mcMax = MIN((m + mr - 1) / mr * mr, GEMM_MC);
+    int ncMax = MIN((n + nr - 1) / nr * nr, GEMM_NC);
+
+    DTYPE * aBuf = threadPackA.Get(mcMax * kcMax);
+    DTYPE * bBuf = packedB == NULL ? threadPackB.Get(ncMax * kcMax) : NULL;
+    DTYPE tile[GEMM_MAX_MR * GEMM_MAX_NR];
+
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = MIN(GEMM_NC, n - jc);
+
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = MIN(GEMM_KC, k - pc);
+
+            /* c is scaled by beta only once */
+            DTYPE betaBlock = pc == 0 ? beta : (DTYPE)1.0;
+
+            /* the epilogue is applied when the blocks of c are done */
+            const GEMMEpilogue * epilogueBlock = pc + kc >= k ? epilogue : NULL;
+
+            const DTYPE * bPanel = NULL;
+            if (packedB != NULL)
+                bPanel = packedB + pc * packedN + (packedCol + jc) * kc;
+            else {
+                const DTYPE * bBlock = transposedB ? b + jc * ldb + pc : b + pc * ldb + jc;
+                PackBlockB(transposedB, kc, nc, bBlock, ldb, nr, bBuf);
+                bPanel = bBuf;
+            }
+
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = MIN(GEMM_MC, m - ic);
+
+                const DTYPE * aBlock = transposedA ? a + pc * lda + ic : a + ic * lda + pc;
+                PackBlockA(transposedA, mc, kc, aBlock, lda, mr, aBuf);
+
+                for (int jr = 0; jr < nc; jr += nr) {
+                    int cols = MIN(nr, nc - jr);
+                    const DTYPE * bp = bPanel + jr * kc;
+
+                    for (int ir = 0; ir < mc; ir += mr) {
+                        int rows = MIN(mr, mc - ir);
+                        const DTYPE * ap = aBuf + ir * kc;
+                        DTYPE * cp = c + (ic + ir) * ldc + jc + jr;
+
+                        if (rows == mr && cols == nr) {
+                            kernel(kc, ap, bp, cp, ldc, alpha, betaBlock);
+                        }
+                        /* the margin is computed in a temporary tile */
+                        else {
+                            kernel(kc, ap, bp, tile, nr, alpha, 0);
+                            for (int i = 0; i < rows; i++) {
+                                DTYPE * ci = cp + i * ldc;
+                                DTYPE * ti = tile + i * nr;
+                                if (betaBlock == 0) {
+                                    for (int j = 0; j < cols; j++)
+                                        ci[j] = ti[j];
+                                }
+                                else {
+                                    for (int j = 0; j < cols; j++)
+                                        ci[j] = ti[j] + ci[j] * betaBlock;
+                                }
+                            }
+                        }
+
+                        if (epilogueBlock != NULL)
+                            ApplyEpilogue(epilogueBlock, cp, ldc, ic + ir, jc + jr, rows, cols);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+matrix multiplication on raw buffers (row-major) with packing
+c = op(a) * op(b) * alpha + c * beta
+where op(a) is m * k, op(b) is k * n and c is m * n.
+Both operands are packed block by block (see _GEMMBlocked).
+>> transposedA - indicates whether a is transposed
+>> transposedB - indicates whether b is transposed
+>> m - number of rows of c
+>> n - number of columns of c
+>> k - the inner dimension
+>> alpha - a coefficient
+>> a - matrix a
+>> lda - leading dimension of a
+>> b - matrix b
+>> ldb - leading dimension of b
+>> beta - another coefficient
+>> c - matrix c
+>> ldc - leading dimension of c
+*/
+void _GEMMPacked(bool transposedA, bool transposedB, int m, int n, int k,
+                 DTYPE alpha, const DTYPE * a, int lda, const DTYPE * b, int ldb,
+                 DTYPE beta, DTYPE * c, int ldc)
+{
+    _GEMMBlocked(gemmKernels + GetGEMMKernel(), transposedA, transposedB, m, n, k,
+                 alpha, a, lda, b, ldb, NULL, 0, 0, beta, c, ldc, NULL);
+}
+
+/*
+matrix multiplication for a block (x1,y1) - (x2,y2) of c with packing
+where (x1,y1) is the upper-left corner and (x2,y2) is the bottom-right corner
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2)
+            and a TensorList of a, b, c, alpha, beta, transposedA and transposedB
+*/
+void _MatrixMul2DPackedBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * matrixArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(matrixArgs->count == 7, "invalid argument number!");
+
+    XTensor * a = matrixArgs->GetItem(0);
+    XTensor * b = matrixArgs->GetItem(1);
+    XTensor * c = matrixArgs->GetItem(2);
+    DTYPE alpha = *(DTYPE*)(matrixArgs->GetItem(3));
+    DTYPE beta = *(DTYPE*)(matrixArgs->GetItem(4));
+    bool transposedA = *(MATRIX_TRANS_TYPE*)(matrixArgs->GetItem(5)) == X_TRANS;
+    bool transposedB = *(MATRIX_TRANS_TYPE*)(matrixArgs->GetItem(6)) == X_TRANS;
+    int x1 = indexArgs->GetItem(0);
+    int y1 = indexArgs->GetItem(1);
+    int x2 = indexArgs->GetItem(2);
+    int y2 = indexArgs->GetItem(3);
+
+    int lda = a->dimSize[1];
+    int ldb = b->dimSize[1];
+    int ldc = c->dimSize[1];
+    int k = transposedA ? a->dimSize[0] : a->dimSize[1];
+
+    /* move to the rows of op(a) and the columns of op(b) that the block needs */
+    const DTYPE * ap = (DTYPE*)a->data + (transposedA ? x1 : x1 * lda);
+    const DTYPE * bp = (DTYPE*)b->data + (transposedB ? y1 * ldb : y1);
+    DTYPE * cp = (DTYPE*)c->data + x1 * ldc + y1;
+
+    _GEMMPacked(transposedA, transposedB, x2 - x1 + 1, y2 - y1 + 1, k,
+                alpha, ap, lda, bp, ldb, beta, cp, ldc);
+}
+
+/* arguments of a block of the multiplication with a packed op(b) */
+struct PackedMulArgs
+{
+    /* the micro-kernel that op(b) is packed for */
+    const GEMMKernelInfo * info;
+
+    /* matrix a, and op(a) is (m, k) */
+    const DTYPE * a;
+
+    /* leading dimension of a */
+    int lda;
+
+    /* indicates whether a is transposed */
+    bool transposedA;
+
+    /* the packed op(b), (k, n) */
+    const DTYPE * b;
+
+    /* the inner dimension */
+    int k;
+
+    /* number of columns of op(b) */
+    int n;
+
+    /* number of columns of the packed op(b) (padded to whole slivers) */
+    int paddedN;
+
+    /* matrix c, (m, n) */
+    DTYPE * c;
+
+    /* leading dimension of c */
+    int ldc;
+
+    /* the coefficients */
+    DTYPE alpha;
+    DTYPE beta;
+
+    /* the epilogue (NULL if there is no epilogue) */
+    const GEMMEpilogue * epilogue;
+};
+
+/*
+matrix multiplication with a packed op(b) for a block (x1,y1) - (x2,y2),
+where the rows are those of c and the columns are the slivers of op(b)
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2)
+            and a TensorList holding the PackedMulArgs structure
+*/
+static void _MatrixMulPackedBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * mulArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(mulArgs->count == 1, "invalid argument number!");
+
+    PackedMulArgs * p = (PackedMulArgs*)mulArgs->GetItem(0);
+    const GEMMKernelInfo * info = p->info;
+    int x1 = indexArgs->GetItem(0);
+    int y1 = indexArgs->GetItem(1);
+    int x2 = indexArgs->GetItem(2);
+    int y2 = indexArgs->GetItem(3);
+
+    int col1 = y1 * info->nr;
+    int col2 = MIN((y2 + 1) * info->nr, p->n);
+    const DTYPE * a = p->a + (p->transposedA ? x1 : x1 * p->lda);
+
+    /* the epilogue of the block */
+    GEMMEpilogue epilogue;
+    if (p->epilogue != NULL) {
+        epilogue = *p->epilogue;
+        if (epilogue.bias != NULL)
+            epilogue.bias += col1;
+        if (epilogue.residual != NULL)
+            epilogue.residual += (size_t)x1 * epilogue.ldr + col1;
+    }
+
+    _GEMMBlocked(info, p->transposedA, false, x2 - x1 + 1, col2 - col1, p->k,
+                 p->alpha, a, p->lda, NULL, 0, p->b, p->paddedN, col1,
+                 p->beta, p->c + x1 * p->ldc + col1, p->ldc,
+                 p->epilogue != NULL ? &epilogue : NULL);
+}
+
+/* arguments of a block of the packing of op(b) */
+struct PackArgs
+{
+    /* matrix b */
+    const DTYPE * b;
+
+    /* leading dimension of b */
+    int ldb;
+
+    /* indicates whether b is transposed */
+    bool transposed;
+
+    /* number of rows and columns of op(b) */
+    int k;
+    int n;
+
+    /* columns of a sliver */
+    int nr;
+
+    /* number of columns after padding to whole slivers */
+    int paddedN;
+
+    /* the packed buffer */
+    DTYPE * buf;
+};
+
+/*
+pack the slivers y1...y2 of op(b)
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2),
+            of which only the slivers y1 and y2 are used, and a TensorList
+            holding the PackArgs structure
+*/
+static void _PackMatrixBBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * packArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(packArgs->count == 1, "invalid argument number!");
+
+    PackArgs * p = (PackArgs*)packArgs->GetItem(0);
+    int y1 = indexArgs->GetItem(1);
+    int y2 = indexArgs->GetItem(3);
+
+    PackMatrixB(p->transposed, p->k, y1 * p->nr, MIN((y2 + 1) * p->nr, p->n),
+                p->b, p->ldb, p->nr, p->paddedN, p->buf);
+}
+
+/*
+matrix multiplication on raw buffers (row-major) with packing and multi-threading
+c = f(op(a) * op(b) * alpha + c * beta + bias) + residual
+where op(a) is m * k, op(b) is k * n and c is m * n, and the epilogue (the
+bias, f and the residual) is optional. If c is computed in one job, the
+panels of op(b) are packed as they are used. Otherwise the whole op(b) is
+packed once (in parallel) and shared by the jobs, so that the blocks of
+rows do not pack the same panels again, and c is segmented into blocks of
+rows and slivers.
+>> transposedA - indicates whether a is transposed
+>> transposedB - indicates whether b is transposed
+>> m - number of rows of c
+>> n - number of columns of c
+>> k - the inner dimension
+>> alpha - a coefficient
+>> a - matrix a
+>> lda - leading dimension of a
+>> b - matrix b
+>> ldb - leading dimension of b
+>> beta - another coefficient
+>> c - matrix c
+>> ldc - leading dimension of c
+>> epilogue - the epilogue (NULL if there is no epilogue)
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _GEMMPackedParallel(bool transposedA, bool transposedB, int m, int n, int k,
+                         DTYPE alpha, const DTYPE * a, int lda, const DTYPE * b, int ldb,
+                         DTYPE beta, DTYPE * c, int ldc, const GEMMEpilogue * epilogue,
+                         XPRunner * parallelRunner)
+{
+    const GEMMKernelInfo * info = gemmKernels + GetGEMMKernel();
+    int paddedN = (n + info->nr - 1) / info->nr * info->nr;
+    int sliverNum = paddedN / info->nr;
+
+    /* number of multiply-add operations (clipped to avoid overflow) */
+    double opNum = (double)m * n * k;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    if (GetParallel2DJobNum(parallelRunner, (int)opNum, m, sliverNum) <= 1) {
+        _GEMMBlocked(info, transposedA, transposedB, m, n, k, alpha, a, lda, b, ldb,
+                     NULL, 0, 0, beta, c, ldc, epilogue);
+        return;
+    }
+
+    /* the buffer of the thread is in use if this is called by a job of another multiplication */
+    void * raw = NULL;
+    bool shared = !threadPackShared.busy;
+    DTYPE * packedB = shared ? threadPackShared.Get(MAX(k * paddedN, 1)) : AllocPackBuffer(MAX(k * paddedN, 1), &raw);
+    threadPackShared.busy = true;
+
+    PackArgs pack;
+    pack.b = b;
+    pack.ldb = ldb;
+    pack.transposed = transposedB;
+    pack.k = k;
+    pack.n = n;
+    pack.nr = info->nr;
+    pack.paddedN = paddedN;
+    pack.buf = packedB;
+
+    /* number of items to copy (clipped to avoid overflow) */
+    double copyNum = (double)k * paddedN;
+    if (copyNum > INT_MAX)
+        copyNum = INT_MAX;
+
+    RunParallel2D(parallelRunner, (void*)_PackMatrixBBlock, (int)copyNum,
+                  1, sliverNum, 1, &pack);
+
+    PackedMulArgs args;
+    args.info = info;
+    args.a = a;
+    args.lda = lda;
+    args.transposedA = transposedA;
+    args.b = packedB;
+    args.k = k;
+    args.n = n;
+    args.paddedN = paddedN;
+    args.c = c;
+    args.ldc = ldc;
+    args.alpha = alpha;
+    args.beta = beta;
+    args.epilogue = epilogue;
+
+    RunParallel2D(parallelRunner, (void*)_MatrixMulPackedBlock, (int)opNum,
+                  m, sliverNum, 1, &args);
+
+    if (shared)
+        threadPackShared.busy = false;
+    else
+        free(raw);
+}
+
+/*
+matrix multiplication (for 2d tensors) with packing and multi-threading.
+c = trans(a) * trans(b) * alpha + c * beta
+where trans() return the transposed matrix if the flag is fired
+(see _GEMMPackedParallel).
+
+>> a - tensor a
+>> transposedA - indicates whether the matrices in a are transposed
+>> b - tensor b
+>> transposedB - indicates whether teh matrices in b are transposed
+>> c - where we put a*b
+>> alpha - a coefficient
+>> beta - another coefficient
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _MatrixMul2DPacked(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
+                        const XTensor * b, MATRIX_TRANS_TYPE transposedB,
+                        XTensor * c, DTYPE alpha, DTYPE beta, XPRunner * parallelRunner)
+{
+    CheckNTErrors((a && b && c), "Empty input tensors!");
+    CheckNTErrors((a->order == 2 && b->order == 2 && c->order == 2),
+                  "Input tensors must have a order = 2!");
+    CheckNTErrors((a->dataType == DEFAULT_DTYPE && b->dataType == DEFAULT_DTYPE &&
+                   c->dataType == DEFAULT_DTYPE), "Unsupported data type!");
+
+    int k = transposedA == X_TRANS ? a->dimSize[0] : a->dimSize[1];
+
+    _GEMMPackedParallel(transposedA == X_TRANS, transposedB == X_TRANS, c->dimSize[0], c->dimSize[1], k,
+                        alpha, (DTYPE*)a->data, a->dimSize[1], (DTYPE*)b->data, b->dimSize[1],
+                        beta, (DTYPE*)c->data, c->dimSize[1], NULL, parallelRunner);
+}
+
+/* constructor */
+XPackedMatrix::XPackedMatrix()
+{
+    data = NULL;
+    k = 0;
+    n = 0;
+    paddedN = 0;
+    kernelType = GEMM_KERNEL_AUTO;
+    enabled = false;
+    raw = NULL;
+}
+
+/* de-constructor */
+XPackedMatrix::~XPackedMatrix()
+{
+    Clear();
+}
+
+/*
+pack op(b) for the micro-kernel in use. For each block of GEMM_KC rows
+(from row pc), the block is packed at data + pc * paddedN in the same
+way as _GEMMPacked packs it, so the results are the same as those of
+the multiplication with the unpacked matrix.
+>> b - the matrix (in float on CPUs)
+>> transposed - indicates whether b is transposed, i.e., op(b) = trans(b)
+*/
+void XPackedMatrix::Pack(const XTensor * b, MATRIX_TRANS_TYPE transposed)
+{
+    CheckNTErrors(b != NULL && b->order == 2, "The packed matrix must be a 2d tensor!");
+    CheckNTErrors(b->devID < 0 && b->dataType == DEFAULT_DTYPE && !b->isSparse,
+                  "Only dense float matrices on CPUs can be packed!");
+
+    Clear();
+
+    kernelType = GetGEMMKernel();
+    int nr = gemmKernels[kernelType].nr;
+    int ldb = b->dimSize[1];
+
+    k = transposed == X_TRANS ? b->dimSize[1] : b->dimSize[0];
+    n = transposed == X_TRANS ? b->dimSize[0] : b->dimSize[1];
+    paddedN = (n + nr - 1) / nr * nr;
+
+    data = AllocPackBuffer(MAX(k * paddedN, 1), &raw);
+
+    PackMatrixB(transposed == X_TRANS, k, 0, n, (DTYPE*)b->data, ldb, nr, paddedN, data);
+
+    enabled = true;
+}
+
+/* release the packed data */
+void XPackedMatrix::Clear()
+{
+    free(raw);
+    raw = NULL;
+    data = NULL;
+    k = 0;
+    n = 0;
+    paddedN = 0;
+    enabled = false;
+}
+
+/*
+matrix multiplication with a packed matrix and multi-threading
+c = a * b * alpha + c * beta
+followed by the epilogue if it is given (see GEMMEpilogue).
+c is segmented into blocks of rows and slivers, and each block is
+processed by a job. The micro-kernel that b is packed for is used.
+
+>> a - tensor a, (..., k)
+>> b - the packed matrix, from a (k, n) matrix
+>> c - where we put a*b, (..., n)
+>> alpha - a coefficient
+>> beta - another coefficient
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+>> epilogue - the epilogue (NULL if there is no epilogue)
+*/
+void _MatrixMulPacked(const XTensor * a, const XPackedMatrix * b, XTensor * c,
+                      DTYPE alpha, DTYPE beta, XPRunner * parallelRunner,
+                      const GEMMEpilogue * epilogue)
+{
+    CheckNTErrors(a && b && c, "Empty input tensors!");
+    CheckNTErrors(b->enabled, "The matrix is not packed!");
+    CheckNTErrors(a->devID < 0 && c->devID < 0, "The packed matrix multiplication only runs on CPUs!");
+    CheckNTErrors(a->dataType == DEFAULT_DTYPE && c->dataType == DEFAULT_DTYPE, "Unsupported data type!");
+    CheckNTErrors(!a->isSparse && !c->isSparse, "Unsupported sparse tensors!");
+
+    int k = b->k;
+    int n = b->n;
+
+    CheckNTErrors(a->GetDim(-1) == k, "Unmatched tensors in multiplication!");
+
+    int m = a->unitNum / k;
+
+    CheckNTErrors(c->GetDim(-1) == n && c->unitNum == m * n, "Unmatched tensors in multiplication!");
+
+    PackedMulArgs args;
+    args.info = gemmKernels + b->kernelType;
+    args.a = (DTYPE*)a->data;
+    args.lda = k;
+    args.transposedA = false;
+    args.b = b->data;
+    args.k = k;
+    args.n = n;
+    args.paddedN = b->paddedN;
+    args.c = (DTYPE*)c->data;
+    args.ldc = n;
+    args.alpha = alpha;
+    args.beta = beta;
+    args.epilogue = epilogue;
+
+    /* number of multiply-add operations (clipped to avoid overflow) */
+    double opNum = (double)m * n * k;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_MatrixMulPackedBlock, (int)opNum,
+                  m, b->paddedN / gemmKernels[b->kernelType].nr, 1, &args);
+}
+
+/*
+matrix multiplication with a packed matrix (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+
+c = a * b
+>> a - tensor a, (..., k)
+>> b - the packed matrix, from a (k, n) matrix
+<< return - the result, (..., n)
+*/
+XTensor MMulPacked(const XTensor &a, const XPackedMatrix &b)
+{
+    int * dimSize = new int[a.order];
+    memcpy(dimSize, a.dimSize, sizeof(int) * a.order);
+    dimSize[a.order - 1] = b.n;
+
+    XTensor c;
+    InitTensor(&c, a.order, dimSize, X_FLOAT, a.devID, false);
+    c.SetTMPFlag();
+
+    _MatrixMulPacked(&a, &b, &c);
+
+    delete[] dimSize;
+
+    return c;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,176 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* A cache-blocked matrix multiplication engine for the CPU. Both operands
+* are packed into panels that fit in the cache and the inner product is
+* computed by a register-blocked micro-kernel. The micro-kernel (generic,
+* AVX2 or AVX-512) is chosen at runtime according to the CPU.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __MATRIXMUL2DPACKED_H__
+#define __MATRIXMUL2DPACKED_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* micro-kernels of the packed matrix multiplication */
+#define GEMM_KERNEL_AUTO -1
+#define GEMM_KERNEL_GENERIC 0
+#define GEMM_KERNEL_AVX2 1
+#define GEMM_KERNEL_AVX512 2
+
+/* block sizes along the k, m and n dimensions */
+#define GEMM_KC 256
+#define GEMM_MC 96
+#define GEMM_NC 2048
+
+/*
+an epilogue of the packed matrix multiplication, i.e., c = f(c + bias) + residual
+where f is ReLU or the identity function. It is applied to each block of c
+as soon as the block is computed, while the block is still in the cache.
+*/
+struct GEMMEpilogue
+{
+    /* the bias of the columns (NULL if there is no bias) */
+    const DTYPE * bias;
+
+    /* indicates whether ReLU is applied */
+    bool rectify;
+
+    /* the residual (NULL if there is no residual) */
+    const DTYPE * residual;
+
+    /* leading dimension of the residual */
+    int ldr;
+};
+
+/* check whether the CPU can run a given micro-kernel */
+bool IsGEMMKernelSupported(int kernelType);
+
+/* select the micro-kernel (GEMM_KERNEL_AUTO means the best one the CPU supports) */
+void SetGEMMKernel(int kernelType);
+
+/* get the micro-kernel in use */
+int GetGEMMKernel();
+
+/* get the name of the micro-kernel in use */
+const char * GetGEMMKernelName();
+
+/*
+matrix multiplication on raw buffers (row-major) with packing
+c = op(a) * op(b) * alpha + c * beta
+where op(a) is m * k, op(b) is k * n and c is m * n
+*/
+void _GEMMPacked(bool transposedA, bool transposedB, int m, int n, int k,
+                 DTYPE alpha, const DTYPE * a, int lda, const DTYPE * b, int ldb,
+                 DTYPE beta, DTYPE * c, int ldc);
+
+/*
+matrix multiplication on raw buffers (row-major) with packing and multi-threading
+c = f(op(a) * op(b) * alpha + c * beta + bias) + residual
+where the epilogue (the bias, f and the residual) is optional
+*/
+void _GEMMPackedParallel(bool transposedA, bool transposedB, int m, int n, int k,
+                         DTYPE alpha, const DTYPE * a, int lda, const DTYPE * b, int ldb,
+                         DTYPE beta, DTYPE * c, int ldc, const GEMMEpilogue * epilogue = NULL,
+                         XPRunner * parallelRunner = NULL);
+
+/*
+matrix multiplication for a block (x1,y1) - (x2,y2) of c with packing.
+It is an instance of TFunction that is used in RunParallel2D.
+*/
+void _MatrixMul2DPackedBlock(TensorList * args);
+
+/*
+matrix multiplication (for 2d tensors) with packing and multi-threading.
+c = trans(a) * trans(b) * alpha + c * beta
+*/
+void _MatrixMul2DPacked(const XTensor * a, MATRIX_TRANS_TYPE transposedA, const XTensor * b, MATRIX_TRANS_TYPE transposedB,
+                        XTensor * c, DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0, XPRunner * parallelRunner = NULL);
+
+/*
+a matrix that is packed into the layout of the micro-kernel once, e.g., the
+weight of a model at load time, so that the multiplications with it do not
+pack or transpose it again. For each block of GEMM_KC rows of op(b), the
+columns are kept in slivers of nr columns (padded with 0).
+*/
+class XPackedMatrix
+{
+public:
+    /* the packed data */
+    DTYPE * data;
+
+    /* number of rows of op(b), i.e., the inner dimension */
+    int k;
+
+    /* number of columns of op(b) */
+    int n;
+
+    /* number of columns after padding to whole slivers */
+    int paddedN;
+
+    /* the micro-kernel that the matrix is packed for */
+    int kernelType;
+
+    /* indicates whether the matrix is packed */
+    bool enabled;
+
+private:
+    /* the memory that is allocated from the system */
+    void * raw;
+
+public:
+    /* constructor */
+    XPackedMatrix();
+
+    /* de-constructor */
+    ~XPackedMatrix();
+
+    /* pack op(b) for the micro-kernel in use */
+    void Pack(const XTensor * b, MATRIX_TRANS_TYPE transposed);
+
+    /* release the packed data */
+    void Clear();
+
+private:
+    /* the packed data is not shared by copies */
+    XPackedMatrix(const XPackedMatrix &);
+    XPackedMatrix & operator=(const XPackedMatrix &);
+};
+
+/*
+matrix multiplication with a packed matrix and multi-threading
+c = a * b * alpha + c * beta (followed by an optional epilogue)
+where a is (..., k), b is packed from a (k, n) matrix and c is (..., n)
+*/
+void _MatrixMulPacked(const XTensor * a, const XPackedMatrix * b, XTensor * c,
+                      DTYPE alpha = (DTYPE)1.0, DTYPE beta = 0, XPRunner * parallelRunner = NULL,
+                      const GEMMEpilogue * epilogue = NULL);
+
+/*
+matrix multiplication with a packed matrix (return an XTensor structure)
+c = a * b
+*/
+XTensor MMulPacked(const XTensor &a, const XPackedMatrix &b);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __MATRIXMUL2DPACKED_H__
@@ -21,8 +21,7 @@
 
 #include "../../XTensor.h"
 #include "MatrixMul2DParallel.h"
-#include "MatrixMul2DMultiTheading.h"
-#include "../utilities/XMatrixSegment.h"
+#include "MatrixMul2DPacked.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -38,7 +37,7 @@ where trans() return the transposed matrix if the flag is fired
 >> c - where we put a*b
 >> alpha - a coefficient
 >> beta - another coefficient
->> parallelRunner - parallel processing module
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
 */
 void _MatrixMul2DParallel(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
                           const XTensor * b, MATRIX_TRANS_TYPE transposedB,
@@ -48,84 +47,10 @@ void _MatrixMul2DParallel(const XTensor * a, MATRIX_TRANS_TYPE transposedA,
     CheckNTErrors((a->order == 2 && b->order == 2 && c->order == 2),
         "Input tensors must have a order = 2!");
 
-    int an = a->dimSize[0], am = a->dimSize[1];
-    int bm = b->dimSize[1];
-    int cn = c->dimSize[0], cm = c->dimSize[1];
-    int aColNum = am;
-    int bColNum = bm;
-
-    /*if (beta == 0)
-        c->SetZeroAll();*/
-
-    /* a * b */
-    if (transposedA == X_NOTRANS && transposedB == X_NOTRANS) {
-        RunParallel2D(parallelRunner, (void*)_MatrixMul2DMultiTheading, an * am * bm,
-                      cn, cm, 5,
-                      a, b, c, &alpha, &beta);
-    }
-    /* trans(a) * b */
-    else if (transposedA == X_TRANS && transposedB == X_NOTRANS) {
-        int num = an;
-        for (int i = 0; i < cn; i++) {
-            DTYPE * p3 = (DTYPE*)c->data + i * cm;
-            for (int j = 0; j < cm; j++) {
-                DTYPE r = 0;
-                DTYPE * p1 = (DTYPE*)a->data + 0 * am + i;
-                DTYPE * p2 = (DTYPE*)b->data + 0 * bm + j;
-
-                for (int k = 0; k < num; k++) {
-                    r += (*p1) * (*p2) * alpha;
-                    p1 += aColNum;
-                    p2 += bColNum;
-                }
-
-                *p3 = *p3 * beta + r;
-                p3 += 1;
-            }
-        }
-    }
-    /* a * trans(b) */
-    else if (transposedA == X_NOTRANS && transposedB == X_TRANS) {
-        int num = am;
-        for (int i = 0; i < cn; i++) {
-            DTYPE * p3 = (DTYPE*)c->data + i * cm;
-            for (int j = 0; j < cm; j++) {
-                DTYPE r = 0;
-                DTYPE * p1 = (DTYPE*)a->data + i * am + 0;
-                DTYPE * p2 = (DTYPE*)b->data + j * bm + 0;
-
-                for (int k = 0; k < num; k++) {
-                    r += (*p1) * (*p2) * alpha;
-                    p1 += 1;
-                    p2 += 1;
-                }
-
-                *p3 = *p3 * beta + r;
-                p3 += 1;
-            }
-        }
-    }
-    /* trans(a) * trans(b) */
-    else if (transposedA == X_TRANS && transposedB == X_TRANS) {
-        int num = an;
-        for (int i = 0; i < cn; i++) {
-            DTYPE * p3 = (DTYPE*)c->data + i * cm;
-            for (int j = 0; j < cm; j++) {
-                DTYPE r = 0;
-                DTYPE * p1 = (DTYPE*)a->data + 0 * am + i;
-                DTYPE * p2 = (DTYPE*)b->data + j * bm + 0;
-
-                for (int k = 0; k < num; k++) {
-                    r += (*p1) * (*p2) * alpha;
-                    p1 += aColNum;
-                    p2 += 1;
-                }
-
-                *p3 = *p3 * beta + r;
-                p3 += 1;
-            }
-        }
-    }
+    /* all the four cases (a * b, trans(a) * b, a * trans(b) and trans(a) * trans(b))
+       are handled by the packed engine. Transposition is absorbed when the blocks
+       of a and b are packed, and c is segmented into blocks for multi-threading. */
+    _MatrixMul2DPacked(a, transposedA, b, transposedB, c, alpha, beta, parallelRunner);
 }
 
 } // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,494 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include <string.h>
+#include <limits.h>
+#include "../../XTensor.h"
+#include "MatrixMulINT8.h"
+#include "../utilities/XMatrixSegment.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INT8_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+a dot-product kernel computes the dot products of a row of x
+and four rows of q, i.e., r(i) = sum_p x(p) * q(i, p) for i = 0...3
+*/
+typedef void (*INT8DotKernel)(const signed char * x, const signed char * q, int ldq, int k, int * r);
+
+/* the generic dot-product kernel */
+static void _DotINT8x4Generic(const signed char * x, const signed char * q, int ldq, int k, int * r)
+{
+    for (int i = 0; i < 4; i++) {
+        const signed char * qi = q + i * ldq;
+        int sum = 0;
+        for (int p = 0; p < k; p++)
+            sum += (int)x[p] * (int)qi[p];
+        r[i] = sum;
+    }
+}
+
+#ifdef INT8_X86_SIMD
+
+/* sum over the 8 int32 items of a ymm register */
+__attribute__((target("avx2")))
+static inline int HSumAVX2(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+/* load 16 int8 items and widen them to int16 */
+#define AVX2_LOAD_INT8(p) _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(p)))
+
+/*
+the AVX2 dot-product kernel. 16 items are widened to int16 and
+multiplied-and-added into int32 (vpmaddwd) in each step.
+*/
+__attribute__((target("avx2")))
+static void _DotINT8x4AVX2(const signed char * x, const signed char * q, int ldq, int k, int * r)
+{
+    __m256i s0 = _mm256_setzero_si256();
+    __m256i s1 = _mm256_setzero_si256();
+    __m256i s2 = _mm256_setzero_si256();
+    __m256i s3 = _mm256_setzero_si256();
+
+    int p = 0;
+    for (; p + 16 <= k; p += 16) {
+        __m256i vx = AVX2_LOAD_INT8(x + p);
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(vx, AVX2_LOAD_INT8(q + p)));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(vx, AVX2_LOAD_INT8(q + ldq + p)));
+        s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(vx, AVX2_LOAD_INT8(q + 2 * ldq + p)));
+        s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(vx, AVX2_LOAD_INT8(q + 3 * ldq + p)));
+    }
+
+    r[0] = HSumAVX2(s0);
+    r[1] = HSumAVX2(s1);
+    r[2] = HSumAVX2(s2);
+    r[3] = HSumAVX2(s3);
+
+    for (; p < k; p++) {
+        for (int i = 0; i < 4; i++)
+            r[i] += (int)x[p] * (int)q[i * ldq + p];
+    }
+}
+
+/* load 32 int8 items and widen them to int16 */
+#define AVX512_LOAD_INT8(p) _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(p)))
+
+/* the AVX-512 (BW) dot-product kernel that processes 32 items in each step */
+__attribute__((target("avx512f,avx512bw")))
+static void _DotINT8x4AVX512(const signed char * x, const signed char * q, int ldq, int k, int * r)
+{
+    __m512i s0 = _mm512_setzero_si512();
+    __m512i s1 = _mm512_setzero_si512();
+    __m512i s2 = _mm512_setzero_si512();
+    __m512i s3 = _mm512_setzero_si512();
+
+    int p = 0;
+    for (; p + 32 <= k; p += 32) {
+        __m512i vx = AVX512_LOAD_INT8(x + p);
+        s0 = _mm512_add_epi32(s0, _mm512_madd_epi16(vx, AVX512_LOAD_INT8(q + p)));
+        s1 = _mm512_add_epi32(s1, _mm512_madd_epi16(vx, AVX512_LOAD_INT8(q + ldq + p)));
+        s2 = _mm512_add_epi32(s2, _mm512_madd_epi16(vx, AVX512_LOAD_INT8(q + 2 * ldq + p)));
+        s3 = _mm512_add_epi32(s3, _mm512_madd_epi16(vx, AVX512_LOAD_INT8(q + 3 * ldq + p)));
+    }
+
+    r[0] = _mm512_reduce_add_epi32(s0);
+    r[1] = _mm512_reduce_add_epi32(s1);
+    r[2] = _mm512_reduce_add_epi32(s2);
+    r[3] = _mm512_reduce_add_epi32(s3);
+
+    for (; p < k; p++) {
+        for (int i = 0; i < 4; i++)
+            r[i] += (int)x[p] * (int)q[i * ldq + p];
+    }
+}
+
+#endif // INT8_X86_SIMD
+
+/* the dot-product kernel in use */
+static INT8DotKernel int8DotKernel = NULL;
+
+/* pick the best dot-product kernel that the CPU supports */
+static INT8DotKernel GetINT8DotKernel()
+{
+    if (int8DotKernel != NULL)
+        return int8DotKernel;
+
+    INT8DotKernel kernel = _DotINT8x4Generic;
+#ifdef INT8_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw"))
+        kernel = _DotINT8x4AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        kernel = _DotINT8x4AVX2;
+#endif
+    int8DotKernel = kernel;
+
+    return int8DotKernel;
+}
+
+/*
+quantize a vector (with a stride) symmetrically into int8
+>> v - the vector
+>> num - number of items
+>> stride - distance between two neighboring items
+>> q - the quantized vector (continuous)
+<< return - the scale, i.e., v(i) ~ q(i) * scale
+*/
+static DTYPE QuantizeVectorINT8(const DTYPE * v, int num, int stride, signed char * q)
+{
+    DTYPE maxAbs = 0;
+    for (int i = 0; i < num; i++) {
+        DTYPE a = (DTYPE)fabs(v[i * stride]);
+        if (a > maxAbs)
+            maxAbs = a;
+    }
+
+    DTYPE scale = maxAbs > 0 ? maxAbs / INT8_QUANT_MAX : (DTYPE)1.0;
+    DTYPE inv = 1.0F / scale;
+    for (int i = 0; i < num; i++) {
+        int r = (int)floor(v[i * stride] * inv + 0.5F);
+        q[i] = (signed char)MAX(-INT8_QUANT_MAX, MIN(INT8_QUANT_MAX, r));
+    }
+
+    return scale;
+}
+
+/*
+quantize a weight matrix into int8 per output channel. Each output
+channel gets its own scale so that the large and small channels do
+not share the same quantization step.
+
+>> w - the weight matrix (in float)
+>> transposed - X_NOTRANS if w is used as x * w, i.e., w is (k, n), or
+                X_TRANS if w is used as x * trans(w), i.e., w is (n, k)
+>> q - the quantized weight (in int8), (n, k)
+>> scale - the scale of each output channel, (n)
+*/
+void _QuantizeINT8(const XTensor * w, MATRIX_TRANS_TYPE transposed, XTensor * q, XTensor * scale)
+{
+    CheckNTErrors(w && q && scale, "Empty input tensors!");
+    CheckNTErrors(w->order == 2, "The weight must be a matrix!");
+    CheckNTErrors(w->devID < 0 && q->devID < 0 && scale->devID < 0, "INT8 quantization only runs on CPUs!");
+    CheckNTErrors(w->dataType == X_FLOAT, "The weight must be in float!");
+    CheckNTErrors(q->dataType == X_INT8 && scale->dataType == X_FLOAT, "Wrong data type!");
+
+    int n = transposed == X_TRANS ? w->dimSize[0] : w->dimSize[1];
+    int k = transposed == X_TRANS ? w->dimSize[1] : w->dimSize[0];
+
+    CheckNTErrors(q->order == 2 && q->dimSize[0] == n && q->dimSize[1] == k,
+                  "The quantized weight must be of size (n, k)!");
+    CheckNTErrors(scale->unitNum == n, "Wrong size of the scale tensor!");
+
+    DTYPE * wData = (DTYPE*)w->data;
+    signed char * qData = (signed char*)q->data;
+    DTYPE * sData = (DTYPE*)scale->data;
+
+    for (int j = 0; j < n; j++) {
+        if (transposed == X_TRANS)
+            sData[j] = QuantizeVectorINT8(wData + j * k, k, 1, qData + j * k);
+        else
+            sData[j] = QuantizeVectorINT8(wData + j, k, n, qData + j * k);
+    }
+}
+
+/* arguments of a block of int8 matrix multiplication */
+struct INT8MulArgs
+{
+    /* the quantized input, (m, k) */
+    const signed char * x;
+
+    /* the scale of each row of the input, (m) */
+    const DTYPE * xScale;
+
+    /* the quantized weight, (n, k) */
+    const signed char * q;
+
+    /* the scale of each output channel, (n) */
+    const DTYPE * qScale;
+
+    /* the bias (NULL if there is no bias), (n) */
+    const DTYPE * b;
+
+    /* apply ReLU to the shifted result */
+    bool rectify;
+
+    /* the residual that is added at last (NULL if there is no residual), (m, n) */
+    const DTYPE * residual;
+
+    /* the output, (m, n) */
+    DTYPE * c;
+
+    /* the inner dimension */
+    int k;
+
+    /* number of output channels */
+    int n;
+};
+
+/*
+int8 matrix multiplication for a block (x1,y1) - (x2,y2) of c
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2)
+            and a TensorList holding the INT8MulArgs structure
+*/
+static void _MatrixMulINT8Block(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * mulArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(mulArgs->count == 1, "invalid argument number!");
+
+    INT8MulArgs * a = (INT8MulArgs*)mulArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int y1 = indexArgs->GetItem(1);
+    int x2 = indexArgs->GetItem(2);
+    int y2 = indexArgs->GetItem(3);
+
+    INT8DotKernel kernel = GetINT8DotKernel();
+    int k = a->k;
+    int r[4];
+
+    /* four output channels at a time, so that a row of x is loaded once for them */
+    for (int j = y1; j <= y2; j += 4) {
+        int cols = MIN(4, y2 - j + 1);
+        const signed char * qj = a->q + j * k;
+
+        for (int i = x1; i <= x2; i++) {
+            const signed char * xi = a->x + i * k;
+            if (cols == 4)
+                kernel(xi, qj, k, k, r);
+            else {
+                for (int jj = 0; jj < cols; jj++) {
+                    int sum = 0;
+                    for (int p = 0; p < k; p++)
+                        sum += (int)xi[p] * (int)qj[jj * k + p];
+                    r[jj] = sum;
+                }
+            }
+
+            DTYPE * ci = a->c + i * a->n + j;
+            const DTYPE * ri = a->residual != NULL ? a->residual + i * a->n + j : NULL;
+            for (int jj = 0; jj < cols; jj++) {
+                DTYPE v = r[jj] * a->xScale[i] * a->qScale[j + jj];
+                if (a->b != NULL)
+                    v += a->b[j + jj];
+                if (a->rectify)
+                    v = v > 0 ? v : 0;
+                if (ri != NULL)
+                    v += ri[jj];
+                ci[jj] = v;
+            }
+        }
+    }
+}
+
+/*
+matrix multiplication with int8 weights
+c = x * trans(q * scale) + b
+>> x - the input (in float), (..., k)
+>> q - the quantized weight (in int8), (n, k)
+>> scale - the scale of each output channel, (n)
+>> c - the output (in float), (..., n)
+>> b - the bias (NULL if there is no bias), (n)
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _MatrixMulINT8(const XTensor * x, const XTensor * q, const XTensor * scale, XTensor * c,
+                    const XTensor * b, XPRunner * parallelRunner)
+{
+    _MulAndShiftINT8(x, q, scale, b, c, false, NULL, parallelRunner);
+}
+
+/*
+matrix multiplication with int8 weights and the operations that follow it
+c = f(x * trans(q * scale) + b) + residual
+where f is ReLU if rectify is true, or the identity function otherwise.
+The input is quantized per row (dynamically), then c is segmented
+into blocks that are processed by the int8 dot-product kernels in parallel.
+The bias, the activation and the residual are applied to each block as
+soon as it is computed, so no intermediate tensor is made for them.
+
+>> x - the input (in float), (..., k)
+>> q - the quantized weight (in int8), (n, k)
+>> scale - the scale of each output channel, (n)
+>> b - the bias (NULL if there is no bias), (n)
+>> c - the output (in float), (..., n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (..., n)
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _MulAndShiftINT8(const XTensor * x, const XTensor * q, const XTensor * scale, const XTensor * b,
+                      XTensor * c, bool rectify, const XTensor * residual, XPRunner * parallelRunner)
+{
+    CheckNTErrors(x && q && scale && c, "Empty input tensors!");
+    CheckNTErrors(x->devID < 0 && c->devID < 0, "INT8 matrix multiplication only runs on CPUs!");
+    CheckNTErrors(x->dataType == X_FLOAT && c->dataType == X_FLOAT, "The input and output must be in float!");
+    CheckNTErrors(q->dataType == X_INT8 && q->order == 2, "The weight must be an int8 matrix!");
+
+    int n = q->dimSize[0];
+    int k = q->dimSize[1];
+    int m = x->unitNum / k;
+
+    CheckNTErrors(x->GetDim(-1) == k, "Unmatched tensors in multiplication!");
+    CheckNTErrors(c->GetDim(-1) == n && c->unitNum == m * n, "Unmatched tensors in multiplication!");
+    CheckNTErrors(scale->unitNum == n, "Wrong size of the scale tensor!");
+    CheckNTErrors(b == NULL || b->unitNum == n, "Wrong size of the bias tensor!");
+    CheckNTErrors(residual == NULL || (residual->devID < 0 && residual->dataType == X_FLOAT &&
+                                       residual->unitNum == c->unitNum),
+                  "Wrong residual tensor!");
+
+    if (m == 0)
+        return;
+
+    /* quantize the input row by row */
+    signed char * xq = new signed char[m * k];
+    DTYPE * xScale = new DTYPE[m];
+    DTYPE * xData = (DTYPE*)x->data;
+    for (int i = 0; i < m; i++)
+        xScale[i] = QuantizeVectorINT8(xData + i * k, k, 1, xq + i * k);
+
+    INT8MulArgs args;
+    args.x = xq;
+    args.xScale = xScale;
+    args.q = (signed char*)q->data;
+    args.qScale = (DTYPE*)scale->data;
+    args.b = b != NULL ? (DTYPE*)b->data : NULL;
+    args.rectify = rectify;
+    args.residual = residual != NULL ? (DTYPE*)residual->data : NULL;
+    args.c = (DTYPE*)c->data;
+    args.k = k;
+    args.n = n;
+
+    /* number of multiply-add operations (clipped to avoid overflow) */
+    double opNum = (double)m * n * k;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_MatrixMulINT8Block, (int)opNum,
+                  m, n, 1, &args);
+
+    delete[] xq;
+    delete[] xScale;
+}
+
+/*
+matrix multiplication with int8 weights (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+
+c = x * trans(q * scale)
+>> x - the input (in float), (..., k)
+>> q - the quantized weight (in int8), (n, k)
+>> scale - the scale of each output channel, (n)
+<< return - the result, (..., n)
+*/
+XTensor MMulINT8(const XTensor &x, const XTensor &q, const XTensor &scale)
+{
+    int * dimSize = new int[x.order];
+    memcpy(dimSize, x.dimSize, sizeof(int) * x.order);
+    dimSize[x.order - 1] = q.dimSize[0];
+
+    XTensor c;
+    InitTensor(&c, x.order, dimSize, X_FLOAT, x.devID, false);
+    c.SetTMPFlag();
+
+    _MatrixMulINT8(&x, &q, &scale, &c);
+
+    delete[] dimSize;
+
+    return c;
+}
+
+/*
+matrix multiplication and shift with int8 weights (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+
+c = x * trans(q * scale) + b
+>> x - the input (in float), (..., k)
+>> q - the quantized weight (in int8), (n, k)
+>> scale - the scale of each output channel, (n)
+>> b - the bias, (n)
+<< return - the result, (..., n)
+*/
+XTensor MulAndShiftINT8(const XTensor &x, const XTensor &q, const XTensor &scale, const XTensor &b)
+{
+    int * dimSize = new int[x.order];
+    memcpy(dimSize, x.dimSize, sizeof(int) * x.order);
+    dimSize[x.order - 1] = q.dimSize[0];
+
+    XTensor c;
+    InitTensor(&c, x.order, dimSize, X_FLOAT, x.devID, false);
+    c.SetTMPFlag();
+
+    _MatrixMulINT8(&x, &q, &scale, &c, &b);
+
+    delete[] dimSize;
+
+    return c;
+}
+
+/*
+matrix multiplication and shift with int8 weights and the operations
+that follow it (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+
+c = f(x * trans(q * scale) + b) + residual
+>> x - the input (in float), (..., k)
+>> q - the quantized weight (in int8), (n, k)
+>> scale - the scale of each output channel, (n)
+>> b - the bias, (n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (..., n)
+<< return - the result, (..., n)
+*/
+XTensor MulAndShiftINT8(const XTensor &x, const XTensor &q, const XTensor &scale, const XTensor &b,
+                        bool rectify, const XTensor * residual)
+{
+    int * dimSize = new int[x.order];
+    memcpy(dimSize, x.dimSize, sizeof(int) * x.order);
+    dimSize[x.order - 1] = q.dimSize[0];
+
+    XTensor c;
+    InitTensor(&c, x.order, dimSize, X_FLOAT, x.devID, false);
+    c.SetTMPFlag();
+
+    _MulAndShiftINT8(&x, &q, &scale, &b, &c, rectify, residual);
+
+    delete[] dimSize;
+
+    return c;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,82 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Matrix multiplication with int8 weights for inference on CPUs. Weights are
+* quantized symmetrically per output channel once (e.g., at load time), and
+* the input is quantized per row on the fly. The products are accumulated
+* in int32 and mapped back to float with the two scales.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __MATRIXMULINT8_H__
+#define __MATRIXMULINT8_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* the largest magnitude of a quantized value */
+#define INT8_QUANT_MAX 127
+
+/*
+quantize a weight matrix into int8 per output channel
+q(j, p) = round(w(p, j) / scale(j)) if w is used as x * w (X_NOTRANS), or
+q(j, p) = round(w(j, p) / scale(j)) if w is used as x * trans(w) (X_TRANS)
+*/
+void _QuantizeINT8(const XTensor * w, MATRIX_TRANS_TYPE transposed, XTensor * q, XTensor * scale);
+
+/*
+matrix multiplication with int8 weights
+c = x * trans(q * scale) + b
+where q is (n, k) in int8, x is (..., k) and c is (..., n)
+*/
+void _MatrixMulINT8(const XTensor * x, const XTensor * q, const XTensor * scale, XTensor * c,
+                    const XTensor * b = NULL, XPRunner * parallelRunner = NULL);
+
+/*
+matrix multiplication with int8 weights and the operations that follow it
+c = f(x * trans(q * scale) + b) + residual
+where f is ReLU if rectify is true, or the identity function otherwise
+*/
+void _MulAndShiftINT8(const XTensor * x, const XTensor * q, const XTensor * scale, const XTensor * b,
+                      XTensor * c, bool rectify, const XTensor * residual, XPRunner * parallelRunner = NULL);
+
+/*
+matrix multiplication with int8 weights (return an XTensor structure)
+c = x * trans(q * scale)
+*/
+XTensor MMulINT8(const XTensor &x, const XTensor &q, const XTensor &scale);
+
+/*
+matrix multiplication and shift with int8 weights (return an XTensor structure)
+c = x * trans(q * scale) + b
+*/
+XTensor MulAndShiftINT8(const XTensor &x, const XTensor &q, const XTensor &scale, const XTensor &b);
+
+/*
+matrix multiplication and shift with int8 weights and the operations
+that follow it (return an XTensor structure)
+c = f(x * trans(q * scale) + b) + residual
+*/
+XTensor MulAndShiftINT8(const XTensor &x, const XTensor &q, const XTensor &scale, const XTensor &b,
+                        bool rectify, const XTensor * residual);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __MATRIXMULINT8_H__
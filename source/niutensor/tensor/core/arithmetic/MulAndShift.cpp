@@ -19,12 +19,15 @@
 * $Created by: JIANG Yufan (email: jiangyufan2018@outlook.com) 2019-02-27
 */
 
+#include <string.h>
+#include <limits.h>
 #include "../../XTensor.h"
 #include "../../XDevice.h"
 #include "../../XName.h"
 #include "MulAndShift.h"
 #include "MatrixMul.h"
 #include "Sum.h"
+#include "../utilities/XMatrixSegment.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 /*
@@ -187,4 +190,302 @@ XTensor MulAndShift(const XTensor& x, MATRIX_TRANS_TYPE transposedX,
     return c;
 }
 
+#if defined(USE_BLAS)
+
+/* arguments of the jobs that shift the result of a matrix multiplication */
+struct ShiftArgs
+{
+    DTYPE * c;
+    const DTYPE * b;
+    const DTYPE * residual;
+    int n;
+    bool rectify;
+};
+
+/*
+shift the result of a matrix multiplication, apply the activation to it
+and add the residual for the rows x1...x2, i.e., c = f(c + b) + residual
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2),
+            of which only the rows x1 and x2 are used, and a TensorList
+            holding the ShiftArgs structure
+*/
+static void _ShiftActivateAndAddBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * shiftArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(shiftArgs->count == 1, "invalid argument number!");
+
+    ShiftArgs * p = (ShiftArgs*)shiftArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int x2 = indexArgs->GetItem(2);
+    int n = p->n;
+
+    for (int i = x1; i <= x2; i++) {
+        DTYPE * ci = p->c + (size_t)i * n;
+        const DTYPE * ri = p->residual != NULL ? p->residual + (size_t)i * n : NULL;
+        for (int j = 0; j < n; j++) {
+            DTYPE v = ci[j] + p->b[j];
+            if (p->rectify)
+                v = v > 0 ? v : 0;
+            if (ri != NULL)
+                v += ri[j];
+            ci[j] = v;
+        }
+    }
+}
+
+/*
+shift the result of a matrix multiplication, apply the activation to it
+and add the residual in one pass, i.e., c = f(c + b) + residual. Rows are
+processed in parallel. It is used when the multiplication runs on BLAS.
+>> c - the result of the matrix multiplication, (m, n)
+>> b - the bias, (n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (m, n)
+>> m - number of rows
+>> n - number of columns
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+static void _ShiftActivateAndAdd(XTensor * c, const XTensor * b, bool rectify,
+                                 const XTensor * residual, int m, int n,
+                                 XPRunner * parallelRunner)
+{
+    ShiftArgs args;
+    args.c = (DTYPE*)c->data;
+    args.b = (DTYPE*)b->data;
+    args.residual = residual != NULL ? (DTYPE*)residual->data : NULL;
+    args.n = n;
+    args.rectify = rectify;
+
+    /* number of operations (clipped to avoid overflow) */
+    double opNum = 3.0 * m * n;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_ShiftActivateAndAddBlock, (int)opNum,
+                  m, 1, 1, &args);
+}
+
+#endif
+
+/*
+make the epilogue of the packed matrix multiplication for _MulAndShift
+>> epilogue - the epilogue
+>> b - the bias, (n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (m, n)
+>> n - number of columns
+*/
+static void MakeShiftEpilogue(GEMMEpilogue * epilogue, const XTensor * b, bool rectify,
+                              const XTensor * residual, int n)
+{
+    epilogue->bias = (DTYPE*)b->data;
+    epilogue->rectify = rectify;
+    epilogue->residual = residual != NULL ? (DTYPE*)residual->data : NULL;
+    epilogue->ldr = n;
+}
+
+/*
+check the input, the bias and the residual of _MulAndShift
+>> x - tensor x, (..., k)
+>> k - the inner dimension
+>> n - number of output columns
+>> b - tensor b
+>> residual - the residual (NULL if there is no residual)
+*/
+static bool IsShiftFusable(const XTensor * x, int k, int n, const XTensor * b, const XTensor * residual)
+{
+    if (x->devID >= 0 || x->isSparse || x->dataType != X_FLOAT || x->order < 2 || x->GetDim(-1) != k)
+        return false;
+
+    if (b->devID >= 0 || b->dataType != X_FLOAT || b->order != 1 || b->unitNum != n)
+        return false;
+
+    if (residual != NULL) {
+        if (residual->devID >= 0 || residual->isSparse || residual->dataType != X_FLOAT ||
+            residual->GetDim(-1) != n || residual->unitNum != x->unitNum / k * n)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+operation c = f(x * w + b) + residual on CPUs (for inference), where f is
+ReLU if rectify is true, or the identity function otherwise. The bias, the
+activation and the residual are the epilogue of the packed matrix
+multiplication, i.e., they are applied to each block of c as soon as it is
+computed. With BLAS, they are applied to the result afterwards in a single
+pass (with the rows in parallel). No intermediate tensor is made for them.
+>> x - tensor x, (..., k)
+>> w - tensor w, (k, n)
+>> b - tensor b, (n)
+>> c - the output, (..., n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (..., n)
+>> parallelRunner - parallel processing module
+*/
+void _MulAndShift(const XTensor * x, const XTensor * w, const XTensor * b, XTensor * c,
+                  bool rectify, const XTensor * residual, XPRunner * parallelRunner)
+{
+    CheckNTErrors(x && w && b && c, "Empty input tensors!");
+    CheckNTErrors(IsMulAndShiftFusable(x, w, b, residual), "Unsupported tensors!");
+
+    int n = w->dimSize[1];
+    int m = x->unitNum / w->dimSize[0];
+
+    CheckNTErrors(c->devID < 0 && c->dataType == X_FLOAT && c->order == x->order &&
+                  c->GetDim(-1) == n && c->unitNum == m * n, "Wrong output tensor!");
+
+    if (m == 0)
+        return;
+
+#if defined(USE_BLAS)
+    /* call _MatrixMul function */
+    _MatrixMul(x, X_NOTRANS, w, X_NOTRANS, c, 1.0F, 0, parallelRunner);
+
+    _ShiftActivateAndAdd(c, b, rectify, residual, m, n, parallelRunner);
+#else
+    int k = w->dimSize[0];
+
+    GEMMEpilogue epilogue;
+    MakeShiftEpilogue(&epilogue, b, rectify, residual, n);
+
+    /* call _GEMMPackedParallel function */
+    _GEMMPackedParallel(false, false, m, n, k, 1.0F, (DTYPE*)x->data, k, (DTYPE*)w->data, n,
+                        0, (DTYPE*)c->data, n, &epilogue, parallelRunner);
+#endif
+}
+
+/*
+operation c = f(x * w + b) + residual on CPUs (for inference), where w is
+packed in advance (see XPackedMatrix) and f is ReLU or the identity function.
+The bias, the activation and the residual are the epilogue of the packed
+matrix multiplication.
+>> x - tensor x, (..., k)
+>> w - the packed matrix, from a (k, n) matrix
+>> b - tensor b, (n)
+>> c - the output, (..., n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (..., n)
+>> parallelRunner - parallel processing module
+*/
+void _MulAndShift(const XTensor * x, const XPackedMatrix * w, const XTensor * b, XTensor * c,
+                  bool rectify, const XTensor * residual, XPRunner * parallelRunner)
+{
+    CheckNTErrors(x && w && b && c, "Empty input tensors!");
+    CheckNTErrors(IsMulAndShiftFusable(x, w, b, residual), "Unsupported tensors!");
+
+    int n = w->n;
+    int m = x->unitNum / w->k;
+
+    CheckNTErrors(c->devID < 0 && c->dataType == X_FLOAT && c->order == x->order &&
+                  c->GetDim(-1) == n && c->unitNum == m * n, "Wrong output tensor!");
+
+    if (m == 0)
+        return;
+
+    GEMMEpilogue epilogue;
+    MakeShiftEpilogue(&epilogue, b, rectify, residual, n);
+
+    /* call _MatrixMulPacked function */
+    _MatrixMulPacked(x, w, c, 1.0F, 0, parallelRunner, &epilogue);
+}
+
+/*
+can _MulAndShift (with the activation and the residual) be used for the
+tensors, i.e., are they dense float tensors on CPUs, and do the weight, the
+bias and the residual fit the input
+>> x - tensor x
+>> w - tensor w
+>> b - tensor b
+>> residual - the residual (NULL if there is no residual)
+*/
+bool IsMulAndShiftFusable(const XTensor * x, const XTensor * w, const XTensor * b,
+                          const XTensor * residual)
+{
+    if (w->devID >= 0 || w->isSparse || w->dataType != X_FLOAT || w->order != 2)
+        return false;
+
+    return IsShiftFusable(x, w->dimSize[0], w->dimSize[1], b, residual);
+}
+
+/*
+can _MulAndShift (with a packed matrix) be used for the tensors
+>> x - tensor x
+>> w - the packed matrix
+>> b - tensor b
+>> residual - the residual (NULL if there is no residual)
+*/
+bool IsMulAndShiftFusable(const XTensor * x, const XPackedMatrix * w, const XTensor * b,
+                          const XTensor * residual)
+{
+    if (!w->enabled)
+        return false;
+
+    return IsShiftFusable(x, w->k, w->n, b, residual);
+}
+
+/*
+operation c = f(x * w + b) + residual (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+>> x - tensor x, (..., k)
+>> w - tensor w, (k, n)
+>> b - tensor b, (n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (..., n)
+<< return - the result, (..., n)
+*/
+XTensor MulAndShift(const XTensor &x, const XTensor &w, const XTensor &b,
+                    bool rectify, const XTensor * residual)
+{
+    int * dimSize = new int[x.order];
+    memcpy(dimSize, x.dimSize, sizeof(int) * x.order);
+    dimSize[x.order - 1] = w.dimSize[w.order - 1];
+
+    XTensor c;
+    InitTensor(&c, x.order, dimSize, X_FLOAT, x.devID, false);
+    c.SetTMPFlag();
+
+    _MulAndShift(&x, &w, &b, &c, rectify, residual);
+
+    delete[] dimSize;
+
+    return c;
+}
+
+/*
+operation c = f(x * w + b) + residual with a packed matrix (return an
+XTensor structure). It is for inference only.
+>> x - tensor x, (..., k)
+>> w - the packed matrix, from a (k, n) matrix
+>> b - tensor b, (n)
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual), (..., n)
+<< return - the result, (..., n)
+*/
+XTensor MulAndShift(const XTensor &x, const XPackedMatrix &w, const XTensor &b,
+                    bool rectify, const XTensor * residual)
+{
+    int * dimSize = new int[x.order];
+    memcpy(dimSize, x.dimSize, sizeof(int) * x.order);
+    dimSize[x.order - 1] = w.n;
+
+    XTensor c;
+    InitTensor(&c, x.order, dimSize, X_FLOAT, x.devID, false);
+    c.SetTMPFlag();
+
+    _MulAndShift(&x, &w, &b, &c, rectify, residual);
+
+    delete[] dimSize;
+
+    return c;
+}
+
 }
@@ -24,6 +24,7 @@
 
 #include "../../XTensor.h"
 #include "../CHeader.h"
+#include "MatrixMul2DPacked.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
@@ -35,6 +36,30 @@ XTensor MulAndShift(const XTensor &x, MATRIX_TRANS_TYPE transposedX,
                     const XTensor &w, MATRIX_TRANS_TYPE transposedW,
                     const XTensor &b, DTYPE alpha = (DTYPE)1.0, XPRunner * parallelRunner = NULL);
 
+/* operation c = f(x * w + b) + residual on CPUs, where f is ReLU or the identity function */
+void _MulAndShift(const XTensor * x, const XTensor * w, const XTensor * b, XTensor * c,
+                  bool rectify, const XTensor * residual, XPRunner * parallelRunner = NULL);
+
+/* operation c = f(x * w + b) + residual on CPUs, where w is packed in advance */
+void _MulAndShift(const XTensor * x, const XPackedMatrix * w, const XTensor * b, XTensor * c,
+                  bool rectify, const XTensor * residual, XPRunner * parallelRunner = NULL);
+
+/* can _MulAndShift (with the activation and the residual) be used for the tensors */
+bool IsMulAndShiftFusable(const XTensor * x, const XTensor * w, const XTensor * b,
+                          const XTensor * residual);
+
+/* can _MulAndShift (with a packed matrix) be used for the tensors */
+bool IsMulAndShiftFusable(const XTensor * x, const XPackedMatrix * w, const XTensor * b,
+                          const XTensor * residual);
+
+/* operation c = f(x * w + b) + residual (return an XTensor structure, for inference) */
+XTensor MulAndShift(const XTensor &x, const XTensor &w, const XTensor &b,
+                    bool rectify, const XTensor * residual);
+
+/* operation c = f(x * w + b) + residual with a packed matrix (return an XTensor structure, for inference) */
+XTensor MulAndShift(const XTensor &x, const XPackedMatrix &w, const XTensor &b,
+                    bool rectify, const XTensor * residual);
+
 } // namespace nts(NiuTrans.Tensor)
 
 #endif // __OPERATION_H__
@@ -0,0 +1,212 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include <limits.h>
+#include "../../XTensor.h"
+#include "SingleQueryAttention.h"
+#include "../shape/IsSameShaped.h"
+#include "../utilities/XMatrixSegment.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* arguments of the attention jobs */
+struct SQAttentionArgs
+{
+    const DTYPE * q;
+    const DTYPE * key;
+    const DTYPE * value;
+    const int * index;
+    DTYPE * c;
+    int len;
+    int rowNum;
+    int dim;
+    int headDim;
+    DTYPE scale;
+};
+
+/*
+single-query attention for a block (x1,y1) - (x2,y2) of (query, head) pairs
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2)
+            over queries and heads, and a TensorList holding the
+            SQAttentionArgs structure
+*/
+static void _SingleQueryAttentionBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * attArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(attArgs->count == 1, "invalid argument number!");
+
+    SQAttentionArgs * a = (SQAttentionArgs*)attArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int y1 = indexArgs->GetItem(1);
+    int x2 = indexArgs->GetItem(2);
+    int y2 = indexArgs->GetItem(3);
+
+    int len = a->len;
+    int dim = a->dim;
+    int headDim = a->headDim;
+    DTYPE * score = new DTYPE[len];
+
+    for (int i = x1; i <= x2; i++) {
+        for (int h = y1; h <= y2; h++) {
+            const DTYPE * qh = a->q + i * dim + h * headDim;
+            DTYPE * ch = a->c + i * dim + h * headDim;
+
+            /* score(t) = scale * q * k(t) (the steps without a row are skipped) */
+            DTYPE maxScore = -1e30F;
+            for (int t = 0; t < len; t++) {
+                int row = a->index[t * a->rowNum + i];
+                if (row < 0)
+                    continue;
+                const DTYPE * kh = a->key + ((size_t)t * a->rowNum + row) * dim + h * headDim;
+                DTYPE dot = 0;
+                for (int p = 0; p < headDim; p++)
+                    dot += qh[p] * kh[p];
+                score[t] = dot * a->scale;
+                if (score[t] > maxScore)
+                    maxScore = score[t];
+            }
+
+            /* softmax over the steps */
+            DTYPE sum = 0;
+            for (int t = 0; t < len; t++) {
+                if (a->index[t * a->rowNum + i] < 0)
+                    continue;
+                score[t] = (DTYPE)exp(score[t] - maxScore);
+                sum += score[t];
+            }
+
+            /* c = sum_t softmax(t) * v(t) */
+            for (int p = 0; p < headDim; p++)
+                ch[p] = 0;
+            for (int t = 0; t < len; t++) {
+                int row = a->index[t * a->rowNum + i];
+                if (row < 0)
+                    continue;
+                const DTYPE * vh = a->value + ((size_t)t * a->rowNum + row) * dim + h * headDim;
+                DTYPE w = score[t] / sum;
+                for (int p = 0; p < headDim; p++)
+                    ch[p] += w * vh[p];
+            }
+        }
+    }
+
+    delete[] score;
+}
+
+/*
+single-query multi-head attention over cached keys and values
+c(b, h) = softmax(scale * q(b, h) * trans(K(b, h))) * V(b, h)
+where q(b, h) is the h-th head of query b, and K(b, h) and V(b, h) are the
+h-th heads of the keys and values of query b over the steps 0...len-1. They
+are read from the buffers through the index table, i.e., the key of query b
+at step t is key(t, index(t, b)), and the query has no key at step t if the
+index is -1 (e.g., a sequence that starts later than the others in the
+batch). The queries are segmented into blocks of
+(query, head) pairs that are processed in parallel.
+
+>> q - the queries, (B, 1, H) or (B, H)
+>> key - the buffer of keys, (L, R, H) where L >= len and R >= B
+>> value - the buffer of values, (L, R, H)
+>> index - the index table, (len, R), i.e., index[t * R + b] is the row of query b at step t
+            (-1 if query b has no key at step t)
+>> len - the number of steps
+>> headNum - the number of heads
+>> scale - the scaling factor of the dot-products
+>> c - the result, of the same shape as q
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _SingleQueryAttention(const XTensor * q, const XTensor * key, const XTensor * value,
+                           const int * index, int len, int headNum, DTYPE scale,
+                           XTensor * c, XPRunner * parallelRunner)
+{
+    CheckNTErrors(q && key && value && index && c, "Empty input tensors!");
+    CheckNTErrors(q->devID < 0 && key->devID < 0 && value->devID < 0 && c->devID < 0,
+                  "Single-query attention only runs on CPUs!");
+    CheckNTErrors(q->dataType == X_FLOAT && key->dataType == X_FLOAT &&
+                  value->dataType == X_FLOAT && c->dataType == X_FLOAT,
+                  "The inputs and output must be in float!");
+    CheckNTErrors(key->order == 3 && _IsSameShaped(key, value), "Wrong shape of the key and value buffers!");
+
+    int dim = q->GetDim(-1);
+    int queryNum = q->unitNum / dim;
+    int rowNum = key->GetDim(1);
+
+    CheckNTErrors(key->GetDim(2) == dim, "Unmatched queries and keys!");
+    CheckNTErrors(len > 0 && len <= key->GetDim(0), "Wrong number of steps!");
+    CheckNTErrors(queryNum <= rowNum, "Too many queries for the buffers!");
+    CheckNTErrors(headNum > 0 && dim % headNum == 0, "Wrong number of heads!");
+    CheckNTErrors(c->unitNum == q->unitNum, "Unmatched queries and results!");
+
+    SQAttentionArgs args;
+    args.q = (DTYPE*)q->data;
+    args.key = (DTYPE*)key->data;
+    args.value = (DTYPE*)value->data;
+    args.index = index;
+    args.c = (DTYPE*)c->data;
+    args.len = len;
+    args.rowNum = rowNum;
+    args.dim = dim;
+    args.headDim = dim / headNum;
+    args.scale = scale;
+
+    /* number of multiply-add operations (clipped to avoid overflow) */
+    double opNum = 2.0 * queryNum * len * dim;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_SingleQueryAttentionBlock, (int)opNum,
+                  queryNum, headNum, 1, &args);
+}
+
+/*
+single-query multi-head attention over cached keys and values (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+
+>> q - the queries, (B, 1, H) or (B, H)
+>> key - the buffer of keys, (L, R, H)
+>> value - the buffer of values, (L, R, H)
+>> index - the index table, (len, R)
+>> len - the number of steps
+>> headNum - the number of heads
+>> scale - the scaling factor of the dot-products
+<< return - the result, of the same shape as q
+*/
+XTensor SingleQueryAttention(const XTensor &q, const XTensor &key, const XTensor &value,
+                             const int * index, int len, int headNum, DTYPE scale)
+{
+    XTensor c;
+    InitTensor(&c, &q);
+    c.SetTMPFlag();
+
+    _SingleQueryAttention(&q, &key, &value, index, len, headNum, scale, &c);
+
+    return c;
+}
+
+} // namespace nts(NiuTrans.Tensor)
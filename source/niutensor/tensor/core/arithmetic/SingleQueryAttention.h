@@ -0,0 +1,55 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Multi-head attention of a single query per row over preallocated key and
+* value buffers (e.g., the decoder cache in incremental decoding). The buffers
+* are kept step by step, i.e., (maxLen, rowNum, dim), and an index table tells
+* which row of each step belongs to a query. Reordering the hypotheses in beam
+* search is thus an update of the table, and the keys and values are read in
+* place instead of being split, concatenated or gathered.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __SINGLEQUERYATTENTION_H__
+#define __SINGLEQUERYATTENTION_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+single-query multi-head attention over cached keys and values
+c(b, h) = softmax(scale * q(b, h) * trans(K(b, h))) * V(b, h)
+where the key (and value) of query b at step t is key(t, index(t, b)), and
+the step is skipped if index(t, b) = -1
+*/
+void _SingleQueryAttention(const XTensor * q, const XTensor * key, const XTensor * value,
+                           const int * index, int len, int headNum, DTYPE scale,
+                           XTensor * c, XPRunner * parallelRunner = NULL);
+
+/*
+single-query multi-head attention over cached keys and values (return an XTensor structure)
+c(b, h) = softmax(scale * q(b, h) * trans(K(b, h))) * V(b, h)
+*/
+XTensor SingleQueryAttention(const XTensor &q, const XTensor &key, const XTensor &value,
+                             const int * index, int len, int headNum, DTYPE scale);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __SINGLEQUERYATTENTION_H__
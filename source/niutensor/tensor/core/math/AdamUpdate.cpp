@@ -0,0 +1,229 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include <limits.h>
+#include "AdamUpdate.h"
+#include "AdamUpdate.cuh"
+#include "../utilities/XMatrixSegment.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ADAM_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* number of the items that a job updates at a time */
+#define ADAM_BLOCK_SIZE 16384
+
+/* arguments of the update jobs */
+struct AdamArgs
+{
+    DTYPE * p;
+    DTYPE * g;
+    DTYPE * m;
+    DTYPE * v;
+    int n;
+    DTYPE beta1;
+    DTYPE beta2;
+    DTYPE stepSize;
+    DTYPE delta;
+    DTYPE decay;
+    bool clearGrad;
+};
+
+/*
+the Adam(W) update of a segment
+>> p - the parameters
+>> g - the gradients
+>> m - the 1st order moments
+>> v - the 2nd order moments
+>> n - number of items
+>> a - the hyper parameters
+*/
+static void AdamSegmentGeneric(DTYPE * p, DTYPE * g, DTYPE * m, DTYPE * v,
+                               int n, const AdamArgs * a)
+{
+    DTYPE keep = 1.0F - a->decay;
+
+    for (int i = 0; i < n; i++) {
+        DTYPE gi = g[i];
+        DTYPE mi = a->beta1 * m[i] + (1.0F - a->beta1) * gi;
+        DTYPE vi = a->beta2 * v[i] + (1.0F - a->beta2) * gi * gi;
+        m[i] = mi;
+        v[i] = vi;
+        p[i] = keep * p[i] - a->stepSize * mi / ((DTYPE)sqrt(vi) + a->delta);
+        if (a->clearGrad)
+            g[i] = 0;
+    }
+}
+
+#ifdef ADAM_X86_SIMD
+
+/* the Adam(W) update of a segment (AVX2) */
+__attribute__((target("avx2")))
+static void AdamSegmentAVX2(DTYPE * p, DTYPE * g, DTYPE * m, DTYPE * v,
+                            int n, const AdamArgs * a)
+{
+    __m256 beta1 = _mm256_set1_ps(a->beta1);
+    __m256 beta1c = _mm256_set1_ps(1.0F - a->beta1);
+    __m256 beta2 = _mm256_set1_ps(a->beta2);
+    __m256 beta2c = _mm256_set1_ps(1.0F - a->beta2);
+    __m256 stepSize = _mm256_set1_ps(a->stepSize);
+    __m256 delta = _mm256_set1_ps(a->delta);
+    __m256 keep = _mm256_set1_ps(1.0F - a->decay);
+    __m256 zero = _mm256_setzero_ps();
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 gi = _mm256_loadu_ps(g + i);
+        __m256 mi = _mm256_add_ps(_mm256_mul_ps(beta1, _mm256_loadu_ps(m + i)),
+                                  _mm256_mul_ps(beta1c, gi));
+        __m256 vi = _mm256_add_ps(_mm256_mul_ps(beta2, _mm256_loadu_ps(v + i)),
+                                  _mm256_mul_ps(beta2c, _mm256_mul_ps(gi, gi)));
+        __m256 u = _mm256_div_ps(mi, _mm256_add_ps(_mm256_sqrt_ps(vi), delta));
+        __m256 pi = _mm256_sub_ps(_mm256_mul_ps(keep, _mm256_loadu_ps(p + i)),
+                                  _mm256_mul_ps(stepSize, u));
+        _mm256_storeu_ps(m + i, mi);
+        _mm256_storeu_ps(v + i, vi);
+        _mm256_storeu_ps(p + i, pi);
+        if (a->clearGrad)
+            _mm256_storeu_ps(g + i, zero);
+    }
+
+    if (i < n)
+        AdamSegmentGeneric(p + i, g + i, m + i, v + i, n - i, a);
+}
+
+#endif
+
+/* the segment kernel in use */
+typedef void (*AdamSegmentKernel)(DTYPE * p, DTYPE * g, DTYPE * m, DTYPE * v,
+                                  int n, const AdamArgs * a);
+
+/* pick the best segment kernel that the CPU supports */
+static AdamSegmentKernel PickAdamKernel()
+{
+#ifdef ADAM_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return AdamSegmentAVX2;
+#endif
+    return AdamSegmentGeneric;
+}
+
+/*
+the Adam(W) update of the blocks x1...x2
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2),
+            of which only the blocks x1 and x2 are used, and a TensorList
+            holding the AdamArgs structure
+*/
+static void _AdamUpdateBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * adamArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(adamArgs->count == 1, "invalid argument number!");
+
+    AdamArgs * a = (AdamArgs*)adamArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int x2 = indexArgs->GetItem(2);
+
+    static const AdamSegmentKernel kernel = PickAdamKernel();
+
+    size_t beg = (size_t)x1 * ADAM_BLOCK_SIZE;
+    size_t end = MIN((size_t)(x2 + 1) * ADAM_BLOCK_SIZE, (size_t)a->n);
+
+    kernel(a->p + beg, a->g + beg, a->m + beg, a->v + beg, (int)(end - beg), a);
+}
+
+/*
+the Adam(W) update, i.e.,
+m = beta1 * m + (1 - beta1) * g
+v = beta2 * v + (1 - beta2) * g * g
+p = (1 - decay) * p - stepSize * m / (sqrt(v) + delta)
+where the bias correction of Adam is in stepSize and delta, and decay is
+the decoupled weight decay (scaled by the learning rate). It reads and
+writes each item once, and the gradient is cleared in the same pass. On
+CPUs, the data is segmented and updated in parallel.
+
+>> param - the parameter tensor
+>> grad - the gradient
+>> m - the 1st order moment
+>> v - the 2nd order moment
+>> beta1 - the decay rate of the 1st order moment
+>> beta2 - the decay rate of the 2nd order moment
+>> stepSize - the step size
+>> delta - added to sqrt(v) for numerical stability
+>> decay - the weight decay
+>> clearGrad - set the gradient to zero after the update
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _AdamUpdate(XTensor * param, XTensor * grad, XTensor * m, XTensor * v,
+                 DTYPE beta1, DTYPE beta2, DTYPE stepSize, DTYPE delta,
+                 DTYPE decay, bool clearGrad,
+                 XPRunner * parallelRunner)
+{
+    CheckNTErrors(param && grad && m && v, "Empty input tensors!");
+    CheckNTErrors(param->unitNum == grad->unitNum && param->unitNum == m->unitNum &&
+                  param->unitNum == v->unitNum, "Unmatched tensors!");
+    CheckNTErrors(param->devID == grad->devID && param->devID == m->devID &&
+                  param->devID == v->devID, "The tensors must be on the same device!");
+    CheckNTErrors(param->dataType == X_FLOAT && grad->dataType == X_FLOAT &&
+                  m->dataType == X_FLOAT && v->dataType == X_FLOAT, "TODO!");
+
+#ifdef USE_CUDA
+    if (param->devID >= 0) {
+        _CudaAdamUpdate(param, grad, m, v, beta1, beta2, stepSize, delta, decay, clearGrad);
+        return;
+    }
+#endif
+
+    AdamArgs args;
+    args.p = (DTYPE*)param->data;
+    args.g = (DTYPE*)grad->data;
+    args.m = (DTYPE*)m->data;
+    args.v = (DTYPE*)v->data;
+    args.n = param->unitNum;
+    args.beta1 = beta1;
+    args.beta2 = beta2;
+    args.stepSize = stepSize;
+    args.delta = delta;
+    args.decay = decay;
+    args.clearGrad = clearGrad;
+
+    int blockNum = (param->unitNum + ADAM_BLOCK_SIZE - 1) / ADAM_BLOCK_SIZE;
+
+    /* number of operations (clipped to avoid overflow) */
+    double opNum = 10.0 * param->unitNum;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_AdamUpdateBlock, (int)opNum,
+                  blockNum, 1, 1, &args);
+}
+
+} // namespace nts(NiuTrans.Tensor)
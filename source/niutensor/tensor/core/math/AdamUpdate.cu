@@ -0,0 +1,99 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../../XDevice.h"
+#include "../../XTensor.h"
+#include "AdamUpdate.h"
+#include "AdamUpdate.cuh"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+#ifdef USE_CUDA
+
+/*
+the Adam(W) update (CUDA Kernel)
+>> p - the parameters
+>> g - the gradients
+>> m - the 1st order moments
+>> v - the 2nd order moments
+>> size - size of the data arrays
+>> beta1 - the decay rate of the 1st order moment
+>> beta2 - the decay rate of the 2nd order moment
+>> stepSize - the step size
+>> delta - added to sqrt(v) for numerical stability
+>> decay - the weight decay
+>> clearGrad - set the gradient to zero after the update
+*/
+__global__
+void KernelAdamUpdate(DTYPE * p, DTYPE * g, DTYPE * m, DTYPE * v, int size,
+                      DTYPE beta1, DTYPE beta2, DTYPE stepSize, DTYPE delta,
+                      DTYPE decay, bool clearGrad)
+{
+    int i = blockDim.x * blockIdx.x + threadIdx.x;
+
+    if (i < size) {
+        DTYPE gi = g[i];
+        DTYPE mi = beta1 * m[i] + (1.0F - beta1) * gi;
+        DTYPE vi = beta2 * v[i] + (1.0F - beta2) * gi * gi;
+        m[i] = mi;
+        v[i] = vi;
+        p[i] = (1.0F - decay) * p[i] - stepSize * mi / (sqrt(vi) + delta);
+        if (clearGrad)
+            g[i] = 0;
+    }
+}
+
+/*
+the Adam(W) update (cuda version)
+>> param - the parameter tensor
+>> grad - the gradient
+>> m - the 1st order moment
+>> v - the 2nd order moment
+>> beta1 - the decay rate of the 1st order moment
+>> beta2 - the decay rate of the 2nd order moment
+>> stepSize - the step size
+>> delta - added to sqrt(v) for numerical stability
+>> decay - the weight decay
+>> clearGrad - set the gradient to zero after the update
+*/
+void _CudaAdamUpdate(XTensor * param, XTensor * grad, XTensor * m, XTensor * v,
+                     DTYPE beta1, DTYPE beta2, DTYPE stepSize, DTYPE delta,
+                     DTYPE decay, bool clearGrad)
+{
+    int gridSize[3];
+    int blockSize[3];
+
+    GDevs.GetCudaThread(param->devID, param->unitNum, gridSize, blockSize);
+
+    int devIDBackup;
+    ProtectCudaDev(param->devID, devIDBackup);
+
+    KernelAdamUpdate<<<dim3(gridSize[0]), dim3(blockSize[0])>>>
+                     ((DTYPE*)param->data, (DTYPE*)grad->data,
+                      (DTYPE*)m->data, (DTYPE*)v->data, param->unitNum,
+                      beta1, beta2, stepSize, delta, decay, clearGrad);
+
+    BacktoCudaDev(param->devID, devIDBackup);
+}
+
+#endif // USE_CUDA
+
+} // namespace nts(NiuTrans.Tensor)
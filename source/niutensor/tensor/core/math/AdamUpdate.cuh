@@ -0,0 +1,46 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __ADAMUPDATE_CUH__
+#define __ADAMUPDATE_CUH__
+
+#include "AdamUpdate.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+#ifdef USE_CUDA
+
+/* the Adam(W) update (CUDA Kernel) */
+__global__
+void KernelAdamUpdate(DTYPE * p, DTYPE * g, DTYPE * m, DTYPE * v, int size,
+                      DTYPE beta1, DTYPE beta2, DTYPE stepSize, DTYPE delta,
+                      DTYPE decay, bool clearGrad);
+
+/* the Adam(W) update (cuda version) */
+void _CudaAdamUpdate(XTensor * param, XTensor * grad, XTensor * m, XTensor * v,
+                     DTYPE beta1, DTYPE beta2, DTYPE stepSize, DTYPE delta,
+                     DTYPE decay, bool clearGrad);
+
+#endif // USE_CUDA
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __ADAMUPDATE_CUH__
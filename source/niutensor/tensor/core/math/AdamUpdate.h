@@ -0,0 +1,48 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* The Adam(W) update in one operation. The moments, the parameter and
+* (optionally) the gradient are updated in a single pass over the data,
+* which is what a bandwidth-bound optimizer step needs when all of them
+* are kept in flat buffers.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __ADAMUPDATE_H__
+#define __ADAMUPDATE_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+the Adam(W) update
+m = beta1 * m + (1 - beta1) * g
+v = beta2 * v + (1 - beta2) * g * g
+p = (1 - decay) * p - stepSize * m / (sqrt(v) + delta)
+and g = 0 if the gradient is cleared
+*/
+void _AdamUpdate(XTensor * param, XTensor * grad, XTensor * m, XTensor * v,
+                 DTYPE beta1, DTYPE beta2, DTYPE stepSize, DTYPE delta,
+                 DTYPE decay, bool clearGrad,
+                 XPRunner * parallelRunner = NULL);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __ADAMUPDATE_H__
@@ -0,0 +1,281 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include <limits.h>
+#include "AddNormalize.h"
+#include "../utilities/XMatrixSegment.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ADDNORM_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* the scale of the L1 distance (as in _ReduceVariance) */
+#define ADDNORM_L1_SCALE sqrtf(3.1415926F / 2.0F)
+
+/* arguments of the normalization jobs */
+struct AddNormArgs
+{
+    DTYPE * x;
+    const DTYPE * residual;
+    DTYPE * y;
+    const DTYPE * a;
+    const DTYPE * b;
+    int n;
+    DTYPE epsilon;
+    bool L1Normed;
+};
+
+/*
+residual connection and normalization of a row
+>> x - the row (it keeps x + residual)
+>> r - the residual (NULL if there is no residual connection)
+>> y - the result (it can be x)
+>> a - the scale
+>> b - the bias
+>> n - number of items
+>> epsilon - added to the variance (L2 only)
+>> L1Normed - L1 or L2 normalization
+*/
+static void RowAddNormGeneric(DTYPE * x, const DTYPE * r, DTYPE * y,
+                              const DTYPE * a, const DTYPE * b,
+                              int n, DTYPE epsilon, bool L1Normed)
+{
+    DTYPE sum = 0;
+    for (int i = 0; i < n; i++) {
+        if (r != NULL)
+            x[i] += r[i];
+        sum += x[i];
+    }
+    DTYPE mean = sum / n;
+
+    DTYPE dev = 0;
+    for (int i = 0; i < n; i++) {
+        DTYPE d = x[i] - mean;
+        dev += L1Normed ? (DTYPE)fabs(d) : d * d;
+    }
+
+    DTYPE norm = L1Normed ? ADDNORM_L1_SCALE / n * dev : (DTYPE)sqrt(dev / n + epsilon);
+
+    for (int i = 0; i < n; i++)
+        y[i] = a[i] * (x[i] - mean) / norm + b[i];
+}
+
+#ifdef ADDNORM_X86_SIMD
+
+/* the sum of the 8 items */
+__attribute__((target("avx2")))
+static inline DTYPE HorizontalSumAVX2(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+/* residual connection and normalization of a row (AVX2) */
+__attribute__((target("avx2")))
+static void RowAddNormAVX2(DTYPE * x, const DTYPE * r, DTYPE * y,
+                           const DTYPE * a, const DTYPE * b,
+                           int n, DTYPE epsilon, bool L1Normed)
+{
+    int m = n - n % 8;
+
+    /* x = x + r and the mean */
+    __m256 vsum = _mm256_setzero_ps();
+    for (int i = 0; i < m; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        if (r != NULL) {
+            v = _mm256_add_ps(v, _mm256_loadu_ps(r + i));
+            _mm256_storeu_ps(x + i, v);
+        }
+        vsum = _mm256_add_ps(vsum, v);
+    }
+    DTYPE sum = HorizontalSumAVX2(vsum);
+    for (int i = m; i < n; i++) {
+        if (r != NULL)
+            x[i] += r[i];
+        sum += x[i];
+    }
+    DTYPE mean = sum / n;
+
+    /* the variance (or the L1 distance) */
+    __m256 vmean = _mm256_set1_ps(mean);
+    __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 vdev = _mm256_setzero_ps();
+    for (int i = 0; i < m; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(x + i), vmean);
+        if (L1Normed)
+            vdev = _mm256_add_ps(vdev, _mm256_and_ps(d, absMask));
+        else
+            vdev = _mm256_add_ps(vdev, _mm256_mul_ps(d, d));
+    }
+    DTYPE dev = HorizontalSumAVX2(vdev);
+    for (int i = m; i < n; i++) {
+        DTYPE d = x[i] - mean;
+        dev += L1Normed ? (DTYPE)fabs(d) : d * d;
+    }
+
+    DTYPE norm = L1Normed ? ADDNORM_L1_SCALE / n * dev : (DTYPE)sqrt(dev / n + epsilon);
+
+    /* y = a * (x - mean) / norm + b */
+    __m256 vnorm = _mm256_set1_ps(norm);
+    for (int i = 0; i < m; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(x + i), vmean);
+        __m256 v = _mm256_div_ps(_mm256_mul_ps(_mm256_loadu_ps(a + i), d), vnorm);
+        _mm256_storeu_ps(y + i, _mm256_add_ps(v, _mm256_loadu_ps(b + i)));
+    }
+    for (int i = m; i < n; i++)
+        y[i] = a[i] * (x[i] - mean) / norm + b[i];
+}
+
+#endif
+
+/* the row kernel in use */
+typedef void (*AddNormRowKernel)(DTYPE * x, const DTYPE * r, DTYPE * y,
+                                 const DTYPE * a, const DTYPE * b,
+                                 int n, DTYPE epsilon, bool L1Normed);
+
+/* pick the best row kernel that the CPU supports */
+static AddNormRowKernel PickAddNormKernel()
+{
+#ifdef ADDNORM_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return RowAddNormAVX2;
+#endif
+    return RowAddNormGeneric;
+}
+
+/*
+residual connection and normalization for the rows x1...x2
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2),
+            of which only the rows x1 and x2 are used, and a TensorList
+            holding the AddNormArgs structure
+*/
+static void _AddNormalizeBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * normArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(normArgs->count == 1, "invalid argument number!");
+
+    AddNormArgs * p = (AddNormArgs*)normArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int x2 = indexArgs->GetItem(2);
+
+    static const AddNormRowKernel kernel = PickAddNormKernel();
+    int n = p->n;
+
+    for (int row = x1; row <= x2; row++) {
+        size_t offset = (size_t)row * n;
+        kernel(p->x + offset, p->residual != NULL ? p->residual + offset : NULL,
+               p->y + offset, p->a, p->b, n, p->epsilon, p->L1Normed);
+    }
+}
+
+/*
+residual connection and normalization along the last dimension (on CPUs).
+For an input x, x = x + residual first. Then
+y = a * (x-mean)/sqrt(variance+\epsilon) + b (L2), or
+y = a * (x-mean)/distance + b (L1)
+where a and b are the scalar and bias respectively, and the distance is
+computed as _ReduceVariance does. It gives the same result as the sum,
+_ReduceMean, _ReduceVariance and _Normalize (or _L1Normalize) in sequence,
+but reads each row once from memory and makes no intermediate tensor.
+Rows are processed in parallel.
+
+>> x - the input tensor (it keeps x + residual if residual is not NULL)
+>> residual - the residual (NULL if there is no residual connection)
+>> y - the output tensor (it can be x)
+>> a - the scale, (d)
+>> b - the bias, (d)
+>> epsilon - added to the variance (L2 only)
+>> L1Normed - L1 or L2 normalization
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _AddNormalize(XTensor * x, const XTensor * residual, XTensor * y,
+                   const XTensor * a, const XTensor * b,
+                   DTYPE epsilon, bool L1Normed,
+                   XPRunner * parallelRunner)
+{
+    CheckNTErrors(x && y && a && b, "Empty input tensors!");
+    CheckNTErrors(IsAddNormalizable(x, residual, a, b), "Unsupported tensors!");
+    CheckNTErrors(y->devID < 0 && y->dataType == X_FLOAT && y->unitNum == x->unitNum,
+                  "Wrong output tensor!");
+
+    int n = x->GetDim(-1);
+    int rowNum = x->unitNum / n;
+
+    AddNormArgs args;
+    args.x = (DTYPE*)x->data;
+    args.residual = residual != NULL ? (DTYPE*)residual->data : NULL;
+    args.y = (DTYPE*)y->data;
+    args.a = (DTYPE*)a->data;
+    args.b = (DTYPE*)b->data;
+    args.n = n;
+    args.epsilon = epsilon;
+    args.L1Normed = L1Normed;
+
+    /* number of operations (clipped to avoid overflow) */
+    double opNum = 6.0 * rowNum * n;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_AddNormalizeBlock, (int)opNum,
+                  rowNum, 1, 1, &args);
+}
+
+/*
+can _AddNormalize be used for the tensors, i.e., are they dense float tensors
+on CPUs, and do the residual, the scale and the bias fit the input
+>> x - the input tensor
+>> residual - the residual (NULL if there is no residual connection)
+>> a - the scale
+>> b - the bias
+*/
+bool IsAddNormalizable(const XTensor * x, const XTensor * residual,
+                       const XTensor * a, const XTensor * b)
+{
+    if (x->devID >= 0 || x->isSparse || x->dataType != X_FLOAT || x->unitNum == 0)
+        return false;
+
+    int n = x->GetDim(-1);
+
+    if (residual != NULL) {
+        if (residual->devID >= 0 || residual->isSparse || residual->dataType != X_FLOAT ||
+            residual->unitNum != x->unitNum || residual->GetDim(-1) != n)
+            return false;
+    }
+
+    return a->devID < 0 && b->devID < 0 &&
+           a->dataType == X_FLOAT && b->dataType == X_FLOAT &&
+           a->unitNum == n && b->unitNum == n;
+}
+
+} // namespace nts(NiuTrans.Tensor)
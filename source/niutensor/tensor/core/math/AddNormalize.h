@@ -0,0 +1,51 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Residual connection and layer normalization in one operation on CPUs
+* (for inference). Each row is summed, normalized and scaled while it is in
+* the cache, so that no mean, variance or sum tensor is made.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __ADDNORMALIZE_H__
+#define __ADDNORMALIZE_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+residual connection and normalization along the last dimension.
+x = x + residual, and
+y = a * (x-mean)/sqrt(variance+\epsilon) + b (L2), or
+y = a * (x-mean)/distance + b (L1)
+where a and b are the scalar and bias respectively.
+*/
+void _AddNormalize(XTensor * x, const XTensor * residual, XTensor * y,
+                   const XTensor * a, const XTensor * b,
+                   DTYPE epsilon, bool L1Normed,
+                   XPRunner * parallelRunner = NULL);
+
+/* can _AddNormalize be used for the tensors */
+bool IsAddNormalizable(const XTensor * x, const XTensor * residual,
+                       const XTensor * a, const XTensor * b);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __ADDNORMALIZE_H__
@@ -170,4 +170,69 @@ XTensor Gather(XTensor &s, XTensor &index)
     return t;
 }
 
+/*
+gather indexed rows of an int8 matrix and dequantize them, i.e.,
+t(i, j) = q(index(i), j) * scale(index(i))
+(e.g., a row-wise quantized embedding table)
+
+>> q - the source matrix (in int8)
+>> scale - the scale of each row
+>> t - the target tensor (in float)
+>> srcIndex - the tensor to save the index of the source rows
+*/
+void _GatherINT8(const XTensor * q, const XTensor * scale, XTensor * t, XTensor * srcIndex)
+{
+    CheckNTErrors((q && scale && t && srcIndex), "Invalid tensors!");
+    CheckNTErrors(q->devID < 0 && t->devID < 0, "INT8 tensors are only supported on CPUs!");
+    CheckNTErrors(q->dataType == X_INT8 && q->order == 2, "The source must be an int8 matrix!");
+    CheckNTErrors(t->dataType == X_FLOAT, "The target must be in float!");
+    CheckNTErrors(scale->unitNum == q->dimSize[0], "Wrong size of the scale tensor!");
+
+    int stride = q->GetDim(-1);
+    int indexSize = srcIndex->unitNum;
+
+    CheckNTErrors(t->unitNum == indexSize * stride, "Unmatched tensors!");
+
+    signed char * qData = (signed char*)q->data;
+    DTYPE * sData = (DTYPE*)scale->data;
+    DTYPE * tData = (DTYPE*)t->data;
+    int * sIndexData = (int*)srcIndex->data;
+
+    for (int i = 0; i < indexSize; i++) {
+        int row = sIndexData[i];
+        CheckNTErrors(row >= 0 && row < q->dimSize[0], "Wrong index!");
+        signed char * qp = qData + row * stride;
+        DTYPE * tp = tData + i * stride;
+        DTYPE s = sData[row];
+        for (int j = 0; j < stride; j++)
+            tp[j] = qp[j] * s;
+    }
+}
+
+/*
+gather indexed rows of an int8 matrix and dequantize them (return an XTensor structure)
+make a new tensor to keep the result and return it.
+NOTE: it is for inference only and no gradient flows through it.
+
+>> q - the source matrix (in int8)
+>> scale - the scale of each row
+>> index - the index tensor
+<< return - the dequantized rows, (index dims..., q.GetDim(-1))
+*/
+XTensor GatherINT8(XTensor &q, XTensor &scale, XTensor &index)
+{
+    int * dims = new int[index.order + 1];
+    memcpy(dims, index.dimSize, index.order * sizeof(int));
+    dims[index.order] = q.GetDim(-1);
+
+    XTensor t;
+    InitTensor(&t, index.order + 1, dims, X_FLOAT, q.devID, false);
+
+    _GatherINT8(&q, &scale, &t, &index);
+
+    delete[] dims;
+
+    return t;
+}
+
 } // namespace nts(NiuTrans.Tensor)
\ No newline at end of file
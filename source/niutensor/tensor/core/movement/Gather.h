@@ -36,6 +36,13 @@ void _Gather(const XTensor * s, XTensor * t, XTensor * srcIndex, int dim);
    make a new tensor to keep the result and return it */
 XTensor Gather(XTensor &s, XTensor &index);
 
+/* gather selected rows of an int8 matrix and dequantize them */
+void _GatherINT8(const XTensor * q, const XTensor * scale, XTensor * t, XTensor * srcIndex);
+
+/* gather selected rows of an int8 matrix and dequantize them (return an XTensor structure)
+   make a new tensor to keep the result and return it */
+XTensor GatherINT8(XTensor &q, XTensor &scale, XTensor &index);
+
 } // namespace nts(NiuTrans.Tensor)
 
 #endif // __GATHER_H__
\ No newline at end of file
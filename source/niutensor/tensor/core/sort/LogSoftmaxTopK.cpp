@@ -0,0 +1,257 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include <limits.h>
+#include "../../XTensor.h"
+#include "../../XHeap.h"
+#include "LogSoftmaxTopK.h"
+#include "../utilities/XMatrixSegment.h"
+#include "../../function/SoftmaxKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LSTOPK_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* arguments of the pruning jobs */
+struct LSTopKArgs
+{
+    const DTYPE * x;
+    const DTYPE * prev;
+    const DTYPE * mask;
+    DTYPE * value;
+    DTYPE * score;
+    int * index;
+    int vocabSize;
+    int groupSize;
+    int k;
+    DTYPE lp;
+};
+
+/* push an item into the heap if it is one of the top-k items so far */
+static inline void OfferTopK(XHeap<MIN_HEAP, DTYPE> &heap, int index, DTYPE s)
+{
+    if (heap.count < heap.size)
+        heap.Push(HeapNode<DTYPE>(index, s));
+    else if (s > heap.Top().value)
+        heap.ReplaceTop(HeapNode<DTYPE>(index, s));
+}
+
+/*
+offer the items of a row to the heap
+s(v) = (max(x(v) - c, LOGPROB_MIN) + prev) + mask
+*/
+static void RowSelectGeneric(const DTYPE * x, int n, DTYPE c, DTYPE prev, DTYPE mask,
+                             int offset, XHeap<MIN_HEAP, DTYPE> &heap)
+{
+    for (int i = 0; i < n; i++) {
+        DTYPE s = (MAX(x[i] - c, LOGPROB_MIN) + prev) + mask;
+        OfferTopK(heap, offset + i, s);
+    }
+}
+
+#ifdef LSTOPK_X86_SIMD
+
+/*
+offer the items of a row to the heap (AVX2). The scores of 8 items are
+computed at a time and compared with the smallest item in the heap, so
+that only the few items that make it into the top-k touch the heap.
+*/
+__attribute__((target("avx2")))
+static void RowSelectAVX2(const DTYPE * x, int n, DTYPE c, DTYPE prev, DTYPE mask,
+                          int offset, XHeap<MIN_HEAP, DTYPE> &heap)
+{
+    __m256 vc = _mm256_set1_ps(c);
+    __m256 vmin = _mm256_set1_ps(LOGPROB_MIN);
+    __m256 vprev = _mm256_set1_ps(prev);
+    __m256 vmask = _mm256_set1_ps(mask);
+    float buf[8];
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 s = _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), vc), vmin);
+        s = _mm256_add_ps(_mm256_add_ps(s, vprev), vmask);
+
+        int bits = 0xFF;
+        if (heap.count == heap.size)
+            bits = _mm256_movemask_ps(_mm256_cmp_ps(s, _mm256_set1_ps(heap.Top().value), _CMP_GT_OQ));
+        if (bits == 0)
+            continue;
+
+        _mm256_storeu_ps(buf, s);
+        for (int j = 0; j < 8; j++) {
+            if (bits & (1 << j))
+                OfferTopK(heap, offset + i + j, buf[j]);
+        }
+    }
+
+    RowSelectGeneric(x + i, n - i, c, prev, mask, offset + i, heap);
+}
+
+#endif
+
+/* the row kernels in use */
+struct LSTopKKernels
+{
+    void (*rowSelect)(const DTYPE * x, int n, DTYPE c, DTYPE prev, DTYPE mask,
+                      int offset, XHeap<MIN_HEAP, DTYPE> &heap);
+};
+
+/* pick the best row kernels that the CPU supports */
+static LSTopKKernels GetLSTopKKernels()
+{
+    LSTopKKernels kernels;
+    kernels.rowSelect = RowSelectGeneric;
+#ifdef LSTOPK_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.rowSelect = RowSelectAVX2;
+    }
+#endif
+    return kernels;
+}
+
+/*
+beam pruning for the groups x1...x2
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2),
+            of which only the groups x1 and x2 are used, and a TensorList
+            holding the LSTopKArgs structure
+*/
+static void _LogSoftmaxTopKBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * topkArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(topkArgs->count == 1, "invalid argument number!");
+
+    LSTopKArgs * a = (LSTopKArgs*)topkArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int x2 = indexArgs->GetItem(2);
+
+    LSTopKKernels kernels = GetLSTopKKernels();
+    int n = a->vocabSize;
+    int k = a->k;
+    XHeap<MIN_HEAP, DTYPE> heap(k);
+
+    for (int g = x1; g <= x2; g++) {
+        heap.Clear(DTYPE_MIN);
+
+        for (int i = 0; i < a->groupSize; i++) {
+            int r = g * a->groupSize + i;
+            const DTYPE * xr = a->x + (size_t)r * n;
+
+            /* log-softmax: x(v) - max - log(sum_v' exp(x(v') - max)) */
+            DTYPE m = 0;
+            DTYPE sum = 0;
+            _RowMaxExpSumCPU(xr, n, &m, &sum);
+            DTYPE c = m + (DTYPE)log(sum);
+
+            DTYPE prev = a->prev != NULL ? a->prev[r] : 0;
+            DTYPE mask = a->mask != NULL ? a->mask[r] : 0;
+
+            kernels.rowSelect(xr, n, c, prev, mask, i * n, heap);
+        }
+
+        /* the items are sorted in descending order */
+        for (int j = k - 1; j >= 0; j--) {
+            HeapNode<DTYPE> node = heap.Pop();
+            a->value[g * k + j] = node.value;
+            a->index[g * k + j] = (int)node.index;
+            if (a->score != NULL)
+                a->score[g * k + j] = node.value / a->lp;
+        }
+    }
+}
+
+/*
+top-k items of the accumulated log-softmax scores of each group of rows. It
+fuses the log-softmax, the sum with the scores of the previous step and the
+top-k selection in beam search, i.e.,
+s(r, v) = logsoftmax(x(r))(v) + prev(r) + mask(r)
+and the top-k items of each group of rows are selected from s. The indices
+are offsets in the group, i.e., r' * V + v for the row r' of the group. The
+log-softmax is clipped at LOGPROB_MIN as _LogSoftmax does. Groups are
+processed in parallel, and each row is read twice (for the max and the sum
+in one pass, and for the selection) without any intermediate tensor.
+
+>> x - the output scores (before the softmax), (N, V) where N = G * groupSize
+>> prev - the score of each row (NULL for zeros), (N)
+>> mask - a value added to the score of each row (NULL for zeros), (N)
+>> groupSize - the number of rows in a group, e.g., the beam size
+>> k - the number of items to keep for each group
+>> lp - the length penalty, i.e., score = value / lp
+>> value - the top-k scores of each group, (G, k)
+>> score - the top-k scores divided by the length penalty (NULL if not needed), (G, k)
+>> index - the offsets of the top-k items in each group, (G, k)
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _LogSoftmaxTopK(const XTensor * x, const XTensor * prev, const XTensor * mask,
+                     int groupSize, int k, DTYPE lp,
+                     XTensor * value, XTensor * score, XTensor * index,
+                     XPRunner * parallelRunner)
+{
+    CheckNTErrors(x && value && index, "Empty input tensors!");
+    CheckNTErrors(x->devID < 0 && value->devID < 0 && index->devID < 0,
+                  "The fused beam pruning only runs on CPUs!");
+    CheckNTErrors(x->dataType == X_FLOAT && value->dataType == X_FLOAT && index->dataType == X_INT,
+                  "Wrong data types!");
+
+    int n = x->GetDim(-1);
+    int rowNum = x->unitNum / n;
+    int groupNum = rowNum / groupSize;
+
+    CheckNTErrors(groupSize > 0 && rowNum % groupSize == 0, "Wrong group size!");
+    CheckNTErrors(k > 0 && k <= groupSize * n, "A too large K!");
+    CheckNTErrors(prev == NULL || prev->unitNum == rowNum, "Wrong size of the previous scores!");
+    CheckNTErrors(mask == NULL || mask->unitNum == rowNum, "Wrong size of the mask!");
+    CheckNTErrors(value->unitNum == groupNum * k && index->unitNum == groupNum * k, "Wrong size of the output!");
+    CheckNTErrors(score == NULL || (score->unitNum == groupNum * k && score->dataType == X_FLOAT),
+                  "Wrong size of the output!");
+
+    LSTopKArgs args;
+    args.x = (DTYPE*)x->data;
+    args.prev = prev != NULL ? (DTYPE*)prev->data : NULL;
+    args.mask = mask != NULL ? (DTYPE*)mask->data : NULL;
+    args.value = (DTYPE*)value->data;
+    args.score = score != NULL ? (DTYPE*)score->data : NULL;
+    args.index = (int*)index->data;
+    args.vocabSize = n;
+    args.groupSize = groupSize;
+    args.k = k;
+    args.lp = lp;
+
+    /* number of operations (clipped to avoid overflow) */
+    double opNum = 4.0 * rowNum * n;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_LogSoftmaxTopKBlock, (int)opNum,
+                  groupNum, 1, 1, &args);
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,47 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Beam pruning in one pass over the output scores: the log-softmax of each
+* row, the accumulated score of the row and the top-k selection over a group
+* of rows (e.g., the hypotheses of a sentence) are fused, so that no
+* intermediate tensor of the vocabulary size is made.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __LOGSOFTMAXTOPK_H__
+#define __LOGSOFTMAXTOPK_H__
+
+#include "../../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+top-k items of the accumulated log-softmax scores of each group of rows
+s(r, v) = logsoftmax(x(r))(v) + prev(r) + mask(r)
+value(g) = top-k of s(r, v) for the rows r of group g, index(g) = r' * V + v
+where r' is the offset of the row in the group, and score(g) = value(g) / lp
+*/
+void _LogSoftmaxTopK(const XTensor * x, const XTensor * prev, const XTensor * mask,
+                     int groupSize, int k, DTYPE lp,
+                     XTensor * value, XTensor * score, XTensor * index,
+                     XPRunner * parallelRunner = NULL);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __LOGSOFTMAXTOPK_H__
@@ -25,6 +25,27 @@
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
+/*
+get the number of the jobs that RunParallel2D runs a matrix in
+>> parallelRunner - parallel runner
+>> opNum - number of operations
+>> rowNum - number of rows
+>> colNum - number of columns
+<< return - number of the jobs (1 if the matrix is processed in one job)
+*/
+int GetParallel2DJobNum(XPRunner * parallelRunner, int opNum, int rowNum, int colNum)
+{
+    int jobNum = 1;
+
+    if (parallelRunner != NULL && (parallelRunner->method == PRUNNER_SINGLE || parallelRunner->method == PRUNNER_MULTIPLE)) {
+        if (opNum >= parallelRunner->minimumOPNum * parallelRunner->threadNum)
+            jobNum = parallelRunner->GetJobNum(opNum);
+    }
+
+    /* a job has at least one item to compute */
+    return MAX(MIN(jobNum, rowNum * colNum), 1);
+}
+
 /*
 segment a 2d tensor (i.e., matrix) into blocks and run jobs in parallel
 >> parallelRunner - parallel runner
@@ -41,14 +62,7 @@ void RunParallel2D(XPRunner * parallelRunner, void * job,
     if (rowNum == 0 || colNum == 0)
         return;
 
-    int jobNum = 1;
-
-    if (parallelRunner != NULL && (parallelRunner->method == PRUNNER_SINGLE || parallelRunner->method == PRUNNER_MULTIPLE)) {
-        if (opNum >= parallelRunner->minimumOPNum * parallelRunner->threadNum)
-            jobNum = parallelRunner->GetJobNum(rowNum * colNum);
-    }
-
-    CheckNTErrors(jobNum != 0, "TODO!");
+    int jobNum = GetParallel2DJobNum(parallelRunner, opNum, rowNum, colNum);
 
     /* argument list of the jobs */
     XList * jobArgList = new XList(argNum);
@@ -72,11 +86,12 @@ void RunParallel2D(XPRunner * parallelRunner, void * job,
 
     /*
     assign jobs
-    argument rules:
+    argument rules (for each job):
     1. block information
     2. other arguments
     */
-    for (int i = 0; i < jobNum; i++) {
+    for (int i = 0; i < nblock; i++) {
+        XList * jobArgs = new XList(2);
         IntList* indexArgs = new IntList(4);
         XList * blockArgs = new XList(argNum);
         int * blockIndex = indexList + i * 4;
@@ -89,18 +104,16 @@ void RunParallel2D(XPRunner * parallelRunner, void * job,
         for (int j = 0; j < argNum; j++)
             blockArgs->Add(jobArgList->GetItem(j));
 
-        args->Add((void*)indexArgs);
-        args->Add((void*)blockArgs);
+        jobArgs->Add((void*)indexArgs);
+        jobArgs->Add((void*)blockArgs);
 
+        args->Add((void*)jobArgs);
         jobs->Add((void*)job);
     }
 
-    args->count = jobNum * 2;
-    jobs->count = nblock;
-
     /* single job */
-    if (jobNum == 1)
-        ((TFunction)job)(args);
+    if (nblock == 1)
+        ((TFunction)job)((XList*)args->GetItem(0));
     /* multiple jobs */
     else
         parallelRunner->Run(jobs, args);
@@ -108,8 +121,10 @@ void RunParallel2D(XPRunner * parallelRunner, void * job,
     /* free the memory */
     delete[] indexList;
     for (int i = 0; i < args->count; i++) {
-        TensorList * blockArgs = (TensorList*)args->GetItem(i);
-        delete blockArgs;
+        XList * jobArgs = (XList*)args->GetItem(i);
+        delete (IntList*)jobArgs->GetItem(0);
+        delete (XList*)jobArgs->GetItem(1);
+        delete jobArgs;
     }
     delete args;
     delete jobs;
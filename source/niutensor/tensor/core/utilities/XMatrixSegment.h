@@ -30,6 +30,9 @@ namespace nts { // namespace nts(NiuTrans.Tensor)
 /* segment a 2d tensor (i.e., matrix) into blocks and run jobs in parallel */
 void RunParallel2D(XPRunner * parallelRunner, void * job, int opNum, int rowNum, int colNum, int argNum, ...);
 
+/* number of the jobs that RunParallel2D runs a matrix in */
+int GetParallel2DJobNum(XPRunner * parallelRunner, int opNum, int rowNum, int colNum);
+
 /* segment a block into sub-blocks */
 int SegmentTensor2D(int rowNum, int colNum, int blockNum, int * blockIndex);
 
@@ -35,5 +35,6 @@
 #include "Rectify.h"
 #include "Sigmoid.h"
 #include "Softmax.h"
+#include "SoftmaxKernel.h"
 
 #endif // __FHEADER_H__
\ No newline at end of file
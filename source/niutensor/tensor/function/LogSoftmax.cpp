@@ -22,6 +22,7 @@
 #include <math.h>
 #include "LogSoftmax.h"
 #include "LogSoftmax.cuh"
+#include "SoftmaxKernel.h"
 #include "../XName.h"
 #include "../XUtility.h"
 #include "../core/reduce/ReduceSum.h"
@@ -50,6 +51,12 @@ void _LogSoftmax(const XTensor * x, XTensor * y, int leadDim)
         return;
     }
 
+    /* the row kernels on CPUs (without the max and sum tensors) */
+    if (IsSoftmaxLastDimCPU(x, y, leadDim)) {
+        _SoftmaxLastDimCPU(x, y, true);
+        return;
+    }
+
     if (!x->isSparse && !y->isSparse &&
         x->dataType == DEFAULT_DTYPE && y->dataType == DEFAULT_DTYPE)
     {
@@ -22,6 +22,7 @@
 #include <math.h>
 #include "Softmax.h"
 #include "Softmax.cuh"
+#include "SoftmaxKernel.h"
 #include "../XName.h"
 #include "../XUtility.h"
 #include "../core/reduce/ReduceSum.h"
@@ -41,6 +42,12 @@ void _Softmax(const XTensor * x, XTensor * y, int leadDim)
     if(leadDim < 0)
         leadDim = x->order - 1;
 
+    /* the row kernels on CPUs (without the max and sum tensors) */
+    if(IsSoftmaxLastDimCPU(x, y, leadDim)){
+        _SoftmaxLastDimCPU(x, y, false);
+        return;
+    }
+
     if(!x->isSparse && !y->isSparse && x->dataType == y->dataType){
         int * dimSize = new int[x->order - 1];
         for(int i = 0; i < x->order; i++){
@@ -0,0 +1,396 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include <limits.h>
+#include "SoftmaxKernel.h"
+#include "../XUtility.h"
+#include "../core/utilities/XMatrixSegment.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SOFTMAX_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* arguments of the softmax jobs */
+struct SoftmaxArgs
+{
+    const DTYPE * x;
+    DTYPE * y;
+    int n;
+    bool isLog;
+};
+
+/* the max item of a row */
+static DTYPE RowMaxGeneric(const DTYPE * x, int n)
+{
+    DTYPE m = x[0];
+    for (int i = 1; i < n; i++) {
+        if (x[i] > m)
+            m = x[i];
+    }
+    return m;
+}
+
+/*
+the max item of a row and \sum_{i} e^{x_i - max} in one pass. The sum is
+rescaled whenever a larger item is found (see "Online normalizer calculation
+for softmax", Milakov and Gimelshein, 2018).
+*/
+static void RowMaxExpSumGeneric(const DTYPE * x, int n, DTYPE * max, DTYPE * sum)
+{
+    DTYPE m = x[0];
+    DTYPE s = 1.0F;
+    for (int i = 1; i < n; i++) {
+        if (x[i] > m) {
+            s = s * (DTYPE)exp(m - x[i]) + 1.0F;
+            m = x[i];
+        }
+        else
+            s += (DTYPE)exp(x[i] - m);
+    }
+    *max = m;
+    *sum = s;
+}
+
+/* y = e^{x - max} / sum, in [0, 1] */
+static void RowSoftmaxGeneric(const DTYPE * x, DTYPE * y, int n, DTYPE max, DTYPE sum)
+{
+    for (int i = 0; i < n; i++) {
+        DTYPE r = (DTYPE)exp(x[i] - max) / sum;
+        if (r > (DTYPE)1.0F)
+            r = (DTYPE)1.0F;
+        else if (r < 0)
+            r = 0;
+        y[i] = r;
+    }
+}
+
+/* y = x - c where c = max + log(sum), clipped at LOGPROB_MIN */
+static void RowLogSoftmaxGeneric(const DTYPE * x, DTYPE * y, int n, DTYPE c)
+{
+    for (int i = 0; i < n; i++) {
+        DTYPE r = x[i] - c;
+        if (IsNAN(r))
+            r = LOGPROB_MIN;
+        y[i] = MAX(r, LOGPROB_MIN);
+    }
+}
+
+#ifdef SOFTMAX_X86_SIMD
+
+/* the max item of a row (AVX2) */
+__attribute__((target("avx2")))
+static DTYPE RowMaxAVX2(const DTYPE * x, int n)
+{
+    if (n < 8)
+        return RowMaxGeneric(x, n);
+
+    __m256 m = _mm256_loadu_ps(x);
+    int i = 8;
+    for (; i + 8 <= n; i += 8)
+        m = _mm256_max_ps(m, _mm256_loadu_ps(x + i));
+
+    float buf[8];
+    _mm256_storeu_ps(buf, m);
+    DTYPE r = buf[0];
+    for (int j = 1; j < 8; j++)
+        r = MAX(r, buf[j]);
+    for (; i < n; i++)
+        r = MAX(r, x[i]);
+    return r;
+}
+
+/*
+exp of 8 items (AVX2). The input is split into n * ln(2) + r, and exp(r)
+is approximated by a polynomial of degree 6 (as in the Cephes library).
+The relative error is about 1e-7.
+*/
+__attribute__((target("avx2")))
+static inline __m256 Exp8AVX2(__m256 x)
+{
+    x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949F));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949F));
+
+    /* n = floor(x / ln(2) + 0.5) */
+    __m256 n = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341F)), _mm256_set1_ps(0.5F));
+    n = _mm256_floor_ps(n);
+
+    /* r = x - n * ln(2) (ln(2) is split into two parts for precision) */
+    x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375F)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4F)));
+
+    __m256 y = _mm256_set1_ps(1.9875691500E-4F);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507E-3F));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073E-3F));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894E-2F));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459E-1F));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201E-1F));
+    y = _mm256_add_ps(_mm256_mul_ps(y, _mm256_mul_ps(x, x)), x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(1.0F));
+
+    /* 2^n */
+    __m256i e = _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127));
+    e = _mm256_slli_epi32(e, 23);
+
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+}
+
+/*
+the max item of a row and \sum_{i} e^{x_i - max} in one pass (AVX2). Each
+lane keeps its own max and sum, and the sum of a lane is rescaled only if
+the max of the lane changes. The lanes are merged at the end.
+*/
+__attribute__((target("avx2")))
+static void RowMaxExpSumAVX2(const DTYPE * x, int n, DTYPE * max, DTYPE * sum)
+{
+    if (n < 8) {
+        RowMaxExpSumGeneric(x, n, max, sum);
+        return;
+    }
+
+    __m256 m = _mm256_loadu_ps(x);
+    __m256 s = _mm256_set1_ps(1.0F);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        __m256 newM = _mm256_max_ps(m, v);
+        if (_mm256_movemask_ps(_mm256_cmp_ps(v, m, _CMP_GT_OQ)) != 0)
+            s = _mm256_mul_ps(s, Exp8AVX2(_mm256_sub_ps(m, newM)));
+        s = _mm256_add_ps(s, Exp8AVX2(_mm256_sub_ps(v, newM)));
+        m = newM;
+    }
+
+    float mBuf[8];
+    float sBuf[8];
+    _mm256_storeu_ps(mBuf, m);
+    _mm256_storeu_ps(sBuf, s);
+
+    DTYPE r = mBuf[0];
+    for (int j = 1; j < 8; j++)
+        r = MAX(r, mBuf[j]);
+    for (int j = i; j < n; j++)
+        r = MAX(r, x[j]);
+
+    DTYPE total = 0;
+    for (int j = 0; j < 8; j++)
+        total += sBuf[j] * (DTYPE)exp(mBuf[j] - r);
+    for (int j = i; j < n; j++)
+        total += (DTYPE)exp(x[j] - r);
+
+    *max = r;
+    *sum = total;
+}
+
+/* y = e^{x - max} / sum, in [0, 1] (AVX2) */
+__attribute__((target("avx2")))
+static void RowSoftmaxAVX2(const DTYPE * x, DTYPE * y, int n, DTYPE max, DTYPE sum)
+{
+    __m256 vm = _mm256_set1_ps(max);
+    __m256 vs = _mm256_set1_ps(sum);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0F);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_div_ps(Exp8AVX2(_mm256_sub_ps(_mm256_loadu_ps(x + i), vm)), vs);
+        _mm256_storeu_ps(y + i, _mm256_min_ps(_mm256_max_ps(r, zero), one));
+    }
+
+    RowSoftmaxGeneric(x + i, y + i, n - i, max, sum);
+}
+
+/* y = x - c where c = max + log(sum), clipped at LOGPROB_MIN (AVX2) */
+__attribute__((target("avx2")))
+static void RowLogSoftmaxAVX2(const DTYPE * x, DTYPE * y, int n, DTYPE c)
+{
+    __m256 vc = _mm256_set1_ps(c);
+    __m256 vmin = _mm256_set1_ps(LOGPROB_MIN);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        /* NaNs are replaced by LOGPROB_MIN because max_ps returns the second operand for them */
+        __m256 r = _mm256_sub_ps(_mm256_loadu_ps(x + i), vc);
+        _mm256_storeu_ps(y + i, _mm256_max_ps(r, vmin));
+    }
+
+    RowLogSoftmaxGeneric(x + i, y + i, n - i, c);
+}
+
+#endif
+
+/* the row kernels in use */
+struct SoftmaxKernels
+{
+    DTYPE (*rowMax)(const DTYPE * x, int n);
+    void (*rowMaxExpSum)(const DTYPE * x, int n, DTYPE * max, DTYPE * sum);
+    void (*rowSoftmax)(const DTYPE * x, DTYPE * y, int n, DTYPE max, DTYPE sum);
+    void (*rowLogSoftmax)(const DTYPE * x, DTYPE * y, int n, DTYPE c);
+};
+
+/* pick the best row kernels that the CPU supports */
+static SoftmaxKernels PickSoftmaxKernels()
+{
+    SoftmaxKernels kernels;
+    kernels.rowMax = RowMaxGeneric;
+    kernels.rowMaxExpSum = RowMaxExpSumGeneric;
+    kernels.rowSoftmax = RowSoftmaxGeneric;
+    kernels.rowLogSoftmax = RowLogSoftmaxGeneric;
+#ifdef SOFTMAX_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.rowMax = RowMaxAVX2;
+        kernels.rowMaxExpSum = RowMaxExpSumAVX2;
+        kernels.rowSoftmax = RowSoftmaxAVX2;
+        kernels.rowLogSoftmax = RowLogSoftmaxAVX2;
+    }
+#endif
+    return kernels;
+}
+
+/* the row kernels (they are picked once) */
+static const SoftmaxKernels & GetSoftmaxKernels()
+{
+    static const SoftmaxKernels kernels = PickSoftmaxKernels();
+    return kernels;
+}
+
+/*
+the max item of a row
+>> x - the row
+>> n - number of items
+<< return - the max item
+*/
+DTYPE _RowMaxCPU(const DTYPE * x, int n)
+{
+    CheckNTErrors(n > 0, "Empty row!");
+    return GetSoftmaxKernels().rowMax(x, n);
+}
+
+/*
+the max item of a row and \sum_{i} e^{x_i - max} in one pass
+>> x - the row
+>> n - number of items
+>> max - the max item
+>> sum - the sum of exponentials (shifted by the max item)
+*/
+void _RowMaxExpSumCPU(const DTYPE * x, int n, DTYPE * max, DTYPE * sum)
+{
+    CheckNTErrors(n > 0, "Empty row!");
+    GetSoftmaxKernels().rowMaxExpSum(x, n, max, sum);
+}
+
+/*
+softmax (or log-softmax) for the rows x1...x2
+>> args - a list of two items: an IntList of the block (x1, y1, x2, y2),
+            of which only the rows x1 and x2 are used, and a TensorList
+            holding the SoftmaxArgs structure
+*/
+static void _SoftmaxLastDimBlock(TensorList * args)
+{
+    CheckNTErrors(args->count == 2, "invalid argument number!");
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * softmaxArgs = (TensorList*)args->GetItem(1);
+    CheckNTErrors(indexArgs->count == 4, "invalid argument number!");
+    CheckNTErrors(softmaxArgs->count == 1, "invalid argument number!");
+
+    SoftmaxArgs * a = (SoftmaxArgs*)softmaxArgs->GetItem(0);
+    int x1 = indexArgs->GetItem(0);
+    int x2 = indexArgs->GetItem(2);
+
+    const SoftmaxKernels & kernels = GetSoftmaxKernels();
+    int n = a->n;
+
+    for (int r = x1; r <= x2; r++) {
+        const DTYPE * xr = a->x + (size_t)r * n;
+        DTYPE * yr = a->y + (size_t)r * n;
+        DTYPE max = 0;
+        DTYPE sum = 0;
+
+        kernels.rowMaxExpSum(xr, n, &max, &sum);
+
+        if (a->isLog)
+            kernels.rowLogSoftmax(xr, yr, n, max + (DTYPE)log(sum));
+        else if (sum == 0) {
+            for (int i = 0; i < n; i++)
+                yr[i] = 0;
+        }
+        else
+            kernels.rowSoftmax(xr, yr, n, max, sum);
+    }
+}
+
+/*
+softmax (or log-softmax) along the last dimension of a tensor on CPUs, i.e.,
+y = e^x / \sum_{i} e^{x_i} or y = log(e^x / \sum_{i} e^{x_i}) for each row.
+It needs neither the max tensor nor the sum tensor, and rows are processed
+in parallel. The results are clipped as _Softmax and _LogSoftmax do.
+
+>> x - input tensor
+>> y - result (it can be x)
+>> isLog - log-softmax or softmax
+>> parallelRunner - parallel processing module (globalPRunner is used if it is NULL)
+*/
+void _SoftmaxLastDimCPU(const XTensor * x, XTensor * y, bool isLog, XPRunner * parallelRunner)
+{
+    CheckNTErrors(x && y, "Empty input tensors!");
+    CheckNTErrors(IsSoftmaxLastDimCPU(x, y, x->order - 1), "Unsupported tensors!");
+
+    int n = x->GetDim(-1);
+    int rowNum = x->unitNum / n;
+
+    SoftmaxArgs args;
+    args.x = (DTYPE*)x->data;
+    args.y = (DTYPE*)y->data;
+    args.n = n;
+    args.isLog = isLog;
+
+    /* number of operations (clipped to avoid overflow) */
+    double opNum = 4.0 * rowNum * n;
+    if (opNum > INT_MAX)
+        opNum = INT_MAX;
+
+    if (parallelRunner == NULL)
+        parallelRunner = globalPRunner;
+
+    RunParallel2D(parallelRunner, (void*)_SoftmaxLastDimBlock, (int)opNum,
+                  rowNum, 1, 1, &args);
+}
+
+/*
+can the last dimension kernels be used for softmax along the given dimension,
+i.e., are the tensors dense float tensors on CPUs and is the dimension the last one
+>> x - input tensor
+>> y - output tensor
+>> leadDim - the dimension of softmax
+*/
+bool IsSoftmaxLastDimCPU(const XTensor * x, const XTensor * y, int leadDim)
+{
+    return x->devID < 0 && y->devID < 0 &&
+           !x->isSparse && !y->isSparse &&
+           x->dataType == X_FLOAT && y->dataType == X_FLOAT &&
+           leadDim == x->order - 1 && x->unitNum == y->unitNum &&
+           x->unitNum > 0 && x->GetDim(-1) > 0;
+}
+
+} // namespace nts(NiuTrans.Tensor)
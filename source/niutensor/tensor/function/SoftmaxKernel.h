@@ -0,0 +1,50 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Row kernels of softmax and log-softmax on CPUs. The max and the sum of
+* exponentials of a row are computed in a single (online) pass, and the
+* results are written in a second pass. The kernels use AVX2 (with a
+* polynomial approximation of exp) when the CPU supports it, and the rows
+* are processed in parallel.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __SOFTMAXKERNEL_H__
+#define __SOFTMAXKERNEL_H__
+
+#include "../XTensor.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* the max item of a row */
+DTYPE _RowMaxCPU(const DTYPE * x, int n);
+
+/* the max item of a row and \sum_{i} e^{x_i - max} in one pass */
+void _RowMaxExpSumCPU(const DTYPE * x, int n, DTYPE * max, DTYPE * sum);
+
+/* softmax (or log-softmax) along the last dimension of a tensor on CPUs */
+void _SoftmaxLastDimCPU(const XTensor * x, XTensor * y, bool isLog,
+                        XPRunner * parallelRunner = NULL);
+
+/* can the last dimension kernels be used for softmax along the given dimension */
+bool IsSoftmaxLastDimCPU(const XTensor * x, const XTensor * y, int leadDim);
+
+} // namespace nts(NiuTrans.Tensor)
+
+#endif // __SOFTMAXKERNEL_H__
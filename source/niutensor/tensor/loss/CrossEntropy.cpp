@@ -20,6 +20,7 @@
  */
 
 #include <math.h>
+#include <string.h>
 #include "CrossEntropy.h"
 #include "CrossEntropy.cuh"
 #include "../XTensor.h"
@@ -31,6 +32,7 @@
 #include "../core/reduce/ReduceSum.h"
 #include "../core/reduce/ReduceSumAll.h"
 #include "../core/shape/IsSameShaped.h"
+#include "../function/SoftmaxKernel.h"
 
 namespace nts{ // namespace nts(NiuTrans.Tensor)
 
@@ -693,4 +695,183 @@ void _CrossEntropyBackward(XTensor * dedy, const XTensor * output,
     }
 }
 
+/*
+compute the label-smoothed cross entropy loss from the logits and the label
+indices. The log-softmax is fused into the loss (the max and the sum of
+exponentials of a row are computed in one pass), and the smoothed
+distribution of the labels is never made, i.e.,
+
+loss = sum_{i} (-t_i * log(softmax(x)_i))
+     = S * logsumexp(x) - (t_y - p/V) * x_y - p/V * sum_{i} x_i
+
+where y is the label, t_y = 1 - p, t_i = p/V for the other words (as in
+IndexToOnehot()), and S = sum_{i} t_i
+
+>> logits - the model output before the softmax, the last dimension is the vocabulary
+>> label - indices of the gold words (X_INT), which are of the same shape as the loss
+>> loss - the loss of each position (for return)
+>> padding - specify a target value that is ignored and does not contribute to the loss computation
+>> labelSmoothingP - the parameter that controls how smooth the gold distribution is, 
+                     e.g., p = 0 means no smoothing
+*/
+void _CrossEntropySparse(const XTensor * logits, const XTensor * label,
+                         XTensor * loss, const XTensor * padding,
+                         DTYPE labelSmoothingP)
+{
+    int vSize = logits->GetDim(-1);
+    int rowNum = logits->unitNum / vSize;
+
+    CheckNTErrors(logits->dataType == DEFAULT_DTYPE && loss->dataType == DEFAULT_DTYPE, "TODO!");
+    CheckNTErrors(label->dataType == X_INT, "The label tensor must be in X_INT!");
+    CheckNTErrors(label->unitNum == rowNum && loss->unitNum == rowNum, "Unmatched tensors!");
+    CheckNTErrors(padding == NULL || padding->unitNum == rowNum, "Wrong padding tensor!");
+    CheckNTErrors(label->devID == logits->devID && loss->devID == logits->devID, 
+                 "The tensors must be on the same device!");
+
+#ifdef USE_CUDA
+    if (logits->devID >= 0) {
+        _CudaCrossEntropySparse(logits, label, loss, padding, labelSmoothingP);
+        return;
+    }
+#endif
+
+    DTYPE confidence = 1 - labelSmoothingP;
+    DTYPE lowConfidence = labelSmoothingP / vSize;
+    DTYPE goldSum = confidence + lowConfidence * (vSize - 1);
+
+    DTYPE * logitsData = (DTYPE*)logits->data;
+    DTYPE * lossData = (DTYPE*)loss->data;
+    int * labelData = (int*)label->data;
+    DTYPE * paddingData = padding != NULL ? (DTYPE*)padding->data : NULL;
+
+    for (int i = 0; i < rowNum; i++) {
+        if (paddingData != NULL && paddingData[i] == 0) {
+            lossData[i] = 0;
+            continue;
+        }
+
+        const DTYPE * x = logitsData + (MTYPE)i * vSize;
+        int y = labelData[i];
+        CheckNTErrors(y >= 0 && y < vSize, "Wrong label!");
+
+        DTYPE max;
+        DTYPE expSum;
+        DTYPE xSum = 0;
+        _RowMaxExpSumCPU(x, vSize, &max, &expSum);
+        for (int k = 0; k < vSize; k++)
+            xSum += x[k];
+
+        DTYPE lse = max + (DTYPE)log(expSum);
+
+        lossData[i] = goldSum * lse - (confidence - lowConfidence) * x[y] - lowConfidence * xSum;
+    }
+}
+
+/*
+compute the label-smoothed cross entropy loss from the logits and the label 
+indices (return an XTensor structure)
+make a new tensor to keep the result and return it
+
+>> logits - the model output before the softmax, the last dimension is the vocabulary
+>> label - indices of the gold words (X_INT)
+>> padding - specify a target value that is ignored and does not contribute to the loss computation
+>> labelSmoothingP - the parameter that controls how smooth the gold distribution is
+<< return - the loss of each position
+*/
+XTensor CrossEntropySparse(const XTensor & logits, const XTensor & label,
+                           const XTensor & padding, DTYPE labelSmoothingP)
+{
+    XTensor loss;
+    loss = GetReduceTensor(logits, logits.order - 1);
+
+    /* call _CrossEntropySparse function */
+    _CrossEntropySparse(&logits, &label, &loss, &padding, labelSmoothingP);
+
+    /* tensor connection */
+    TensorList tails(3);
+    tails.Add((XTensor*)&logits);
+    tails.Add((XTensor*)&label);
+    tails.Add((XTensor*)&padding);
+
+    if (logits.enableGrad) {
+        XLink::MakeLink(&tails, &loss, LOSS_CROSSENTROPY_SPARSE);
+        XLink::AddParamToHead(&loss, labelSmoothingP);
+    }
+
+    return loss;
+}
+
+/*
+backward computation of the label-smoothed cross entropy function with 
+respect to the logits (see _CrossEntropySparse())
+
+dE/dx_i = S * softmax(x)_i - t_i
+
+The gradient is averaged over the positions that are not padded, as in
+_CrossEntropyBackward().
+
+>> dedx - dE/dx (for return)
+>> logits - the model output before the softmax
+>> label - indices of the gold words (X_INT)
+>> padding - specify a target value that is ignored and does not contribute to the loss computation
+>> labelSmoothingP - the parameter that controls how smooth the gold distribution is
+*/
+void _CrossEntropySparseBackward(XTensor * dedx, const XTensor * logits,
+                                 const XTensor * label, const XTensor * padding,
+                                 DTYPE labelSmoothingP)
+{
+    int vSize = logits->GetDim(-1);
+    int rowNum = logits->unitNum / vSize;
+
+    CheckNTErrors(_IsSameShaped(dedx, logits), "The gradient and the logits must be of the same size!");
+    CheckNTErrors(logits->dataType == DEFAULT_DTYPE && dedx->dataType == DEFAULT_DTYPE, "TODO!");
+    CheckNTErrors(label->dataType == X_INT, "The label tensor must be in X_INT!");
+    CheckNTErrors(label->unitNum == rowNum, "Unmatched tensors!");
+    CheckNTErrors(padding == NULL || padding->unitNum == rowNum, "Wrong padding tensor!");
+
+#ifdef USE_CUDA
+    if (logits->devID >= 0) {
+        _CudaCrossEntropySparseBackward(dedx, logits, label, padding, labelSmoothingP);
+        return;
+    }
+#endif
+
+    DTYPE nonZeroNum = (DTYPE)rowNum;
+    if (padding != NULL)
+        _ReduceSumAll(padding, &nonZeroNum);
+
+    DTYPE scale = (DTYPE)1.0 / nonZeroNum;
+    DTYPE confidence = 1 - labelSmoothingP;
+    DTYPE lowConfidence = labelSmoothingP / vSize;
+    DTYPE goldSum = confidence + lowConfidence * (vSize - 1);
+
+    DTYPE * dedxData = (DTYPE*)dedx->data;
+    DTYPE * logitsData = (DTYPE*)logits->data;
+    int * labelData = (int*)label->data;
+    DTYPE * paddingData = padding != NULL ? (DTYPE*)padding->data : NULL;
+
+    for (int i = 0; i < rowNum; i++) {
+        DTYPE * g = dedxData + (MTYPE)i * vSize;
+
+        if (paddingData != NULL && paddingData[i] == 0) {
+            memset(g, 0, sizeof(DTYPE) * vSize);
+            continue;
+        }
+
+        const DTYPE * x = logitsData + (MTYPE)i * vSize;
+        int y = labelData[i];
+        CheckNTErrors(y >= 0 && y < vSize, "Wrong label!");
+
+        DTYPE max;
+        DTYPE expSum;
+        _RowMaxExpSumCPU(x, vSize, &max, &expSum);
+
+        DTYPE lse = max + (DTYPE)log(expSum);
+
+        for (int k = 0; k < vSize; k++)
+            g[k] = (goldSum * (DTYPE)exp(x[k] - lse) - lowConfidence) * scale;
+        g[y] -= (confidence - lowConfidence) * scale;
+    }
+}
+
 } // namespace nts(NiuTrans.Tensor)
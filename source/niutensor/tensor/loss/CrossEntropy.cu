@@ -226,6 +226,201 @@ void _CudaCrossEntropyBackward(XTensor * dedy, const XTensor * output,
 
 }
 
+/* number of the threads that share a row of the logits */
+#define CROSSENTROPY_SPARSE_THREAD_NUM 256
+
+/*
+get the log-sum-exp of a row of logits and the sum of the logits, 
+where the threads of a block share the row (kernel version)
+>> x - the logits
+>> num - number of the logits
+>> buf - the shared buffer of the threads
+>> sum - sum of the logits (for return)
+<< return - log(sum_{i} exp(x_i))
+*/
+__device__
+DTYPE BlockLogSumExp(const DTYPE * x, int num, DTYPE * buf, DTYPE * sum)
+{
+    int tid = threadIdx.x;
+
+    DTYPE maxValue = FLOAT_MIN;
+    for (int i = tid; i < num; i += blockDim.x)
+        maxValue = max(maxValue, x[i]);
+
+    buf[tid] = maxValue;
+    __syncthreads();
+    for (int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if (tid < s)
+            buf[tid] = max(buf[tid], buf[tid + s]);
+        __syncthreads();
+    }
+    maxValue = buf[0];
+    __syncthreads();
+
+    DTYPE expSum = 0;
+    DTYPE xSum = 0;
+    for (int i = tid; i < num; i += blockDim.x) {
+        expSum += exp(x[i] - maxValue);
+        xSum += x[i];
+    }
+
+    buf[tid] = expSum;
+    buf[tid + blockDim.x] = xSum;
+    __syncthreads();
+    for (int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if (tid < s) {
+            buf[tid] += buf[tid + s];
+            buf[tid + blockDim.x] += buf[tid + blockDim.x + s];
+        }
+        __syncthreads();
+    }
+
+    *sum = buf[blockDim.x];
+
+    return maxValue + log(buf[0]);
+}
+
+/*
+compute the label-smoothed cross entropy loss from the logits and the label 
+indices (kernel version). A block of threads computes the loss of a row.
+>> logits - the logits
+>> label - indices of the gold words
+>> padding - the padding of the rows (NULL for no padding)
+>> loss - the loss of each row (for return)
+>> vSize - size of the vocabulary
+>> confidence - the gold probability of the label
+>> lowConfidence - the gold probability of the other words
+*/
+__global__
+void KernelCrossEntropySparse(DTYPE * logits, int * label, DTYPE * padding, DTYPE * loss,
+                              int vSize, DTYPE confidence, DTYPE lowConfidence)
+{
+    __shared__ DTYPE buf[CROSSENTROPY_SPARSE_THREAD_NUM * 2];
+
+    int row = blockIdx.x;
+
+    if (padding != NULL && padding[row] == 0) {
+        if (threadIdx.x == 0)
+            loss[row] = 0;
+        return;
+    }
+
+    const DTYPE * x = logits + (size_t)row * vSize;
+
+    DTYPE xSum;
+    DTYPE lse = BlockLogSumExp(x, vSize, buf, &xSum);
+
+    if (threadIdx.x == 0) {
+        DTYPE goldSum = confidence + lowConfidence * (vSize - 1);
+        loss[row] = goldSum * lse - (confidence - lowConfidence) * x[label[row]] - lowConfidence * xSum;
+    }
+}
+
+/*
+backward computation of the label-smoothed cross entropy function (kernel version). 
+A block of threads computes the gradient of a row.
+>> dedx - dE/dx (for return)
+>> logits - the logits
+>> label - indices of the gold words
+>> padding - the padding of the rows (NULL for no padding)
+>> vSize - size of the vocabulary
+>> confidence - the gold probability of the label
+>> lowConfidence - the gold probability of the other words
+>> scale - the scaling factor of the gradient
+*/
+__global__
+void KernelCrossEntropySparseBackward(DTYPE * dedx, DTYPE * logits, int * label, DTYPE * padding,
+                                      int vSize, DTYPE confidence, DTYPE lowConfidence, DTYPE scale)
+{
+    __shared__ DTYPE buf[CROSSENTROPY_SPARSE_THREAD_NUM * 2];
+
+    int row = blockIdx.x;
+    DTYPE * g = dedx + (size_t)row * vSize;
+
+    if (padding != NULL && padding[row] == 0) {
+        for (int i = threadIdx.x; i < vSize; i += blockDim.x)
+            g[i] = 0;
+        return;
+    }
+
+    const DTYPE * x = logits + (size_t)row * vSize;
+
+    DTYPE xSum;
+    DTYPE lse = BlockLogSumExp(x, vSize, buf, &xSum);
+    DTYPE goldSum = confidence + lowConfidence * (vSize - 1);
+    int y = label[row];
+
+    for (int i = threadIdx.x; i < vSize; i += blockDim.x) {
+        DTYPE gold = i == y ? confidence : lowConfidence;
+        g[i] = (goldSum * exp(x[i] - lse) - gold) * scale;
+    }
+}
+
+/*
+compute the label-smoothed cross entropy loss from the logits and the label 
+indices (cuda version)
+>> logits - the model output before the softmax, the last dimension is the vocabulary
+>> label - indices of the gold words (X_INT)
+>> loss - the loss of each position (for return)
+>> padding - specify a target value that is ignored and does not contribute to the loss computation
+>> labelSmoothingP - the parameter that controls how smooth the gold distribution is
+*/
+void _CudaCrossEntropySparse(const XTensor * logits, const XTensor * label,
+                             XTensor * loss, const XTensor * padding,
+                             DTYPE labelSmoothingP)
+{
+    int devID = logits->devID;
+    int vSize = logits->GetDim(-1);
+    int rowNum = logits->unitNum / vSize;
+
+    DTYPE confidence = 1 - labelSmoothingP;
+    DTYPE lowConfidence = labelSmoothingP / vSize;
+
+    int devIDBackup;
+    ProtectCudaDev(devID, devIDBackup);
+
+    KernelCrossEntropySparse<<<dim3(rowNum), dim3(CROSSENTROPY_SPARSE_THREAD_NUM)>>>
+                            ((DTYPE*)logits->data, (int*)label->data, 
+                             padding != NULL ? (DTYPE*)padding->data : NULL, 
+                             (DTYPE*)loss->data, vSize, confidence, lowConfidence);
+
+    BacktoCudaDev(devID, devIDBackup);
+}
+
+/*
+backward computation of the label-smoothed cross entropy function (cuda version)
+>> dedx - dE/dx (for return)
+>> logits - the model output before the softmax
+>> label - indices of the gold words (X_INT)
+>> padding - specify a target value that is ignored and does not contribute to the loss computation
+>> labelSmoothingP - the parameter that controls how smooth the gold distribution is
+*/
+void _CudaCrossEntropySparseBackward(XTensor * dedx, const XTensor * logits,
+                                     const XTensor * label, const XTensor * padding,
+                                     DTYPE labelSmoothingP)
+{
+    int devID = logits->devID;
+    int vSize = logits->GetDim(-1);
+    int rowNum = logits->unitNum / vSize;
+
+    DTYPE nonZeroNum = (DTYPE)rowNum;
+    if (padding != NULL)
+        _ReduceSumAll(padding, &nonZeroNum);
+
+    DTYPE confidence = 1 - labelSmoothingP;
+    DTYPE lowConfidence = labelSmoothingP / vSize;
+
+    int devIDBackup;
+    ProtectCudaDev(devID, devIDBackup);
+
+    KernelCrossEntropySparseBackward<<<dim3(rowNum), dim3(CROSSENTROPY_SPARSE_THREAD_NUM)>>>
+                                    ((DTYPE*)dedx->data, (DTYPE*)logits->data, (int*)label->data, 
+                                     padding != NULL ? (DTYPE*)padding->data : NULL, 
+                                     vSize, confidence, lowConfidence, (DTYPE)1.0 / nonZeroNum);
+
+    BacktoCudaDev(devID, devIDBackup);
+}
+
 } // namespace nts(NiuTrans.Tensor)
 
 #endif // __CROSSENTROPY_CUH__
\ No newline at end of file
@@ -42,6 +42,15 @@ void _CudaCrossEntropyBackward(XTensor * dedy, const XTensor * output,
                                const XTensor * gold, const XTensor * weight = NULL, 
                                XTensor * padding = NULL, int leadingDim = -1);
 
+/* compute the label-smoothed cross entropy loss from the logits and the label indices (cuda version) */
+void _CudaCrossEntropySparse(const XTensor * logits, const XTensor * label,
+                             XTensor * loss, const XTensor * padding,
+                             DTYPE labelSmoothingP);
+
+/* backward computation of the label-smoothed cross entropy function (cuda version) */
+void _CudaCrossEntropySparseBackward(XTensor * dedx, const XTensor * logits,
+                                     const XTensor * label, const XTensor * padding,
+                                     DTYPE labelSmoothingP);
 
 } // namespace nts(NiuTrans.Tensor)
 
@@ -75,6 +75,21 @@ void _CrossEntropyBackward(XTensor * dedy, const XTensor * output,
                            const XTensor * gold, const XTensor * weight = NULL, 
                            XTensor * padding = NULL, int leadingDim = -1);
 
+/* compute the label-smoothed cross entropy loss from the logits and the label indices */
+void _CrossEntropySparse(const XTensor * logits, const XTensor * label,
+                         XTensor * loss, const XTensor * padding = NULL,
+                         DTYPE labelSmoothingP = 0);
+
+/* compute the label-smoothed cross entropy loss from the logits and the label indices
+   (return an XTensor structure) */
+XTensor CrossEntropySparse(const XTensor & logits, const XTensor & label,
+                           const XTensor & padding, DTYPE labelSmoothingP = 0);
+
+/* backward computation of the label-smoothed cross entropy function (with respect to the logits) */
+void _CrossEntropySparseBackward(XTensor * dedx, const XTensor * logits,
+                                 const XTensor * label, const XTensor * padding = NULL,
+                                 DTYPE labelSmoothingP = 0);
+
 } // namespace nts(NiuTrans.Tensor)
 
 #endif // __CROSSENTROPY_H__
\ No newline at end of file
@@ -0,0 +1,519 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <string>
+#include "Benchmark.h"
+#include "../XBLAS.h"
+#include "../XPRunner.h"
+#include "../XUtility.h"
+#include "../core/CHeader.h"
+#include "../function/FHeader.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+#if defined(MKL)
+#define BENCHMARK_BACKEND "mkl"
+#elif defined(OPENBLAS)
+#define BENCHMARK_BACKEND "openblas"
+#else
+#define BENCHMARK_BACKEND "builtin"
+#endif
+
+/* load the configuration from the command */
+void BenchmarkConfig::Load(int argsNum, const char ** args)
+{
+    Create(argsNum, args);
+
+    LoadString("benchops", ops, "");
+    LoadString("benchthreads", threads, "");
+    LoadString("benchoutput", outputFN, "");
+    LoadInt("nthread", &maxThreadNum, 1);
+    LoadInt("benchwarmup", &warmupNum, 3);
+    LoadInt("benchrun", &runNum, 20);
+    LoadFloat("benchtime", &maxTime, 1.0F);
+}
+
+/* the runner of the cases */
+class BenchmarkRunner
+{
+public:
+    /* the configuration */
+    BenchmarkConfig * config;
+
+    /* the operators to run */
+    std::vector<std::string> ops;
+
+    /* the numbers of threads */
+    std::vector<int> threadNums;
+
+    /* the parallel runners (NULL for a single thread) */
+    std::vector<XPRunner*> runners;
+
+    /* where the JSON lines go */
+    FILE * file;
+
+    /* number of the cases that are run */
+    int caseNum;
+
+public:
+    /* constructor */
+    BenchmarkRunner(BenchmarkConfig * myConfig);
+
+    /* de-constructor */
+    ~BenchmarkRunner();
+
+    /* check whether an operator is to run */
+    bool IsSelected(const char * op);
+
+    /* time a case with all the numbers of threads */
+    void Measure(const char * op, const char * shape, double flops, double bytes,
+                 const std::function<void()> & body);
+};
+
+/* split a comma-separated list */
+static std::vector<std::string> SplitList(const char * s)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char * p = s; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (item.size() > 0)
+                items.push_back(item);
+            item.clear();
+            if (*p == '\0')
+                break;
+        }
+        else if (*p != ' ')
+            item += *p;
+    }
+    return items;
+}
+
+/*
+constructor
+>> myConfig - the configuration
+*/
+BenchmarkRunner::BenchmarkRunner(BenchmarkConfig * myConfig)
+{
+    config = myConfig;
+    ops = SplitList(config->ops);
+    caseNum = 0;
+
+    std::vector<std::string> items = SplitList(config->threads);
+    for (size_t i = 0; i < items.size(); i++) {
+        int n = atoi(items[i].c_str());
+        CheckNTErrors(n > 0 && n <= MAX_THREAD_NUM, "Invalid number of threads!");
+        threadNums.push_back(n);
+    }
+    if (threadNums.empty()) {
+        for (int n = 1; n < config->maxThreadNum; n *= 2)
+            threadNums.push_back(n);
+        threadNums.push_back(MIN(MAX(config->maxThreadNum, 1), MAX_THREAD_NUM));
+    }
+
+    for (size_t i = 0; i < threadNums.size(); i++) {
+        XPRunner * runner = NULL;
+        if (threadNums[i] > 1) {
+            runner = new XPRunner();
+            runner->Init(threadNums[i]);
+        }
+        runners.push_back(runner);
+    }
+
+    file = stdout;
+    if (strcmp(config->outputFN, "") != 0) {
+        file = fopen(config->outputFN, "w");
+        CheckNTErrors(file, "Cannot open the output file of the benchmarks!");
+    }
+}
+
+/* de-constructor */
+BenchmarkRunner::~BenchmarkRunner()
+{
+    for (size_t i = 0; i < runners.size(); i++)
+        delete runners[i];
+    if (file != stdout)
+        fclose(file);
+}
+
+/*
+check whether an operator is to run
+>> op - name of the operator
+<< return - true if a part of the name is given in the "benchops" option (or nothing is given)
+*/
+bool BenchmarkRunner::IsSelected(const char * op)
+{
+    if (ops.empty())
+        return true;
+    for (size_t i = 0; i < ops.size(); i++) {
+        if (strstr(op, ops[i].c_str()) != NULL)
+            return true;
+    }
+    return false;
+}
+
+/*
+get a percentile of the sorted times
+>> times - the times (sorted)
+>> p - the percentile (in [0, 100])
+*/
+static double GetPercentile(const std::vector<double> & times, double p)
+{
+    double pos = p / 100 * (times.size() - 1);
+    size_t lower = (size_t)pos;
+    size_t upper = MIN(lower + 1, times.size() - 1);
+    return times[lower] + (times[upper] - times[lower]) * (pos - lower);
+}
+
+/*
+time a case with all the numbers of threads. The operation is run for
+"benchwarmup" times first, and then it is timed for "benchrun" times or
+until the time budget is used up (at least 3 runs). GFLOP/s and GB/s are
+computed on the median latency.
+>> op - name of the operator
+>> shape - description of the shapes
+>> flops - number of floating-point operations of a run
+>> bytes - number of bytes that a run reads and writes
+>> body - the operation
+*/
+void BenchmarkRunner::Measure(const char * op, const char * shape, double flops, double bytes,
+                              const std::function<void()> & body)
+{
+    XPRunner * backup = globalPRunner;
+    double baseMedian = 0;
+
+    for (size_t t = 0; t < threadNums.size(); t++) {
+        globalPRunner = runners[t];
+#if defined(USE_BLAS)
+        XBLAS_SET_THREAD_NUM(threadNums[t]);
+#endif
+
+        for (int i = 0; i < config->warmupNum; i++)
+            body();
+
+        std::vector<double> times;
+        double total = 0;
+        while ((int)times.size() < MAX(config->runNum, 1)) {
+            double start = GetClockSec();
+            body();
+            double elapsed = GetClockSec() - start;
+            times.push_back(elapsed);
+            total += elapsed;
+            if (total > config->maxTime && times.size() >= 3)
+                break;
+        }
+
+        std::sort(times.begin(), times.end());
+        double median = GetPercentile(times, 50);
+        if (t == 0)
+            baseMedian = median;
+
+        double gflops = median > 0 ? flops / median / 1e9 : 0;
+        double gbps = median > 0 ? bytes / median / 1e9 : 0;
+        double speedup = median > 0 ? baseMedian / median : 0;
+
+        XPRINT7(0, stderr, "%-16s %-22s %3d threads  p50 %9.3f ms  p90 %9.3f ms  %8.2f GFLOP/s  %7.2f GB/s",
+                op, shape, threadNums[t], median * 1000, GetPercentile(times, 90) * 1000, gflops, gbps);
+        XPRINT1(0, stderr, "  x%.2f\n", speedup);
+
+        fprintf(file, "{\"op\": \"%s\", \"shape\": \"%s\", \"backend\": \"%s\", \"threads\": %d, "
+                      "\"runs\": %d, \"min_ms\": %.4f, \"mean_ms\": %.4f, \"p50_ms\": %.4f, "
+                      "\"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+                      "\"gflops\": %.3f, \"gbps\": %.3f, \"speedup\": %.3f}\n",
+                op, shape, BENCHMARK_BACKEND, threadNums[t], (int)times.size(),
+                times.front() * 1000, total / times.size() * 1000, median * 1000,
+                GetPercentile(times, 90) * 1000, GetPercentile(times, 99) * 1000,
+                times.back() * 1000, gflops, gbps, speedup);
+        fflush(file);
+    }
+
+#if defined(USE_BLAS)
+    XBLAS_SET_THREAD_NUM(MAX(config->maxThreadNum, 1));
+#endif
+    globalPRunner = backup;
+    caseNum++;
+}
+
+/* matrix multiplication of the projections, the FFN and the output layer */
+static void BenchmarkMatrixMul2D(BenchmarkRunner & runner)
+{
+    const char * op = "MatrixMul2D";
+    if (!runner.IsSelected(op))
+        return;
+
+    int shapes[4][3] = { {1024, 512, 512}, {1024, 512, 2048}, {1024, 2048, 512}, {128, 512, 32000} };
+    for (int s = 0; s < 4; s++) {
+        int m = shapes[s][0], k = shapes[s][1], n = shapes[s][2];
+        XTensor * a = NewTensor2DV2(m, k);
+        XTensor * b = NewTensor2DV2(k, n);
+        XTensor * c = NewTensor2DV2(m, n);
+        a->SetDataRand(-1.0F, 1.0F);
+        b->SetDataRand(-1.0F, 1.0F);
+
+        char shape[64];
+        sprintf(shape, "%dx%dx%d", m, k, n);
+        runner.Measure(op, shape, 2.0 * m * k * n, 4.0 * ((double)m * k + (double)k * n + (double)m * n),
+                       [&]() { _MatrixMul2D(a, X_NOTRANS, b, X_NOTRANS, c); });
+
+        delete a;
+        delete b;
+        delete c;
+    }
+}
+
+/* batched matrix multiplication of the attention (256 = batch 32 * 8 heads) */
+static void BenchmarkMatrixMulBatched(BenchmarkRunner & runner)
+{
+    const char * op = "MatrixMulBatched";
+    if (!runner.IsSelected(op))
+        return;
+
+    int batch = 256, len = 32, dim = 64;
+    int qDims[3] = { batch, len, dim };
+    int sDims[3] = { batch, len, len };
+    XTensor * q = NewTensorV2(3, qDims);
+    XTensor * k = NewTensorV2(3, qDims);
+    XTensor * scores = NewTensorV2(3, sDims);
+    XTensor * out = NewTensorV2(3, qDims);
+    q->SetDataRand(-1.0F, 1.0F);
+    k->SetDataRand(-1.0F, 1.0F);
+    scores->SetDataRand(0.0F, 1.0F);
+
+    double qkBytes = 4.0 * batch * ((double)len * dim * 2 + (double)len * len);
+    runner.Measure(op, "256x32x64*T(256x32x64)", 2.0 * batch * len * len * dim, qkBytes,
+                   [&]() { _MatrixMulBatched(q, X_NOTRANS, k, X_TRANS, scores); });
+    runner.Measure(op, "256x32x32*256x32x64", 2.0 * batch * len * len * dim, qkBytes + 4.0 * batch * len * dim,
+                   [&]() { _MatrixMulBatched(scores, X_NOTRANS, k, X_NOTRANS, out); });
+
+    delete q;
+    delete k;
+    delete scores;
+    delete out;
+}
+
+/* reduction along the last dimension (layer normalization and the output layer) */
+static void BenchmarkReduce(BenchmarkRunner & runner)
+{
+    int shapes[2][2] = { {1024, 512}, {128, 32000} };
+    for (int s = 0; s < 2; s++) {
+        int m = shapes[s][0], n = shapes[s][1];
+        XTensor * x = NewTensor2DV2(m, n);
+        XTensor * y = NewTensor1DV2(m);
+        x->SetDataRand(-1.0F, 1.0F);
+
+        char shape[64];
+        sprintf(shape, "%dx%d", m, n);
+        double bytes = 4.0 * ((double)m * n + m);
+        if (runner.IsSelected("ReduceSum"))
+            runner.Measure("ReduceSum", shape, (double)m * n, bytes, [&]() { _ReduceSum(x, y, 1); });
+        if (runner.IsSelected("ReduceMax"))
+            runner.Measure("ReduceMax", shape, (double)m * n, bytes, [&]() { _ReduceMax(x, y, 1); });
+
+        delete x;
+        delete y;
+    }
+}
+
+/* softmax of the attention weights and log-softmax of the output layer (for large and small batches) */
+static void BenchmarkSoftmax(BenchmarkRunner & runner)
+{
+    int shapes[4][2] = { {8192, 32}, {128, 32000}, {512, 64}, {16, 8000} };
+    for (int s = 0; s < 4; s++) {
+        int m = shapes[s][0], n = shapes[s][1];
+        XTensor * x = NewTensor2DV2(m, n);
+        XTensor * y = NewTensor2DV2(m, n);
+        x->SetDataRand(-8.0F, 8.0F);
+
+        char shape[64];
+        sprintf(shape, "%dx%d", m, n);
+        double bytes = 8.0 * m * n;
+        if (runner.IsSelected("Softmax"))
+            runner.Measure("Softmax", shape, 4.0 * m * n, bytes, [&]() { _Softmax(x, y, 1); });
+        if (runner.IsSelected("LogSoftmax"))
+            runner.Measure("LogSoftmax", shape, 4.0 * m * n, bytes, [&]() { _LogSoftmax(x, y, 1); });
+
+        delete x;
+        delete y;
+    }
+}
+
+/* top-k of the beam search (over the vocabulary and over the beams * vocabulary) */
+static void BenchmarkTopK(BenchmarkRunner & runner)
+{
+    const char * op = "TopK";
+    if (!runner.IsSelected(op))
+        return;
+
+    int shapes[2][3] = { {128, 32000, 4}, {32, 128000, 4} };
+    for (int s = 0; s < 2; s++) {
+        int m = shapes[s][0], n = shapes[s][1], k = shapes[s][2];
+        XTensor * x = NewTensor2DV2(m, n);
+        XTensor * value = NewTensor2DV2(m, k);
+        XTensor * index = NewTensor2DV2(m, k, X_INT);
+        x->SetDataRand(-8.0F, 8.0F);
+
+        char shape[64];
+        sprintf(shape, "%dx%d,k=%d", m, n, k);
+        runner.Measure(op, shape, (double)m * n, 4.0 * ((double)m * n + 2.0 * m * k),
+                       [&]() { _TopK(x, value, index, 1, k); });
+
+        delete x;
+        delete value;
+        delete index;
+    }
+}
+
+/* embedding lookup of a batch of 1024 tokens */
+static void BenchmarkGather(BenchmarkRunner & runner)
+{
+    const char * op = "Gather";
+    if (!runner.IsSelected(op))
+        return;
+
+    int vocabSize = 32000, dim = 512, num = 1024;
+    XTensor * table = NewTensor2DV2(vocabSize, dim);
+    XTensor * output = NewTensor2DV2(num, dim);
+    XTensor * index = NewTensor1DV2(num, X_INT);
+    table->SetDataRand(-1.0F, 1.0F);
+
+    int * ids = new int[num];
+    for (int i = 0; i < num; i++)
+        ids[i] = rand() % vocabSize;
+    index->SetData(ids, num);
+    delete[] ids;
+
+    runner.Measure(op, "32000x512,1024", 0, 4.0 * (2.0 * num * dim + num),
+                   [&]() { _Gather(table, output, index); });
+
+    delete table;
+    delete output;
+    delete index;
+}
+
+/* reordering of the states of the beams (128 blocks of 32 x 512 floats) */
+static void BenchmarkCopyBlocks(BenchmarkRunner & runner)
+{
+    const char * op = "CopyBlocks";
+    if (!runner.IsSelected(op))
+        return;
+
+    int blockNum = 128, blockSize = 32 * 512;
+    XTensor * source = NewTensor2DV2(blockNum, blockSize);
+    XTensor * target = NewTensor2DV2(blockNum, blockSize);
+    source->SetDataRand(-1.0F, 1.0F);
+
+    std::vector<int> targetBlocks(blockNum);
+    for (int i = 0; i < blockNum; i++)
+        targetBlocks[i] = i;
+    std::random_shuffle(targetBlocks.begin(), targetBlocks.end());
+
+    runner.Measure(op, "128x(32x512)", 0, 8.0 * blockNum * blockSize,
+                   [&]() { _CopyBlocks(source->data, source->unitSize, blockSize * source->unitSize, blockNum,
+                                       target->data, targetBlocks.data(), NULL, -1); });
+
+    delete source;
+    delete target;
+}
+
+/* splitting into the heads of the attention and merging them back */
+static void BenchmarkMergeSplit(BenchmarkRunner & runner)
+{
+    int batch = 32, len = 32, dim = 512, headNum = 8;
+    int mergedDims[3] = { batch, len, dim };
+    int splitDims[4] = { headNum, batch, len, dim / headNum };
+    XTensor * merged = NewTensorV2(3, mergedDims);
+    XTensor * split = NewTensorV2(4, splitDims);
+    merged->SetDataRand(-1.0F, 1.0F);
+    split->SetDataRand(-1.0F, 1.0F);
+
+    double bytes = 8.0 * batch * len * dim;
+    if (runner.IsSelected("Split"))
+        runner.Measure("Split", "32x32x512->8x32x32x64", 0, bytes, [&]() { _Split(merged, split, 2, headNum); });
+    if (runner.IsSelected("Merge"))
+        runner.Measure("Merge", "8x32x32x64->32x32x512", 0, bytes, [&]() { _Merge(split, merged, 3, 0); });
+
+    delete merged;
+    delete split;
+}
+
+/* conversion between FP32 and FP16 */
+static void BenchmarkConvertDataType(BenchmarkRunner & runner)
+{
+    const char * op = "ConvertDataType";
+    if (!runner.IsSelected(op))
+        return;
+
+    int m = 1024, n = 512;
+    XTensor * x = NewTensor2DV2(m, n);
+    XTensor * half = NewTensor2DV2(m, n, X_FLOAT16);
+    XTensor * y = NewTensor2DV2(m, n);
+    x->SetDataRand(-1.0F, 1.0F);
+    _ConvertDataType(x, half);
+
+    double bytes = 6.0 * m * n;
+    runner.Measure(op, "1024x512,fp32->fp16", 0, bytes, [&]() { _ConvertDataType(x, half); });
+    runner.Measure(op, "1024x512,fp16->fp32", 0, bytes, [&]() { _ConvertDataType(half, y); });
+
+    delete x;
+    delete half;
+    delete y;
+}
+
+/*
+run the benchmarks (on the CPU). The options are
+  -benchops      the operators to run, e.g., "MatrixMul,Softmax" (default: all)
+  -benchthreads  the numbers of threads, e.g., "1,2,4" (default: 1, 2, 4, ... up to -nthread)
+  -benchwarmup   number of runs before timing (default: 3)
+  -benchrun      the maximum number of timed runs of a case (default: 20)
+  -benchtime     the time budget of a case in seconds (default: 1.0)
+  -benchoutput   the file of the JSON lines (default: stdout)
+>> argc - number of arguments
+>> argv - the list of arguments
+<< return - true if all the cases are run
+*/
+bool Benchmark(int argc, const char ** argv)
+{
+    BenchmarkConfig config;
+    config.Load(argc, argv);
+
+    BenchmarkRunner runner(&config);
+
+    XPRINT1(0, stderr, "[INFO] benchmarking the tensor operators (backend: %s)\n", BENCHMARK_BACKEND);
+
+    BenchmarkMatrixMul2D(runner);
+    BenchmarkMatrixMulBatched(runner);
+    BenchmarkReduce(runner);
+    BenchmarkSoftmax(runner);
+    BenchmarkTopK(runner);
+    BenchmarkGather(runner);
+    BenchmarkCopyBlocks(runner);
+    BenchmarkMergeSplit(runner);
+    BenchmarkConvertDataType(runner);
+
+    XPRINT1(0, stderr, "[INFO] %d cases are run\n", runner.caseNum);
+
+    return runner.caseNum > 0;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,71 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* Micro-benchmarks of the core tensor operators on the shapes of a
+* Transformer-base NMT model (e.g., the projections and the FFN of a batch
+* of 1024 tokens, the attention of 8 heads over 32 tokens and the output
+* layer of a vocabulary of 32000 words). Each case is run with a number of
+* threads, and the latency percentiles, GFLOP/s and GB/s are reported in a
+* table and as JSON lines, so that the results of different builds (e.g.,
+* the built-in kernels, OpenBLAS and MKL) can be compared by scripts.
+*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "../XConfig.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* configuration of the benchmarks */
+class BenchmarkConfig : public XConfig
+{
+public:
+    /* the operators to run (comma-separated parts of the names, empty for all) */
+    char ops[1024];
+
+    /* the numbers of threads (comma-separated, empty for 1, 2, 4, ... up to nthread) */
+    char threads[256];
+
+    /* the maximum number of threads */
+    int maxThreadNum;
+
+    /* number of runs before timing */
+    int warmupNum;
+
+    /* the maximum number of timed runs of a case */
+    int runNum;
+
+    /* the time budget of a case (in seconds), at least 3 runs are timed */
+    float maxTime;
+
+    /* the file of the JSON lines (stdout if it is empty) */
+    char outputFN[1024];
+
+public:
+    /* load the configuration from the command */
+    void Load(int argsNum, const char ** args);
+};
+
+/* run the benchmarks */
+bool Benchmark(int argc, const char ** argv);
+
+} // namespace nts(NiuTrans.Tensor)
+#endif // __BENCHMARK_H__
@@ -0,0 +1,194 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../core/utilities/CheckData.h"
+#include "../core/arithmetic/Div.h"
+#include "../core/arithmetic/Multiply.h"
+#include "../core/arithmetic/Sum.h"
+#include "../core/math/Binary.h"
+#include "../core/math/ScaleAndShift.h"
+#include "../core/movement/CopyValues.h"
+#include "TAdamUpdate.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: the Adam(W) update of a vector.
+In this case, p=(4), g=(4), m=(4) and v=(4), the moments are zero at
+the beginning, and the gradient is cleared after the update.
+*/
+bool TestAdamUpdate1()
+{
+    int unitNum = 4;
+
+    DTYPE pData[4] = {1.0F, 2.0F, -1.0F, 0.5F};
+    DTYPE gData[4] = {0.5F, -1.0F, 2.0F, 0.0F};
+
+    /* m = 0.1 * g, v = 0.01 * g * g and m / sqrt(v) = sign(g) */
+    DTYPE pAnswer[4] = {0.4F, 1.1F, -0.6F, 0.25F};
+    DTYPE gAnswer[4] = {0.0F, 0.0F, 0.0F, 0.0F};
+    DTYPE mAnswer[4] = {0.05F, -0.1F, 0.2F, 0.0F};
+    DTYPE vAnswer[4] = {0.0025F, 0.01F, 0.04F, 0.0F};
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * p = NewTensorV2(1, &unitNum);
+    XTensor * g = NewTensorV2(1, &unitNum);
+    XTensor * m = NewTensorV2(1, &unitNum);
+    XTensor * v = NewTensorV2(1, &unitNum);
+
+    /* initialize variables */
+    p->SetData(pData, unitNum);
+    g->SetData(gData, unitNum);
+    m->SetZeroAll();
+    v->SetZeroAll();
+
+    /* call AdamUpdate function */
+    _AdamUpdate(p, g, m, v, 0.9F, 0.99F, 0.1F, 1e-9F, 0.5F, true);
+
+    /* check results */
+    cpuTest = _CheckData(p, pAnswer, unitNum, 1e-4F) && _CheckData(g, gAnswer, unitNum, 1e-4F) &&
+              _CheckData(m, mAnswer, unitNum, 1e-4F) && _CheckData(v, vAnswer, unitNum, 1e-4F);
+
+    /* destroy variables */
+    delete p;
+    delete g;
+    delete m;
+    delete v;
+
+    return cpuTest;
+}
+
+/*
+case 2: the Adam(W) update on random data.
+In this case, p=(40001) which is updated in several blocks, and the results
+are compared with the update made of ScaleAndShift, Sum, Multiply, Power
+and Div. A runner of 2 threads is used.
+*/
+bool TestAdamUpdate2()
+{
+    int unitNum = 40001;
+    DTYPE beta1 = 0.9F;
+    DTYPE beta2 = 0.98F;
+    DTYPE stepSize = 0.01F;
+    DTYPE delta = 1e-6F;
+    DTYPE decay = 0.001F;
+    bool cpuTest = true;
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    XTensor * p = NewTensorV2(1, &unitNum);
+    XTensor * g = NewTensorV2(1, &unitNum);
+    XTensor * m = NewTensorV2(1, &unitNum);
+    XTensor * v = NewTensorV2(1, &unitNum);
+    XTensor * pAnswer = NewTensorV2(1, &unitNum);
+    XTensor * mAnswer = NewTensorV2(1, &unitNum);
+    XTensor * vAnswer = NewTensorV2(1, &unitNum);
+    XTensor * u = NewTensorV2(1, &unitNum);
+
+    p->SetDataRand(-1.0F, 1.0F);
+    g->SetDataRand(-1.0F, 1.0F);
+    m->SetDataRand(-0.1F, 0.1F);
+    v->SetDataRand(0.0F, 0.1F);
+    _CopyValues(p, pAnswer);
+    _CopyValues(m, mAnswer);
+    _CopyValues(v, vAnswer);
+
+    /* the unfused implementation */
+    _ScaleAndShiftMe(mAnswer, beta1, 0);
+    _Sum(mAnswer, g, mAnswer, 1.0F - beta1);
+    _Multiply(g, g, vAnswer, beta2 / (1.0F - beta2));
+    _ScaleAndShiftMe(vAnswer, 1.0F - beta2, 0);
+    _Power(vAnswer, u, 0.5F);
+    _ScaleAndShiftMe(u, 1.0F, delta);
+    _Div(mAnswer, u, u);
+    _ScaleAndShiftMe(pAnswer, 1.0F - decay, 0);
+    _Sum(pAnswer, u, pAnswer, -stepSize);
+
+    /* call AdamUpdate function */
+    _AdamUpdate(p, g, m, v, beta1, beta2, stepSize, delta, decay, false, runner);
+
+    cpuTest = _CheckData(p, pAnswer->data, unitNum, 1e-4F) &&
+              _CheckData(m, mAnswer->data, unitNum, 1e-4F) &&
+              _CheckData(v, vAnswer->data, unitNum, 1e-4F);
+
+    delete p;
+    delete g;
+    delete m;
+    delete v;
+    delete pAnswer;
+    delete mAnswer;
+    delete vAnswer;
+    delete u;
+    delete runner;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for AdamUpdate Function */
+bool TestAdamUpdate()
+{
+    XPRINT(0, stdout, "[TEST AdamUpdate] the Adam(W) update in one pass \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestAdamUpdate1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestAdamUpdate2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,192 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../core/utilities/CheckData.h"
+#include "../core/arithmetic/Sum.h"
+#include "../core/math/Normalize.h"
+#include "../core/reduce/ReduceMean.h"
+#include "../core/reduce/ReduceVariance.h"
+#include "TAddNormalize.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: residual connection and L2 normalization.
+In this case, x=(2, 4), residual=(2, 4), a=(4) and b=(4).
+x' = x + residual and y = a * (x' - mean)/sqrt(variance + epsilon) + b
+*/
+bool TestAddNormalize1()
+{
+    int dimSize[2] = {2, 4};
+    int vSize = 4;
+
+    DTYPE xData[2][4] = { {0.0F, 1.0F, 2.0F, 3.0F},
+                          {1.0F, 0.0F, 1.0F, 0.0F} };
+    DTYPE rData[2][4] = { {1.0F, 1.0F, 1.0F, 1.0F},
+                          {1.0F, 2.0F, 3.0F, 4.0F} };
+    DTYPE aData[4] = {1.0F, 2.0F, 1.0F, 0.5F};
+    DTYPE bData[4] = {0.0F, 0.0F, 1.0F, 1.0F};
+
+    /* x' = {{1, 2, 3, 4}, {2, 2, 4, 4}}, mean = {2.5, 3}, variance = {1.25, 1} */
+    DTYPE sumAnswer[2][4] = { {1.0F, 2.0F, 3.0F, 4.0F},
+                              {2.0F, 2.0F, 4.0F, 4.0F} };
+    DTYPE answer[2][4] = { {-1.3416408F, -0.8944272F, 1.4472136F, 1.6708204F},
+                           {-1.0F, -2.0F, 2.0F, 1.5F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * x = NewTensorV2(2, dimSize);
+    XTensor * r = NewTensorV2(2, dimSize);
+    XTensor * y = NewTensorV2(2, dimSize);
+    XTensor * a = NewTensorV2(1, &vSize);
+    XTensor * b = NewTensorV2(1, &vSize);
+
+    /* initialize variables */
+    x->SetData(xData, 8);
+    r->SetData(rData, 8);
+    a->SetData(aData, 4);
+    b->SetData(bData, 4);
+
+    /* call AddNormalize function */
+    _AddNormalize(x, r, y, a, b, 0.0F, false);
+
+    /* check results */
+    cpuTest = _CheckData(x, sumAnswer, 8, 1e-4F) && _CheckData(y, answer, 8, 1e-4F);
+
+    /* destroy variables */
+    delete x;
+    delete r;
+    delete y;
+    delete a;
+    delete b;
+
+    return cpuTest;
+}
+
+/*
+case 2: residual connection and normalization (L1 and L2) on random data.
+In this case, x=(50, 37) and the results are compared with Sum, ReduceMean,
+ReduceVariance and Normalize (or L1Normalize). The output is written in
+place, and a runner of 2 threads is used.
+*/
+bool TestAddNormalize2()
+{
+    int rowNum = 50;
+    int vSize = 37;
+    int dimSize[2] = {rowNum, vSize};
+    int unitNum = rowNum * vSize;
+    bool cpuTest = true;
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    for (int L1Normed = 0; L1Normed < 2; L1Normed++) {
+        XTensor * x = NewTensorV2(2, dimSize);
+        XTensor * x2 = NewTensorV2(2, dimSize);
+        XTensor * r = NewTensorV2(2, dimSize);
+        XTensor * a = NewTensorV2(1, &vSize);
+        XTensor * b = NewTensorV2(1, &vSize);
+        XTensor * mean = NewTensorV2(1, &rowNum);
+        XTensor * var = NewTensorV2(1, &rowNum);
+        XTensor * answer = NewTensorV2(2, dimSize);
+
+        x->SetDataRand(-2.0F, 2.0F);
+        r->SetDataRand(-2.0F, 2.0F);
+        a->SetDataRand(0.5F, 1.5F);
+        b->SetDataRand(-0.5F, 0.5F);
+
+        /* the unfused implementation */
+        _Sum(x, r, x2);
+        _ReduceMean(x2, mean, 1);
+        _ReduceVariance(x2, var, 1, mean, L1Normed == 1);
+        if (L1Normed == 1)
+            _L1Normalize(x2, answer, 1, mean, var, a, b);
+        else
+            _Normalize(x2, answer, 1, mean, var, a, b, 1e-6F);
+
+        /* call AddNormalize function (in place) */
+        _AddNormalize(x, r, x, a, b, 1e-6F, L1Normed == 1, runner);
+
+        cpuTest = _CheckData(x, answer->data, unitNum, 1e-4F) && cpuTest;
+
+        delete x;
+        delete x2;
+        delete r;
+        delete a;
+        delete b;
+        delete mean;
+        delete var;
+        delete answer;
+    }
+
+    delete runner;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for AddNormalize Function */
+bool TestAddNormalize()
+{
+    XPRINT(0, stdout, "[TEST AddNormalize] residual connection and layer normalization \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestAddNormalize1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestAddNormalize2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
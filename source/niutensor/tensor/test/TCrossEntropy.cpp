@@ -23,6 +23,8 @@
 #include "../core/utilities/CheckData.h"
 #include "../loss/CrossEntropy.h"
 #include "../core/math/ScaleAndShift.h"
+#include "../core/getandset/OnehotAndIndex.h"
+#include "../function/Softmax.h"
 #include "TCrossEntropy.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
@@ -407,6 +409,126 @@ bool TestCrossEntropy4()
 #endif // USE_CUDA
 }
 
+/*
+case 5: test CrossEntropySparse function.
+The loss and the gradient of the logits are compared with those of
+Softmax + IndexToOnehot + CrossEntropy (with label smoothing and padding).
+*/
+bool TestCrossEntropy5()
+{
+    /* a tensor of size (3, 5) */
+    int order = 2;
+    int * dimSize = new int[order];
+    dimSize[0] = 3;
+    dimSize[1] = 5;
+
+    int unitNum = 1;
+    for (int i = 0; i < order; i++)
+        unitNum *= dimSize[i];
+
+    DTYPE logitsData[3][5] = { {0.5F, 2.6F, -0.3F, 1.7F, 0.6F},
+                               {-1.2F, 0.8F, 2.2F, 0.1F, 0.3F},
+                               {0.2F, 0.5F, 1.1F, -2.0F, 0.6F} };
+    int labelData[3] = {1, 4, 0};
+    DTYPE paddingData[3] = {1.0F, 1.0F, 0.0F};
+    DTYPE labelSmoothingP = 0.1F;
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * logits = NewTensorV2(order, dimSize);
+    XTensor * label = NewTensor1DV2(dimSize[0], X_INT);
+    XTensor * padding = NewTensor1DV2(dimSize[0]);
+    XTensor * loss = NewTensor1DV2(dimSize[0]);
+    XTensor * dedx = NewTensorV2(order, dimSize);
+    XTensor * prob = NewTensorV2(order, dimSize);
+    XTensor * gold = NewTensorV2(order, dimSize);
+    XTensor * answer = NewTensor1DV2(dimSize[0]);
+    XTensor * dedp = NewTensorV2(order, dimSize);
+    XTensor * dedxAnswer = NewTensorV2(order, dimSize);
+
+    /* initialize variables */
+    logits->SetData(logitsData, unitNum);
+    label->SetData(labelData, dimSize[0]);
+    padding->SetData(paddingData, dimSize[0]);
+
+    /* the answer */
+    _Softmax(logits, prob, 1);
+    _IndexToOnehot(label, gold, dimSize[1], labelSmoothingP);
+    _CrossEntropy(prob, gold, answer, NULL, padding, 1);
+    _CrossEntropyBackward(dedp, prob, gold, NULL, padding, 1);
+    _SoftmaxBackward(NULL, prob, logits, dedp, dedxAnswer, NULL, 1, NOLOSS);
+
+    /* call CrossEntropySparse function */
+    _CrossEntropySparse(logits, label, loss, padding, labelSmoothingP);
+    _CrossEntropySparseBackward(dedx, logits, label, padding, labelSmoothingP);
+
+    /* check results */
+    cpuTest = _CheckData(loss, answer->data, dimSize[0], 1e-4F) &&
+              _CheckData(dedx, dedxAnswer->data, unitNum, 1e-4F);
+
+#ifdef USE_CUDA
+    /* GPU test */
+    bool gpuTest = true;
+
+    /* create tensors */
+    XTensor * logitsGPU = NewTensorV2(order, dimSize, X_FLOAT, 1.0F, 0);
+    XTensor * labelGPU = NewTensor1DV2(dimSize[0], X_INT, 0);
+    XTensor * paddingGPU = NewTensor1DV2(dimSize[0], X_FLOAT, 0);
+    XTensor * lossGPU = NewTensor1DV2(dimSize[0], X_FLOAT, 0);
+    XTensor * dedxGPU = NewTensorV2(order, dimSize, X_FLOAT, 1.0F, 0);
+
+    /* initialize variables */
+    logitsGPU->SetData(logitsData, unitNum);
+    labelGPU->SetData(labelData, dimSize[0]);
+    paddingGPU->SetData(paddingData, dimSize[0]);
+
+    /* call CrossEntropySparse function */
+    _CrossEntropySparse(logitsGPU, labelGPU, lossGPU, paddingGPU, labelSmoothingP);
+    _CrossEntropySparseBackward(dedxGPU, logitsGPU, labelGPU, paddingGPU, labelSmoothingP);
+
+    /* check results */
+    gpuTest = _CheckData(lossGPU, answer->data, dimSize[0], 1e-4F) &&
+              _CheckData(dedxGPU, dedxAnswer->data, unitNum, 1e-4F);
+
+    /* destroy variables */
+    delete logits;
+    delete label;
+    delete padding;
+    delete loss;
+    delete dedx;
+    delete prob;
+    delete gold;
+    delete answer;
+    delete dedp;
+    delete dedxAnswer;
+    delete logitsGPU;
+    delete labelGPU;
+    delete paddingGPU;
+    delete lossGPU;
+    delete dedxGPU;
+    delete[] dimSize;
+
+    return cpuTest && gpuTest;
+#else
+    /* destroy variables */
+    delete logits;
+    delete label;
+    delete padding;
+    delete loss;
+    delete dedx;
+    delete prob;
+    delete gold;
+    delete answer;
+    delete dedp;
+    delete dedxAnswer;
+    delete[] dimSize;
+
+    return cpuTest;
+#endif // USE_CUDA
+}
+
 /* other cases */
 /*
 TODO!!
@@ -454,6 +576,15 @@ bool TestCrossEntropy()
     else
         XPRINT(0, stdout, ">> case 4 passed!\n");
 
+    /* case 5 test */
+    caseFlag = TestCrossEntropy5();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 5 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 5 passed!\n");
+
     ///* other cases test */
     ///*
     //TODO!!
@@ -0,0 +1,200 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../core/utilities/CheckData.h"
+#include "../core/sort/TopK.h"
+#include "../function/LogSoftmax.h"
+#include "TLogSoftmaxTopK.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: fused log-softmax and top-k selection over groups of rows.
+In this case, x=(4, 2) is split into 2 groups of 2 rows, k = 3 -> (2, 3).
+The second group has a mask on its second row, as the first step of
+beam search does.
+*/
+bool TestLogSoftmaxTopK1()
+{
+    int xDimSize[2] = {4, 2};
+    int tDimSize[2] = {2, 3};
+
+    DTYPE xData[4][2] = { {0.0F, 1.0986123F},
+                          {0.0F, 1.3862944F},
+                          {0.0F, 1.0986123F},
+                          {0.0F, 1.3862944F} };
+    DTYPE prevData[4] = {0.0F, -0.5F, 0.0F, -0.5F};
+    DTYPE maskData[4] = {0.0F, 0.0F, 0.0F, -10.0F};
+    DTYPE valueAnswer[2][3] = { {-0.2876821F, -0.7231435F, -1.3862944F},
+                                {-0.2876821F, -1.3862944F, -10.7231435F} };
+    DTYPE scoreAnswer[2][3] = { {-0.1438410F, -0.3615718F, -0.6931472F},
+                                {-0.1438410F, -0.6931472F, -5.3615718F} };
+    int indexAnswer[2][3] = { {1, 3, 0},
+                              {1, 0, 3} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * prev = NewTensorV2(1, &xDimSize[0]);
+    XTensor * mask = NewTensorV2(1, &xDimSize[0]);
+    XTensor * value = NewTensorV2(2, tDimSize);
+    XTensor * score = NewTensorV2(2, tDimSize);
+    XTensor * index = NewTensorV2(2, tDimSize, X_INT);
+
+    /* initialize variables */
+    x->SetData(xData, 8);
+    prev->SetData(prevData, 4);
+    mask->SetData(maskData, 4);
+
+    /* call LogSoftmaxTopK function */
+    _LogSoftmaxTopK(x, prev, mask, 2, 3, 2.0F, value, score, index);
+
+    /* check results */
+    cpuTest = _CheckData(value, valueAnswer, 6, 1e-4F) &&
+              _CheckData(score, scoreAnswer, 6, 1e-4F) &&
+              _CheckData(index, indexAnswer, 6);
+
+    /* destroy variables */
+    delete x;
+    delete prev;
+    delete mask;
+    delete value;
+    delete score;
+    delete index;
+
+    return cpuTest;
+}
+
+/*
+case 2: fused log-softmax and top-k selection on random data.
+In this case, x=(12, 1000) is split into 3 groups of 4 rows, k = 4.
+The result is compared with LogSoftmax followed by TopK over each
+group, with and without multi-threading.
+*/
+bool TestLogSoftmaxTopK2()
+{
+    int groupNum = 3;
+    int groupSize = 4;
+    int vocabSize = 1000;
+    int k = 4;
+    int rowNum = groupNum * groupSize;
+
+    int xDimSize[2] = {rowNum, vocabSize};
+    int gDimSize[2] = {groupNum, groupSize * vocabSize};
+    int tDimSize[2] = {groupNum, k};
+
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * y = NewTensorV2(2, xDimSize);
+    XTensor * prev = NewTensorV2(1, &rowNum);
+    XTensor * value = NewTensorV2(2, tDimSize);
+    XTensor * index = NewTensorV2(2, tDimSize, X_INT);
+    XTensor * valueAnswer = NewTensorV2(2, tDimSize);
+    XTensor * indexAnswer = NewTensorV2(2, tDimSize, X_INT);
+
+    x->SetDataRand(-8.0F, 8.0F);
+    prev->SetDataRand(-2.0F, 0.0F);
+
+    /* the unfused implementation */
+    _LogSoftmax(x, y, 1);
+    DTYPE * yp = (DTYPE*)y->data;
+    DTYPE * pp = (DTYPE*)prev->data;
+    for (int r = 0; r < rowNum; r++) {
+        for (int v = 0; v < vocabSize; v++)
+            yp[r * vocabSize + v] += pp[r];
+    }
+    y->Reshape(2, gDimSize);
+    _TopK(y, valueAnswer, indexAnswer, 1, k, true);
+
+    /* call LogSoftmaxTopK function */
+    _LogSoftmaxTopK(x, prev, NULL, groupSize, k, 1.0F, value, NULL, index);
+    bool cpuTest = _CheckData(value, valueAnswer->data, groupNum * k, 1e-4F) &&
+                   _CheckData(index, indexAnswer->data, groupNum * k);
+
+    /* and with multiple threads */
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+    value->SetZeroAll();
+    index->SetZeroAll();
+    _LogSoftmaxTopK(x, prev, NULL, groupSize, k, 1.0F, value, NULL, index, runner);
+    cpuTest = _CheckData(value, valueAnswer->data, groupNum * k, 1e-4F) &&
+              _CheckData(index, indexAnswer->data, groupNum * k) && cpuTest;
+
+    /* destroy variables */
+    delete runner;
+    delete x;
+    delete y;
+    delete prev;
+    delete value;
+    delete index;
+    delete valueAnswer;
+    delete indexAnswer;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for LogSoftmaxTopK Function */
+bool TestLogSoftmaxTopK()
+{
+    XPRINT(0, stdout, "[TEST LogSoftmaxTopK] fused log-softmax and top-k selection over groups of rows \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestLogSoftmaxTopK1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestLogSoftmaxTopK2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
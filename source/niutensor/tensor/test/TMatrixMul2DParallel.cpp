@@ -20,6 +20,8 @@
 */
 
 #include "../core/utilities/CheckData.h"
+#include "../core/movement/CopyValues.h"
+#include "../core/arithmetic/MatrixMul2DPacked.h"
 #include "TMatrixMul2DParallel.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
@@ -175,6 +177,408 @@ bool TestMatrixMul2DParallel2()
     return cpuTest;
 }
 
+/* 
+case 3: matrix multiplication (for 2d tensors) with multi-threading.
+In this case, a=(2, 3), b=(2, 3) -> c=(2, 2), 
+transposedA=X_NOTRANS, transposedB=X_TRANS.
+*/
+bool TestMatrixMul2DParallel3()
+{
+    /* a source tensor of size (2, 3) */
+    int sOrder1 = 2;
+    int * sDimSize1 = new int[sOrder1];
+    sDimSize1[0] = 2;
+    sDimSize1[1] = 3;
+
+    int sUnitNum1 = 1;
+    for (int i = 0; i < sOrder1; i++)
+        sUnitNum1 *= sDimSize1[i];
+
+    /* a source tensor of size (2, 3) */
+    int sOrder2 = 2;
+    int * sDimSize2 = new int[sOrder2];
+    sDimSize2[0] = 2;
+    sDimSize2[1] = 3;
+
+    int sUnitNum2 = 1;
+    for (int i = 0; i < sOrder2; i++)
+        sUnitNum2 *= sDimSize2[i];
+
+    /* a target tensor of size (2, 2) */
+    int tOrder = 2;
+    int * tDimSize = new int[tOrder];
+    tDimSize[0] = 2;
+    tDimSize[1] = 2;
+
+    int tUnitNum = 1;
+    for (int i = 0; i < tOrder; i++)
+        tUnitNum *= tDimSize[i];
+
+    DTYPE sData1[2][3] = { {1.0F, 2.0F, 3.0F},
+                           {-4.0F, 5.0F, 6.0F} };
+    DTYPE sData2[2][3] = { {0.0F, 1.0F, 2.0F},
+                           {-1.0F, 2.0F, 1.0F} };
+    DTYPE answer[2][2] = { {8.0F, 6.0F},
+                           {17.0F, 20.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s1 = NewTensorV2(sOrder1, sDimSize1);
+    XTensor * s2 = NewTensorV2(sOrder2, sDimSize2);
+    XTensor * t = NewTensorV2(tOrder, tDimSize);
+
+    /* initialize variables */
+    s1->SetData(sData1, sUnitNum1);
+    s2->SetData(sData2, sUnitNum2);
+    t->SetZeroAll();
+
+    /* call MatrixMul2DParallel function */
+    _MatrixMul2DParallel(s1, X_NOTRANS, s2, X_TRANS, t);
+
+    /* check results */
+    cpuTest = _CheckData(t, answer, tUnitNum, 1e-4F);
+
+    /* destroy variables */
+    delete s1;
+    delete s2;
+    delete t;
+    delete[] sDimSize1;
+    delete[] sDimSize2;
+    delete[] tDimSize;
+
+    return cpuTest;
+}
+
+/* 
+case 4: matrix multiplication (for 2d tensors) with multi-threading.
+In this case, a=(3, 2), b=(2, 3) -> c=(2, 2), 
+transposedA=X_TRANS, transposedB=X_TRANS.
+*/
+bool TestMatrixMul2DParallel4()
+{
+    /* a source tensor of size (3, 2) */
+    int sOrder1 = 2;
+    int * sDimSize1 = new int[sOrder1];
+    sDimSize1[0] = 3;
+    sDimSize1[1] = 2;
+
+    int sUnitNum1 = 1;
+    for (int i = 0; i < sOrder1; i++)
+        sUnitNum1 *= sDimSize1[i];
+
+    /* a source tensor of size (2, 3) */
+    int sOrder2 = 2;
+    int * sDimSize2 = new int[sOrder2];
+    sDimSize2[0] = 2;
+    sDimSize2[1] = 3;
+
+    int sUnitNum2 = 1;
+    for (int i = 0; i < sOrder2; i++)
+        sUnitNum2 *= sDimSize2[i];
+
+    /* a target tensor of size (2, 2) */
+    int tOrder = 2;
+    int * tDimSize = new int[tOrder];
+    tDimSize[0] = 2;
+    tDimSize[1] = 2;
+
+    int tUnitNum = 1;
+    for (int i = 0; i < tOrder; i++)
+        tUnitNum *= tDimSize[i];
+
+    DTYPE sData1[3][2] = { {1.0F, -4.0F},
+                           {2.0F, 5.0F},
+                           {3.0F, 6.0F} };
+    DTYPE sData2[2][3] = { {0.0F, 1.0F, 2.0F},
+                           {-1.0F, 2.0F, 1.0F} };
+    DTYPE answer[2][2] = { {8.0F, 6.0F},
+                           {17.0F, 20.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * s1 = NewTensorV2(sOrder1, sDimSize1);
+    XTensor * s2 = NewTensorV2(sOrder2, sDimSize2);
+    XTensor * t = NewTensorV2(tOrder, tDimSize);
+
+    /* initialize variables */
+    s1->SetData(sData1, sUnitNum1);
+    s2->SetData(sData2, sUnitNum2);
+    t->SetZeroAll();
+
+    /* call MatrixMul2DParallel function */
+    _MatrixMul2DParallel(s1, X_TRANS, s2, X_TRANS, t);
+
+    /* check results */
+    cpuTest = _CheckData(t, answer, tUnitNum, 1e-4F);
+
+    /* destroy variables */
+    delete s1;
+    delete s2;
+    delete t;
+    delete[] sDimSize1;
+    delete[] sDimSize2;
+    delete[] tDimSize;
+
+    return cpuTest;
+}
+
+/* 
+case 5: matrix multiplication (for 2d tensors) with multi-threading.
+In this case, c=(101, 97) and the inner dimension is 300, so that the
+margins of the register blocks and the k-blocking are covered. All the
+transposition cases and all micro-kernels that the CPU supports are
+checked against a naive implementation with c = a * b * 2 + c * 0.5
+on two threads.
+*/
+bool TestMatrixMul2DParallel5()
+{
+    int n = 101;
+    int m = 97;
+    int k = 300;
+    DTYPE alpha = 2.0F;
+    DTYPE beta = 0.5F;
+
+    int cDimSize[2] = {n, m};
+    XTensor * c = NewTensorV2(2, cDimSize);
+    XTensor * c0 = NewTensorV2(2, cDimSize);
+    DTYPE * answer = new DTYPE[n * m];
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    bool cpuTest = true;
+
+    for (int trans = 0; trans < 4; trans++) {
+        MATRIX_TRANS_TYPE transposedA = (trans & 1) ? X_TRANS : X_NOTRANS;
+        MATRIX_TRANS_TYPE transposedB = (trans & 2) ? X_TRANS : X_NOTRANS;
+        int aDimSize[2] = {n, k};
+        int bDimSize[2] = {k, m};
+        if (transposedA == X_TRANS) {
+            aDimSize[0] = k;
+            aDimSize[1] = n;
+        }
+        if (transposedB == X_TRANS) {
+            bDimSize[0] = m;
+            bDimSize[1] = k;
+        }
+
+        XTensor * a = NewTensorV2(2, aDimSize);
+        XTensor * b = NewTensorV2(2, bDimSize);
+        a->SetDataRand(-1.0F, 1.0F);
+        b->SetDataRand(-1.0F, 1.0F);
+        c0->SetDataRand(-1.0F, 1.0F);
+
+        DTYPE * ap = (DTYPE*)a->data;
+        DTYPE * bp = (DTYPE*)b->data;
+        DTYPE * cp = (DTYPE*)c0->data;
+
+        /* the naive implementation */
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < m; j++) {
+                DTYPE r = 0;
+                for (int p = 0; p < k; p++) {
+                    DTYPE x = transposedA == X_TRANS ? ap[p * n + i] : ap[i * k + p];
+                    DTYPE y = transposedB == X_TRANS ? bp[j * k + p] : bp[p * m + j];
+                    r += x * y;
+                }
+                answer[i * m + j] = r * alpha + cp[i * m + j] * beta;
+            }
+        }
+
+        for (int kernel = GEMM_KERNEL_GENERIC; kernel <= GEMM_KERNEL_AVX512; kernel++) {
+            if (!IsGEMMKernelSupported(kernel))
+                continue;
+
+            SetGEMMKernel(kernel);
+
+            /* single thread */
+            _CopyValues(c0, c);
+            _MatrixMul2DParallel(a, transposedA, b, transposedB, c, alpha, beta);
+            cpuTest = _CheckData(c, answer, n * m, 1e-3F) && cpuTest;
+
+            /* multiple threads */
+            _CopyValues(c0, c);
+            _MatrixMul2DParallel(a, transposedA, b, transposedB, c, alpha, beta, runner);
+            cpuTest = _CheckData(c, answer, n * m, 1e-3F) && cpuTest;
+        }
+
+        delete a;
+        delete b;
+    }
+
+    SetGEMMKernel(GEMM_KERNEL_AUTO);
+
+    /* destroy variables */
+    delete runner;
+    delete c;
+    delete c0;
+    delete[] answer;
+
+    return cpuTest;
+}
+
+/*
+case 6: matrix multiplication with a pre-packed matrix.
+In this case, a=(37, 300) and b=(300, 101) (or its transposition), and b is
+packed once for each micro-kernel that the CPU supports. The result of
+c = a * b * 2 + c * 0.5 on two threads is checked against a naive
+implementation.
+*/
+bool TestMatrixMul2DParallel6()
+{
+    int n = 37;
+    int m = 101;
+    int k = 300;
+    DTYPE alpha = 2.0F;
+    DTYPE beta = 0.5F;
+
+    int aDimSize[2] = {n, k};
+    int cDimSize[2] = {n, m};
+    XTensor * a = NewTensorV2(2, aDimSize);
+    XTensor * c = NewTensorV2(2, cDimSize);
+    XTensor * c0 = NewTensorV2(2, cDimSize);
+    DTYPE * answer = new DTYPE[n * m];
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    bool cpuTest = true;
+
+    for (int trans = 0; trans < 2; trans++) {
+        MATRIX_TRANS_TYPE transposedB = trans == 1 ? X_TRANS : X_NOTRANS;
+        int bDimSize[2] = {k, m};
+        if (transposedB == X_TRANS) {
+            bDimSize[0] = m;
+            bDimSize[1] = k;
+        }
+
+        XTensor * b = NewTensorV2(2, bDimSize);
+        a->SetDataRand(-1.0F, 1.0F);
+        b->SetDataRand(-1.0F, 1.0F);
+        c0->SetDataRand(-1.0F, 1.0F);
+
+        DTYPE * ap = (DTYPE*)a->data;
+        DTYPE * bp = (DTYPE*)b->data;
+        DTYPE * cp = (DTYPE*)c0->data;
+
+        /* the naive implementation */
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < m; j++) {
+                DTYPE r = 0;
+                for (int p = 0; p < k; p++) {
+                    DTYPE y = transposedB == X_TRANS ? bp[j * k + p] : bp[p * m + j];
+                    r += ap[i * k + p] * y;
+                }
+                answer[i * m + j] = r * alpha + cp[i * m + j] * beta;
+            }
+        }
+
+        for (int kernel = GEMM_KERNEL_GENERIC; kernel <= GEMM_KERNEL_AVX512; kernel++) {
+            if (!IsGEMMKernelSupported(kernel))
+                continue;
+
+            SetGEMMKernel(kernel);
+
+            XPackedMatrix packed;
+            packed.Pack(b, transposedB);
+
+            /* single thread */
+            _CopyValues(c0, c);
+            _MatrixMulPacked(a, &packed, c, alpha, beta);
+            cpuTest = _CheckData(c, answer, n * m, 1e-3F) && cpuTest;
+
+            /* multiple threads */
+            _CopyValues(c0, c);
+            _MatrixMulPacked(a, &packed, c, alpha, beta, runner);
+            cpuTest = _CheckData(c, answer, n * m, 1e-3F) && cpuTest;
+        }
+
+        delete b;
+    }
+
+    SetGEMMKernel(GEMM_KERNEL_AUTO);
+
+    /* destroy variables */
+    delete runner;
+    delete a;
+    delete c;
+    delete c0;
+    delete[] answer;
+
+    return cpuTest;
+}
+
+/*
+case 7: matrix multiplication (for 2d tensors) with multi-threading on
+matrices of different sizes in turn, i.e., c=(200, 2100), (3, 5) and
+(200, 2100) again with an inner dimension of 40. The columns of c are
+more than GEMM_NC, and op(b) that is packed once is shared by the blocks
+of rows on four threads. The results are checked against a naive
+implementation with c = a * b.
+*/
+bool TestMatrixMul2DParallel7()
+{
+    int shapes[3][2] = { {200, 2100}, {3, 5}, {200, 2100} };
+    int k = 40;
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(4);
+
+    bool cpuTest = true;
+
+    for (int s = 0; s < 3; s++) {
+        int n = shapes[s][0];
+        int m = shapes[s][1];
+        MATRIX_TRANS_TYPE transposedB = s == 1 ? X_TRANS : X_NOTRANS;
+        int aDimSize[2] = {n, k};
+        int bDimSize[2] = {k, m};
+        int cDimSize[2] = {n, m};
+        if (transposedB == X_TRANS) {
+            bDimSize[0] = m;
+            bDimSize[1] = k;
+        }
+
+        XTensor * a = NewTensorV2(2, aDimSize);
+        XTensor * b = NewTensorV2(2, bDimSize);
+        XTensor * c = NewTensorV2(2, cDimSize);
+        DTYPE * answer = new DTYPE[n * m];
+        a->SetDataRand(-1.0F, 1.0F);
+        b->SetDataRand(-1.0F, 1.0F);
+
+        DTYPE * ap = (DTYPE*)a->data;
+        DTYPE * bp = (DTYPE*)b->data;
+
+        /* the naive implementation */
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < m; j++) {
+                DTYPE r = 0;
+                for (int p = 0; p < k; p++) {
+                    DTYPE y = transposedB == X_TRANS ? bp[j * k + p] : bp[p * m + j];
+                    r += ap[i * k + p] * y;
+                }
+                answer[i * m + j] = r;
+            }
+        }
+
+        _MatrixMul2DParallel(a, X_NOTRANS, b, transposedB, c, 1.0F, 0, runner);
+        cpuTest = _CheckData(c, answer, n * m, 1e-3F) && cpuTest;
+
+        delete a;
+        delete b;
+        delete c;
+        delete[] answer;
+    }
+
+    /* destroy variables */
+    delete runner;
+
+    return cpuTest;
+}
+
 /* other cases */
 /*
     TODO!!
@@ -205,6 +609,51 @@ bool TestMatrixMul2DParallel()
     else
         XPRINT(0, stdout, ">> case 2 passed!\n");
 
+    /* case 3 test */
+    caseFlag = TestMatrixMul2DParallel3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* case 4 test */
+    caseFlag = TestMatrixMul2DParallel4();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 4 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 4 passed!\n");
+
+    /* case 5 test */
+    caseFlag = TestMatrixMul2DParallel5();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 5 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 5 passed!\n");
+
+    /* case 6 test */
+    caseFlag = TestMatrixMul2DParallel6();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 6 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 6 passed!\n");
+
+    /* case 7 test */
+    caseFlag = TestMatrixMul2DParallel7();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 7 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 7 passed!\n");
+
     /* other cases test */
     /*
     TODO!!
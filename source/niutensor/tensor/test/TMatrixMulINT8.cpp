@@ -0,0 +1,257 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../core/utilities/CheckData.h"
+#include "../core/movement/Gather.h"
+#include "TMatrixMulINT8.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: matrix multiplication with int8 weights and a bias.
+In this case, x=(2, 3), w=(3, 2), b=(2) -> c=(2, 2).
+The values are chosen so that the quantization is lossless.
+*/
+bool TestMatrixMulINT81()
+{
+    int xDimSize[2] = {2, 3};
+    int wDimSize[2] = {3, 2};
+    int qDimSize[2] = {2, 3};
+    int cDimSize[2] = {2, 2};
+    int bDimSize[1] = {2};
+    int sDimSize[1] = {2};
+
+    DTYPE xData[2][3] = { {127.0F, 0.0F, -127.0F},
+                          {-254.0F, 128.0F, 254.0F} };
+    DTYPE wData[3][2] = { {0.0F, -1.0F},
+                          {1.0F, 2.0F},
+                          {127.0F, 127.0F} };
+    DTYPE bData[2] = {1.0F, -1.0F};
+    DTYPE answer[2][2] = { {-16128.0F, -16257.0F},
+                           {32387.0F, 32767.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * q = NewTensorV2(2, qDimSize, X_INT8);
+    XTensor * s = NewTensorV2(1, sDimSize);
+    XTensor * b = NewTensorV2(1, bDimSize);
+    XTensor * c = NewTensorV2(2, cDimSize);
+
+    /* initialize variables */
+    x->SetData(xData, 6);
+    w->SetData(wData, 6);
+    b->SetData(bData, 2);
+    c->SetZeroAll();
+
+    /* call QuantizeINT8 and MatrixMulINT8 functions */
+    _QuantizeINT8(w, X_NOTRANS, q, s);
+    _MatrixMulINT8(x, q, s, c, b);
+
+    /* check results */
+    cpuTest = _CheckData(c, answer, 4, 1e-4F);
+
+    /* destroy variables */
+    delete x;
+    delete w;
+    delete q;
+    delete s;
+    delete b;
+    delete c;
+
+    return cpuTest;
+}
+
+/*
+case 2: matrix multiplication with int8 weights on random data.
+In this case, x=(3, 5, k), w=(n, k) is used as x * trans(w) -> c=(3, 5, n).
+The result is compared with the float matrix multiplication within the
+quantization error, with and without multi-threading.
+*/
+bool TestMatrixMulINT82()
+{
+    int n = 37;
+    int k = 131;
+    int m = 15;
+
+    int xDimSize[3] = {3, 5, k};
+    int wDimSize[2] = {n, k};
+    int cDimSize[3] = {3, 5, n};
+
+    XTensor * x = NewTensorV2(3, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * q = NewTensorV2(2, wDimSize, X_INT8);
+    XTensor * s = NewTensorV2(1, &n);
+    XTensor * c = NewTensorV2(3, cDimSize);
+    DTYPE * answer = new DTYPE[m * n];
+
+    x->SetDataRand(-1.0F, 1.0F);
+    w->SetDataRand(-1.0F, 1.0F);
+
+    DTYPE * xp = (DTYPE*)x->data;
+    DTYPE * wp = (DTYPE*)w->data;
+
+    /* the float implementation */
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            DTYPE r = 0;
+            for (int p = 0; p < k; p++)
+                r += xp[i * k + p] * wp[j * k + p];
+            answer[i * n + j] = r;
+        }
+    }
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    bool cpuTest = true;
+
+    _QuantizeINT8(w, X_TRANS, q, s);
+
+    /* single thread */
+    c->SetZeroAll();
+    _MatrixMulINT8(x, q, s, c);
+    cpuTest = _CheckData(c, answer, m * n, 2e-1F) && cpuTest;
+
+    /* multiple threads */
+    c->SetZeroAll();
+    _MatrixMulINT8(x, q, s, c, NULL, runner);
+    cpuTest = _CheckData(c, answer, m * n, 2e-1F) && cpuTest;
+
+    /* the XTensor interface */
+    XTensor cUser = MMulINT8(*x, *q, *s);
+    cpuTest = _CheckData(&cUser, answer, m * n, 2e-1F) && cpuTest;
+
+    /* destroy variables */
+    delete runner;
+    delete x;
+    delete w;
+    delete q;
+    delete s;
+    delete c;
+    delete[] answer;
+
+    return cpuTest;
+}
+
+/*
+case 3: gather and dequantize rows of an int8 matrix.
+In this case, w=(3, 2), index=(2) -> t=(2, 2).
+*/
+bool TestMatrixMulINT83()
+{
+    int wDimSize[2] = {3, 2};
+    int indexSize = 2;
+
+    DTYPE wData[3][2] = { {0.0F, -1.0F},
+                          {126.0F, 254.0F},
+                          {2.0F, 2.0F} };
+    int indexData[2] = {1, 0};
+    DTYPE answer[2][2] = { {126.0F, 254.0F},
+                           {0.0F, -1.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * q = NewTensorV2(2, wDimSize, X_INT8);
+    XTensor * s = NewTensorV2(1, wDimSize);
+    XTensor * index = NewTensorV2(1, &indexSize, X_INT);
+
+    /* initialize variables */
+    w->SetData(wData, 6);
+    index->SetData(indexData, 2);
+
+    /* call QuantizeINT8 and GatherINT8 functions */
+    _QuantizeINT8(w, X_TRANS, q, s);
+    XTensor tUser = GatherINT8(*q, *s, *index);
+
+    /* check results */
+    cpuTest = _CheckData(&tUser, answer, 4, 1e-4F);
+
+    /* destroy variables */
+    delete w;
+    delete q;
+    delete s;
+    delete index;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for MatrixMulINT8 Function */
+bool TestMatrixMulINT8()
+{
+    XPRINT(0, stdout, "[TEST MatrixMulINT8] int8 matrix multiplication for inference \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestMatrixMulINT81();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestMatrixMulINT82();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestMatrixMulINT83();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
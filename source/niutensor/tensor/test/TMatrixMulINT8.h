@@ -0,0 +1,33 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#ifndef __TEST_MATRIXMULINT8_H__
+#define __TEST_MATRIXMULINT8_H__
+
+#include "../core/arithmetic/MatrixMulINT8.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* test for MatrixMulINT8 Function */
+bool TestMatrixMulINT8();
+
+} // namespace nts(NiuTrans.Tensor)
+#endif // __TEST_MATRIXMULINT8_H__
@@ -0,0 +1,412 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../core/utilities/CheckData.h"
+#include "../core/arithmetic/Sum.h"
+#include "../function/Rectify.h"
+#include "TMulAndShift.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: matrix multiplication and shift with ReLU and a residual connection.
+In this case, x=(2, 3), w=(3, 2), b=(2) and residual=(2, 2) -> c=(2, 2).
+c = max(0, x * w + b) + residual
+*/
+bool TestMulAndShift1()
+{
+    int xDimSize[2] = {2, 3};
+    int wDimSize[2] = {3, 2};
+    int cDimSize[2] = {2, 2};
+    int bDimSize[1] = {2};
+
+    DTYPE xData[2][3] = { {1.0F, 2.0F, 3.0F},
+                          {-1.0F, 0.0F, 1.0F} };
+    DTYPE wData[3][2] = { {1.0F, -1.0F},
+                          {0.0F, 2.0F},
+                          {1.0F, -3.0F} };
+    DTYPE bData[2] = {0.5F, -1.0F};
+    DTYPE rData[2][2] = { {1.0F, 1.0F},
+                          {-1.0F, 2.0F} };
+
+    /* x * w + b = {{4.5, -7}, {0.5, -3}} */
+    DTYPE shiftAnswer[2][2] = { {4.5F, -7.0F},
+                                {0.5F, -3.0F} };
+    DTYPE answer[2][2] = { {5.5F, 1.0F},
+                           {-0.5F, 2.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * b = NewTensorV2(1, bDimSize);
+    XTensor * r = NewTensorV2(2, cDimSize);
+    XTensor * c = NewTensorV2(2, cDimSize);
+
+    /* initialize variables */
+    x->SetData(xData, 6);
+    w->SetData(wData, 6);
+    b->SetData(bData, 2);
+    r->SetData(rData, 4);
+
+    /* call MulAndShift function */
+    _MulAndShift(x, w, b, c, false, NULL);
+    cpuTest = _CheckData(c, shiftAnswer, 4, 1e-4F) && cpuTest;
+
+    _MulAndShift(x, w, b, c, true, r);
+    cpuTest = _CheckData(c, answer, 4, 1e-4F) && cpuTest;
+
+    /* the XTensor interface */
+    XTensor cUser = MulAndShift(*x, *w, *b, true, r);
+    cpuTest = _CheckData(&cUser, answer, 4, 1e-4F) && cpuTest;
+
+    /* destroy variables */
+    delete x;
+    delete w;
+    delete b;
+    delete r;
+    delete c;
+
+    return cpuTest;
+}
+
+/*
+case 2: matrix multiplication and shift with ReLU and a residual connection
+on random data. In this case, x=(3, 5, k), w=(k, n) -> c=(3, 5, n).
+The result is compared with MulAndShift, Rectify and Sum (also with
+the weight pre-packed).
+*/
+bool TestMulAndShift2()
+{
+    int n = 37;
+    int k = 131;
+    int m = 15;
+
+    int xDimSize[3] = {3, 5, k};
+    int wDimSize[2] = {k, n};
+    int cDimSize[3] = {3, 5, n};
+
+    XTensor * x = NewTensorV2(3, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * b = NewTensorV2(1, &n);
+    XTensor * r = NewTensorV2(3, cDimSize);
+    XTensor * c = NewTensorV2(3, cDimSize);
+    XTensor * answer = NewTensorV2(3, cDimSize);
+
+    x->SetDataRand(-1.0F, 1.0F);
+    w->SetDataRand(-1.0F, 1.0F);
+    b->SetDataRand(-1.0F, 1.0F);
+    r->SetDataRand(-1.0F, 1.0F);
+
+    bool cpuTest = IsMulAndShiftFusable(x, w, b, r) && !IsMulAndShiftFusable(x, w, b, x);
+
+    /* the unfused implementation */
+    XTensor shift = MulAndShift(*x, *w, *b);
+    _Rectify(&shift, answer);
+    _Sum(answer, r, answer);
+
+    _MulAndShift(x, w, b, c, true, r);
+    cpuTest = _CheckData(c, answer->data, m * n, 1e-4F) && cpuTest;
+
+    /* without the activation and the residual */
+    _MulAndShift(x, w, b, c, false, NULL);
+    cpuTest = _CheckData(c, shift.data, m * n, 1e-4F) && cpuTest;
+
+    /* with the pre-packed weight */
+    XPackedMatrix pw;
+    pw.Pack(w, X_NOTRANS);
+    cpuTest = IsMulAndShiftFusable(x, &pw, b, r) && cpuTest;
+
+    _MulAndShift(x, &pw, b, c, true, r);
+    cpuTest = _CheckData(c, answer->data, m * n, 1e-4F) && cpuTest;
+
+    XTensor packed = MulAndShift(*x, pw, *b, false, NULL);
+    cpuTest = _CheckData(&packed, shift.data, m * n, 1e-4F) && cpuTest;
+
+    /* destroy variables */
+    delete x;
+    delete w;
+    delete b;
+    delete r;
+    delete c;
+    delete answer;
+
+    return cpuTest;
+}
+
+/*
+case 3: matrix multiplication and shift with int8 weights, ReLU and a
+residual connection. In this case, x=(2, 3), w=(3, 2), b=(2) and
+residual=(2, 2) -> c=(2, 2). The values are chosen so that the
+quantization is lossless.
+*/
+bool TestMulAndShift3()
+{
+    int xDimSize[2] = {2, 3};
+    int wDimSize[2] = {3, 2};
+    int qDimSize[2] = {2, 3};
+    int cDimSize[2] = {2, 2};
+    int bDimSize[1] = {2};
+    int sDimSize[1] = {2};
+
+    DTYPE xData[2][3] = { {127.0F, 0.0F, -127.0F},
+                          {-254.0F, 128.0F, 254.0F} };
+    DTYPE wData[3][2] = { {0.0F, -1.0F},
+                          {1.0F, 2.0F},
+                          {127.0F, 127.0F} };
+    DTYPE bData[2] = {1.0F, -1.0F};
+    DTYPE rData[2][2] = { {1.0F, 2.0F},
+                          {3.0F, 4.0F} };
+
+    /* x * w + b = {{-16128, -16257}, {32387, 32767}} */
+    DTYPE answer[2][2] = { {1.0F, 2.0F},
+                           {32390.0F, 32771.0F} };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * q = NewTensorV2(2, qDimSize, X_INT8);
+    XTensor * s = NewTensorV2(1, sDimSize);
+    XTensor * b = NewTensorV2(1, bDimSize);
+    XTensor * r = NewTensorV2(2, cDimSize);
+    XTensor * c = NewTensorV2(2, cDimSize);
+
+    /* initialize variables */
+    x->SetData(xData, 6);
+    w->SetData(wData, 6);
+    b->SetData(bData, 2);
+    r->SetData(rData, 4);
+
+    /* call QuantizeINT8 and MulAndShiftINT8 functions */
+    _QuantizeINT8(w, X_NOTRANS, q, s);
+    _MulAndShiftINT8(x, q, s, b, c, true, r);
+    cpuTest = _CheckData(c, answer, 4, 1e-4F) && cpuTest;
+
+    /* the XTensor interface */
+    XTensor cUser = MulAndShiftINT8(*x, *q, *s, *b, true, r);
+    cpuTest = _CheckData(&cUser, answer, 4, 1e-4F) && cpuTest;
+
+    /* destroy variables */
+    delete x;
+    delete w;
+    delete q;
+    delete s;
+    delete b;
+    delete r;
+    delete c;
+
+    return cpuTest;
+}
+
+/*
+case 4: matrix multiplication and shift with ReLU and a residual connection
+on random data, where the blocks of c are computed by a runner of 2 threads.
+In this case, x=(200, k), w=(k, n) -> c=(200, n).
+*/
+bool TestMulAndShift4()
+{
+    int n = 96;
+    int k = 64;
+    int m = 200;
+
+    int xDimSize[2] = {m, k};
+    int wDimSize[2] = {k, n};
+    int cDimSize[2] = {m, n};
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * b = NewTensorV2(1, &n);
+    XTensor * r = NewTensorV2(2, cDimSize);
+    XTensor * c = NewTensorV2(2, cDimSize);
+    XTensor * answer = NewTensorV2(2, cDimSize);
+
+    x->SetDataRand(-1.0F, 1.0F);
+    w->SetDataRand(-1.0F, 1.0F);
+    b->SetDataRand(-1.0F, 1.0F);
+    r->SetDataRand(-1.0F, 1.0F);
+
+    /* the unfused implementation */
+    XTensor shift = MulAndShift(*x, *w, *b);
+    _Rectify(&shift, answer);
+    _Sum(answer, r, answer);
+
+    _MulAndShift(x, w, b, c, true, r, runner);
+    bool cpuTest = _CheckData(c, answer->data, m * n, 1e-4F);
+
+    /* with the pre-packed weight */
+    XPackedMatrix pw;
+    pw.Pack(w, X_NOTRANS);
+    _MulAndShift(x, &pw, b, c, true, r, runner);
+    cpuTest = _CheckData(c, answer->data, m * n, 1e-4F) && cpuTest;
+
+    /* destroy variables */
+    delete x;
+    delete w;
+    delete b;
+    delete r;
+    delete c;
+    delete answer;
+    delete runner;
+
+    return cpuTest;
+}
+
+/*
+case 5: matrix multiplication and shift with ReLU and a residual connection
+on random data, where k is split into more than one block and c has margin
+blocks, i.e., the epilogue is only applied after the last block of k.
+In this case, x=(37, k), w=(k, n) -> c=(37, n).
+*/
+bool TestMulAndShift5()
+{
+    int n = 100;
+    int k = GEMM_KC + 44;
+    int m = 37;
+
+    int xDimSize[2] = {m, k};
+    int wDimSize[2] = {k, n};
+    int cDimSize[2] = {m, n};
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    XTensor * x = NewTensorV2(2, xDimSize);
+    XTensor * w = NewTensorV2(2, wDimSize);
+    XTensor * b = NewTensorV2(1, &n);
+    XTensor * r = NewTensorV2(2, cDimSize);
+    XTensor * c = NewTensorV2(2, cDimSize);
+    XTensor * answer = NewTensorV2(2, cDimSize);
+
+    x->SetDataRand(-1.0F, 1.0F);
+    w->SetDataRand(-1.0F, 1.0F);
+    b->SetDataRand(-1.0F, 1.0F);
+    r->SetDataRand(-1.0F, 1.0F);
+
+    /* the unfused implementation */
+    XTensor shift = MulAndShift(*x, *w, *b);
+    _Rectify(&shift, answer);
+    _Sum(answer, r, answer);
+
+    _MulAndShift(x, w, b, c, true, r);
+    bool cpuTest = _CheckData(c, answer->data, m * n, 1e-3F);
+
+    _MulAndShift(x, w, b, c, true, r, runner);
+    cpuTest = _CheckData(c, answer->data, m * n, 1e-3F) && cpuTest;
+
+    /* with the pre-packed weight */
+    XPackedMatrix pw;
+    pw.Pack(w, X_NOTRANS);
+    _MulAndShift(x, &pw, b, c, true, r, runner);
+    cpuTest = _CheckData(c, answer->data, m * n, 1e-3F) && cpuTest;
+
+    /* destroy variables */
+    delete x;
+    delete w;
+    delete b;
+    delete r;
+    delete c;
+    delete answer;
+    delete runner;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for MulAndShift Function */
+bool TestMulAndShift()
+{
+    XPRINT(0, stdout, "[TEST MulAndShift] matrix multiplication and shift with the activation and residual \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestMulAndShift1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestMulAndShift2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestMulAndShift3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* case 4 test */
+    caseFlag = TestMulAndShift4();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 4 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 4 passed!\n");
+
+    /* case 5 test */
+    caseFlag = TestMulAndShift5();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 5 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 5 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
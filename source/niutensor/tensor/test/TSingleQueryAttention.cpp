@@ -0,0 +1,273 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include "../core/utilities/CheckData.h"
+#include "TSingleQueryAttention.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+case 1: single-query attention with one head.
+In this case, q=(2, 1, 2), the buffers are (2, 2, 2) and the index table
+is (2, 2) -> c=(2, 1, 2). The second query reads different rows of the
+buffers at different steps.
+*/
+bool TestSingleQueryAttention1()
+{
+    int qDimSize[3] = {2, 1, 2};
+    int bufDimSize[3] = {2, 2, 2};
+
+    DTYPE qData[2][1][2] = { { {1.0F, 0.0F} },
+                             { {0.0F, 0.0F} } };
+    DTYPE keyData[2][2][2] = { { {0.0F, 0.0F}, {1.0F, 1.0F} },
+                               { {1.0986123F, 0.0F}, {0.0F, 0.0F} } };
+    DTYPE valueData[2][2][2] = { { {4.0F, 0.0F}, {2.0F, 2.0F} },
+                                 { {0.0F, 8.0F}, {6.0F, 6.0F} } };
+    int index[4] = {0, 0, 0, 1};
+    DTYPE answer[2][1][2] = { { {1.0F, 6.0F} },
+                              { {5.0F, 3.0F} } };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * q = NewTensorV2(3, qDimSize);
+    XTensor * key = NewTensorV2(3, bufDimSize);
+    XTensor * value = NewTensorV2(3, bufDimSize);
+    XTensor * c = NewTensorV2(3, qDimSize);
+    XTensor cUser;
+
+    /* initialize variables */
+    q->SetData(qData, 4);
+    key->SetData(keyData, 8);
+    value->SetData(valueData, 8);
+    c->SetZeroAll();
+
+    /* call SingleQueryAttention function */
+    _SingleQueryAttention(q, key, value, index, 2, 1, 1.0F, c);
+    cUser = SingleQueryAttention(*q, *key, *value, index, 2, 1, 1.0F);
+
+    /* check results */
+    cpuTest = _CheckData(c, answer, 4, 1e-4F) && _CheckData(&cUser, answer, 4, 1e-4F);
+
+    /* destroy variables */
+    delete q;
+    delete key;
+    delete value;
+    delete c;
+
+    return cpuTest;
+}
+
+/*
+case 2: single-query attention with multiple heads on random data.
+In this case, q=(6, 1, 16) with 4 heads, the buffers are (5, 8, 16) and
+3 steps are used. The result is compared with the attention computed
+head by head from the gathered keys and values.
+*/
+bool TestSingleQueryAttention2()
+{
+    int queryNum = 6;
+    int rowNum = 8;
+    int maxLen = 5;
+    int len = 3;
+    int dim = 16;
+    int headNum = 4;
+    int headDim = dim / headNum;
+    DTYPE scale = 1.0F / (DTYPE)sqrt((DTYPE)headDim);
+
+    int qDimSize[3] = {queryNum, 1, dim};
+    int bufDimSize[3] = {maxLen, rowNum, dim};
+
+    XTensor * q = NewTensorV2(3, qDimSize);
+    XTensor * key = NewTensorV2(3, bufDimSize);
+    XTensor * value = NewTensorV2(3, bufDimSize);
+    XTensor * c = NewTensorV2(3, qDimSize);
+    DTYPE * answer = new DTYPE[queryNum * dim];
+    int * index = new int[len * rowNum];
+
+    q->SetDataRand(-1.0F, 1.0F);
+    key->SetDataRand(-1.0F, 1.0F);
+    value->SetDataRand(-1.0F, 1.0F);
+
+    /* the rows are shuffled from step to step, as beam search does */
+    for (int t = 0; t < len; t++) {
+        for (int i = 0; i < rowNum; i++)
+            index[t * rowNum + i] = (i * 3 + t) % rowNum;
+    }
+
+    DTYPE * qp = (DTYPE*)q->data;
+    DTYPE * kp = (DTYPE*)key->data;
+    DTYPE * vp = (DTYPE*)value->data;
+
+    /* the reference implementation */
+    for (int i = 0; i < queryNum; i++) {
+        for (int h = 0; h < headNum; h++) {
+            DTYPE score[3];
+            DTYPE sum = 0;
+            for (int t = 0; t < len; t++) {
+                int row = index[t * rowNum + i];
+                DTYPE dot = 0;
+                for (int p = 0; p < headDim; p++)
+                    dot += qp[i * dim + h * headDim + p] * kp[(t * rowNum + row) * dim + h * headDim + p];
+                score[t] = (DTYPE)exp(dot * scale);
+                sum += score[t];
+            }
+            for (int p = 0; p < headDim; p++) {
+                DTYPE r = 0;
+                for (int t = 0; t < len; t++) {
+                    int row = index[t * rowNum + i];
+                    r += score[t] / sum * vp[(t * rowNum + row) * dim + h * headDim + p];
+                }
+                answer[i * dim + h * headDim + p] = r;
+            }
+        }
+    }
+
+    /* call SingleQueryAttention function */
+    _SingleQueryAttention(q, key, value, index, len, headNum, scale, c);
+    bool cpuTest = _CheckData(c, answer, queryNum * dim, 1e-4F);
+
+    /* and with multiple threads */
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+    c->SetZeroAll();
+    _SingleQueryAttention(q, key, value, index, len, headNum, scale, c, runner);
+    cpuTest = _CheckData(c, answer, queryNum * dim, 1e-4F) && cpuTest;
+
+    /* destroy variables */
+    delete runner;
+    delete q;
+    delete key;
+    delete value;
+    delete c;
+    delete[] answer;
+    delete[] index;
+
+    return cpuTest;
+}
+
+/*
+case 3: single-query attention with the steps that a query has no key.
+In this case, q=(2, 1, 2), the buffers are (2, 2, 2) and the second query
+starts at step 1 (its index is -1 at step 0) -> c=(2, 1, 2).
+*/
+bool TestSingleQueryAttention3()
+{
+    int qDimSize[3] = {2, 1, 2};
+    int bufDimSize[3] = {2, 2, 2};
+
+    DTYPE qData[2][1][2] = { { {1.0F, 0.0F} },
+                             { {1.0F, 1.0F} } };
+    DTYPE keyData[2][2][2] = { { {0.0F, 0.0F}, {5.0F, 5.0F} },
+                               { {1.0986123F, 0.0F}, {0.0F, 0.0F} } };
+    DTYPE valueData[2][2][2] = { { {4.0F, 0.0F}, {9.0F, 9.0F} },
+                                 { {0.0F, 8.0F}, {6.0F, 6.0F} } };
+    int index[4] = {0, -1, 0, 1};
+    DTYPE answer[2][1][2] = { { {1.0F, 6.0F} },
+                              { {6.0F, 6.0F} } };
+
+    /* CPU test */
+    bool cpuTest = true;
+
+    /* create tensors */
+    XTensor * q = NewTensorV2(3, qDimSize);
+    XTensor * key = NewTensorV2(3, bufDimSize);
+    XTensor * value = NewTensorV2(3, bufDimSize);
+    XTensor * c = NewTensorV2(3, qDimSize);
+
+    /* initialize variables */
+    q->SetData(qData, 4);
+    key->SetData(keyData, 8);
+    value->SetData(valueData, 8);
+    c->SetZeroAll();
+
+    /* call SingleQueryAttention function */
+    _SingleQueryAttention(q, key, value, index, 2, 1, 1.0F, c);
+
+    /* check results */
+    cpuTest = _CheckData(c, answer, 4, 1e-4F);
+
+    /* destroy variables */
+    delete q;
+    delete key;
+    delete value;
+    delete c;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for SingleQueryAttention Function */
+bool TestSingleQueryAttention()
+{
+    XPRINT(0, stdout, "[TEST SingleQueryAttention] single-query attention over cached keys and values \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestSingleQueryAttention1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestSingleQueryAttention2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestSingleQueryAttention3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,196 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include <math.h>
+#include "../core/utilities/CheckData.h"
+#include "TSoftmaxKernel.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/*
+the softmax (or log-softmax) of the rows of x in double precision, clipped
+as _Softmax and _LogSoftmax do
+*/
+static void SoftmaxKernelAnswer(const DTYPE * x, DTYPE * y, int rowNum, int n, bool isLog)
+{
+    for (int r = 0; r < rowNum; r++) {
+        const DTYPE * xr = x + r * n;
+        DTYPE * yr = y + r * n;
+        double max = xr[0];
+        for (int i = 1; i < n; i++)
+            max = MAX(max, (double)xr[i]);
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += exp(xr[i] - max);
+        for (int i = 0; i < n; i++) {
+            if (isLog)
+                yr[i] = (DTYPE)MAX(xr[i] - max - log(sum), (double)LOGPROB_MIN);
+            else
+                yr[i] = (DTYPE)(exp(xr[i] - max) / sum);
+        }
+    }
+}
+
+/*
+case 1: softmax and log-softmax along the last dimension.
+The rows have different lengths (including those shorter than a SIMD
+register and those with a tail), and the results of the default runner
+and a runner of 2 threads are compared with the answer.
+*/
+bool TestSoftmaxKernel1()
+{
+    int lengths[5] = {1, 5, 8, 37, 1000};
+    int rowNum = 6;
+    bool cpuTest = true;
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(2);
+
+    for (int l = 0; l < 5; l++) {
+        int n = lengths[l];
+        int dimSize[2] = {rowNum, n};
+
+        XTensor * x = NewTensorV2(2, dimSize);
+        XTensor * y = NewTensorV2(2, dimSize);
+        XTensor * answer = NewTensorV2(2, dimSize);
+
+        /* the last row has large values and a large range */
+        x->SetDataRand(-4.0F, 4.0F);
+        DTYPE * xp = (DTYPE*)x->data;
+        for (int i = 0; i < n; i++)
+            xp[(rowNum - 1) * n + i] = (DTYPE)(i % 7) * 30.0F - 100.0F;
+
+        for (int isLog = 0; isLog < 2; isLog++) {
+            SoftmaxKernelAnswer(xp, (DTYPE*)answer->data, rowNum, n, isLog == 1);
+
+            y->SetZeroAll();
+            _SoftmaxLastDimCPU(x, y, isLog == 1);
+            cpuTest = _CheckData(y, answer->data, rowNum * n, 1e-4F) && cpuTest;
+
+            y->SetZeroAll();
+            _SoftmaxLastDimCPU(x, y, isLog == 1, runner);
+            cpuTest = _CheckData(y, answer->data, rowNum * n, 1e-4F) && cpuTest;
+        }
+
+        /* the max and the sum of a row */
+        DTYPE max = 0;
+        DTYPE sum = 0;
+        _RowMaxExpSumCPU(xp, n, &max, &sum);
+        double maxAnswer = xp[0];
+        for (int i = 1; i < n; i++)
+            maxAnswer = MAX(maxAnswer, (double)xp[i]);
+        double sumAnswer = 0;
+        for (int i = 0; i < n; i++)
+            sumAnswer += exp(xp[i] - maxAnswer);
+        cpuTest = max == (DTYPE)maxAnswer && _RowMaxCPU(xp, n) == (DTYPE)maxAnswer &&
+                  fabs(sum - sumAnswer) < 1e-4 * sumAnswer && cpuTest;
+
+        delete x;
+        delete y;
+        delete answer;
+    }
+
+    delete runner;
+
+    return cpuTest;
+}
+
+/*
+case 2: softmax and log-softmax along the last dimension on the shapes
+of attention weights (batch * heads * length, length) and of the output
+layer (batch * beam, vocabulary size).
+*/
+bool TestSoftmaxKernel2()
+{
+    int shapes[2][2] = { {512, 64}, {16, 8000} };
+    bool cpuTest = true;
+
+    for (int s = 0; s < 2; s++) {
+        int rowNum = shapes[s][0];
+        int n = shapes[s][1];
+
+        XTensor * x = NewTensorV2(2, shapes[s]);
+        XTensor * y = NewTensorV2(2, shapes[s]);
+        XTensor * answer = NewTensorV2(2, shapes[s]);
+        x->SetDataRand(-8.0F, 8.0F);
+
+        for (int isLog = 0; isLog < 2; isLog++) {
+            SoftmaxKernelAnswer((DTYPE*)x->data, (DTYPE*)answer->data, rowNum, n, isLog == 1);
+
+            y->SetZeroAll();
+            _SoftmaxLastDimCPU(x, y, isLog == 1);
+            cpuTest = _CheckData(y, answer->data, rowNum * n, 1e-4F) && cpuTest;
+        }
+
+        delete x;
+        delete y;
+        delete answer;
+    }
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for SoftmaxKernel Function */
+bool TestSoftmaxKernel()
+{
+    XPRINT(0, stdout, "[TEST SoftmaxKernel] softmax and log-softmax along the last dimension on CPUs \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestSoftmaxKernel1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestSoftmaxKernel2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -0,0 +1,259 @@
+/* NiuTrans.Tensor - an open-source tensor library
+* Copyright (C) 2017, Natural Language Processing Lab, Northeastern University.
+* All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+* $Created by: NiuTrans Team 2026-10-16
+*/
+
+#include "../XPRunner.h"
+#include "../XGlobal.h"
+#include "../core/utilities/XMatrixSegment.h"
+#include "TThreadPool.h"
+
+namespace nts { // namespace nts(NiuTrans.Tensor)
+
+/* arguments of the test jobs */
+struct ThreadPoolTestArgs
+{
+    XThreadPool * pool;
+    int * data;
+    int colNum;
+};
+
+/* data[i] = 2 * i for the items [begin, end) */
+static void FillDouble(void * arg, int begin, int end)
+{
+    ThreadPoolTestArgs * p = (ThreadPoolTestArgs*)arg;
+    for (int i = begin; i < end; i++)
+        p->data[i] = 2 * i;
+}
+
+/* data[i][j] = i * colNum + j for the rows i in [begin, end) */
+static void FillRow(void * arg, int begin, int end)
+{
+    ThreadPoolTestArgs * p = (ThreadPoolTestArgs*)arg;
+    for (int i = begin; i < end; i++)
+        for (int j = 0; j < p->colNum; j++)
+            p->data[i * p->colNum + j] = i * p->colNum + j;
+}
+
+/* a parallel-for over the rows [begin, end), and each row is a nested parallel-for */
+static void FillRowsNested(void * arg, int begin, int end)
+{
+    ThreadPoolTestArgs * p = (ThreadPoolTestArgs*)arg;
+    for (int i = begin; i < end; i++) {
+        ThreadPoolTestArgs rowArgs;
+        rowArgs.pool = p->pool;
+        rowArgs.data = p->data + i * p->colNum;
+        rowArgs.colNum = p->colNum;
+        p->pool->ParallelFor(0, p->colNum, 16, FillDouble, &rowArgs);
+    }
+}
+
+/* a RunParallel2D job that fills its block with i * colNum + j */
+static void FillBlock(TensorList * args)
+{
+    IntList * indexArgs = (IntList*)args->GetItem(0);
+    TensorList * blockArgs = (TensorList*)args->GetItem(1);
+    ThreadPoolTestArgs * p = (ThreadPoolTestArgs*)blockArgs->GetItem(0);
+
+    for (int i = indexArgs->GetItem(0); i <= indexArgs->GetItem(2); i++)
+        for (int j = indexArgs->GetItem(1); j <= indexArgs->GetItem(3); j++)
+            p->data[i * p->colNum + j] += i * p->colNum + j + 1;
+}
+
+/*
+case 1: parallel-for.
+Each item i of an array is set to 2 * i with a pool of 3 workers, where
+the grain size is given or chosen by the pool.
+*/
+bool TestThreadPool1()
+{
+    int itemNum = 100003;
+    int * data = new int[itemNum];
+    bool cpuTest = true;
+
+    XThreadPool * pool = new XThreadPool();
+    pool->Init(3);
+
+    int grains[3] = {0, 1, 777};
+    for (int g = 0; g < 3; g++) {
+        for (int i = 0; i < itemNum; i++)
+            data[i] = -1;
+
+        ThreadPoolTestArgs args;
+        args.pool = pool;
+        args.data = data;
+        args.colNum = 0;
+        pool->ParallelFor(0, itemNum, grains[g], FillDouble, &args);
+
+        for (int i = 0; i < itemNum; i++) {
+            if (data[i] != 2 * i) {
+                cpuTest = false;
+                break;
+            }
+        }
+    }
+
+    delete pool;
+    delete[] data;
+
+    return cpuTest;
+}
+
+/*
+case 2: nested parallel-for.
+A parallel-for over 37 rows runs a parallel-for over the 1000 items
+of each row on the same pool.
+*/
+bool TestThreadPool2()
+{
+    int rowNum = 37;
+    int colNum = 1000;
+    int * data = new int[rowNum * colNum];
+    bool cpuTest = true;
+
+    XThreadPool * pool = new XThreadPool();
+    pool->Init(3);
+
+    for (int i = 0; i < rowNum * colNum; i++)
+        data[i] = -1;
+
+    ThreadPoolTestArgs args;
+    args.pool = pool;
+    args.data = data;
+    args.colNum = colNum;
+    pool->ParallelFor(0, rowNum, 1, FillRowsNested, &args);
+
+    for (int i = 0; i < rowNum && cpuTest; i++) {
+        for (int j = 0; j < colNum; j++) {
+            if (data[i * colNum + j] != 2 * j) {
+                cpuTest = false;
+                break;
+            }
+        }
+    }
+
+    /* the pool works without workers too */
+    pool->Stop();
+    pool->ParallelFor(0, rowNum, 0, FillRow, &args);
+
+    for (int i = 0; i < rowNum * colNum; i++) {
+        if (data[i] != i) {
+            cpuTest = false;
+            break;
+        }
+    }
+
+    delete pool;
+    delete[] data;
+
+    return cpuTest;
+}
+
+/*
+case 3: jobs of XPRunner.
+A matrix (300, 200) is segmented by RunParallel2D and each item is
+visited once by a runner of 4 threads.
+*/
+bool TestThreadPool3()
+{
+    int rowNum = 300;
+    int colNum = 200;
+    int * data = new int[rowNum * colNum];
+    bool cpuTest = true;
+
+    XPRunner * runner = new XPRunner();
+    runner->Init(4);
+
+    for (int i = 0; i < rowNum * colNum; i++)
+        data[i] = 0;
+
+    ThreadPoolTestArgs args;
+    args.pool = runner->pool;
+    args.data = data;
+    args.colNum = colNum;
+    RunParallel2D(runner, (void*)FillBlock, rowNum * colNum, rowNum, colNum, 1, &args);
+
+    for (int i = 0; i < rowNum * colNum; i++) {
+        if (data[i] != i + 1) {
+            cpuTest = false;
+            break;
+        }
+    }
+
+    delete runner;
+    delete[] data;
+
+    return cpuTest;
+}
+
+/* other cases */
+/*
+TODO!!
+*/
+
+/* test for the work-stealing thread pool */
+bool TestThreadPool()
+{
+    XPRINT(0, stdout, "[TEST ThreadPool] work-stealing thread pool \n");
+    bool returnFlag = true, caseFlag = true;
+
+    /* case 1 test */
+    caseFlag = TestThreadPool1();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 1 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 1 passed!\n");
+
+    /* case 2 test */
+    caseFlag = TestThreadPool2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestThreadPool3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
+    /* other cases test */
+    /*
+    TODO!!
+    */
+
+    if (returnFlag) {
+        XPRINT(0, stdout, ">> All Passed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> Failed!\n");
+
+    XPRINT(0, stdout, "\n");
+
+    return returnFlag;
+}
+
+} // namespace nts(NiuTrans.Tensor)
@@ -21,6 +21,8 @@
 
 #include "../XGlobal.h"
 #include "../XUtility.h"
+#include "../XArena.h"
+#include "../XTensor.h"
 #include "TXMem.h"
 
 namespace nts{ // namespace nts(NiuTrans.Tensor)
@@ -162,6 +164,118 @@ bool TestXMemCase1()
     return ok;
 }
 
+/* case 2: test memory pool class in the size-class mode */
+bool TestXMemCase2()
+{
+    bool ok = true;
+    int caseNum = 1000;
+    int blockSize = 16;
+    int testNum = caseNum * 10;
+
+    /* small chunks so that the arena has to grow */
+    XMem mem(-1, SIZE_CLASS, 4096, 1, 0);
+
+    srand(907);
+
+    int ** p = new int*[caseNum];
+    int * size = new int[caseNum];
+
+    for (int i = 0; i < caseNum; i++) {
+        p[i] = NULL;
+        size[i] = rand() % (200 * blockSize) + 1;
+    }
+
+    for (int i = 0; i < testNum; i++) {
+        int j = rand() % caseNum;
+
+        if (p[j] == NULL) {
+            p[j] = (int*)mem.Alloc(size[j] * sizeof(int));
+            if ((MTYPE)p[j] % ARENA_ALIGNMENT != 0)
+                ok = false;
+            for (int k = 0; k < size[j]; k++)
+                p[j][k] = j;
+        }
+        else {
+            for (int k = 0; k < size[j]; k++) {
+                if (p[j][k] != j)
+                    ok = false;
+            }
+            mem.Release(p[j], size[j] * sizeof(int), mem.GetSignature());
+            p[j] = NULL;
+        }
+    }
+
+    /* the buffer is used in a stack manner */
+    int * buf1 = (int*)mem.AllocBuf(-1, 100 * sizeof(int));
+    int * buf2 = (int*)mem.AllocBuf(-1, 1000 * sizeof(int));
+    if (buf1 == NULL || buf2 == NULL || buf1 == buf2)
+        ok = false;
+    mem.ReleaseBuf(-1, 1000 * sizeof(int));
+    mem.ReleaseBuf(-1, 100 * sizeof(int));
+
+    for (int i = 0; i < caseNum; i++) {
+        if (p[i] != NULL)
+            mem.Release(p[i], size[i] * sizeof(int), mem.GetSignature());
+    }
+
+    XArena * arena = mem.arena;
+    if (arena->usedSize != 0 || arena->allocNum != arena->releaseNum || arena->peakSize == 0)
+        ok = false;
+
+    /* all the pieces are freed at once, and the chunks are merged */
+    MTYPE signature = mem.GetSignature();
+    mem.Alloc(100);
+    mem.Clear();
+    if (arena->usedSize != 0 || arena->resetNum != 1 || mem.GetSignature() == signature)
+        ok = false;
+
+    /* a size class is never smaller than the request */
+    for (MTYPE s = 1; s < 1000000; s += 97) {
+        int c = XArena::GetClass(s);
+        MTYPE classSize = XArena::GetClassSize(c);
+        if (classSize < s || XArena::GetClass(classSize) != c || classSize % ARENA_ALIGNMENT != 0)
+            ok = false;
+    }
+
+    delete[] p;
+    delete[] size;
+
+    return ok;
+}
+
+/* case 3: test the memory pool of a thread */
+bool TestXMemCase3()
+{
+    bool ok = true;
+
+    XMem * mem = GMems.NewThreadMem(4096);
+    GMems.SetThreadMem(mem);
+
+    {
+        float data[6] = {1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F};
+        XTensor a;
+        InitTensor2D(&a, 2, 3, X_FLOAT, -1);
+        a.SetData(data, 6);
+
+        /* a new tensor and the result of an operation go to the pool of the thread */
+        XTensor b = a * 2.0F;
+        ok = ok && a.mem == mem && b.mem == mem;
+        ok = ok && b.Get2D(1, 2) == 12.0F;
+    }
+
+    GMems.SetThreadMem(NULL);
+
+    {
+        XTensor c;
+        InitTensor1D(&c, 4, X_FLOAT, -1);
+        ok = ok && c.mem != mem && c.mem == GMems.GetMem(-1);
+    }
+
+    ok = ok && mem->arena->usedSize == 0;
+
+    return ok;
+}
+
 /* test for memory pool class */
 bool TestXMem()
 {
@@ -180,6 +294,24 @@ bool TestXMem()
     else
         XPRINT(0, stdout, ">> case 1 passed!\n");
 
+    /* case 2 test */
+    caseFlag = TestXMemCase2();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 2 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 2 passed!\n");
+
+    /* case 3 test */
+    caseFlag = TestXMemCase3();
+    if (!caseFlag) {
+        returnFlag = false;
+        XPRINT(0, stdout, ">> case 3 failed!\n");
+    }
+    else
+        XPRINT(0, stdout, ">> case 3 passed!\n");
+
     if (returnFlag) {
         XPRINT(0, stdout, ">> All Passed!\n");
     }
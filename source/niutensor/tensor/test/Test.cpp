@@ -30,6 +30,8 @@ bool Test()
     XPRINT(0, stdout, "Testing the XTensor utilites ... \n\n");
     
     wrong = !TestAbsolute() || wrong;
+    wrong = !TestAdamUpdate() || wrong;
+    wrong = !TestAddNormalize() || wrong;
     wrong = !TestClip() || wrong;
     wrong = !TestCompare() || wrong;
     wrong = !TestConcatenate() || wrong;
@@ -46,8 +48,10 @@ bool Test()
     wrong = !TestMatrixMul() || wrong;
     wrong = !TestMatrixMul2D() || wrong;
     wrong = !TestMatrixMul2DParallel() || wrong;
+    wrong = !TestMatrixMulINT8() || wrong;
     wrong = !TestMatrixMulBatched() || wrong;
     wrong = !TestMerge() || wrong;
+    wrong = !TestMulAndShift() || wrong;
     wrong = !TestMultiply() || wrong;
     wrong = !TestMultiplyDim() || wrong;
     wrong = !TestNegate() || wrong;
@@ -66,6 +70,7 @@ bool Test()
     wrong = !TestSetData() || wrong;
     wrong = !TestSign() || wrong;
     wrong = !TestSin() || wrong;
+    wrong = !TestSingleQueryAttention() || wrong;
     wrong = !TestSort() || wrong;
     wrong = !TestSplit() || wrong;
     wrong = !TestSpread() || wrong;
@@ -73,6 +78,7 @@ bool Test()
     wrong = !TestSum() || wrong;
     wrong = !TestSumDim() || wrong;
     wrong = !TestTan() || wrong;
+    wrong = !TestThreadPool() || wrong;
     wrong = !TestTranspose() || wrong;
     wrong = !TestTopK() || wrong;
     wrong = !TestUnsqueeze() || wrong;
@@ -83,10 +89,12 @@ bool Test()
     wrong = !TestHardTanH() || wrong;
     wrong = !TestIdentity() || wrong;
     wrong = !TestLogSoftmax() || wrong;
+    wrong = !TestLogSoftmaxTopK() || wrong;
     wrong = !TestLoss() || wrong;
     wrong = !TestRectify() || wrong;
     wrong = !TestSigmoid() || wrong;
     wrong = !TestSoftmax() || wrong;
+    wrong = !TestSoftmaxKernel() || wrong;
 
     /* other test */
     /*
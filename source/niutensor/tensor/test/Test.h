@@ -23,6 +23,8 @@
 #define __TEST_H__
 
 #include "TAbsolute.h"
+#include "TAdamUpdate.h"
+#include "TAddNormalize.h"
 #include "TClip.h"
 #include "TCompare.h"
 #include "TConcatenate.h"
@@ -39,8 +41,10 @@
 #include "TMatrixMul.h"
 #include "TMatrixMul2D.h"
 #include "TMatrixMul2DParallel.h"
+#include "TMatrixMulINT8.h"
 #include "TMatrixMulBatched.h"
 #include "TMerge.h"
+#include "TMulAndShift.h"
 #include "TMultiply.h"
 #include "TMultiplyDim.h"
 #include "TNegate.h"
@@ -59,6 +63,7 @@
 #include "TSetData.h"
 #include "TSign.h"
 #include "TSin.h"
+#include "TSingleQueryAttention.h"
 #include "TSort.h"
 #include "TSplit.h"
 #include "TSpread.h"
@@ -66,6 +71,7 @@
 #include "TSum.h"
 #include "TSumDim.h"
 #include "TTan.h"
+#include "TThreadPool.h"
 #include "TTranspose.h"
 #include "TTopK.h"
 #include "TUnsqueeze.h"
@@ -76,10 +82,12 @@
 #include "THardTanH.h"
 #include "TIdentity.h"
 #include "TLogSoftmax.h"
+#include "TLogSoftmaxTopK.h"
 #include "TLoss.h"
 #include "TRectify.h"
 #include "TSigmoid.h"
 #include "TSoftmax.h"
+#include "TSoftmaxKernel.h"
 
 namespace nts { // namespace nts(NiuTrans.Tensor)
 
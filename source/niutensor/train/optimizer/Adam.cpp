@@ -168,31 +168,11 @@ void Adam::UpdateParam(XTensor * param, XTensor * grad, int pid)
     float e = lrate * (float)sqrt(1 - adamBeta2T) / (1 - adamBeta1T);
     float d = adamDelta * (float)sqrt(1 - adamBeta2T);
 
-    /* m = beta_1 * m + (1-beta_1) * grad */
-    XTensor * m = moments[pid];
-    _ScaleAndShiftMe(m, adamBeta1, 0);
-    _Sum(m, grad, m, (1.0F - adamBeta1));
-
-    /* v = beta_2 * v + (1-beta_2) * grad * grad*/
-    XTensor * v = moments2nd[pid];
-    _Multiply(grad, grad, v, adamBeta2 / (1.0F - adamBeta2));
-    _ScaleAndShiftMe(v, (1.0F - adamBeta2), 0);
-
-    /* allocate a piece of buffer memory */
-    GMems.GetMem(v->devID)->LockBuf();
-    XTensor* v2 = NewTensorBuf(v, v->devID);
-
-    /* v2 = m / (sqrt(v) + delta) */
-    _Power(v, v2, 0.5F);
-    _ScaleAndShiftMe(v2, 1.0F, d);
-    _Div(m, v2, v2);
-
-    /* the delta rule */
-    _Sum(param, v2, param, -e);
-
-    /* release a piece of buffer memory */
-    DelTensorBuf(v2);
-    GMems.GetMem(v->devID)->UnlockBuf();
+    /* m = beta_1 * m + (1-beta_1) * grad
+       v = beta_2 * v + (1-beta_2) * grad * grad
+       param = param - e * m / (sqrt(v) + d) */
+    _AdamUpdate(param, grad, moments[pid], moments2nd[pid],
+                adamBeta1, adamBeta2, e, d, 0, false);
 }
 
 }
@@ -0,0 +1,354 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "BatchPipeline.h"
+#include "DataSet.h"
+
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* constructor */
+template<typename T>
+HostBuffer<T>::HostBuffer()
+{
+    data = NULL;
+    capacity = 0;
+    pinned = false;
+}
+
+/* de-constructor */
+template<typename T>
+HostBuffer<T>::~HostBuffer()
+{
+    if (data == NULL)
+        return;
+#ifdef USE_CUDA
+    if (pinned) {
+        cudaFreeHost(data);
+        return;
+    }
+#endif
+    free(data);
+}
+
+/*
+make sure that the buffer can keep n items (the data is not kept)
+>> n - number of items
+*/
+template<typename T>
+void HostBuffer<T>::Reserve(size_t n)
+{
+    if (n <= capacity)
+        return;
+
+    size_t newCapacity = MAX(n, capacity * 2);
+    T * newData = NULL;
+
+#ifdef USE_CUDA
+    if (pinned) {
+        if (data != NULL)
+            cudaFreeHost(data);
+        CheckNTErrors(cudaMallocHost((void**)&newData, newCapacity * sizeof(T)) == cudaSuccess,
+                      "Cannot allocate the page-locked memory!");
+    }
+    else
+#endif
+    {
+        free(data);
+        newData = (T*)malloc(newCapacity * sizeof(T));
+        CheckNTErrors(newData != NULL, "Cannot allocate the batch buffer!");
+    }
+
+    data = newData;
+    capacity = newCapacity;
+}
+
+/*
+constructor
+>> pinned - use page-locked memory for the buffers
+*/
+BatchBuffer::BatchBuffer(bool pinned)
+{
+    ready = false;
+    maxSrcLen = 0;
+    maxTgtLen = 0;
+    srcWordNum = 0;
+    tgtWordNum = 0;
+    enc.pinned = pinned;
+    encPadding.pinned = pinned;
+    dec.pinned = pinned;
+    decPadding.pinned = pinned;
+    label.pinned = pinned;
+}
+
+/* constructor */
+BatchPipeline::BatchPipeline()
+{
+    dataset = NULL;
+    pad = 0;
+    eos = 0;
+    hasTarget = false;
+    pinned = false;
+    capacity = 1;
+    current = NULL;
+    toStop = false;
+}
+
+/* de-constructor */
+BatchPipeline::~BatchPipeline()
+{
+    Stop();
+    for (size_t i = 0; i < freeList.size(); i++)
+        delete freeList[i];
+    freeList.clear();
+}
+
+/*
+start the pipeline
+>> myDataset - the dataset that picks the samples of batches
+>> myPad - the padding symbol
+>> myEos - the end symbol (of the labels)
+>> myHasTarget - indicates whether the batches have targets
+>> workerNum - number of workers (the batches are made by the
+               consumer if it is 0)
+>> myCapacity - the maximum number of batches in the pipeline
+>> myPinned - use page-locked memory for the buffers
+*/
+void BatchPipeline::Start(DataSetBase * myDataset, int myPad, int myEos, bool myHasTarget,
+                          int workerNum, int myCapacity, bool myPinned)
+{
+    Stop();
+
+    dataset = myDataset;
+    pad = myPad;
+    eos = myEos;
+    hasTarget = myHasTarget;
+    pinned = myPinned;
+    capacity = workerNum > 0 ? MAX(myCapacity, 1) : 1;
+    toStop = false;
+
+    for (int i = 0; i < workerNum; i++)
+        workers.push_back(thread(&BatchPipeline::WorkerLoop, this));
+}
+
+/* stop the workers and drop the batches in the pipeline */
+void BatchPipeline::Stop()
+{
+    {
+        lock_guard<mutex> lock(pipeMutex);
+        toStop = true;
+    }
+    todoCond.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+
+    ReleaseCurrent();
+    while (!inFlight.empty()) {
+        freeList.push_back(inFlight.front());
+        inFlight.pop_front();
+    }
+    todo.clear();
+}
+
+/*
+get the next batch. The batches are planned until the pipeline is full,
+and then we wait for the first one. The batch can be used until the next
+call of this function.
+<< return - the batch (NULL if the dataset has no more batch)
+*/
+BatchBuffer * BatchPipeline::Next()
+{
+    ReleaseCurrent();
+
+    /* pick the samples of the next batches (on the calling thread) */
+    while ((int)inFlight.size() < capacity) {
+        BatchBuffer * batch = NULL;
+        {
+            lock_guard<mutex> lock(pipeMutex);
+            if (!freeList.empty()) {
+                batch = freeList.back();
+                freeList.pop_back();
+            }
+        }
+        if (batch == NULL)
+            batch = new BatchBuffer(pinned);
+
+        batch->samples.clear();
+        batch->ready = false;
+
+        if (!dataset->PlanBatch(batch)) {
+            lock_guard<mutex> lock(pipeMutex);
+            freeList.push_back(batch);
+            break;
+        }
+
+        if (workers.empty()) {
+            Fill(batch, pad, eos, hasTarget);
+            batch->ready = true;
+            inFlight.push_back(batch);
+            continue;
+        }
+
+        {
+            lock_guard<mutex> lock(pipeMutex);
+            inFlight.push_back(batch);
+            todo.push_back(batch);
+        }
+        todoCond.notify_one();
+    }
+
+    if (inFlight.empty())
+        return NULL;
+
+    /* wait for the first batch */
+    BatchBuffer * batch = inFlight.front();
+    {
+        unique_lock<mutex> lock(pipeMutex);
+        readyCond.wait(lock, [batch] { return batch->ready; });
+    }
+    inFlight.pop_front();
+
+    current = batch;
+    return batch;
+}
+
+/* check whether there are batches in the pipeline */
+bool BatchPipeline::HasPending()
+{
+    return !inFlight.empty();
+}
+
+/* the loop of a worker */
+void BatchPipeline::WorkerLoop()
+{
+    while (true) {
+        BatchBuffer * batch = NULL;
+        {
+            unique_lock<mutex> lock(pipeMutex);
+            todoCond.wait(lock, [this] { return toStop || !todo.empty(); });
+            if (toStop)
+                return;
+            batch = todo.front();
+            todo.pop_front();
+        }
+
+        Fill(batch, pad, eos, hasTarget);
+
+        {
+            lock_guard<mutex> lock(pipeMutex);
+            batch->ready = true;
+        }
+        readyCond.notify_all();
+    }
+}
+
+/* release the batch that is used by the consumer */
+void BatchPipeline::ReleaseCurrent()
+{
+    if (current == NULL)
+        return;
+
+    lock_guard<mutex> lock(pipeMutex);
+    freeList.push_back(current);
+    current = NULL;
+}
+
+/*
+fill the buffers of a batch. The source sequences are padded on the right.
+For the target, the decoder input begins with SOS and the labels end with
+EOS (both are padded on the right).
+>> batch - the batch
+>> pad - the padding symbol
+>> eos - the end symbol (of the labels)
+>> hasTarget - indicates whether the batch has targets
+*/
+void BatchPipeline::Fill(BatchBuffer * batch, int pad, int eos, bool hasTarget)
+{
+    int sentNum = (int)batch->samples.size();
+
+    batch->maxSrcLen = 0;
+    batch->maxTgtLen = 0;
+    batch->srcWordNum = 0;
+    batch->tgtWordNum = 0;
+    for (int i = 0; i < sentNum; i++) {
+        const BatchSample & sample = batch->samples[i];
+        batch->maxSrcLen = MAX(batch->maxSrcLen, sample.srcLen);
+        batch->maxTgtLen = MAX(batch->maxTgtLen, sample.tgtLen);
+        batch->srcWordNum += sample.srcLen;
+        batch->tgtWordNum += sample.tgtLen;
+    }
+
+    int maxSrcLen = batch->maxSrcLen;
+    batch->enc.Reserve((size_t)sentNum * maxSrcLen);
+    batch->encPadding.Reserve((size_t)sentNum * maxSrcLen);
+
+    for (int i = 0; i < sentNum; i++) {
+        const BatchSample & sample = batch->samples[i];
+        int * enc = batch->enc.data + (size_t)i * maxSrcLen;
+        float * encPadding = batch->encPadding.data + (size_t)i * maxSrcLen;
+
+        memcpy(enc, sample.src, sizeof(int) * sample.srcLen);
+        for (int j = 0; j < sample.srcLen; j++)
+            encPadding[j] = 1.0F;
+        for (int j = sample.srcLen; j < maxSrcLen; j++) {
+            enc[j] = pad;
+            encPadding[j] = 0;
+        }
+    }
+
+    if (!hasTarget)
+        return;
+
+    int maxTgtLen = batch->maxTgtLen;
+    batch->dec.Reserve((size_t)sentNum * maxTgtLen);
+    batch->decPadding.Reserve((size_t)sentNum * maxTgtLen);
+    batch->label.Reserve((size_t)sentNum * maxTgtLen);
+
+    for (int i = 0; i < sentNum; i++) {
+        const BatchSample & sample = batch->samples[i];
+        int * dec = batch->dec.data + (size_t)i * maxTgtLen;
+        float * decPadding = batch->decPadding.data + (size_t)i * maxTgtLen;
+        int * label = batch->label.data + (size_t)i * maxTgtLen;
+
+        memcpy(dec, sample.tgt, sizeof(int) * sample.tgtLen);
+        if (sample.tgtLen > 1)
+            memcpy(label, sample.tgt + 1, sizeof(int) * (sample.tgtLen - 1));
+        label[sample.tgtLen - 1] = eos;
+        for (int j = 0; j < sample.tgtLen; j++)
+            decPadding[j] = 1.0F;
+        for (int j = sample.tgtLen; j < maxTgtLen; j++) {
+            dec[j] = pad;
+            label[j] = pad;
+            decPadding[j] = 0;
+        }
+    }
+}
+
+template struct HostBuffer<int>;
+template struct HostBuffer<float>;
+
+} /* end of the nmt namespace */
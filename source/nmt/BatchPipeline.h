@@ -0,0 +1,195 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The batch pipeline prepares mini-batches in the background. The thread
+ * that consumes the batches picks the samples of the next few batches (so
+ * that the order of batches and the use of random numbers do not depend on
+ * the workers), and the workers fill the token ids and the paddings of each
+ * batch into reusable host buffers. The consumer only copies a ready batch
+ * into tensors, so the data preparation runs behind the model computation.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __BATCHPIPELINE_H__
+#define __BATCHPIPELINE_H__
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+using namespace std;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+class DataSetBase;
+
+/* a buffer on the host (in page-locked memory if the batches go to GPUs) */
+template<typename T>
+struct HostBuffer
+{
+    /* the data */
+    T * data;
+
+    /* number of items that the buffer can keep */
+    size_t capacity;
+
+    /* indicates whether the memory is page-locked */
+    bool pinned;
+
+    /* constructor */
+    HostBuffer();
+
+    /* de-constructor */
+    ~HostBuffer();
+
+    /* make sure that the buffer can keep n items */
+    void Reserve(size_t n);
+};
+
+/* a sample of a batch (the tokens are owned by the dataset) */
+struct BatchSample
+{
+    /* source tokens */
+    const int * src;
+
+    /* source sentence length */
+    int srcLen;
+
+    /* target tokens (NULL for translation) */
+    const int * tgt;
+
+    /* target sentence length */
+    int tgtLen;
+
+    /* index of the sample */
+    int index;
+};
+
+/* a batch in the pipeline */
+struct BatchBuffer
+{
+    /* the samples (picked by the consumer) */
+    vector<BatchSample> samples;
+
+    /* indicates whether the buffers are filled */
+    bool ready;
+
+    /* the maximum source and target sentence length */
+    int maxSrcLen;
+    int maxTgtLen;
+
+    /* number of source and target tokens */
+    int srcWordNum;
+    int tgtWordNum;
+
+    /* the encoder input and its padding (sentNum * maxSrcLen) */
+    HostBuffer<int> enc;
+    HostBuffer<float> encPadding;
+
+    /* the decoder input, its padding and the labels (sentNum * maxTgtLen) */
+    HostBuffer<int> dec;
+    HostBuffer<float> decPadding;
+    HostBuffer<int> label;
+
+    /* constructor */
+    BatchBuffer(bool pinned);
+};
+
+/* the pipeline of batches */
+class BatchPipeline
+{
+private:
+    /* the dataset that picks the samples of batches */
+    DataSetBase * dataset;
+
+    /* the padding symbol */
+    int pad;
+
+    /* the end symbol (of the labels) */
+    int eos;
+
+    /* indicates whether the batches have targets (for training) */
+    bool hasTarget;
+
+    /* indicates whether the buffers are page-locked */
+    bool pinned;
+
+    /* the maximum number of batches in the pipeline */
+    int capacity;
+
+    /* the workers */
+    vector<thread> workers;
+
+    /* batches in the order of use */
+    deque<BatchBuffer*> inFlight;
+
+    /* batches that wait for a worker */
+    deque<BatchBuffer*> todo;
+
+    /* batches that can be reused */
+    vector<BatchBuffer*> freeList;
+
+    /* the batch that is used by the consumer */
+    BatchBuffer * current;
+
+    /* a lock and the conditions of the pipeline */
+    mutex pipeMutex;
+    condition_variable todoCond;
+    condition_variable readyCond;
+
+    /* indicates whether the workers should stop */
+    bool toStop;
+
+public:
+    /* constructor */
+    BatchPipeline();
+
+    /* de-constructor */
+    ~BatchPipeline();
+
+    /* start the pipeline */
+    void Start(DataSetBase * myDataset, int myPad, int myEos, bool myHasTarget,
+               int workerNum, int myCapacity, bool myPinned);
+
+    /* stop the workers and drop the batches in the pipeline */
+    void Stop();
+
+    /* get the next batch (NULL if there is no more batch) */
+    BatchBuffer * Next();
+
+    /* check whether there are batches in the pipeline */
+    bool HasPending();
+
+    /* fill the buffers of a batch */
+    static void Fill(BatchBuffer * batch, int pad, int eos, bool hasTarget);
+
+private:
+    /* the loop of a worker */
+    void WorkerLoop();
+
+    /* release the batch that is used by the consumer */
+    void ReleaseCurrent();
+};
+
+} /* end of the nmt namespace */
+
+#endif /* __BATCHPIPELINE_H__ */
@@ -151,6 +151,7 @@ void TrainingConfig::Load(int argsNum, const char **args)
 
     LoadBool("adam", &useAdam, true);
     LoadBool("resetoptimizer", &resetOptimizer, false);
+    LoadBool("asyncsave", &asyncSave, true);
 
     LoadInt("nepoch", &nepoch, 50);
     LoadInt("nstep", &nstep, 100000);
@@ -181,6 +182,17 @@ void TranslationConfig::Load(int argsNum, const char** args)
     LoadInt("maxlen", &maxLen, 1024);
     LoadFloat("lenalpha", &lenAlpha, 1.0F);
     LoadFloat("maxlenalpha", &maxLenAlpha, 0.0F);
+    LoadBool("serve", &serve, false);
+    LoadInt("port", &port, 0);
+    LoadInt("maxlatency", &maxLatency, 10);
+    LoadString("shortlist", shortlistFN, "");
+    LoadInt("shortlisttopn", &shortlistTopN, 100);
+    LoadInt("shortlisttransn", &shortlistTransN, 100);
+    LoadBool("arena", &useArena, true);
+    LoadInt("nworker", &workerNum, 1);
+    LoadBool("continuous", &continuousBatching, false);
+    LoadInt("cachesize", &cacheSize, 0);
+    LoadString("cachefile", cacheFN, "");
 }
 
 /* load training configuration from the command */
@@ -197,7 +209,21 @@ void CommonConfig::Load(int argsNum, const char** args)
     LoadInt("bufsize", &bufSize, 2000000);
     LoadInt("bucketsize", &bucketSize, wBatchSize);
     LoadInt("loginterval", &logInterval, 100);
+    LoadInt("nthread", &nthread, 1);
+    LoadBool("pincore", &pinCore, false);
+    LoadInt("prefetch", &prefetchThreadNum, 1);
+    LoadInt("prefetchbatch", &prefetchBatchNum, 4);
     LoadBool("fp16", &useFP16, false);
+    LoadBool("int8", &useINT8, false);
+    LoadBool("packweights", &packWeights, false);
+    LoadBool("mergeqkv", &mergeQKV, false);
+    LoadBool("benchmark", &benchmark, false);
+
+    /* the model file is mapped into the memory unless it is disabled */
+    bool noMMap = false;
+    LoadBool("nommap", &noMMap, false);
+    useMMap = !noMMap;
+    LoadBool("verifymodel", &verifyModel, false);
 }
 
 /* 
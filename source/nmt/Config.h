@@ -87,6 +87,9 @@ public:
        resuming training from previous checkpoints */
     bool resetOptimizer;
 
+    /* indicates whether the checkpoints are written in the background */
+    bool asyncSave;
+
     /* hyper parameters of Adam */
     float adamBeta1;
     float adamBeta2;
@@ -128,6 +131,39 @@ public:
     /* max length of the generated sequence */
     int maxLen;
 
+    /* indicates whether the system runs as a server that translates lines from stdin */
+    bool serve;
+
+    /* the local port the server listens on (0 for the stdin mode) */
+    int port;
+
+    /* the maximum time (in milliseconds) that a request waits for its batch */
+    int maxLatency;
+
+    /* path to the lexical table for the vocabulary shortlist (empty for the full vocabulary) */
+    char shortlistFN[MAX_PATH_LEN];
+
+    /* the number of the most frequent target words that are always in the shortlist */
+    int shortlistTopN;
+
+    /* the number of translations of each source word that are put into the shortlist */
+    int shortlistTransN;
+
+    /* indicates whether the tensors of a batch are kept in a size-class pool of the thread (on CPUs) */
+    bool useArena;
+
+    /* number of threads that translate different batches with the same model (on CPUs) */
+    int workerNum;
+
+    /* indicates whether new sentences join the batch as soon as others are done (beam search on CPUs) */
+    bool continuousBatching;
+
+    /* the maximum number of translations in the translation cache (0 for no cache) */
+    int cacheSize;
+
+    /* the file that keeps the translation cache across runs */
+    char cacheFN[MAX_PATH_LEN];
+
 public:
     /* load configuration from the command */
     void Load(int argsNum, const char** args);
@@ -278,6 +314,37 @@ public:
     /* indicates whether the model is running with FP16 data type */
     bool useFP16;
 
+    /* indicates whether the model is running with INT8 weights (CPU inference only) */
+    bool useINT8;
+
+    /* indicates whether the weights are packed for the matrix multiplication at load time (CPU inference only) */
+    bool packWeights;
+
+    /* indicates whether the transformation matrices of Q, K and V are merged at load time (inference only) */
+    bool mergeQKV;
+
+    /* run the micro-benchmarks of the tensor operators */
+    bool benchmark;
+
+    /* number of threads for the CPU operations */
+    int nthread;
+
+    /* indicates whether the threads are pinned to cores (linux only) */
+    bool pinCore;
+
+    /* number of threads that prepare batches in the background */
+    int prefetchThreadNum;
+
+    /* the maximum number of batches that are prepared in advance */
+    int prefetchBatchNum;
+
+    /* indicates whether the model file is mapped into the memory (CPU inference only) */
+    bool useMMap;
+
+    /* indicates whether the checksums of the tensors are checked even if the
+       model file is mapped into the memory */
+    bool verifyModel;
+
 public:
     /* load configuration from the command */
     void Load(int argsNum, const char** args);
@@ -116,6 +116,8 @@ DataSetBase::DataSetBase()
 /* de-constructor */
 DataSetBase::~DataSetBase()
 {
+    pipeline.Stop();
+
     if (buf != NULL) {
         ClearBuf();
         delete buf;
@@ -26,6 +26,7 @@
 #define __DATASET_H__
 
 #include "Config.h"
+#include "BatchPipeline.h"
 #include "../niutensor/train/XBaseTemplate.h"
 
 using namespace std;
@@ -74,6 +75,9 @@ public:
     /* the configuration of NMT system */
     NMTConfig* config;
 
+    /* the pipeline that prepares batches in the background */
+    BatchPipeline pipeline;
+
 public:
     /* get the maximum source sentence length in a range of buffer */
     int MaxSrcLen(int begin, int end);
@@ -116,6 +120,10 @@ public:
     virtual
     bool GetBatchSimple(XList* inputs, XList* golds = NULL) = 0;
 
+    /* pick the samples of the next batch (for the batch pipeline) */
+    virtual
+    bool PlanBatch(BatchBuffer* batch) = 0;
+
     /* de-constructor */
     ~DataSetBase();
 };
@@ -34,16 +34,6 @@ void AttDecoder::SetTrainingFlag(bool myIsTraining)
 {
     isTraining = myIsTraining;
 
-    /* disable caching during training */
-    if (isTraining) {
-        for (int i = 0; i < nlayer; i++) {
-            if (selfAttCache != NULL)
-                selfAttCache[i].enabled = false;
-            if (enDeAttCache != NULL)
-                enDeAttCache[i].enabled = false;
-        }
-    }
-
     for (int i = 0; i < nlayer; i++) {
         if (ffns != NULL)
             ffns[i].SetTrainingFlag(myIsTraining);
@@ -99,8 +89,6 @@ AttDecoder::AttDecoder()
     embedder = NULL;
     selfAtts = NULL;
     enDeAtts = NULL;
-    selfAttCache = NULL;
-    enDeAttCache = NULL;
     ffnLayerNorms = NULL;
     decoderLayerNorm = NULL;
     selfAttLayerNorms = NULL;
@@ -112,8 +100,6 @@ AttDecoder::~AttDecoder()
 {
     delete[] selfAtts;
     delete[] enDeAtts;
-    delete[] selfAttCache;
-    delete[] enDeAttCache;
     delete[] ffnLayerNorms;
     delete[] enDeAttLayerNorms;
     delete[] selfAttLayerNorms;
@@ -153,8 +139,6 @@ void AttDecoder::InitModel(NMTConfig& config)
         ffns = new FFN[nlayer];
     selfAtts = new Attention[nlayer];
     enDeAtts = new Attention[nlayer];
-    selfAttCache = new Cache[nlayer];
-    enDeAttCache = new Cache[nlayer];
     ffnLayerNorms = new LayerNorm[nlayer];
     selfAttLayerNorms = new LayerNorm[nlayer];
     enDeAttLayerNorms = new LayerNorm[nlayer];
@@ -200,6 +184,10 @@ XTensor AttDecoder::Make(XTensor& inputDec, XTensor& outputEnc,
     if (useHistory)
         history->ClearHistory();
 
+    /* the whole sequence is computed at once, so the keys and values are not cached */
+    Cache noCache;
+    noCache.enabled = false;
+
     XTensor x;
     x = embedder->Make(inputDec, true, nstep);
 
@@ -231,7 +219,7 @@ XTensor AttDecoder::Make(XTensor& inputDec, XTensor& outputEnc,
         /******************/
         /* self attention */
         att = selfAtts[i].Make(selfAttnBefore, selfAttnBefore, selfAttnBefore, 
-                               mask, &selfAttCache[i], SELF_ATT);
+                               mask, &noCache, SELF_ATT);
 
         /* dropout */
         if (isTraining && dropoutP > 0)
@@ -248,7 +236,7 @@ XTensor AttDecoder::Make(XTensor& inputDec, XTensor& outputEnc,
 
         /* encoder-decoder attention */
         ende = enDeAtts[i].Make(outputEnc, endeAttnBefore, outputEnc, maskEncDec, 
-                                &enDeAttCache[i], EN_DE_ATT);
+                                &noCache, EN_DE_ATT);
 
         /* dropout */
         if (isTraining && dropoutP > 0)
@@ -300,25 +288,28 @@ run decoding for inference with pre-norm
 >> mask - mask that indicates which position is valid
 >> maskEncDec - mask for the encoder-decoder attention
 >> nstep - the current length of the decoder input
+>> selfAttCache - the caches of self-attention (one for each layer)
+>> enDeAttCache - the caches of encoder-decoder attention (one for each layer)
+>> steps - the step of each sequence, (B) (NULL if all the sequences are at step nstep)
 << return - the output tensor of the decoder
 */
-XTensor AttDecoder::RunFastPreNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep)
+XTensor AttDecoder::RunFastPreNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep,
+                                   Cache* selfAttCache, Cache* enDeAttCache, XTensor* steps)
 {
-    /* clear the history */
-    if (useHistory)
-        history->ClearHistory();
+    /* the history of layers (it is kept here as the module is shared in inference) */
+    History* layers = useHistory ? new History : NULL;
 
     XTensor x;
 
-    x = embedder->Make(inputDec, true, nstep);
+    x = embedder->Make(inputDec, true, nstep, steps);
 
     if (useHistory)
-        history->Add(x);
+        history->Add(x, *layers);
 
     for (int i = 0; i < nlayer; i++) {
 
         if (useHistory)
-            x = history->Pop();
+            x = history->Pop(*layers);
 
         XTensor xn;
 
@@ -328,39 +319,30 @@ XTensor AttDecoder::RunFastPreNorm(XTensor& inputDec, XTensor& outputEnc, XTenso
         /* self attention */
         xn = selfAtts[i].Make(xn, xn, xn, NULL, &selfAttCache[i], SELF_ATT);
 
-        /* residual connection */
-        SumMe(xn, x);
-
-        /* layer normalization with pre-norm for encoder-decoder attention */
-        x = enDeAttLayerNorms[i].Run(xn);
+        /* residual connection and layer normalization with pre-norm for encoder-decoder attention */
+        x = enDeAttLayerNorms[i].Run(xn, x);
 
         /* encoder-decoder attention */
         x = enDeAtts[i].Make(outputEnc, x, outputEnc, maskEncDec,
                              &enDeAttCache[i], EN_DE_ATT);
 
-        /* residual connection */
-        SumMe(x, xn);
-
-        /* layer normalization with pre-norm for ffn */
-        xn = ffnLayerNorms[i].Run(x);
+        /* residual connection and layer normalization with pre-norm for ffn */
+        xn = ffnLayerNorms[i].Run(x, xn);
 
-        /* ffn */
+        /* ffn and residual connection */
         if (ffns != NULL)
-            xn = ffns[i].Make(xn);
-
-        /* residual connection */
-        SumMe(x, xn);
+            x = ffns[i].Make(xn, x);
+        else
+            SumMe(x, xn);
 
         if (useHistory)
-            history->Add(x);
+            history->Add(x, *layers);
     }
 
-    if (useHistory)
-        x = history->Pop();
-
-    /* clear the history while not training */
-    if (useHistory && !isTraining)
-        history->ClearHistory();
+    if (useHistory) {
+        x = history->Pop(*layers);
+        delete layers;
+    }
 
     if (finalNorm)
         return decoderLayerNorm->Run(x);
@@ -375,74 +357,65 @@ run decoding for inference with post-norm
 >> mask - mask that indicates which position is valid
 >> maskEncDec - mask for the encoder-decoder attention
 >> nstep - the current length of the decoder input
+>> selfAttCache - the caches of self-attention (one for each layer)
+>> enDeAttCache - the caches of encoder-decoder attention (one for each layer)
+>> steps - the step of each sequence, (B) (NULL if all the sequences are at step nstep)
 << return - the output tensor of the decoder
 */
-XTensor AttDecoder::RunFastPostNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep)
+XTensor AttDecoder::RunFastPostNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep,
+                                    Cache* selfAttCache, Cache* enDeAttCache, XTensor* steps)
 {
-    /* clear the history */
-    if (useHistory)
-        history->ClearHistory();
+    /* the history of layers (it is kept here as the module is shared in inference) */
+    History* layers = useHistory ? new History : NULL;
 
     XTensor x;
-    x = embedder->Make(inputDec, true, nstep);
+    x = embedder->Make(inputDec, true, nstep, steps);
 
     /* dropout */
     if (isTraining && dropoutP > 0)
         x = Dropout(x, dropoutP, /*inplace=*/isTraining);
 
     if (useHistory)
-        history->Add(x);
+        history->Add(x, *layers);
 
     for (int i = 0; i < nlayer; i++) {
 
         if (useHistory)
-            x = history->Pop();
+            x = history->Pop(*layers);
 
         XTensor att;
         XTensor ffn;
-        XTensor res;
         XTensor ende;
-        XTensor selfAttnAfter;
-        XTensor endeAttnAfter;
 
         /* self attention */
         att = selfAtts[i].Make(x, x, x, NULL, &selfAttCache[i], SELF_ATT);
 
-        /* residual connection */
-        res = Sum(att, x, /*inplace=*/false);
-
-        /* layer normalization with post-norm for self-attention */
-        selfAttnAfter = LN(res, selfAttLayerNorms[i], preLN, false, true);
+        /* residual connection and layer normalization with post-norm for self-attention */
+        selfAttLayerNorms[i].RunMe(att, x);
 
         /* encoder-decoder attention */
-        ende = enDeAtts[i].Make(outputEnc, selfAttnAfter, outputEnc, maskEncDec,
+        ende = enDeAtts[i].Make(outputEnc, att, outputEnc, maskEncDec,
                                 &enDeAttCache[i], EN_DE_ATT);
 
-        /* residual connection */
-        res = Sum(ende, selfAttnAfter, /*inplace=*/false);
-
-        /* layer normalization with post-norm for encoder-decoder attention */
-        endeAttnAfter = LN(res, enDeAttLayerNorms[i], preLN, false, true);
+        /* residual connection and layer normalization with post-norm for encoder-decoder attention */
+        enDeAttLayerNorms[i].RunMe(ende, att);
 
         /* ffn */
-        ffn = ffns[i].Make(endeAttnAfter);
+        ffn = ffns[i].Make(ende);
 
-        /* residual connection */
-        res = Sum(ffn, endeAttnAfter, /*inplace=*/false);
+        /* residual connection and layer normalization with post-norm for ffn */
+        ffnLayerNorms[i].RunMe(ffn, ende);
 
-        /* layer normalization with post-norm for ffn */
-        x = LN(res, ffnLayerNorms[i], preLN, false, true);
+        x = std::move(ffn);
 
         if (useHistory)
-            history->Add(x);
+            history->Add(x, *layers);
     }
 
-    if (useHistory)
-        x = history->Pop();
-
-    /* clear the history while not training */
-    if (useHistory && !isTraining)
-        history->ClearHistory();
+    if (useHistory) {
+        x = history->Pop(*layers);
+        delete layers;
+    }
 
     if (finalNorm)
         return decoderLayerNorm->Run(x);
@@ -450,4 +423,32 @@ XTensor AttDecoder::RunFastPostNorm(XTensor& inputDec, XTensor& outputEnc, XTens
     return x;
 }
 
+/*
+keep the encoder-decoder caches of some states and append those of new
+sentences, e.g., the sentences that join the batch in the middle of the
+search. The keys and values of a new sentence are made once and copied to
+its states.
+>> states - indices of the states to keep
+>> encoding - the encoder output of the new sentences, (N, L, E)
+>> copies - the number of states of each new sentence (e.g., the beam size)
+>> enDeAttCache - the caches of encoder-decoder attention (one for each layer)
+*/
+void AttDecoder::AppendEnDeCache(IntList& states, XTensor& encoding, int copies, Cache* enDeAttCache)
+{
+    for (int i = 0; i < nlayer; i++) {
+        XTensor k;
+        XTensor v;
+        enDeAtts[i].MakeKeysAndValues(encoding, k, v);
+
+        XTensor kCopies;
+        XTensor vCopies;
+        kCopies = Unsqueeze(k, k.order - 2, copies);
+        vCopies = Unsqueeze(v, v.order - 2, copies);
+        kCopies.ReshapeMerged(kCopies.order - 4);
+        vCopies.ReshapeMerged(vCopies.order - 4);
+
+        enDeAttCache[i].KeepAndAppend(states, kCopies, vCopies);
+    }
+}
+
 }
\ No newline at end of file
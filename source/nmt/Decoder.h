@@ -86,12 +86,6 @@ public:
     /* dynamic layer history */
     LayerHistory* history;
 
-    /* layer cache list */
-    Cache* selfAttCache;
-
-    /* layer cache list */
-    Cache* enDeAttCache;
-
     /* the location of layer normalization */
     bool preLN;
 
@@ -123,10 +117,15 @@ public:
                  XTensor* maskEncDec, int nstep);
 
     /* run decoding for inference with pre-norm */
-    XTensor RunFastPreNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep);
+    XTensor RunFastPreNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep,
+                           Cache* selfAttCache, Cache* enDeAttCache, XTensor* steps = NULL);
 
     /* run decoding for inference with post-norm */
-    XTensor RunFastPostNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep);
+    XTensor RunFastPostNorm(XTensor& inputDec, XTensor& outputEnc, XTensor* maskEncDec, int nstep,
+                            Cache* selfAttCache, Cache* enDeAttCache, XTensor* steps = NULL);
+
+    /* keep the encoder-decoder caches of some states and append those of new sentences */
+    void AppendEnDeCache(IntList& states, XTensor& encoding, int copies, Cache* enDeAttCache);
 };
 
 } /* end of the nmt namespace */
@@ -234,22 +234,21 @@ run encoding for inference with pre-norm
 */
 XTensor AttEncoder::RunFastPreNorm(XTensor& input, XTensor* mask)
 {
-    /* clear the history */
-    if (useHistory)
-        history->ClearHistory();
+    /* the history of layers (it is kept here as the module is shared in inference) */
+    History* layers = useHistory ? new History : NULL;
 
     XTensor x;
     x = embedder.Make(input, false, 0);
 
     if (useHistory)
-        history->Add(x);
+        history->Add(x, *layers);
 
     for (int i = 0; i < nlayer; i++) {
 
         XTensor xn;
 
         if (useHistory)
-            x = history->Pop();
+            x = history->Pop(*layers);
 
         /* layer normalization with pre-norm for self-attn */
         xn = attLayerNorms[i].Run(x);
@@ -257,28 +256,20 @@ XTensor AttEncoder::RunFastPreNorm(XTensor& input, XTensor* mask)
         /* self attention */
         xn = selfAtts[i].Make(xn, xn, xn, mask, NULL, SELF_ATT);
 
-        /* residual connection */
-        SumMe(xn, x);
-
-        /* layer normalization with pre-norm for ffn */
-        x = fnnLayerNorms[i].Run(xn);
+        /* residual connection and layer normalization with pre-norm for ffn */
+        x = fnnLayerNorms[i].Run(xn, x);
 
-        /* ffn */
-        x = ffns[i].Make(x);
-
-        /* residual connection */
-        SumMe(x, xn);
+        /* ffn and residual connection */
+        x = ffns[i].Make(x, xn);
 
         if (useHistory)
-            history->Add(x);
+            history->Add(x, *layers);
     }
 
-    if (useHistory)
-        x = history->Pop();
-
-    /* clear the history while not training */
-    if (useHistory && !isTraining)
-        history->ClearHistory();
+    if (useHistory) {
+        x = history->Pop(*layers);
+        delete layers;
+    }
 
     if (finalNorm)
         return encoderLayerNorm->Run(x);
@@ -294,51 +285,42 @@ run encoding for inference with post-norm
 */
 XTensor AttEncoder::RunFastPostNorm(XTensor& input, XTensor* mask)
 {
-    /* clear the history */
-    if (useHistory)
-        history->ClearHistory();
+    /* the history of layers (it is kept here as the module is shared in inference) */
+    History* layers = useHistory ? new History : NULL;
 
     XTensor x;
     x = embedder.Make(input, false, 0);
 
     if (useHistory)
-        history->Add(x);
+        history->Add(x, *layers);
 
     for (int i = 0; i < nlayer; i++) {
 
         if (useHistory)
-            x = history->Pop();
+            x = history->Pop(*layers);
 
         XTensor selfAtt;
 
         /* self attention */
         selfAtt = selfAtts[i].Make(x, x, x, mask, NULL, SELF_ATT);
 
-        /* residual connection */
-        SumMe(selfAtt, x);
-
-        /* layer normalization with post-norm for self-attn */
-        selfAtt = attLayerNorms[i].Run(selfAtt);
+        /* residual connection and layer normalization with post-norm for self-attn */
+        attLayerNorms[i].RunMe(selfAtt, x);
 
         /* ffn */
         x = ffns[i].Make(selfAtt);
 
-        /* residual connection */
-        SumMe(x, selfAtt);
-
-        /* layer normalization with post-norm for ffn */
-        x = fnnLayerNorms[i].Run(x);
+        /* residual connection and layer normalization with post-norm for ffn */
+        fnnLayerNorms[i].RunMe(x, selfAtt);
 
         if (useHistory)
-            history->Add(x);
+            history->Add(x, *layers);
     }
 
-    if (useHistory)
-        x = history->Pop();
-
-    /* clear the history while not training */
-    if (useHistory && !isTraining)
-        history->ClearHistory();
+    if (useHistory) {
+        x = history->Pop(*layers);
+        delete layers;
+    }
 
     if (finalNorm)
         return encoderLayerNorm->Run(x);
@@ -22,6 +22,7 @@
 
 #include <cstdint>
 #include "Model.h"
+#include "train/Corpus.h"
 
 /* the nmt namespace */
 namespace nmt
@@ -33,6 +34,7 @@ NMTModel::NMTModel()
     filePos = -1;
     devID = -1;
     config = NULL;
+    modelContainer = NULL;
     encoder = new AttEncoder();
     decoder = new AttDecoder();
     outputLayer = new OutputLayer();
@@ -44,6 +46,30 @@ NMTModel::~NMTModel()
     delete encoder;
     delete decoder;
     delete outputLayer;
+
+    /* unmap the model file after the parameters are gone */
+    delete modelContainer;
+}
+
+/* return a list to keep the configurations (boolean) */
+vector<bool*> NMTModel::GetBoolConfigs()
+{
+    /* 11 booleans */
+    vector<bool*> boolConfig = {
+        &(config->model.encoderL1Norm),
+        &(config->model.decoderL1Norm),
+        &(config->model.useBigAtt),
+        &(config->model.encFinalNorm),
+        &(config->model.decFinalNorm),
+        &(config->model.encPreLN),
+        &(config->model.decPreLN),
+        &(config->model.useEncHistory),
+        &(config->model.useDecHistory),
+        &(config->model.shareEncDecEmb),
+        &(config->model.shareDecInputOutputEmb),
+    };
+
+    return boolConfig;
 }
 
 /* return a list to keep the configurations (interger) */
@@ -84,60 +110,77 @@ void NMTModel::InitModel(NMTConfig& myConfig)
     devID = config->common.devID;
 
     /* configurations for the model */
+    vector<bool*> boolConfig = GetBoolConfigs();
     vector<int*> intConfig = GetIntConfigs();
 
     FILE* modelFile = NULL;
-    modelFile = fopen(config->common.modelFN, "rb");
+    int maxSrcLen = config->model.maxSrcLen;
 
     /* read model configurations */
-    if (modelFile) {
+    if (XModelFile::IsModelFile(config->common.modelFN)) {
+
+        /* the parameters on CPUs can be the mapped file itself for inference */
+        bool useMMap = config->common.useMMap && devID < 0 &&
+                       !config->common.useFP16 && !config->training.isTraining;
 
-        CheckNTErrors(modelFile, "Failed to open the model file");
+        modelContainer = new XModelFile();
+        modelContainer->Open(config->common.modelFN, useMMap);
+        if (config->common.verifyModel)
+            modelContainer->verify = true;
+
+        LOG("loading configurations from the model file (version %d)...", modelContainer->header.version);
+
+        const char* meta = modelContainer->meta;
+        CheckNTErrors(modelContainer->header.metaSize == boolConfig.size() * sizeof(bool) + intConfig.size() * sizeof(int),
+                      "Unmatched configurations in the model file");
+        for (auto c : boolConfig) {
+            memcpy(c, meta, sizeof(bool));
+            meta += sizeof(bool);
+        }
+        for (auto c : intConfig) {
+            memcpy(c, meta, sizeof(int));
+            meta += sizeof(int);
+        }
+    }
+    else if ((modelFile = fopen(config->common.modelFN, "rb")) != NULL) {
 
         LOG("loading configurations from the model file...");
 
-        /* 11 booleans */
-        fread(&(config->model.encoderL1Norm), sizeof(bool), 1, modelFile);
-        fread(&(config->model.decoderL1Norm), sizeof(bool), 1, modelFile);
-        fread(&(config->model.useBigAtt), sizeof(bool), 1, modelFile);
-        fread(&(config->model.encFinalNorm), sizeof(bool), 1, modelFile);
-        fread(&(config->model.decFinalNorm), sizeof(bool), 1, modelFile);
-        fread(&(config->model.encPreLN), sizeof(bool), 1, modelFile);
-        fread(&(config->model.decPreLN), sizeof(bool), 1, modelFile);
-        fread(&(config->model.useEncHistory), sizeof(bool), 1, modelFile);
-        fread(&(config->model.useDecHistory), sizeof(bool), 1, modelFile);
-        fread(&(config->model.shareEncDecEmb), sizeof(bool), 1, modelFile);
-        fread(&(config->model.shareDecInputOutputEmb), sizeof(bool), 1, modelFile);
-
-        int maxSrcLen = config->model.maxSrcLen;
+        for (auto c : boolConfig) {
+            fread(c, sizeof(bool), 1, modelFile);
+        }
         for (auto c : intConfig) {
             fread(c, sizeof(int), 1, modelFile);
         }
-        /* reset the maximum source sentence length */
-        config->model.maxSrcLen = MIN(maxSrcLen, config->model.maxSrcLen);
     }
 
+    /* reset the maximum source sentence length */
+    if (modelFile || modelContainer)
+        config->model.maxSrcLen = MIN(maxSrcLen, config->model.maxSrcLen);
+
     if (config->training.isTraining) {
 
-        /* currently we do not support training with FP16 */
+        /* currently we do not support training with FP16 or INT8 */
         config->common.useFP16 = false;
+        config->common.useINT8 = false;
+        config->common.packWeights = false;
+        config->common.mergeQKV = false;
 
         /* read the source & target vocab size and special tokens from the training file */
-        FILE* trainF = fopen(config->training.trainFN, "rb");
-        CheckNTErrors(trainF, "Failed to open the training file");
-
-        fread(&(config->model.srcVocabSize), sizeof(int), 1, trainF);
-        fread(&(config->model.tgtVocabSize), sizeof(int), 1, trainF);
-        fread(&(config->model.pad), sizeof(int), 1, trainF);
-        fread(&(config->model.sos), sizeof(int), 1, trainF);
-        fread(&(config->model.eos), sizeof(int), 1, trainF);
-        fread(&(config->model.unk), sizeof(int), 1, trainF);
+        CorpusHeader corpusHeader;
+        ReadCorpusHeader(config->training.trainFN, corpusHeader);
+
+        config->model.srcVocabSize = corpusHeader.vocabSize[0];
+        config->model.tgtVocabSize = corpusHeader.vocabSize[1];
+        config->model.pad = corpusHeader.specialTokens[0];
+        config->model.sos = corpusHeader.specialTokens[1];
+        config->model.eos = corpusHeader.specialTokens[2];
+        config->model.unk = corpusHeader.specialTokens[3];
         CheckNTErrors(config->model.srcVocabSize > 0, "Invalid source vocabulary size");
         CheckNTErrors(config->model.tgtVocabSize > 0, "Invalid target vocabulary size");
-        fclose(trainF);
 
         /* start incremental training from a checkpoint */
-        if (modelFile) {
+        if (modelFile || modelContainer) {
             config->training.incremental = true;
         }
     }
@@ -171,6 +214,15 @@ void NMTModel::InitModel(NMTConfig& myConfig)
         filePos = ftell(modelFile);
         fclose(modelFile);
     }
+
+    /* keep the file only if the parameters are mapped from it */
+    if (modelContainer) {
+        filePos = (long)modelContainer->GetFileSize();
+        if (!modelContainer->IsMapped()) {
+            delete modelContainer;
+            modelContainer = NULL;
+        }
+    }
 }
 
 /*
@@ -275,12 +327,12 @@ XTensor NMTModel::MakeLM(XTensor& input, XTensor& padding)
 }
 
 /*
-make the network for machine translation (with the output softmax layer)
+make the network for machine translation (the softmax is left to the loss)
 >> inputEnc - input tensor of the encoder, (batchSize, srcLen)
 >> inputDec - input tensor of the decoder, (batchSize, tgtLen)
 >> paddingEnc - padding of the sequences (on the encoder side), (batchSize, srcLen)
 >> paddingDec - padding of the sequences (on the decoder side), (batchSize, tgtLen)
-<< output - output tensor (distribution), (batchSize, tgtLen, hiddenDim)
+<< output - output tensor (logits), (batchSize, tgtLen, vocabSize)
 */
 XTensor NMTModel::MakeMT(XTensor& inputEnc, XTensor& inputDec,
                          XTensor& paddingEnc, XTensor& paddingDec)
@@ -302,7 +354,7 @@ XTensor NMTModel::MakeMT(XTensor& inputEnc, XTensor& inputDec,
 
     decoding = MakeDecoder(inputDec, encoding, &maskDec, maskEncDec);
 
-    return outputLayer->Make(decoding, true);
+    return outputLayer->Make(decoding, false);
 }
 
 /*
@@ -659,6 +711,27 @@ void NMTModel::GetParams(TensorList& list)
     }
 }
 
+/*
+get the meta data of the model file, i.e., the configurations of the model
+>> meta - the meta data
+*/
+void NMTModel::GetMetaData(vector<char>& meta)
+{
+    vector<bool*> boolConfig = GetBoolConfigs();
+    vector<int*> intConfig = GetIntConfigs();
+
+    meta.resize(boolConfig.size() * sizeof(bool) + intConfig.size() * sizeof(int));
+    char* p = meta.data();
+    for (auto c : boolConfig) {
+        memcpy(p, c, sizeof(bool));
+        p += sizeof(bool);
+    }
+    for (auto c : intConfig) {
+        memcpy(p, c, sizeof(int));
+        p += sizeof(int);
+    }
+}
+
 /*
 dump the model to a file
 >> fn - where to save the model
@@ -666,35 +739,15 @@ dump the model to a file
 void NMTModel::DumpToFile(const char* fn)
 {
     double startT = GetClockSec();
-    FILE* modelFile = fopen(fn, "wb");
-    CheckNTErrors(modelFile, "Cannot open the model file");
 
-    vector<int*> intConfig = GetIntConfigs();
+    vector<char> meta;
+    GetMetaData(meta);
 
-    /* save the configurations */
-    fwrite(&(config->model.encoderL1Norm), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.decoderL1Norm), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.useBigAtt), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.encFinalNorm), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.decFinalNorm), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.encPreLN), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.decPreLN), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.useEncHistory), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.useDecHistory), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.shareEncDecEmb), sizeof(bool), 1, modelFile);
-    fwrite(&(config->model.shareDecInputOutputEmb), sizeof(bool), 1, modelFile);
-    for (auto c : intConfig) {
-        fwrite(c, sizeof(int), 1, modelFile);
-    }
-
-    /* save the model parameters */
+    /* save the configurations and the model parameters */
     TensorList params;
     GetParams(params);
-    for (int i = 0; i < params.Size(); i++) {
-        params[i]->BinaryDump(modelFile);
-    }
+    XModelFile::Write(fn, params, meta.data(), meta.size());
 
-    fclose(modelFile);
     double elapsed = GetClockSec() - startT;
     LOG("model saved (took %.1fs)", elapsed);
 }
@@ -712,6 +765,9 @@ void NMTModel::LoadFromFile(FILE* file)
     if (config->common.useFP16) {
         LOG("running with fp16");
     }
+    else if (config->common.useINT8) {
+        LOG("running with int8");
+    }
     else {
         LOG("running with fp32");
     }
@@ -731,13 +787,140 @@ void NMTModel::LoadFromFile(FILE* file)
         }
     }
 
-    for (int i = 0; i < params.Size(); i++)
-        params[i]->BinaryRead(file);
+    if (modelContainer != NULL) {
+        CheckNTErrors(modelContainer->GetTensorNum() == params.Size(),
+                      "Unmatched number of parameters in the model file");
+
+        /* point the parameters to the mapped file if possible */
+        bool share = modelContainer->IsMapped();
+        if (share)
+            LOG("mapping parameters from the model file");
+
+        for (int i = 0; i < params.Size(); i++) {
+            XTensor* p = params[i];
+
+            /* a model saved in FP32 can also run with FP16 */
+            if (modelContainer->GetEntry(i)->dataType == X_FLOAT && p->dataType == X_FLOAT16) {
+                XTensor tmp;
+                InitTensor(&tmp, p->order, p->dimSize, X_FLOAT, p->devID);
+                modelContainer->ReadTensor(i, &tmp, false);
+                _ConvertDataType(&tmp, p);
+            }
+            else
+                modelContainer->ReadTensor(i, p, share);
+        }
+    }
+    else {
+        for (int i = 0; i < params.Size(); i++)
+            params[i]->BinaryRead(file);
+    }
+
+    if (config->common.mergeQKV)
+        MergeWeights();
+
+    if (config->common.useINT8)
+        QuantizeINT8();
+    else if (config->common.packWeights)
+        PackWeights();
 
     double elapsed = GetClockSec() - startT;
     LOG("model loaded (took %.1fs)", elapsed);
 }
 
+/*
+quantize the weight matrices of the attention, ffn, embedding
+and output layers into int8 (per output channel). The float
+weights are released, so the model can only be used for inference.
+*/
+void NMTModel::QuantizeINT8()
+{
+    CheckNTErrors(devID < 0, "INT8 inference is only supported on CPUs!");
+    CheckNTErrors(!config->common.useFP16, "INT8 cannot be used with FP16!");
+    CheckNTErrors(!config->training.isTraining, "INT8 is only supported for inference!");
+
+    if (!config->model.decoderOnly) {
+        for (int i = 0; i < encoder->nlayer; i++) {
+            encoder->selfAtts[i].QuantizeINT8();
+            encoder->ffns[i].QuantizeINT8();
+        }
+        encoder->embedder.QuantizeINT8();
+    }
+
+    for (int i = 0; i < decoder->nlayer; i++) {
+        decoder->selfAtts[i].QuantizeINT8();
+        if (!config->model.decoderOnly)
+            decoder->enDeAtts[i].QuantizeINT8();
+        if (decoder->ffns != NULL)
+            decoder->ffns[i].QuantizeINT8();
+    }
+
+    /* the decoder embeddings have been quantized if they are shared with the encoder */
+    if (!config->model.shareEncDecEmb || config->model.decoderOnly)
+        decoder->embedder->QuantizeINT8();
+
+    /* share the int8 weight with the decoder embeddings */
+    if (config->model.shareDecInputOutputEmb)
+        outputLayer->qWeight = &(decoder->embedder->qw);
+    else
+        outputLayer->QuantizeINT8();
+}
+
+/*
+pack the weight matrices of the attention, ffn and output layers for
+the matrix multiplication, so that they are not packed again in each
+call. The float matrices of the attention and ffn layers are released,
+so the model can only be used for inference.
+*/
+void NMTModel::PackWeights()
+{
+    CheckNTErrors(devID < 0, "Packed weights are only supported on CPUs!");
+    CheckNTErrors(!config->common.useFP16, "Packed weights cannot be used with FP16!");
+    CheckNTErrors(!config->training.isTraining, "Packed weights are only supported for inference!");
+
+    if (!config->model.decoderOnly) {
+        for (int i = 0; i < encoder->nlayer; i++) {
+            encoder->selfAtts[i].PackWeights();
+            encoder->ffns[i].PackWeights();
+        }
+    }
+
+    for (int i = 0; i < decoder->nlayer; i++) {
+        decoder->selfAtts[i].PackWeights();
+        if (!config->model.decoderOnly)
+            decoder->enDeAtts[i].PackWeights();
+        if (decoder->ffns != NULL)
+            decoder->ffns[i].PackWeights();
+    }
+
+    outputLayer->PackWeights();
+
+    LOG("packed the weights for the %s kernel", GetGEMMKernelName());
+}
+
+/*
+merge the transformation matrices of Q, K and V of the self-attention (and
+those of K and V of the encoder-decoder attention) into one, so that the
+projections are made by one matrix multiplication. The separate matrices
+are released, so the model can only be used for inference.
+*/
+void NMTModel::MergeWeights()
+{
+    CheckNTErrors(!config->training.isTraining, "Merged QKV is only supported for inference!");
+
+    if (!config->model.decoderOnly) {
+        for (int i = 0; i < encoder->nlayer; i++)
+            encoder->selfAtts[i].MergeWeights(true);
+    }
+
+    for (int i = 0; i < decoder->nlayer; i++) {
+        decoder->selfAtts[i].MergeWeights(true);
+        if (!config->model.decoderOnly)
+            decoder->enDeAtts[i].MergeWeights(false);
+    }
+
+    LOG("merged the transformation matrices of Q, K and V");
+}
+
 /* get the total number of parameters */
 uint64_t NMTModel::GetParamNum()
 {
@@ -800,12 +983,8 @@ bool NMTModel::RunSimple(XList* inputs, XList* outputs, XList* golds, XList* los
     /* make the network */
     *output = MakeMT(*batchEnc, *batchDec, *paddingEnc, *paddingDec);
 
-    /* get loss and probabilities */
-    XTensor labelOnehot;
-
-    labelOnehot = IndexToOnehot(label, config->model.tgtVocabSize, config->training.labelSmoothingP);
-
-    *loss = CrossEntropy(output, labelOnehot, paddingDec);
+    /* get loss (the labels are smoothed in the loss) */
+    *loss = CrossEntropySparse(*output, *label, *paddingDec, config->training.labelSmoothingP);
 
     float lossBatch = ReduceSumAllValue(*loss);
 
@@ -825,4 +1004,80 @@ bool NMTModel::RunSimple(XList* inputs, XList* outputs, XList* golds, XList* los
     return true;
 }
 
+/* constructor */
+InferenceContext::InferenceContext()
+{
+    nlayer = 0;
+    selfAttCache = NULL;
+    enDeAttCache = NULL;
+}
+
+/* de-constructor */
+InferenceContext::~InferenceContext()
+{
+    delete[] selfAttCache;
+    delete[] enDeAttCache;
+}
+
+/*
+initialize the context for a model (nothing is done if it is initialized)
+>> model - the model
+*/
+void InferenceContext::Init(NMTModel* model)
+{
+    if (selfAttCache != NULL && nlayer == model->decoder->nlayer)
+        return;
+
+    delete[] selfAttCache;
+    delete[] enDeAttCache;
+
+    nlayer = model->decoder->nlayer;
+    selfAttCache = new Cache[nlayer];
+    enDeAttCache = new Cache[nlayer];
+}
+
+/*
+reserve the decoder caches for a number of steps
+>> maxLen - the maximum number of steps
+*/
+void InferenceContext::Reserve(int maxLen)
+{
+    for (int i = 0; i < nlayer; i++)
+        selfAttCache[i].Reserve(maxLen);
+}
+
+/*
+reorder the states in the decoder caches
+>> reorder - indices of the states
+>> removeFinished - indicates whether the finished states are removed, in
+                    which case the encoder-decoder caches are reordered too
+*/
+void InferenceContext::Reorder(XTensor& reorder, bool removeFinished)
+{
+    for (int i = 0; i < nlayer; i++) {
+        selfAttCache[i].Reorder(reorder);
+        if (removeFinished)
+            enDeAttCache[i].Reorder(reorder);
+    }
+}
+
+/*
+reset the context for the next batch
+>> clear - free the keys and values (e.g., before the memory pool that keeps
+           them is cleared), or just mark the caches as missed
+*/
+void InferenceContext::Reset(bool clear)
+{
+    for (int i = 0; i < nlayer; i++) {
+        if (clear) {
+            selfAttCache[i].Clear();
+            enDeAttCache[i].Clear();
+        }
+        else {
+            selfAttCache[i].miss = true;
+            enDeAttCache[i].miss = true;
+        }
+    }
+}
+
 } /* end of the nmt namespace */
\ No newline at end of file
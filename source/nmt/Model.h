@@ -30,6 +30,7 @@
 #include "submodel/Output.h"
 #include "submodel/Attention.h"
 #include "../niutensor/train/XModel.h"
+#include "../niutensor/tensor/XModelFile.h"
 
 /* the nmt namespace */
 namespace nmt
@@ -46,6 +47,9 @@ public:
     /* the current position of the model file pointer */
     long filePos;
 
+    /* the model file (kept only when the parameters are mapped from it) */
+    XModelFile* modelContainer;
+
     /* configurations */
     NMTConfig* config;
 
@@ -65,6 +69,9 @@ public:
     /* de-constructor */
     ~NMTModel();
 
+    /* get configurations */
+    vector<bool*> GetBoolConfigs();
+
     /* get configurations */
     vector<int*> GetIntConfigs();
 
@@ -106,12 +113,24 @@ public:
     /* get parameter matrices */
     void GetParams(TensorList& list);
 
+    /* get the meta data (the configurations) of the model file */
+    void GetMetaData(vector<char>& meta);
+
     /* dump the model to a file */
     void DumpToFile(const char* fn);
 
     /* read the parameters */
     void LoadFromFile(FILE* file);
 
+    /* quantize the weight matrices into int8 for inference */
+    void QuantizeINT8();
+
+    /* pack the weight matrices for the matrix multiplication in inference */
+    void PackWeights();
+
+    /* merge the transformation matrices of Q, K and V for inference */
+    void MergeWeights();
+
     /* get the number of parameters */
     uint64_t GetParamNum();
 
@@ -130,6 +149,44 @@ public:
     bool RunSimple(XList * inputs, XList * outputs, XList * golds, XList * losses);
 };
 
+/* the state of translating a batch, i.e., the decoder caches and the output
+   layer restricted to a shortlist. The model is read-only in inference, so
+   a number of threads can translate with the same model and a context each. */
+class InferenceContext
+{
+public:
+    /* number of decoder layers */
+    int nlayer;
+
+    /* the caches of decoder self-attention (one for each layer) */
+    Cache* selfAttCache;
+
+    /* the caches of encoder-decoder attention (one for each layer) */
+    Cache* enDeAttCache;
+
+    /* the output layer restricted to a shortlist */
+    OutputShortlist shortlist;
+
+public:
+    /* constructor */
+    InferenceContext();
+
+    /* de-constructor */
+    ~InferenceContext();
+
+    /* initialize the context for a model */
+    void Init(NMTModel* model);
+
+    /* reserve the decoder caches for a number of steps */
+    void Reserve(int maxLen);
+
+    /* reorder the states in the decoder caches */
+    void Reorder(XTensor& reorder, bool removeFinished);
+
+    /* reset the context for the next batch */
+    void Reset(bool clear);
+};
+
 } /* end of the nmt namespace */
 
 #endif /* __MODEL_H__ */
\ No newline at end of file
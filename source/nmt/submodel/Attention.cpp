@@ -52,6 +52,7 @@ Attention::Attention()
     useRPR = false;
     isTraining = false;
     isValidating = false;
+    mergedNum = 0;
 }
 
 /* de-constructor */
@@ -119,6 +120,122 @@ void Attention::InitModel(NMTConfig& config, bool isEnc, bool isSelfAtt)
     }
 }
 
+/* quantize the transformation matrices into int8 (per output channel) */
+void Attention::QuantizeINT8()
+{
+    if (mergedNum > 0)
+        qWeightQKV.Quantize(weightQKV, X_NOTRANS);
+    if (mergedNum < 3)
+        qWeightQ.Quantize(weightQ, X_NOTRANS);
+    if (mergedNum == 0) {
+        qWeightK.Quantize(weightK, X_NOTRANS);
+        qWeightV.Quantize(weightV, X_NOTRANS);
+    }
+    qWeightO.Quantize(weightO, X_NOTRANS);
+}
+
+/*
+pack the transformation matrices for the matrix multiplication (for
+inference on CPUs). The float matrices are released.
+*/
+void Attention::PackWeights()
+{
+    if (mergedNum > 0) {
+        pWeightQKV.Pack(&weightQKV, X_NOTRANS);
+        weightQKV.DestroyData();
+    }
+    if (mergedNum < 3) {
+        pWeightQ.Pack(&weightQ, X_NOTRANS);
+        weightQ.DestroyData();
+    }
+    if (mergedNum == 0) {
+        pWeightK.Pack(&weightK, X_NOTRANS);
+        pWeightV.Pack(&weightV, X_NOTRANS);
+        weightK.DestroyData();
+        weightV.DestroyData();
+    }
+    pWeightO.Pack(&weightO, X_NOTRANS);
+    weightO.DestroyData();
+}
+
+/*
+merge the transformation matrices of Q, K and V (or K and V for the
+encoder-decoder attention) into one, so that the projections are made by
+one matrix multiplication (for inference). The separate matrices are
+released.
+>> isSelfAtt - indicates whether it is a self-attention module
+*/
+void Attention::MergeWeights(bool isSelfAtt)
+{
+    TensorList weights;
+    TensorList biases;
+
+    if (isSelfAtt) {
+        weights.Add(&weightQ);
+        biases.Add(&biasQ);
+    }
+    weights.Add(&weightK);
+    weights.Add(&weightV);
+    biases.Add(&biasK);
+    biases.Add(&biasV);
+
+    mergedNum = weights.Size();
+
+    InitTensor2D(&weightQKV, embDim, mergedNum * embDim, weightK.dataType, devID);
+    InitTensor1D(&biasQKV, mergedNum * embDim, biasK.dataType, devID);
+    _Concatenate(&weights, &weightQKV, 1);
+    _Concatenate(&biases, &biasQKV, 0);
+
+    for (int i = 0; i < mergedNum; i++) {
+        weights[i]->DestroyData();
+        biases[i]->DestroyData();
+    }
+}
+
+/*
+make a tensor that uses a part of the data of another tensor (without
+copying). The view is valid as long as the data of the other tensor is kept.
+>> view - the view (for return)
+>> s - the tensor that keeps the data
+>> order - order of the view
+>> dimSize - size of each dimension of the view
+>> offset - where the view begins in the data of s (in items)
+*/
+static void MakeView(XTensor& view, const XTensor& s, int order, const int* dimSize, int offset)
+{
+    int dims[MAX_TENSOR_DIM_NUM];
+    memcpy(dims, dimSize, sizeof(int) * order);
+
+    /* a negative size lets the tensor skip the allocation */
+    dims[0] = -dims[0];
+
+    view.devID = s.devID;
+    view.Resize(order, dims, s.dataType);
+    view.data = (char*)s.data + (size_t)offset * s.unitSize;
+    view.isShared = true;
+}
+
+/*
+split the merged projections into separate tensors
+>> merged - the merged projections, B * L * (num * H)
+>> parts - the projections (for return), B * L * H
+>> num - number of the projections
+*/
+static void SplitProjections(XTensor& merged, XTensor** parts, int num)
+{
+    int dims[MAX_TENSOR_DIM_NUM];
+    memcpy(dims, merged.dimSize, sizeof(int) * merged.order);
+    dims[merged.order - 1] /= num;
+
+    TensorList list;
+    for (int i = 0; i < num; i++) {
+        InitTensor(parts[i], merged.order, dims, merged.dataType, merged.devID);
+        list.Add(parts[i]);
+    }
+
+    _Split(&merged, &list, merged.order - 1, num);
+}
+
 /*
 make the network
 >> k - keys, B * L * H 
@@ -140,12 +257,25 @@ XTensor Attention::Make(XTensor& k, XTensor& q, XTensor& v,
     /* linear transformation before self-attention */
     XTensor q2, k2, v2;
 
-    q2 = MulAndShift(q, weightQ, biasQ);
+    if (mergedNum == 3) {
+        CheckNTErrors(&k == &q && &q == &v, "The merged transformation needs the same keys, queries and values!");
+
+        XTensor qkv;
+        qkv = AutoMulAndShift(q, weightQKV, biasQKV, qWeightQKV, pWeightQKV);
+
+        if ((!cache || !cache->enabled) && !useRPR)
+            return MakeMergedAttention(qkv, mask);
+
+        XTensor* parts[3] = { &q2, &k2, &v2 };
+        SplitProjections(qkv, parts, 3);
+    }
+    else
+        q2 = AutoMulAndShift(q, weightQ, biasQ, qWeightQ, pWeightQ);
 
     if (!cache || isTraining || !(cache->enabled)) {
         /* self attention for encoder layers */
-        k2 = MulAndShift(k, weightK, biasK);
-        v2 = MulAndShift(v, weightV, biasV);
+        if (mergedNum < 3)
+            MakeKeysAndValues(k, v, k2, v2);
 
         if (useRPR && attType == SELF_ATT)
             return MakeRPRAttention(k2, q2, v2, mask, isEnc);
@@ -154,11 +284,25 @@ XTensor Attention::Make(XTensor& k, XTensor& q, XTensor& v,
 
     else {
         if (attType == SELF_ATT) {
-            k2 = MulAndShift(k, weightK, biasK);
-            v2 = MulAndShift(v, weightV, biasV);
+            if (mergedNum < 3)
+                MakeKeysAndValues(k, v, k2, v2);
+
+            /* on CPUs, the new keys and values are appended to the preallocated
+               buffers, and the attention reads them in place */
+            if (devID < 0 && !useRPR && q2.dataType == X_FLOAT && q2.GetDim(-2) == 1) {
+                cache->Append(k2, v2);
+
+                XTensor att;
+                att = SingleQueryAttention(q2, cache->keyBuf, cache->valueBuf, cache->rowIndex,
+                                           cache->length, nhead, 1.0F / (float)sqrt((float)kDim / nhead));
+
+                return AutoMulAndShift(att, weightO, biasO, qWeightO, pWeightO);
+            }
 
             /* if hit, we only concat the cache with the new token */
-            if (!cache->miss) {
+            if (cache->miss)
+                cache->buffered = false;
+            else {
                 k2 = Concatenate(cache->key, k2, 1);
                 v2 = Concatenate(cache->value, v2, 1);
             }
@@ -172,8 +316,7 @@ XTensor Attention::Make(XTensor& k, XTensor& q, XTensor& v,
         }
         else if (attType == EN_DE_ATT) {
             if (cache->miss) {
-                cache->key = MulAndShift(k, weightK, biasK);
-                cache->value = MulAndShift(v, weightV, biasV);
+                MakeKeysAndValues(k, v, cache->key, cache->value);
                 cache->miss = false;
             }
 
@@ -183,6 +326,43 @@ XTensor Attention::Make(XTensor& k, XTensor& q, XTensor& v,
     }
 }
 
+/*
+transform the inputs into keys and values, e.g., the encoder output for the
+encoder-decoder attention
+>> x - the inputs, B * L * H
+>> k - the keys (for return), B * L * H
+>> v - the values (for return), B * L * H
+*/
+void Attention::MakeKeysAndValues(XTensor& x, XTensor& k, XTensor& v)
+{
+    MakeKeysAndValues(x, x, k, v);
+}
+
+/*
+transform the inputs of keys and values. The keys and values are made by
+one matrix multiplication if their transformation matrices are merged.
+>> k - the inputs of the keys, B * L * H
+>> v - the inputs of the values, B * L * H
+>> k2 - the keys (for return), B * L * H
+>> v2 - the values (for return), B * L * H
+*/
+void Attention::MakeKeysAndValues(XTensor& k, XTensor& v, XTensor& k2, XTensor& v2)
+{
+    if (mergedNum == 2) {
+        CheckNTErrors(&k == &v, "The merged transformation needs the same keys and values!");
+
+        XTensor kv;
+        kv = AutoMulAndShift(k, weightQKV, biasQKV, qWeightQKV, pWeightQKV);
+
+        XTensor* parts[2] = { &k2, &v2 };
+        SplitProjections(kv, parts, 2);
+        return;
+    }
+
+    k2 = AutoMulAndShift(k, weightK, biasK, qWeightK, pWeightK);
+    v2 = AutoMulAndShift(v, weightV, biasV, qWeightV, pWeightV);
+}
+
 /*
 make the attention network given keys, queries and values (after linear transformation)
 >> k - keys, B * L * H
@@ -194,17 +374,62 @@ make the attention network given keys, queries and values (after linear transfor
 XTensor Attention::MakeAttention(XTensor& k, XTensor& q, XTensor& v, 
                                  XTensor* mask, bool isEnc)
 {
+    if (nhead == 1)
+        return MakeHeadAttention(k, q, v, mask);
+
     XTensor kheads;
     XTensor vheads;
 
-    const auto dataType = k.dataType;
-
     /* multi head */
-    if (nhead > 1) {
-        q = Split(q, q.order - 1, nhead, /*inplace=*/isTraining);
-        kheads = Split(k, k.order - 1, nhead, /*inplace=*/isTraining);
-        vheads = Split(v, v.order - 1, nhead, /*inplace=*/isTraining);
-    }
+    q = Split(q, q.order - 1, nhead, /*inplace=*/isTraining);
+    kheads = Split(k, k.order - 1, nhead, /*inplace=*/isTraining);
+    vheads = Split(v, v.order - 1, nhead, /*inplace=*/isTraining);
+
+    return MakeHeadAttention(kheads, q, vheads, mask);
+}
+
+/*
+make the attention network given the merged projections of the inputs (for
+inference). The projections are split into heads at once, and the heads of
+queries, keys and values are views of the split.
+>> qkv - the projections of queries, keys and values, B * L * 3H
+>> mask - as it is
+*/
+XTensor Attention::MakeMergedAttention(XTensor& qkv, XTensor* mask)
+{
+    XTensor heads;
+    heads = Split(qkv, qkv.order - 1, 3 * nhead);
+
+    /* the heads are (K, B, L, H/K), or (B, L, H) for a single head */
+    const int* dims = nhead > 1 ? heads.dimSize : heads.dimSize + 1;
+    int order = nhead > 1 ? heads.order : heads.order - 1;
+    int viewDims[MAX_TENSOR_DIM_NUM];
+    memcpy(viewDims, dims, sizeof(int) * order);
+    if (nhead > 1)
+        viewDims[0] = nhead;
+
+    const int size = heads.unitNum / 3;
+
+    XTensor q;
+    XTensor k;
+    XTensor v;
+    MakeView(q, heads, order, viewDims, 0);
+    MakeView(k, heads, order, viewDims, size);
+    MakeView(v, heads, order, viewDims, size * 2);
+
+    return MakeHeadAttention(k, q, v, mask);
+}
+
+/*
+make the attention network given the heads of keys, queries and values
+>> k - keys, K * B * L * H/K (or B * L * H for a single head)
+>> q - queries, K * B * L * H/K (or B * L * H for a single head)
+>> v - values, K * B * L * H/K (or B * L * H for a single head)
+>> mask - as it is
+*/
+XTensor Attention::MakeHeadAttention(XTensor& k, XTensor& q, XTensor& v, XTensor* mask)
+{
+    const auto dataType = k.dataType;
 
     XTensor att;
 
@@ -214,10 +439,7 @@ XTensor Attention::MakeAttention(XTensor& k, XTensor& q, XTensor& v,
         ScaleMe(q, 1.0F / (float)sqrt((float)kDim / nhead));
 
     /* scalar = softmax(Q * K^T / sqrt(dk)) * V */
-    if(nhead > 1)
-        att = BMMul(q, X_NOTRANS, kheads, X_TRANS);
-    else
-        att = BMMul(q, X_NOTRANS, k, X_TRANS);
+    att = BMMul(q, X_NOTRANS, k, X_TRANS);
 
     if (att.dataType == X_FLOAT16) {
         att = ConvertDataType(att, X_FLOAT);
@@ -238,16 +460,13 @@ XTensor Attention::MakeAttention(XTensor& k, XTensor& q, XTensor& v,
     if (dataType != att.dataType)
         att = ConvertDataType(att, dataType);
     
-    if (nhead > 1)
-        att = BMMul(att, vheads);
-    else
-        att = BMMul(att, v);
+    att = BMMul(att, v);
 
     /* concatenate the heads */
     if (nhead > 1)
-        return MulAndShift(Merge(att, att.order - 1, -1, /*inplace=*/isTraining), weightO, biasO);
+        return AutoMulAndShift(Merge(att, att.order - 1, -1, /*inplace=*/isTraining), weightO, biasO, qWeightO, pWeightO);
     else
-        return MulAndShift(att, weightO, biasO);
+        return AutoMulAndShift(att, weightO, biasO, qWeightO, pWeightO);
 }
     
 /*
@@ -314,7 +533,7 @@ XTensor Attention::MakeRPRAttention(XTensor& k, XTensor& q, XTensor& v,
     att = BMMul(scalar, vheads);
 
     /* concatenate the heads */
-    return MulAndShift(Merge(att, att.order - 1, -1, /*inplace=*/isTraining), weightO, biasO);
+    return AutoMulAndShift(Merge(att, att.order - 1, -1, /*inplace=*/isTraining), weightO, biasO, qWeightO, pWeightO);
 }
 
 /*
@@ -430,24 +649,234 @@ Cache::Cache()
 {
     miss = true;
     enabled = true;
+    buffered = false;
+    rowIndex = NULL;
+    reservedLen = 0;
+    length = 0;
+    stateNum = 0;
+}
+
+/* de-constructor */
+Cache::~Cache()
+{
+    delete[] rowIndex;
+}
+
+/*
+reserve the buffers for a number of steps, e.g., the max length of the
+output sequence. The buffers are allocated when the first step comes.
+>> maxLen - the number of steps
+*/
+void Cache::Reserve(int maxLen)
+{
+    reservedLen = maxLen;
+}
+
+/*
+append the keys and values of a new step to the buffers. The buffers are
+(re)allocated at the first step, and grow if there are more steps than
+reserved.
+>> k - the keys of the step, (B, 1, H)
+>> v - the values of the step, (B, 1, H)
+*/
+void Cache::Append(XTensor& k, XTensor& v)
+{
+    const int dim = k.GetDim(-1);
+    const int num = k.unitNum / dim;
+
+    CheckNTErrors(k.dataType == X_FLOAT && v.dataType == X_FLOAT, "The buffers only keep floats!");
+    CheckNTErrors(v.unitNum == k.unitNum, "Unmatched keys and values!");
+
+    if (miss) {
+        int maxLen = MAX(reservedLen, 1);
+        if (keyBuf.data == NULL || keyBuf.order != 3 || keyBuf.GetDim(0) < maxLen || keyBuf.GetDim(1) != num ||
+            keyBuf.GetDim(2) != dim || keyBuf.devID != k.devID) {
+            InitTensor3D(&keyBuf, maxLen, num, dim, X_FLOAT, k.devID);
+            InitTensor3D(&valueBuf, maxLen, num, dim, X_FLOAT, k.devID);
+            delete[] rowIndex;
+            rowIndex = new int[maxLen * num];
+        }
+        length = 0;
+        miss = false;
+        buffered = true;
+    }
+
+    const int rowNum = keyBuf.GetDim(1);
+    CheckNTErrors(num == stateNum || length == 0, "The number of states changes without reordering!");
+    CheckNTErrors(num <= rowNum && keyBuf.GetDim(2) == dim, "The step does not fit the buffers!");
+
+    /* double the buffers if the sequence is longer than expected */
+    if (length == keyBuf.GetDim(0)) {
+        XTensor newKeyBuf;
+        XTensor newValueBuf;
+        InitTensor3D(&newKeyBuf, length * 2, rowNum, dim, X_FLOAT, keyBuf.devID);
+        InitTensor3D(&newValueBuf, length * 2, rowNum, dim, X_FLOAT, keyBuf.devID);
+
+        size_t size = (size_t)length * rowNum * dim * sizeof(DTYPE);
+        XMemCopy(newKeyBuf.data, newKeyBuf.devID, keyBuf.data, keyBuf.devID, size);
+        XMemCopy(newValueBuf.data, newValueBuf.devID, valueBuf.data, valueBuf.devID, size);
+        keyBuf = std::move(newKeyBuf);
+        valueBuf = std::move(newValueBuf);
+
+        int* newRowIndex = new int[length * 2 * rowNum];
+        memcpy(newRowIndex, rowIndex, sizeof(int) * length * rowNum);
+        delete[] rowIndex;
+        rowIndex = newRowIndex;
+    }
+
+    /* the states of the new step are kept in their own order */
+    size_t offset = (size_t)length * rowNum * dim;
+    XMemCopy((DTYPE*)keyBuf.data + offset, keyBuf.devID, k.data, k.devID, sizeof(DTYPE) * num * dim);
+    XMemCopy((DTYPE*)valueBuf.data + offset, valueBuf.devID, v.data, v.devID, sizeof(DTYPE) * num * dim);
+
+    int* rows = rowIndex + length * rowNum;
+    for (int i = 0; i < num; i++)
+        rows[i] = i;
+
+    stateNum = num;
+    length++;
+}
+
+/*
+free the keys and values, e.g., before the memory pool that keeps them is
+cleared. The buffers are allocated again at the next miss.
+*/
+void Cache::Clear()
+{
+    key.DestroyData();
+    value.DestroyData();
+    keyBuf.DestroyData();
+    valueBuf.DestroyData();
+    miss = true;
+    buffered = false;
+    length = 0;
+    stateNum = 0;
 }
 
 /* keep alive states */
 void Cache::KeepAlive(XTensor& aliveIdx)
 {
-    if (!miss) {
-        key = AutoGather(key, aliveIdx);
-        value = AutoGather(value, aliveIdx);
-    }
+    Reorder(aliveIdx);
 }
 
-/* reorder alive states */
+/*
+reorder alive states. For the buffers, only the index table is updated,
+i.e., the new state i of each step is the state reorder(i) of that step.
+A state is new (and has no key at the previous steps) if its index is -1,
+e.g., the hypothesis of a sentence that joins the batch in the middle of
+the search. The steps that no state uses any more are dropped if they are
+at least half of the buffers.
+>> reorder - indices of the states, (B')
+*/
 void Cache::Reorder(XTensor& reorder)
 {
-    if (!miss) {
+    if (miss)
+        return;
+
+    if (!buffered) {
         key = AutoGather(key, reorder);
         value = AutoGather(value, reorder);
+        return;
     }
+
+    CheckNTErrors(reorder.devID < 0 && reorder.dataType == X_INT, "The states must be indexed on CPUs!");
+
+    const int num = reorder.unitNum;
+    const int* order = (int*)reorder.data;
+
+    if (num > keyBuf.GetDim(1))
+        GrowRows(num);
+
+    const int rowNum = keyBuf.GetDim(1);
+
+    /* the first step that is used by any state */
+    int first = length;
+
+    int* rows = new int[num];
+    for (int t = 0; t < length; t++) {
+        int* rowsT = rowIndex + t * rowNum;
+        for (int i = 0; i < num; i++) {
+            CheckNTErrors(order[i] >= -1 && order[i] < stateNum, "Wrong state index!");
+            rows[i] = order[i] >= 0 ? rowsT[order[i]] : -1;
+            if (rows[i] >= 0 && t < first)
+                first = t;
+        }
+        memcpy(rowsT, rows, sizeof(int) * num);
+    }
+    delete[] rows;
+
+    stateNum = num;
+
+    if (first > 0 && first * 2 >= length)
+        DropSteps(first);
+}
+
+/*
+make the buffers keep more states at each step
+>> num - the number of states
+*/
+void Cache::GrowRows(int num)
+{
+    const int maxLen = keyBuf.GetDim(0);
+    const int rowNum = keyBuf.GetDim(1);
+    const int dim = keyBuf.GetDim(2);
+    const int newRowNum = MAX(num, rowNum * 2);
+
+    XTensor newKeyBuf;
+    XTensor newValueBuf;
+    InitTensor3D(&newKeyBuf, maxLen, newRowNum, dim, X_FLOAT, keyBuf.devID);
+    InitTensor3D(&newValueBuf, maxLen, newRowNum, dim, X_FLOAT, keyBuf.devID);
+    int* newRowIndex = new int[maxLen * newRowNum];
+
+    size_t size = (size_t)rowNum * dim * sizeof(DTYPE);
+    for (int t = 0; t < length; t++) {
+        XMemCopy((DTYPE*)newKeyBuf.data + (size_t)t * newRowNum * dim, newKeyBuf.devID,
+                 (DTYPE*)keyBuf.data + (size_t)t * rowNum * dim, keyBuf.devID, size);
+        XMemCopy((DTYPE*)newValueBuf.data + (size_t)t * newRowNum * dim, newValueBuf.devID,
+                 (DTYPE*)valueBuf.data + (size_t)t * rowNum * dim, valueBuf.devID, size);
+        memcpy(newRowIndex + t * newRowNum, rowIndex + t * rowNum, sizeof(int) * stateNum);
+    }
+
+    keyBuf = std::move(newKeyBuf);
+    valueBuf = std::move(newValueBuf);
+    delete[] rowIndex;
+    rowIndex = newRowIndex;
+}
+
+/*
+drop the first steps of the buffers (no state uses them)
+>> num - the number of steps
+*/
+void Cache::DropSteps(int num)
+{
+    CheckNTErrors(keyBuf.devID < 0, "The buffers must be on CPUs!");
+
+    const int rowNum = keyBuf.GetDim(1);
+    const int dim = keyBuf.GetDim(2);
+    const int rest = length - num;
+
+    size_t stepSize = (size_t)rowNum * dim;
+    memmove(keyBuf.data, (DTYPE*)keyBuf.data + num * stepSize, sizeof(DTYPE) * rest * stepSize);
+    memmove(valueBuf.data, (DTYPE*)valueBuf.data + num * stepSize, sizeof(DTYPE) * rest * stepSize);
+    memmove(rowIndex, rowIndex + num * rowNum, sizeof(int) * rest * rowNum);
+
+    length = rest;
+}
+
+/*
+keep the keys and values of some states and append those of new states
+(for the caches that are not buffered, e.g., the encoder-decoder attention)
+>> states - indices of the states to keep
+>> k - the keys of the new states, (B'', L'', H)
+>> v - the values of the new states, (B'', L'', H)
+*/
+void Cache::KeepAndAppend(IntList& states, XTensor& k, XTensor& v)
+{
+    CheckNTErrors(!buffered, "The buffers cannot be extended in this way!");
+
+    key = nmt::KeepAndAppend(key, states, k);
+    value = nmt::KeepAndAppend(value, states, v);
+    miss = false;
 }
 
 } /* end of the nmt namespace */
\ No newline at end of file
@@ -46,6 +46,24 @@ public:
     /* cache for values, (B, L, H) */
     XTensor value;
 
+    /* preallocated buffer of keys for incremental decoding, (L, B, H) */
+    XTensor keyBuf;
+
+    /* preallocated buffer of values for incremental decoding, (L, B, H) */
+    XTensor valueBuf;
+
+    /* the row of each state in the buffers at each step, (L, B) */
+    int* rowIndex;
+
+    /* the number of steps that the buffers are reserved for */
+    int reservedLen;
+
+    /* the number of steps kept in the buffers */
+    int length;
+
+    /* the number of states in the current step */
+    int stateNum;
+
 public:
     /* indicates cache miss if 'true' */
     bool miss;
@@ -53,14 +71,39 @@ public:
     /* indicates whether we use cache */
     bool enabled;
 
+    /* indicates whether the keys and values are kept in the buffers */
+    bool buffered;
+
     /* constructor */
     Cache();
 
+    /* de-constructor */
+    ~Cache();
+
+    /* reserve the buffers for a number of steps */
+    void Reserve(int maxLen);
+
+    /* append the keys and values of a new step to the buffers */
+    void Append(XTensor& k, XTensor& v);
+
     /* keep alive states */
     void KeepAlive(XTensor& aliveIdx);
 
     /* reorder alive states */
     void Reorder(XTensor& reorder);
+
+    /* keep the keys and values of some states and append those of new states */
+    void KeepAndAppend(IntList& states, XTensor& k, XTensor& v);
+
+    /* free the keys and values */
+    void Clear();
+
+private:
+    /* make the buffers keep more states at each step */
+    void GrowRows(int num);
+
+    /* drop the first steps of the buffers */
+    void DropSteps(int num);
 };
 
 /* multi-head attention */
@@ -124,6 +167,32 @@ public:
     /* the maximum relative window size */
     int maxRP;
 
+    /* int8 copies of the transformation matrices (for inference on CPUs) */
+    QuantizedWeight qWeightQ;
+    QuantizedWeight qWeightK;
+    QuantizedWeight qWeightV;
+    QuantizedWeight qWeightO;
+
+    /* packed copies of the transformation matrices (for inference on CPUs) */
+    XPackedMatrix pWeightQ;
+    XPackedMatrix pWeightK;
+    XPackedMatrix pWeightV;
+    XPackedMatrix pWeightO;
+
+    /* number of the transformation matrices that are merged into weightQKV,
+       i.e., 3 for Q, K and V, 2 for K and V, and 0 if they are not merged */
+    int mergedNum;
+
+    /* the merged transformation matrix, H * (mergedNum * H) (for inference) */
+    XTensor weightQKV;
+
+    /* the merged bias */
+    XTensor biasQKV;
+
+    /* int8 and packed copies of the merged transformation matrix */
+    QuantizedWeight qWeightQKV;
+    XPackedMatrix pWeightQKV;
+
 public:
     /* set the training flag */
     void SetTrainingFlag(bool myIsTraining);
@@ -140,13 +209,34 @@ public:
     /* initialize the model */
     void InitModel(NMTConfig& config, bool isEnc, bool isSelfAtt);
 
+    /* quantize the transformation matrices into int8 */
+    void QuantizeINT8();
+
+    /* pack the transformation matrices for the matrix multiplication */
+    void PackWeights();
+
+    /* merge the transformation matrices of Q, K and V (or K and V) */
+    void MergeWeights(bool isSelfAtt);
+
     /* make the network */
     XTensor Make(XTensor& k, XTensor& q, XTensor& v,
                  XTensor* mask, Cache* cache, int cacheType);
 
+    /* transform the inputs into keys and values */
+    void MakeKeysAndValues(XTensor& x, XTensor& k, XTensor& v);
+
+    /* transform the inputs of keys and values */
+    void MakeKeysAndValues(XTensor& k, XTensor& v, XTensor& k2, XTensor& v2);
+
     /* make the attention network given keys, queries and values (after linear transformation) */
     XTensor MakeAttention(XTensor& k, XTensor& q, XTensor& v, XTensor* mask, bool isEnc);
 
+    /* make the attention network given the heads of keys, queries and values */
+    XTensor MakeHeadAttention(XTensor& k, XTensor& q, XTensor& v, XTensor* mask);
+
+    /* make the attention network given the merged projections of the inputs */
+    XTensor MakeMergedAttention(XTensor& qkv, XTensor* mask);
+
     /* make the attention network given keys, queries and values (after linear transformation) */
     XTensor MakeRPRAttention(XTensor& k, XTensor& q, XTensor& v, XTensor* mask, bool isEnc);
 
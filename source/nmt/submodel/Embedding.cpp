@@ -118,14 +118,23 @@ void Embedder::MakePosEmbedding(int length)
     delete[] data;
 }
 
+/* quantize the word embedding matrix into int8 (a scale for each word) */
+void Embedder::QuantizeINT8()
+{
+    qw.Quantize(*w, X_TRANS);
+}
+
 /*
 make the network
 >> input - the word indices
 >> nstep - the length of current sequence
 >> isDec - indicates whether it is decoder
+>> steps - the step of each sequence during decoding, (B), e.g., the sequences
+           that join the batch at different steps (NULL if all the sequences
+           are at step nstep)
 << return - word & position embeddings of the input
 */
-XTensor Embedder::Make(XTensor& input, bool isDec, int nstep)
+XTensor Embedder::Make(XTensor& input, bool isDec, int nstep, XTensor* steps)
 {
     /* make sure the padding index is 1 */
     CheckNTErrors(input.order > 1, "Wrong input tensor size!");
@@ -135,24 +144,38 @@ XTensor Embedder::Make(XTensor& input, bool isDec, int nstep)
 
     XTensor wordEmbedding, position, posEmbedding;
 
-    InitTensor1D(&position, input.GetDim(-1), X_INT, devID);
-
-    if (!isDec || isTraining || input.GetDim(-1) > 1) {
-        SetAscendingOrder(position, 0);
-        ScaleAndShiftMe(position, 1.0F, float(padIdx + 1));
+    if (steps != NULL) {
+        /* decoder embeddings of the sequences at different steps */
+        CheckNTErrors(isDec && input.GetDim(-1) == 1 && steps->unitNum == input.unitNum,
+                      "Wrong steps of the sequences!");
+        position = ScaleAndShift(*steps, 1.0F, float(padIdx + 1));
+        posEmbedding = Gather(posEmbeddingBase, position);
+        int dims[3] = { input.GetDim(0), 1, eSize };
+        posEmbedding.Reshape(3, dims);
     }
     else {
-        /* decoder embeddings during decoding */
-        position.SetDataFixed(nstep + padIdx + 1);
-    }
+        InitTensor1D(&position, input.GetDim(-1), X_INT, devID);
 
-    /* we make positional embeddings first */
-    XTensor embTMP;
-    embTMP = Gather(posEmbeddingBase, position);
-    posEmbedding = Unsqueeze(embTMP, 0, input.GetDim(0), /*inplace=*/isTraining);
+        if (!isDec || isTraining || input.GetDim(-1) > 1) {
+            SetAscendingOrder(position, 0);
+            ScaleAndShiftMe(position, 1.0F, float(padIdx + 1));
+        }
+        else {
+            /* decoder embeddings during decoding */
+            position.SetDataFixed(nstep + padIdx + 1);
+        }
+
+        /* we make positional embeddings first */
+        XTensor embTMP;
+        embTMP = Gather(posEmbeddingBase, position);
+        posEmbedding = Unsqueeze(embTMP, 0, input.GetDim(0), /*inplace=*/isTraining);
+    }
 
     /* then we make word embeddings */
-    wordEmbedding = Gather(*w, input);
+    if (qw.enabled)
+        wordEmbedding = GatherINT8(qw.weight, qw.scale, input);
+    else
+        wordEmbedding = Gather(*w, input);
 
     if (isTraining)
         wordEmbedding = Linear(wordEmbedding, sqrtf((float)eSize), 0.0F, true);
@@ -23,6 +23,7 @@
 #ifndef __EMBEDDING_H__
 #define __EMBEDDING_H__
 
+#include "NNUtil.h"
 #include "../Config.h"
 #include "../../niutensor/network/XNet.h"
 
@@ -68,6 +69,9 @@ public:
     /* word embedding matrix */
     XTensor* w;
 
+    /* int8 copy of the word embedding matrix (quantized per word) */
+    QuantizedWeight qw;
+
     /* predefined positional embeddings. It can speeds up
        the embedding processing by re-loading. */
     XTensor posEmbeddingBase;
@@ -88,8 +92,11 @@ public:
     /* make positional embeddings */
     void MakePosEmbedding(int length);
 
+    /* quantize the word embedding matrix into int8 */
+    void QuantizeINT8();
+
     /* make the network */
-    XTensor Make(XTensor& input, bool isDec, int nstep);
+    XTensor Make(XTensor& input, bool isDec, int nstep, XTensor* steps = NULL);
 };
 
 } /* end of the nmt namespace */
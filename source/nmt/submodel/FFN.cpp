@@ -81,6 +81,25 @@ void FFN::InitModel(NMTConfig& config, bool isEnc)
     }
 }
 
+/* quantize the transformation matrices into int8 (per output channel) */
+void FFN::QuantizeINT8()
+{
+    qw1.Quantize(w1, X_NOTRANS);
+    qw2.Quantize(w2, X_NOTRANS);
+}
+
+/*
+pack the transformation matrices for the matrix multiplication (for
+inference on CPUs). The float matrices are released.
+*/
+void FFN::PackWeights()
+{
+    pw1.Pack(&w1, X_NOTRANS);
+    pw2.Pack(&w2, X_NOTRANS);
+    w1.DestroyData();
+    w2.DestroyData();
+}
+
 /*
 make the network
 y = max(0, x * w1 + b1) * w2 + b2
@@ -92,13 +111,39 @@ XTensor FFN::Make(XTensor& input)
     XTensor t1;
 
     /* t1 = max(0, x * w1 + b1) */
-    t1 = Rectify(MulAndShift(input, w1, b1));
+    if (isTraining)
+        t1 = Rectify(AutoMulAndShift(input, w1, b1, qw1, pw1));
+    else
+        t1 = AutoMulAndShift(input, w1, b1, qw1, pw1, true, NULL);
     
     if (isTraining && dropoutP > 0)
         t1 = Dropout(t1, dropoutP, /*inplace=*/isTraining);
 
     /* result = t1 * w2 + b2 */
-    return MulAndShift(t1, w2, b2);
+    return AutoMulAndShift(t1, w2, b2, qw2, pw2);
+}
+
+/*
+make the network with a residual connection (for inference)
+y = max(0, x * w1 + b1) * w2 + b2 + residual
+where the activation and the residual connection are applied with
+the two linear transformations (without intermediate tensors)
+>> input - the input tensor
+>> residual - the residual
+>> return - the output tensor
+*/
+XTensor FFN::Make(XTensor& input, XTensor& residual)
+{
+    if (isTraining)
+        return Sum(Make(input), residual);
+
+    XTensor t1;
+
+    /* t1 = max(0, x * w1 + b1) */
+    t1 = AutoMulAndShift(input, w1, b1, qw1, pw1, true, NULL);
+
+    /* result = t1 * w2 + b2 + residual */
+    return AutoMulAndShift(t1, w2, b2, qw2, pw2, false, &residual);
 }
 
 } /* end of the nmt namespace */
\ No newline at end of file
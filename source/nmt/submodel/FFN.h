@@ -23,6 +23,7 @@
 #ifndef __FFN_H__
 #define __FFN_H__
 
+#include "NNUtil.h"
 #include "LayerNorm.h"
 #include "../Config.h"
 //#include "../../niutensor/tensor/XTensor.h"
@@ -67,6 +68,14 @@ public:
     /* dropout probability */
     DTYPE dropoutP;
 
+    /* int8 copies of the transformation matrices (for inference on CPUs) */
+    QuantizedWeight qw1;
+    QuantizedWeight qw2;
+
+    /* packed copies of the transformation matrices (for inference on CPUs) */
+    XPackedMatrix pw1;
+    XPackedMatrix pw2;
+
 public:
     /* set the training flag */
     void SetTrainingFlag(bool myIsTraining);
@@ -80,8 +89,17 @@ public:
     /* initialize the model */
     void InitModel(NMTConfig& config, bool isEnc);
 
+    /* quantize the transformation matrices into int8 */
+    void QuantizeINT8();
+
+    /* pack the transformation matrices for the matrix multiplication */
+    void PackWeights();
+
     /* make the network */
     XTensor Make(XTensor& input);
+
+    /* make the network with a residual connection */
+    XTensor Make(XTensor& input, XTensor& residual);
 };
 
 } /* end of the nmt namespace */
@@ -104,22 +104,33 @@ the Add operation
 */
 void LayerHistory::Add(XTensor& layer)
 {
-    /* the embedding is not normed */
     count += 1;
-    if (history->count == 0) {
-        history->Add(layer);
+    Add(layer, *history);
+}
+
+/*
+the Add operation on a given history. The history is kept by the caller,
+so that the module itself is not changed in inference.
+>> layer - the previous layer output (B * L * H)
+>> h - the history
+*/
+void LayerHistory::Add(XTensor& layer, History& h)
+{
+    /* the embedding is not normed */
+    if (h.count == 0) {
+        h.Add(layer);
         return;
     }
     XTensor normed;
     if (preLN) {
         /* normalize the layer */
-        normed = layerNorms[count - 2].Run(layer);
+        normed = layerNorms[h.count - 1].Run(layer);
     }
     else {
         normed = layer;
     }
     
-    history->Add(normed);
+    h.Add(normed);
 }
 
 /*
@@ -129,10 +140,20 @@ result = sum(layers[0...i] * weight[i][0...i])
 shape of the result: B * L * H
 */
 XTensor LayerHistory::Pop()
+{
+    return Pop(*history);
+}
+
+/*
+calculate the weighted sum of previous layers in a given history
+>> h - the history
+<< return - the weighted sum (B * L * H)
+*/
+XTensor LayerHistory::Pop(History& h)
 {
     TensorList list;
-    for (int i = 0; i < history->count; i++) {
-        list.Add(&(history->list[i]));
+    for (int i = 0; i < h.count; i++) {
+        list.Add(&(h.list[i]));
     }
     XTensor stack;
     stack = Merge(list, 0);
@@ -156,8 +177,8 @@ XTensor LayerHistory::Pop()
         /* delete unused data to save memory */
         multiplication.DestroyData();
 
-        if (!preLN && count > 1) {
-            res = layerNorms[count - 2].Run(res);
+        if (!preLN && h.count > 1) {
+            res = layerNorms[h.count - 2].Run(res);
         }
         return res;
     }
@@ -175,8 +196,8 @@ XTensor LayerHistory::Pop()
         if (res.dataType != stack.dataType) {
             res = ConvertDataType(res, stack.dataType);
         }
-        if (!preLN && count > 1) {
-            res = layerNorms[count - 2].Run(res);
+        if (!preLN && h.count > 1) {
+            res = layerNorms[h.count - 2].Run(res);
         }
         return res;
     }
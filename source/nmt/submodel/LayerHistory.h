@@ -108,10 +108,16 @@ public:
     /* add the layer output to the history */
     void Add(XTensor& tensor);
 
+    /* add the layer output to a given history (for inference) */
+    void Add(XTensor& tensor, History& h);
+
     /* compute the layer input for the current layer, 
        the weight sum of all previous layer output after normed in the history */
     XTensor Pop();
 
+    /* compute the layer input for the current layer from a given history (for inference) */
+    XTensor Pop(History& h);
+
     /* clean the history*/
     void ClearHistory(bool reset=true);
 };
@@ -74,12 +74,62 @@ initialize the model
 */
 XTensor LayerNorm::Run(XTensor& input)
 {
+    /* the fused operation for faster inference on CPUs */
+    if (!isTraining && IsAddNormalizable(&input, NULL, &weight, &bias)) {
+        XTensor output(&input);
+        output.SetTMPFlag();
+        _AddNormalize(&input, NULL, &output, &weight, &bias, 0.0F, isL1Normed);
+        return output;
+    }
+
     if (isL1Normed)
         return RunL1Norm(input);
     else
         return RunL2Norm(input);
 }
 
+/*
+run layernorm after a residual connection, i.e., input = input + residual
+and the result is the layer normalization of the sum (for pre-norm where
+the sum is used later)
+>> input - the input tensor (it keeps the sum)
+>> residual - the residual
+>> return - layer normalization output
+*/
+XTensor LayerNorm::Run(XTensor& input, XTensor& residual)
+{
+    /* the fused operation for faster inference on CPUs */
+    if (!isTraining && IsAddNormalizable(&input, &residual, &weight, &bias)) {
+        XTensor output(&input);
+        output.SetTMPFlag();
+        _AddNormalize(&input, &residual, &output, &weight, &bias, 0.0F, isL1Normed);
+        return output;
+    }
+
+    SumMe(input, residual);
+
+    return Run(input);
+}
+
+/*
+run layernorm after a residual connection in place, i.e.,
+input = LN(input + residual) (for post-norm)
+>> input - the input tensor (it keeps the result)
+>> residual - the residual
+*/
+void LayerNorm::RunMe(XTensor& input, XTensor& residual)
+{
+    /* the fused operation for faster inference on CPUs */
+    if (!isTraining && IsAddNormalizable(&input, &residual, &weight, &bias)) {
+        _AddNormalize(&input, &residual, &input, &weight, &bias, 0.0F, isL1Normed);
+        return;
+    }
+
+    SumMe(input, residual);
+
+    input = Run(input);
+}
+
 /*
 run standard layernorm with l2-norm
 >> input - the input tensor
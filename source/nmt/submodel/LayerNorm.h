@@ -66,6 +66,12 @@ public:
     /* run layernorm (wrapper) */
     XTensor Run(XTensor& input);
 
+    /* run layernorm after a residual connection, i.e., input = input + residual */
+    XTensor Run(XTensor& input, XTensor& residual);
+
+    /* run layernorm after a residual connection in place */
+    void RunMe(XTensor& input, XTensor& residual);
+
     /* run layernorm with L2-Norm */
     XTensor RunL2Norm(XTensor& input);
 
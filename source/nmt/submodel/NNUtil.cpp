@@ -68,4 +68,172 @@ XTensor AutoGather(XTensor& src, XTensor& index)
     }
 }
 
+/*
+keep some rows of a tensor and append the rows of another one (on CPUs),
+e.g., the encoder output of the sentences in the batch when some sentences
+are done and some new ones come. The tensors are (B, L) or (B, L, H), and
+the shorter sequences are padded with zeros along the second dimension.
+>> src - the tensor (it is not used if no row is kept)
+>> rows - indices of the rows to keep
+>> appended - the rows to append, (B'', L'') or (B'', L'', H)
+<< return - the result, (B' + B'', max(L, L'')) or (B' + B'', max(L, L''), H)
+*/
+XTensor KeepAndAppend(XTensor& src, IntList& rows, XTensor& appended)
+{
+    CheckNTErrors(appended.order == 2 || appended.order == 3, "Unsupported shape!");
+    CheckNTErrors(appended.devID < 0, "The tensors must be on CPUs!");
+
+    const int keepNum = rows.Size();
+    const int newNum = appended.GetDim(0);
+    const int width = appended.order == 3 ? appended.GetDim(2) : 1;
+    const int srcLen = keepNum > 0 ? src.GetDim(1) : 0;
+    const int newLen = appended.GetDim(1);
+    const int len = MAX(srcLen, newLen);
+
+    if (keepNum > 0) {
+        CheckNTErrors(src.devID < 0 && src.order == appended.order && src.dataType == appended.dataType,
+                      "Unmatched tensors!");
+        CheckNTErrors(appended.order == 2 || src.GetDim(2) == width, "Unmatched tensors!");
+    }
+
+    XTensor res;
+    int dims[3] = { keepNum + newNum, len, width };
+    InitTensor(&res, appended.order, dims, appended.dataType, -1);
+    if (srcLen != newLen)
+        res.SetZeroAll();
+
+    const size_t unitSize = appended.unitSize;
+    const size_t rowSize = (size_t)len * width * unitSize;
+    const size_t srcRowSize = (size_t)srcLen * width * unitSize;
+    const size_t newRowSize = (size_t)newLen * width * unitSize;
+    char* data = (char*)res.data;
+
+    for (int i = 0; i < keepNum; i++) {
+        int row = rows[i];
+        CheckNTErrors(row >= 0 && row < src.GetDim(0), "Wrong row index!");
+        memcpy(data + i * rowSize, (char*)src.data + row * srcRowSize, srcRowSize);
+    }
+    for (int i = 0; i < newNum; i++)
+        memcpy(data + (keepNum + i) * rowSize, (char*)appended.data + i * newRowSize, newRowSize);
+
+    return res;
+}
+
+/* constructor */
+QuantizedWeight::QuantizedWeight()
+{
+    enabled = false;
+}
+
+/*
+quantize a float weight matrix. The float weight is released
+afterwards to save the memory, so it is only used for inference.
+>> w - the weight matrix
+>> transposed - X_NOTRANS if it is used as x * w, or X_TRANS if it is used as x * trans(w)
+*/
+void QuantizedWeight::Quantize(XTensor& w, MATRIX_TRANS_TYPE transposed)
+{
+    CheckNTErrors(w.devID < 0, "INT8 inference is only supported on CPUs!");
+
+    int n = transposed == X_TRANS ? w.dimSize[0] : w.dimSize[1];
+    int k = transposed == X_TRANS ? w.dimSize[1] : w.dimSize[0];
+
+    InitTensor2D(&weight, n, k, X_INT8, w.devID, false);
+    InitTensor1D(&scale, n, X_FLOAT, w.devID, false);
+
+    _QuantizeINT8(&w, transposed, &weight, &scale);
+
+    w.DestroyData();
+    enabled = true;
+}
+
+/*
+keep some output channels of another quantized weight, e.g., the
+words in the vocabulary shortlist of the output layer
+>> src - the quantized weight
+>> rows - the output channels to keep (on CPUs)
+*/
+void QuantizedWeight::SelectRows(const QuantizedWeight& src, const XTensor& rows)
+{
+    CheckNTErrors(src.enabled, "The weight is not quantized!");
+    CheckNTErrors(rows.devID < 0 && rows.dataType == X_INT, "The rows must be integers on CPUs!");
+
+    int n = rows.unitNum;
+    int k = src.weight.GetDim(1);
+
+    InitTensor2D(&weight, n, k, X_INT8, src.weight.devID, false);
+    InitTensor1D(&scale, n, X_FLOAT, src.scale.devID, false);
+
+    const int* r = (int*)rows.data;
+    const signed char* w = (signed char*)src.weight.data;
+    const DTYPE* sc = (DTYPE*)src.scale.data;
+    for (int i = 0; i < n; i++) {
+        CheckNTErrors(r[i] >= 0 && r[i] < src.weight.GetDim(0), "Wrong row index!");
+        memcpy((signed char*)weight.data + (size_t)i * k, w + (size_t)r[i] * k, k);
+        ((DTYPE*)scale.data)[i] = sc[r[i]];
+    }
+
+    enabled = true;
+}
+
+/*
+the linear transformation that uses the int8 or the packed weight if it is available
+>> x - the input tensor
+>> w - the float weight, used as x * w
+>> b - the bias
+>> qw - the quantized weight
+>> pw - the packed weight
+<< return - x * w + b
+*/
+XTensor AutoMulAndShift(const XTensor& x, const XTensor& w, const XTensor& b,
+                        const QuantizedWeight& qw, const XPackedMatrix& pw)
+{
+    if (qw.enabled)
+        return MulAndShiftINT8(x, qw.weight, qw.scale, b);
+
+    if (IsMulAndShiftFusable(&x, &pw, &b, NULL))
+        return MulAndShift(x, pw, b, false, NULL);
+
+    return MulAndShift(x, w, b);
+}
+
+/*
+the linear transformation with the activation and the residual connection,
+i.e., f(x * w + b) + residual where f is ReLU if rectify is true. On CPUs
+they are applied to the blocks of the matrix multiplication as soon as
+the blocks are computed (or in one pass after it if BLAS is used). It is for inference only, and the separate operations
+are used if _MulAndShift does not fit the tensors (e.g., on GPUs).
+>> x - the input tensor
+>> w - the float weight, used as x * w
+>> b - the bias
+>> qw - the quantized weight
+>> pw - the packed weight
+>> rectify - apply ReLU to the shifted result
+>> residual - the residual (NULL if there is no residual)
+<< return - f(x * w + b) + residual
+*/
+XTensor AutoMulAndShift(const XTensor& x, const XTensor& w, const XTensor& b,
+                        const QuantizedWeight& qw, const XPackedMatrix& pw,
+                        bool rectify, const XTensor* residual)
+{
+    if (qw.enabled)
+        return MulAndShiftINT8(x, qw.weight, qw.scale, b, rectify, residual);
+
+    if (IsMulAndShiftFusable(&x, &pw, &b, residual))
+        return MulAndShift(x, pw, b, rectify, residual);
+
+    if (IsMulAndShiftFusable(&x, &w, &b, residual))
+        return MulAndShift(x, w, b, rectify, residual);
+
+    XTensor y = MulAndShift(x, w, b);
+
+    if (rectify)
+        y = Rectify(y);
+
+    if (residual != NULL)
+        SumMe(y, *residual);
+
+    return y;
+}
+
 } /* end of the nmt namespace */
\ No newline at end of file
@@ -35,6 +35,42 @@ namespace nmt
 /* the gather function for tensor with any dimension */
 XTensor AutoGather(XTensor& src, XTensor& index);
 
+/* keep some rows of a tensor and append the rows of another one (on CPUs) */
+XTensor KeepAndAppend(XTensor& src, IntList& rows, XTensor& appended);
+
+/* a weight matrix quantized into int8 per output channel (for inference on CPUs) */
+class QuantizedWeight
+{
+public:
+    /* the int8 weight, (output channels, input channels) */
+    XTensor weight;
+
+    /* the scale of each output channel */
+    XTensor scale;
+
+    /* indicates whether the weight is quantized */
+    bool enabled;
+
+public:
+    /* constructor */
+    QuantizedWeight();
+
+    /* quantize a float weight matrix */
+    void Quantize(XTensor& w, MATRIX_TRANS_TYPE transposed);
+
+    /* keep some output channels of another quantized weight */
+    void SelectRows(const QuantizedWeight& src, const XTensor& rows);
+};
+
+/* the linear transformation that uses the int8 or the packed weight if it is available */
+XTensor AutoMulAndShift(const XTensor& x, const XTensor& w, const XTensor& b,
+                        const QuantizedWeight& qw, const XPackedMatrix& pw);
+
+/* the linear transformation with the activation and the residual connection (for inference) */
+XTensor AutoMulAndShift(const XTensor& x, const XTensor& w, const XTensor& b,
+                        const QuantizedWeight& qw, const XPackedMatrix& pw,
+                        bool rectify, const XTensor* residual);
+
 } /* end of the nmt namespace */
 
 #endif /* __NNUTIL_H__ */
\ No newline at end of file
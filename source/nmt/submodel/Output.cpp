@@ -28,6 +28,12 @@
 namespace nmt
 {
 
+/* constructor */
+OutputShortlist::OutputShortlist()
+{
+    enabled = false;
+}
+
 /* set the training flag */
 void OutputLayer::SetTrainingFlag(bool myIsTraining)
 {
@@ -38,6 +44,7 @@ void OutputLayer::SetTrainingFlag(bool myIsTraining)
 OutputLayer::OutputLayer()
 {
     weight = NULL;
+    qWeight = NULL;
     devID = -1;
     vSize = -1;
     hSize = -1;
@@ -48,8 +55,10 @@ OutputLayer::OutputLayer()
 /* de-constructor */
 OutputLayer::~OutputLayer()
 {
-    if (!shareDecInputOutputEmb)
+    if (!shareDecInputOutputEmb) {
         DelTensor(weight);
+        delete qWeight;
+    }
 }
 
 /*
@@ -74,21 +83,81 @@ void OutputLayer::InitModel(NMTConfig& config)
     }
 }
 
+/* 
+quantize the transformation matrix into int8 (a scale for each word).
+NOTE: the weight is quantized by the decoder embedder when they are shared.
+*/
+void OutputLayer::QuantizeINT8()
+{
+    if (shareDecInputOutputEmb)
+        return;
+
+    if (qWeight == NULL)
+        qWeight = new QuantizedWeight();
+    qWeight->Quantize(*weight, X_TRANS);
+}
+
+/*
+pack the transposed transformation matrix for the matrix multiplication
+(for inference on CPUs). The float matrix is kept for the shortlist and
+the decoder embeddings.
+*/
+void OutputLayer::PackWeights()
+{
+    pWeight.Pack(weight, X_TRANS);
+}
+
+/*
+restrict the output to a shortlist of words (for inference). The rows of
+the transformation matrix are gathered once here, so that each step only
+projects the input onto the shortlist.
+>> candidates - the words in the shortlist, (V'), or NULL for the whole vocabulary
+>> shortlist - the restricted output layer
+*/
+void OutputLayer::SetShortlist(XTensor* candidates, OutputShortlist& shortlist)
+{
+    shortlist.enabled = (candidates != NULL);
+
+    if (!shortlist.enabled) {
+        shortlist.weight.DestroyData();
+        shortlist.qWeight.weight.DestroyData();
+        shortlist.qWeight.scale.DestroyData();
+        shortlist.qWeight.enabled = false;
+        return;
+    }
+
+    if (qWeight != NULL && qWeight->enabled)
+        shortlist.qWeight.SelectRows(*qWeight, *candidates);
+    else
+        shortlist.weight = Gather(*weight, *candidates);
+}
+
 /*
 project the output from the embedding space (E) to the vocabulary space (V)
 >> input - the input tensor, the shape is (B, L, E)
 >> normalized - whether ignore the log-softmax operation
-<< output - the output tensor, the shape is (B, L, V)
+>> shortlist - the output layer restricted to a shortlist (NULL for the whole vocabulary)
+<< output - the output tensor, the shape is (B, L, V), or (B, L, V') for the shortlist
 */
-XTensor OutputLayer::Make(XTensor& input, bool normalized)
+XTensor OutputLayer::Make(XTensor& input, bool normalized, OutputShortlist* shortlist)
 {
     XTensor output;
-
-    output = MMul(input, X_NOTRANS, *weight, X_TRANS);
-
-    /* use softmax for training */
+    bool useShortlist = (shortlist != NULL && shortlist->enabled);
+
+    if (useShortlist && shortlist->qWeight.enabled)
+        output = MMulINT8(input, shortlist->qWeight.weight, shortlist->qWeight.scale);
+    else if (useShortlist)
+        output = MMul(input, X_NOTRANS, shortlist->weight, X_TRANS);
+    else if (qWeight != NULL && qWeight->enabled)
+        output = MMulINT8(input, qWeight->weight, qWeight->scale);
+    else if (pWeight.enabled && input.devID < 0 && input.dataType == X_FLOAT)
+        output = MMulPacked(input, pWeight);
+    else
+        output = MMul(input, X_NOTRANS, *weight, X_TRANS);
+
+    /* use softmax for training, or keep the logits for the loss that normalizes them */
     if (weight->enableGrad)
-        return Softmax(output, -1);
+        return normalized ? Softmax(output, -1) : output;
 
     /* normalize the output for beam search */
     if (normalized) {
@@ -24,6 +24,7 @@
 #define __OUTPUT_H__
 
 #include <memory>
+#include "NNUtil.h"
 #include "../Config.h"
 #include "../../niutensor/tensor/function/FHeader.h"
 
@@ -33,6 +34,23 @@ using namespace nts;
 namespace nmt
 {
 
+/* the output layer restricted to a shortlist of words. It is a part of the
+   inference state, so that the output layer itself is kept read-only. */
+struct OutputShortlist
+{
+    /* indicates whether the output is restricted to the shortlist */
+    bool enabled;
+
+    /* the rows of the transformation matrix for the shortlist, (V', H) */
+    XTensor weight;
+
+    /* int8 copy of the rows for the shortlist */
+    QuantizedWeight qWeight;
+
+    /* constructor */
+    OutputShortlist();
+};
+
 /* output layer */
 class OutputLayer
 {
@@ -55,6 +73,13 @@ public:
     /* transformation matrix */
     XTensor* weight;
 
+    /* int8 copy of the transformation matrix (it is shared with the
+       decoder embeddings if shareDecInputOutputEmb is set) */
+    QuantizedWeight* qWeight;
+
+    /* packed copy of the transposed transformation matrix (for inference on CPUs) */
+    XPackedMatrix pWeight;
+
 public:
     /* set the training flag */
     void SetTrainingFlag(bool myIsTraining);
@@ -68,8 +93,17 @@ public:
     /* initialize the model */
     void InitModel(NMTConfig& config);
 
+    /* quantize the transformation matrix into int8 */
+    void QuantizeINT8();
+
+    /* pack the transformation matrix for the matrix multiplication */
+    void PackWeights();
+
+    /* restrict the output to a shortlist of words */
+    void SetShortlist(XTensor* candidates, OutputShortlist& shortlist);
+
     /* make the network */
-    XTensor Make(XTensor& input, bool normalized);
+    XTensor Make(XTensor& input, bool normalized, OutputShortlist* shortlist = NULL);
 };
 
 } /* end of the nmt namespace */
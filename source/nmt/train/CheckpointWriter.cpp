@@ -0,0 +1,251 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "CheckpointWriter.h"
+#include "../../niutensor/tensor/XCall.h"
+#include "../../niutensor/tensor/XModelFile.h"
+#include "../../niutensor/tensor/XUtility.h"
+#include "../../niutensor/tensor/core/movement/CopyValues.h"
+#include "../../niutensor/tensor/core/shape/IsSameShaped.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* constructor */
+CheckpointWriter::CheckpointWriter()
+{
+    step = 0;
+    pending = false;
+    running = false;
+    toStop = false;
+}
+
+/* de-constructor */
+CheckpointWriter::~CheckpointWriter()
+{
+    Stop();
+    ClearStaging(params);
+    ClearStaging(moments);
+    ClearStaging(moments2nd);
+}
+
+/* start the writer thread */
+void CheckpointWriter::Start()
+{
+    if (running)
+        return;
+
+    toStop = false;
+    running = true;
+    worker = thread(&CheckpointWriter::WorkerLoop, this);
+}
+
+/* write the pending checkpoint and stop the writer thread */
+void CheckpointWriter::Stop()
+{
+    if (!running)
+        return;
+
+    {
+        lock_guard<mutex> lock(writerMutex);
+        toStop = true;
+    }
+    todoCond.notify_all();
+
+    worker.join();
+    running = false;
+}
+
+/*
+save a checkpoint. The data is copied into the staging tensors, and the
+files are written by the writer thread (or here if the thread is not
+running). If the previous checkpoint is still being written, we wait
+for it first, as the staging tensors are shared by the checkpoints.
+>> myParams - the parameters
+>> myMoments - the moments of the parameters (for the optimizer state)
+>> myMoments2nd - the 2nd order moments of the parameters
+>> myMeta - the meta data of the model file
+>> myStep - the training step
+>> myFiles - the files to write
+*/
+void CheckpointWriter::Save(TensorList& myParams, TensorList& myMoments, TensorList& myMoments2nd,
+                            vector<char>& myMeta, int myStep, vector<CheckpointFile>& myFiles)
+{
+    Wait();
+
+    Snapshot(myParams, params);
+    Snapshot(myMoments, moments);
+    Snapshot(myMoments2nd, moments2nd);
+
+    {
+        lock_guard<mutex> lock(writerMutex);
+        meta = myMeta;
+        step = myStep;
+        files = myFiles;
+        pending = true;
+    }
+
+    if (running)
+        todoCond.notify_one();
+    else
+        Write();
+}
+
+/* wait until the pending checkpoint is written */
+void CheckpointWriter::Wait()
+{
+    unique_lock<mutex> lock(writerMutex);
+    doneCond.wait(lock, [this] { return !pending; });
+}
+
+/*
+copy a list of tensors into the staging tensors. The staging tensors
+are created (on the host) when they do not fit the source tensors.
+>> source - the tensors to copy
+>> staging - the staging tensors
+*/
+void CheckpointWriter::Snapshot(TensorList& source, TensorList& staging)
+{
+    bool fit = source.Size() == staging.Size();
+    for (int i = 0; fit && i < source.Size(); i++)
+        fit = _IsSameShaped(source[i], staging[i]);
+
+    if (!fit) {
+        ClearStaging(staging);
+        for (int i = 0; i < source.Size(); i++) {
+            XTensor* t = new XTensor();
+            InitTensorOnCPU(t, source[i]);
+            t->enableGrad = false;
+            staging.Add(t);
+        }
+    }
+
+    for (int i = 0; i < source.Size(); i++) {
+        staging[i]->SetName(source[i]->name);
+        _CopyValues(source[i], staging[i]);
+    }
+}
+
+/*
+release the staging tensors
+>> staging - the staging tensors
+*/
+void CheckpointWriter::ClearStaging(TensorList& staging)
+{
+    for (int i = 0; i < staging.Size(); i++)
+        delete staging[i];
+    staging.Clear();
+}
+
+/* write the files of the checkpoint in the staging tensors */
+void CheckpointWriter::Write()
+{
+    for (size_t i = 0; i < files.size(); i++)
+        WriteFile(files[i]);
+
+    {
+        lock_guard<mutex> lock(writerMutex);
+        pending = false;
+    }
+    doneCond.notify_all();
+}
+
+/*
+write a file of the checkpoint. The model is written into a temporary
+file, followed by the optimizer state (the step number, the moments and
+the 2nd order moments) if required. The file replaces the old one after
+it is synchronized to the disk, and then the directory is synchronized
+so that the rename is durable (on POSIX systems).
+>> file - the file to write
+*/
+void CheckpointWriter::WriteFile(const CheckpointFile& file)
+{
+    double startT = GetClockSec();
+
+    string tmpFN = file.fn + ".tmp";
+
+    XModelFile::Write(tmpFN.c_str(), params, meta.data(), meta.size());
+
+    FILE* f = fopen(tmpFN.c_str(), "ab");
+    CheckNTErrors(f, "Cannot open the checkpoint file!");
+
+    if (file.withState) {
+        fwrite(&step, sizeof(step), 1, f);
+        for (int i = 0; i < moments.Size(); i++)
+            fwrite(moments[i]->data, moments[i]->unitSize, moments[i]->unitNum, f);
+        for (int i = 0; i < moments2nd.Size(); i++)
+            fwrite(moments2nd[i]->data, moments2nd[i]->unitSize, moments2nd[i]->unitNum, f);
+    }
+
+    CheckNTErrors(fflush(f) == 0, "Cannot write the checkpoint file!");
+#ifdef _WIN32
+    CheckNTErrors(_commit(_fileno(f)) == 0, "Cannot write the checkpoint file!");
+#else
+    CheckNTErrors(fsync(fileno(f)) == 0, "Cannot write the checkpoint file!");
+#endif
+    CheckNTErrors(fclose(f) == 0, "Cannot write the checkpoint file!");
+
+#ifdef _WIN32
+    /* rename() does not replace an existing file on Windows */
+    remove(file.fn.c_str());
+#endif
+    CheckNTErrors(rename(tmpFN.c_str(), file.fn.c_str()) == 0, "Cannot rename the checkpoint file!");
+
+#ifndef _WIN32
+    /* the rename is kept in the directory, so the directory is synchronized
+       as well, or the old file might come back after a power loss */
+    size_t slash = file.fn.find_last_of('/');
+    string dir = slash == string::npos ? "." : (slash == 0 ? "/" : file.fn.substr(0, slash));
+    int dirFD = open(dir.c_str(), O_RDONLY);
+    CheckNTErrors(dirFD >= 0, "Cannot open the directory of the checkpoint file!");
+    CheckNTErrors(fsync(dirFD) == 0, "Cannot write the checkpoint file!");
+    close(dirFD);
+#endif
+
+    double elapsed = GetClockSec() - startT;
+    LOG("model saved to `%s` (took %.1fs)", file.fn.c_str(), elapsed);
+}
+
+/* the loop of the writer thread */
+void CheckpointWriter::WorkerLoop()
+{
+    while (true) {
+        {
+            unique_lock<mutex> lock(writerMutex);
+            todoCond.wait(lock, [this] { return toStop || pending; });
+            if (!pending)
+                return;
+        }
+
+        Write();
+    }
+}
+
+} /* end of the nmt namespace */
@@ -0,0 +1,130 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The checkpoint writer saves checkpoints in the background. The trainer
+ * only copies the parameters and the optimizer state into staging tensors
+ * on the host, and a writer thread writes them while the training goes on.
+ * A file is written under a temporary name, synchronized to the disk and
+ * then renamed, so that a checkpoint on the disk is never half-written.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __CHECKPOINTWRITER_H__
+#define __CHECKPOINTWRITER_H__
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include "../../niutensor/tensor/XTensor.h"
+
+using namespace std;
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* a file to write for a checkpoint */
+struct CheckpointFile
+{
+    /* name of the file */
+    string fn;
+
+    /* indicates whether the optimizer state is appended to the model */
+    bool withState;
+};
+
+/* the writer of checkpoints */
+class CheckpointWriter
+{
+private:
+    /* the staging tensors of the parameters (on the host) */
+    TensorList params;
+
+    /* the staging tensors of the moments and the 2nd order moments */
+    TensorList moments;
+    TensorList moments2nd;
+
+    /* the meta data of the model file */
+    vector<char> meta;
+
+    /* the training step (of the optimizer state) */
+    int step;
+
+    /* the files of the checkpoint in the staging tensors */
+    vector<CheckpointFile> files;
+
+    /* indicates whether the staging tensors wait to be (or are being) written */
+    bool pending;
+
+    /* the writer thread */
+    thread worker;
+
+    /* indicates whether the writer thread is running */
+    bool running;
+
+    /* a lock and the conditions of the writer */
+    mutex writerMutex;
+    condition_variable todoCond;
+    condition_variable doneCond;
+
+    /* indicates whether the writer thread should stop */
+    bool toStop;
+
+public:
+    /* constructor */
+    CheckpointWriter();
+
+    /* de-constructor */
+    ~CheckpointWriter();
+
+    /* start the writer thread */
+    void Start();
+
+    /* write the pending checkpoint and stop the writer thread */
+    void Stop();
+
+    /* save a checkpoint (in the background if the writer thread is running) */
+    void Save(TensorList& myParams, TensorList& myMoments, TensorList& myMoments2nd,
+              vector<char>& myMeta, int myStep, vector<CheckpointFile>& myFiles);
+
+    /* wait until the pending checkpoint is written */
+    void Wait();
+
+private:
+    /* copy a list of tensors into the staging tensors */
+    static void Snapshot(TensorList& source, TensorList& staging);
+
+    /* release the staging tensors */
+    static void ClearStaging(TensorList& staging);
+
+    /* write the files of the checkpoint in the staging tensors */
+    void Write();
+
+    /* write a file of the checkpoint */
+    void WriteFile(const CheckpointFile& file);
+
+    /* the loop of the writer thread */
+    void WorkerLoop();
+};
+
+} /* end of the nmt namespace */
+
+#endif /* __CHECKPOINTWRITER_H__ */
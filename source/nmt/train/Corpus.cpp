@@ -0,0 +1,291 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "Corpus.h"
+#include "../../niutensor/tensor/XGlobal.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* the size of a file */
+static MTYPE GetFileSize(FILE * file)
+{
+#ifdef _WIN32
+    _fseeki64(file, 0, SEEK_END);
+    MTYPE size = (MTYPE)_ftelli64(file);
+    _fseeki64(file, 0, SEEK_SET);
+#else
+    fseeko(file, 0, SEEK_END);
+    MTYPE size = (MTYPE)ftello(file);
+    fseeko(file, 0, SEEK_SET);
+#endif
+    return size;
+}
+
+/* constructor */
+CorpusShard::CorpusShard()
+{
+    memset(&header, 0, sizeof(header));
+    index = NULL;
+    data = NULL;
+    mapped = NULL;
+    mappedSize = 0;
+    buffer = NULL;
+    indexBuffer = NULL;
+}
+
+/* de-constructor */
+CorpusShard::~CorpusShard()
+{
+    Close();
+}
+
+/*
+open a shard
+>> fn - name of the file
+>> useMMap - map the file into the memory (for the corpus format)
+*/
+void CorpusShard::Open(const char * fn, bool useMMap)
+{
+    Close();
+
+    FILE * file = fopen(fn, "rb");
+    CheckNTErrors(file, "Failed to open the training/validation file");
+
+    MTYPE fileSize = GetFileSize(file);
+
+    if (fileSize < sizeof(header) ||
+        fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, CORPUS_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        LoadRaw(file, fileSize);
+        fclose(file);
+        return;
+    }
+
+    CheckNTErrors(header.version <= CORPUS_FILE_VERSION, "The corpus file is of a newer version!");
+    CheckNTErrors(header.dataOffset >= sizeof(header) &&
+                  header.indexOffset + header.sampleNum * sizeof(CorpusIndexEntry) <= fileSize,
+                  "Incomplete corpus file!");
+
+#ifndef _WIN32
+    if (useMMap) {
+        void * p = mmap(NULL, (size_t)fileSize, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        CheckNTErrors(p != MAP_FAILED, "Cannot map the corpus file into the memory!");
+
+        mapped = (char*)p;
+        mappedSize = fileSize;
+    }
+#endif
+
+    if (mapped == NULL) {
+        buffer = new char[fileSize];
+        fseek(file, 0, SEEK_SET);
+        CheckNTErrors(fread(buffer, 1, (size_t)fileSize, file) == fileSize, "Incomplete corpus file!");
+    }
+
+    fclose(file);
+
+    char * base = mapped != NULL ? mapped : buffer;
+    data = (const int*)(base + header.dataOffset);
+    index = (const CorpusIndexEntry*)(base + header.indexOffset);
+}
+
+/*
+read a file in the raw format and index it. The file is
+  srcVocabSize, tgtVocabSize, pad, sos, eos, unk, sampleNum,
+  (srcLen, tgtLen, src tokens, tgt tokens) * sampleNum
+where all the numbers are 32-bit integers.
+>> file - the file stream
+>> fileSize - size of the file
+*/
+void CorpusShard::LoadRaw(FILE * file, MTYPE fileSize)
+{
+    const int metaNum = 7;
+    CheckNTErrors(fileSize >= metaNum * sizeof(int), "Incomplete training/validation file");
+
+    buffer = new char[fileSize];
+    fseek(file, 0, SEEK_SET);
+    CheckNTErrors(fread(buffer, 1, (size_t)fileSize, file) == fileSize,
+                  "Incomplete training/validation file");
+
+    const int * meta = (const int*)buffer;
+    int sampleNum = meta[6];
+    CheckNTErrors(sampleNum > 0, "There is no training/validation data");
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CORPUS_FILE_MAGIC, sizeof(header.magic));
+    header.version = CORPUS_FILE_VERSION;
+    header.vocabSize[0] = meta[0];
+    header.vocabSize[1] = meta[1];
+    for (int i = 0; i < 4; i++)
+        header.specialTokens[i] = meta[2 + i];
+    header.sampleNum = (MTYPE)sampleNum;
+    header.dataOffset = metaNum * sizeof(int);
+
+    data = meta + metaNum;
+    MTYPE tokenNum = fileSize / sizeof(int) - metaNum;
+
+    /* index the sentence pairs */
+    indexBuffer = new CorpusIndexEntry[sampleNum];
+    MTYPE pos = 0;
+    for (int i = 0; i < sampleNum; i++) {
+        CheckNTErrors(pos + 2 <= tokenNum, "Incomplete training/validation file");
+        int srcLen = data[pos];
+        int tgtLen = data[pos + 1];
+        CheckNTErrors(srcLen > 0, "Invalid source sentence length");
+        CheckNTErrors(tgtLen > 0, "Invalid target sentence length");
+
+        indexBuffer[i].offset = pos + 2;
+        indexBuffer[i].srcLen = srcLen;
+        indexBuffer[i].tgtLen = tgtLen;
+
+        pos += 2 + (MTYPE)srcLen + (MTYPE)tgtLen;
+        CheckNTErrors(pos <= tokenNum, "Incomplete training/validation file");
+    }
+
+    index = indexBuffer;
+}
+
+/* close the shard */
+void CorpusShard::Close()
+{
+#ifndef _WIN32
+    if (mapped != NULL)
+        munmap(mapped, (size_t)mappedSize);
+#endif
+    mapped = NULL;
+    mappedSize = 0;
+
+    delete[] buffer;
+    delete[] indexBuffer;
+    buffer = NULL;
+    indexBuffer = NULL;
+
+    index = NULL;
+    data = NULL;
+    memset(&header, 0, sizeof(header));
+}
+
+/* number of sentence pairs */
+MTYPE CorpusShard::GetSampleNum()
+{
+    return header.sampleNum;
+}
+
+/*
+the source tokens of a sentence pair
+>> i - index of the sentence pair
+*/
+const int * CorpusShard::GetSrc(MTYPE i)
+{
+    return data + index[i].offset;
+}
+
+/*
+the target tokens of a sentence pair
+>> i - index of the sentence pair
+*/
+const int * CorpusShard::GetTgt(MTYPE i)
+{
+    return data + index[i].offset + index[i].srcLen;
+}
+
+/*
+open a corpus. It is a single file (in the corpus or the raw format), or
+a set of shards <fn>.0, <fn>.1, ... if there is no file named fn.
+>> fn - name of the corpus
+>> useMMap - map the shards into the memory
+>> shards - the shards
+*/
+void OpenCorpus(const char * fn, bool useMMap, vector<CorpusShard*> & shards)
+{
+    FILE * file = fopen(fn, "rb");
+    if (file != NULL) {
+        fclose(file);
+        CorpusShard * shard = new CorpusShard();
+        shard->Open(fn, useMMap);
+        shards.push_back(shard);
+        return;
+    }
+
+    char * shardFN = new char[strlen(fn) + 32];
+    for (int i = 0; ; i++) {
+        sprintf(shardFN, "%s.%d", fn, i);
+        file = fopen(shardFN, "rb");
+        if (file == NULL)
+            break;
+        fclose(file);
+
+        CorpusShard * shard = new CorpusShard();
+        shard->Open(shardFN, useMMap);
+        shards.push_back(shard);
+    }
+    delete[] shardFN;
+
+    CheckNTErrors(shards.size() > 0, "Failed to open the training/validation file");
+}
+
+/*
+read the header of a corpus (of its first shard). For a file in the raw
+format, the vocabulary sizes, the user-defined tokens and the number of
+sentence pairs are filled in.
+>> fn - name of the corpus
+>> header - the header
+*/
+void ReadCorpusHeader(const char * fn, CorpusHeader & header)
+{
+    FILE * file = fopen(fn, "rb");
+    if (file == NULL) {
+        char * shardFN = new char[strlen(fn) + 32];
+        sprintf(shardFN, "%s.0", fn);
+        file = fopen(shardFN, "rb");
+        delete[] shardFN;
+    }
+    CheckNTErrors(file, "Failed to open the training file");
+
+    memset(&header, 0, sizeof(header));
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, CORPUS_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        int meta[7];
+        fseek(file, 0, SEEK_SET);
+        CheckNTErrors(fread(meta, sizeof(int), 7, file) == 7, "Incomplete training file");
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CORPUS_FILE_MAGIC, sizeof(header.magic));
+        header.version = CORPUS_FILE_VERSION;
+        header.vocabSize[0] = meta[0];
+        header.vocabSize[1] = meta[1];
+        for (int i = 0; i < 4; i++)
+            header.specialTokens[i] = meta[2 + i];
+        header.sampleNum = (MTYPE)MAX(meta[6], 0);
+    }
+
+    fclose(file);
+}
+
+} /* end of the nmt namespace */
@@ -0,0 +1,148 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A shard of the training corpus. A shard in the corpus format is
+ *   header | tokens | length index
+ * where the index keeps the offset and the lengths of each sentence pair,
+ * so that samples can be sorted and bucketed without reading the tokens.
+ * The shard is mapped into the memory, and the pages of the tokens are
+ * loaded only when a batch uses them. A large corpus is split into shards
+ * named <file>.0, <file>.1, ... (see tools/PrepareParallelData.py).
+ *
+ * Files in the raw format (the output of the old PrepareParallelData.py)
+ * are read into the memory and indexed when they are opened.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __CORPUS_H__
+#define __CORPUS_H__
+
+#include <vector>
+#include "../../niutensor/tensor/XMem.h"
+
+using namespace std;
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+#define CORPUS_FILE_MAGIC "NIUCORPS"
+#define CORPUS_FILE_VERSION 1
+
+/* the header of a shard in the corpus format (64 bytes) */
+struct CorpusHeader
+{
+    /* the magic number, i.e., CORPUS_FILE_MAGIC */
+    char magic[8];
+
+    /* version of the format */
+    int version;
+
+    /* source and target vocabulary size */
+    int vocabSize[2];
+
+    /* user-defined tokens (pad, sos, eos and unk) */
+    int specialTokens[4];
+
+    /* reserved */
+    int reserved;
+
+    /* number of sentence pairs */
+    MTYPE sampleNum;
+
+    /* offset of the tokens (in bytes) */
+    MTYPE dataOffset;
+
+    /* offset of the length index (in bytes) */
+    MTYPE indexOffset;
+};
+
+/* an entry of the length index */
+struct CorpusIndexEntry
+{
+    /* offset of the source tokens (in tokens from the beginning of the data) */
+    MTYPE offset;
+
+    /* source sentence length */
+    int srcLen;
+
+    /* target sentence length (the target tokens follow the source tokens) */
+    int tgtLen;
+};
+
+/* a shard of the training corpus */
+class CorpusShard
+{
+public:
+    /* the header */
+    CorpusHeader header;
+
+    /* the length index */
+    const CorpusIndexEntry * index;
+
+    /* the tokens */
+    const int * data;
+
+private:
+    /* the beginning of the mapped file (NULL if the file is not mapped) */
+    char * mapped;
+
+    /* size of the mapped file */
+    MTYPE mappedSize;
+
+    /* the buffers of a shard that is read into the memory */
+    char * buffer;
+    CorpusIndexEntry * indexBuffer;
+
+public:
+    /* constructor */
+    CorpusShard();
+
+    /* de-constructor */
+    ~CorpusShard();
+
+    /* open a shard */
+    void Open(const char * fn, bool useMMap);
+
+    /* close the shard */
+    void Close();
+
+    /* number of sentence pairs */
+    MTYPE GetSampleNum();
+
+    /* the source tokens of a sentence pair */
+    const int * GetSrc(MTYPE i);
+
+    /* the target tokens of a sentence pair */
+    const int * GetTgt(MTYPE i);
+
+private:
+    /* read a file in the raw format and index it */
+    void LoadRaw(FILE * file, MTYPE fileSize);
+};
+
+/* open a corpus, i.e., a file or the shards <fn>.0, <fn>.1, ... */
+void OpenCorpus(const char * fn, bool useMMap, vector<CorpusShard*> & shards);
+
+/* read the header of a corpus (of its first shard) */
+void ReadCorpusHeader(const char * fn, CorpusHeader & header);
+
+} /* end of the nmt namespace */
+
+#endif /* __CORPUS_H__ */
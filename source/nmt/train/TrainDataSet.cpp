@@ -20,6 +20,7 @@
  */
 
 #include <cstdlib>
+#include <climits>
 #include <algorithm>
 
 #include "TrainDataSet.h"
@@ -28,63 +29,88 @@
 /* the nmt namespace */
 namespace nmt {
 
-/* shuffle buckets by their keys */
-void TrainDataSet::ShuffleBuckets() {
-
-    /* assign random keys for buckets */
-    int keyIdx = 0;
-    std::random_shuffle(randomKeys.items, randomKeys.items + randomKeys.Size());
-
-    while (bufIdx < buf->Size()) {
-        int bucketKey = ((Sample*)(buf->Get(bufIdx)))->bucketKey;
-        while ((bufIdx < buf->Size()) &&
-            (((Sample*)(buf->Get(bufIdx)))->bucketKey == bucketKey)) {
-            ((Sample*)(buf->Get(bufIdx)))->bucketKey = randomKeys[keyIdx];
-            bufIdx++;
-        }
-        keyIdx++;
-    }
-
-    /* sort buckets by the previous keys */
-    sort(buf->items, buf->items + buf->count,
-        [](void* a, void* b) {
-            return ((Sample*)(a))->bucketKey <
-                ((Sample*)(b))->bucketKey;
-        });
+/* shuffle the buckets (of the current window) */
+void TrainDataSet::ShuffleBuckets()
+{
+    std::random_shuffle(bucketOrder.begin(), bucketOrder.end());
 
-    /* reset the buffer index */
-    bufIdx = 0;
+    /* reset the bucket index */
+    bucketIdx = 0;
 }
 
 /*
-load samples from a file into the buffer
+load the next window of samples into the buffer. Only the lengths of the
+samples are read (from the length index), and the samples are sorted
+and grouped into buckets.
 */
 bool TrainDataSet::LoadBatchToBuf()
 {
-    int n = 0;
+    /* a new epoch (the windows are visited in a random order for training) */
+    if (windowIdx == int(windows.size())) {
+        windowIdx = 0;
+        if (isTraining)
+            std::random_shuffle(windowOrder.begin(), windowOrder.end());
+    }
 
-    while (n < config->common.bufSize) {
-        Sample* sample = LoadSample();
-        buf->Add(sample);
-        n++;
+    CorpusWindow& window = windows[windowOrder[windowIdx++]];
+    CorpusShard* shard = shards[window.shard];
+    curShard = window.shard;
+
+    items.resize(window.size);
+    for (int i = 0; i < window.size; i++) {
+        MTYPE id = window.begin + i;
+        items[i].id = id;
+        items[i].srcLen = shard->index[id].srcLen;
+        items[i].tgtLen = shard->index[id].tgtLen;
     }
 
-    /* group samples into buckets */
-    SortByTgtLengthAscending();
-    SortBySrcLengthAscending();
+    /* sort the samples by the source length and then by the target length */
+    stable_sort(items.begin(), items.end(),
+        [](const CorpusItem& a, const CorpusItem& b) {
+            if (a.srcLen != b.srcLen)
+                return a.srcLen < b.srcLen;
+            return a.tgtLen < b.tgtLen;
+        });
+
+    BuildBucket();
 
-    /* build buckets for training */
     if (isTraining) {
-        BuildBucket();
-        LOG("loaded %d samples from the training file `%s`", n, config->training.trainFN);
+        ShuffleBuckets();
+        LOG("loaded %d samples from the training file `%s`", window.size, config->training.trainFN);
     }
     else {
-        LOG("loaded %d samples from the validation file `%s`", n, config->training.validFN);
+        bucketIdx = 0;
+        LOG("loaded %d samples from the validation file `%s`", window.size, config->training.validFN);
     }
 
     return true;
 }
 
+/*
+pick the samples of the next batch, i.e., the next bucket
+>> batch - the batch
+*/
+bool TrainDataSet::PlanBatch(BatchBuffer* batch)
+{
+    int num = GetBucket();
+    CorpusShard* shard = shards[curShard];
+
+    batch->samples.resize(num);
+    for (int i = 0; i < num; i++) {
+        CorpusItem& item = items[bufIdx + i];
+        BatchSample& sample = batch->samples[i];
+        sample.src = shard->GetSrc(item.id);
+        sample.srcLen = item.srcLen;
+        sample.tgt = shard->GetTgt(item.id);
+        sample.tgtLen = item.tgtLen;
+        sample.index = i;
+    }
+
+    bufIdx += num;
+
+    return true;
+}
+
 /*
 load a mini-batch to a device
 >> inputs - the list to store input tensors
@@ -92,160 +118,114 @@ load a mini-batch to a device
 */
 bool TrainDataSet::GetBatchSimple(XList* inputs, XList* golds)
 {
-    if (bufIdx == buf->Size()) {
-        if (isTraining)
-            ShuffleBuckets();
-        else
-            bufIdx = 0;
-    }
+    BatchBuffer* batch = pipeline.Next();
+    CheckNTErrors(batch != NULL, "No batch is loaded");
 
-    wc = 0;
-    sc = isTraining ? GetBucket() : config->common.sBatchSize;
-    sc = MIN(sc, buf->Size() - bufIdx);
+    sc = int(batch->samples.size());
+    wc = batch->tgtWordNum;
 
-    /* get the maximum sentence length in a mini-batch */
-    int maxSrcLen = MaxSrcLen(bufIdx, bufIdx + sc);
-    int maxTgtLen = MaxTgtLen(bufIdx, bufIdx + sc);
+    int maxSrcLen = batch->maxSrcLen;
+    int maxTgtLen = batch->maxTgtLen;
 
     CheckNTErrors(maxSrcLen > 0, "Invalid source length for batching");
     CheckNTErrors(maxTgtLen > 0, "Invalid target length for batching");
 
-    int* batchEncValues = new int[sc * maxSrcLen];
-    float* paddingEncValues = new float[sc * maxSrcLen];
-
-    int* labelVaues = new int[sc * maxTgtLen];
-    int* batchDecValues = new int[sc * maxTgtLen];
-    float* paddingDecValues = new float[sc * maxTgtLen];
-
-    for (int i = 0; i < sc * maxSrcLen; i++) {
-        batchEncValues[i] = config->model.pad;
-        paddingEncValues[i] = 1.0F;
-    }
-    for (int i = 0; i < sc * maxTgtLen; i++) {
-        batchDecValues[i] = config->model.pad;
-        labelVaues[i] = config->model.pad;
-        paddingDecValues[i] = 1.0F;
-    }
-
-    int curSrc = 0;
-    int curTgt = 0;
-
-    /*
-    batchEnc: end with EOS (left padding)
-    batchDec: begin with SOS (right padding)
-    label:    end with EOS (right padding)
-    */
-    for (int i = 0; i < sc; ++i) {
-
-        Sample* sample = (Sample*)(buf->Get(bufIdx + i));
-        wc += int(sample->tgtSeq->Size());
-
-        curSrc = maxSrcLen * i;
-        for (int j = 0; j < int(sample->srcSeq->Size()); j++)
-            batchEncValues[curSrc++] = sample->srcSeq->Get(j);
-
-        curTgt = maxTgtLen * i;
-        for (int j = 0; j < int(sample->tgtSeq->Size()); j++) {
-            if (j > 0)
-                labelVaues[curTgt - 1] = sample->tgtSeq->Get(j);
-            batchDecValues[curTgt++] = sample->tgtSeq->Get(j);
-        }
-        labelVaues[curTgt - 1] = config->model.eos;
-        while (curSrc < maxSrcLen * (i + 1))
-            paddingEncValues[curSrc++] = 0;
-        while (curTgt < maxTgtLen * (i + 1))
-            paddingDecValues[curTgt++] = 0;
-    }
-
     XTensor * batchEnc = ((TensorList*)(inputs))->Get(0);
     XTensor * paddingEnc = ((TensorList*)(inputs))->Get(1);
     XTensor * batchDec = ((TensorList*)(golds))->Get(0);
     XTensor * paddingDec = ((TensorList*)(golds))->Get(1);
     XTensor * label = ((TensorList*)(golds))->Get(2);
 
-    InitTensor2D(batchEnc, sc, maxSrcLen, X_INT);
-    InitTensor2D(paddingEnc, sc, maxSrcLen, X_FLOAT);
-    InitTensor2D(batchDec, sc, maxTgtLen, X_INT);
-    InitTensor2D(paddingDec, sc, maxTgtLen, X_FLOAT);
-    InitTensor2D(label, sc, maxTgtLen, X_INT);
-
-    bufIdx += sc;
-
-    batchEnc->SetData(batchEncValues, batchEnc->unitNum);
-    paddingEnc->SetData(paddingEncValues, paddingEnc->unitNum);
-    batchDec->SetData(batchDecValues, batchDec->unitNum);
-    paddingDec->SetData(paddingDecValues, paddingDec->unitNum);
-    label->SetData(labelVaues, label->unitNum);
+    /* the batch goes to the device directly */
+    int devID = config->common.devID;
+    InitTensor2D(batchEnc, sc, maxSrcLen, X_INT, devID);
+    InitTensor2D(paddingEnc, sc, maxSrcLen, X_FLOAT, devID);
+    InitTensor2D(batchDec, sc, maxTgtLen, X_INT, devID);
+    InitTensor2D(paddingDec, sc, maxTgtLen, X_FLOAT, devID);
+    InitTensor2D(label, sc, maxTgtLen, X_INT, devID);
 
-    delete[] batchEncValues;
-    delete[] paddingEncValues;
-    delete[] batchDecValues;
-    delete[] paddingDecValues;
-    delete[] labelVaues;
+    batchEnc->SetData(batch->enc.data, batchEnc->unitNum);
+    paddingEnc->SetData(batch->encPadding.data, paddingEnc->unitNum);
+    batchDec->SetData(batch->dec.data, batchDec->unitNum);
+    paddingDec->SetData(batch->decPadding.data, paddingDec->unitNum);
+    label->SetData(batch->label.data, label->unitNum);
 
     return true;
 }
 
-/* group samples with similar length into buckets */
+/*
+group samples with similar length into buckets. For validation, a bucket
+is a batch of "sbatch" samples.
+*/
 void TrainDataSet::BuildBucket()
 {
     int idx = 0;
+    int num = int(items.size());
+
+    bucketStarts.clear();
+    bucketOrder.clear();
 
     /* build buckets by the length of source and target sentences */
-    while (idx < int(buf->Size())) {
+    while (idx < num) {
 
         /* sentence number in a bucket */
         int sentNum = 1;
 
-        /* get the maximum source sentence length in a bucket */
-        int maxSrcLen = MaxSrcLen(idx, idx + sentNum);
-        int maxTgtLen = MaxTgtLen(idx, idx + sentNum);
-        int maxLen = MAX(maxSrcLen, maxTgtLen);
-
-        /* the maximum sentence number in a bucket */
-        const int MAX_SENT_NUM = 5120;
-
-        while ((sentNum < (buf->count - idx))
-            && (sentNum < MAX_SENT_NUM)
-            && (sentNum * maxLen <= config->common.bucketSize)) {
-            sentNum++;
-            maxSrcLen = MaxSrcLen(idx, idx + sentNum);
-            maxTgtLen = MaxTgtLen(idx, idx + sentNum);
-            maxLen = MAX(maxSrcLen, maxTgtLen);
+        if (isTraining) {
+            /* get the maximum sentence length in a bucket */
+            int maxLen = MAX(items[idx].srcLen, items[idx].tgtLen);
+
+            /* the maximum sentence number in a bucket */
+            const int MAX_SENT_NUM = 5120;
+
+            while ((sentNum < (num - idx))
+                && (sentNum < MAX_SENT_NUM)
+                && (sentNum * maxLen <= config->common.bucketSize)) {
+                sentNum++;
+                maxLen = MAX(maxLen, MAX(items[idx + sentNum - 1].srcLen,
+                                         items[idx + sentNum - 1].tgtLen));
+            }
+
+            /* make sure the number is valid */
+            if ((sentNum) * maxLen > config->common.bucketSize || sentNum >= MAX_SENT_NUM) {
+                sentNum--;
+                sentNum = max(8 * (sentNum / 8), sentNum % 8);
+            }
+
+            /* a sample that is longer than the bucket size is a bucket */
+            sentNum = MAX(sentNum, 1);
         }
-
-        /* make sure the number is valid */
-        if ((sentNum) * maxLen > config->common.bucketSize || sentNum >= MAX_SENT_NUM) {
-            sentNum--;
-            sentNum = max(8 * (sentNum / 8), sentNum % 8);
+        else {
+            sentNum = config->common.sBatchSize;
         }
-        if ((int(buf->Size()) - idx) < sentNum)
-            sentNum = int(buf->Size()) - idx;
 
-        /* assign the same key for items in a bucket */
-        for (int i = 0; i < sentNum; i++)
-            ((Sample*)(buf->Get(idx + i)))->bucketKey = idx;
+        if ((num - idx) < sentNum)
+            sentNum = num - idx;
 
-        randomKeys.Add(idx);
+        bucketOrder.push_back(int(bucketStarts.size()));
+        bucketStarts.push_back(idx);
         idx += sentNum;
     }
 
-    /* shuffle buckets */
-    ShuffleBuckets();
+    bucketStarts.push_back(num);
 }
 
-/* find the sentences in a bucket */
-inline int TrainDataSet::GetBucket()
+/* move to the next bucket (and the next window if necessary) and get its size */
+int TrainDataSet::GetBucket()
 {
-    int sent = 0;
-    int bucketKey = ((Sample*)(buf->Get(bufIdx)))->bucketKey;
-
-    while ((sent < (int(buf->Size()) - bufIdx)) &&
-          (((Sample*)(buf->Get(bufIdx + sent)))->bucketKey == bucketKey)) {
-        sent++;
+    if (bucketIdx == int(bucketOrder.size())) {
+        if (windows.size() > 1)
+            LoadBatchToBuf();
+        else if (isTraining)
+            ShuffleBuckets();
+        else
+            bucketIdx = 0;
     }
 
-    sent = MIN(sent, (int(buf->Size()) - bufIdx));
+    int bucket = bucketOrder[bucketIdx++];
+    bufIdx = bucketStarts[bucket];
+
+    int sent = bucketStarts[bucket + 1] - bufIdx;
     CheckNTErrors(sent > 0, "Invalid batch size");
 
     return sent;
@@ -263,25 +243,21 @@ bool TrainDataSet::End()
     return true;
 }
 
-/* load a sample from the training file */
+/* load a sample (the one at bufIdx) of the current window */
 Sample* TrainDataSet::LoadSample()
 {
-    int srcLen;
-    int tgtLen;
-
-    fread(&srcLen, sizeof(srcLen), 1, fp);
-    fread(&tgtLen, sizeof(tgtLen), 1, fp);
+    CheckNTErrors(bufIdx >= 0 && bufIdx < int(items.size()), "No sample to load");
 
-    CheckNTErrors(srcLen > 0, "Invalid source sentence length");
-    CheckNTErrors(tgtLen > 0, "Invalid target sentence length");
+    CorpusItem& item = items[bufIdx];
+    CorpusShard* shard = shards[curShard];
 
-    IntList* srcSent = new IntList(srcLen);
-    IntList* tgtSent = new IntList(tgtLen);
-    srcSent->ReadFromFile(fp, srcLen);
-    tgtSent->ReadFromFile(fp, tgtLen);
+    IntList* srcSent = new IntList(item.srcLen);
+    IntList* tgtSent = new IntList(item.tgtLen);
+    srcSent->Add(shard->GetSrc(item.id), item.srcLen);
+    tgtSent->Add(shard->GetTgt(item.id), item.tgtLen);
 
     Sample* sample = new Sample(srcSent, tgtSent, 0);
-    
+
     return sample;
 }
 
@@ -297,29 +273,57 @@ void TrainDataSet::Init(NMTConfig& cfg, bool isTrainDataset)
     isTraining = isTrainDataset;
 
     if (isTraining)
-        fp = fopen(config->training.trainFN, "rb");
+        OpenCorpus(config->training.trainFN, config->common.useMMap, shards);
     else
-        fp = fopen(config->training.validFN, "rb");
-    CheckNTErrors(fp, "Failed to open the training/validation file");
+        OpenCorpus(config->training.validFN, config->common.useMMap, shards);
+
+    /* split the shards into windows of "bufsize" samples */
+    MTYPE total = 0;
+    int windowSize = MAX(config->common.bufSize, 1);
+    for (int i = 0; i < int(shards.size()); i++) {
+        MTYPE num = shards[i]->GetSampleNum();
+        for (MTYPE begin = 0; begin < num; begin += windowSize) {
+            CorpusWindow window;
+            window.shard = i;
+            window.begin = begin;
+            window.size = int(MIN(num - begin, (MTYPE)windowSize));
+            windowOrder.push_back(int(windows.size()));
+            windows.push_back(window);
+        }
+        total += num;
+    }
 
-    /* skip the meta information */
-    int meta_info[6];
-    fread(meta_info, sizeof(*meta_info), 6, fp);
+    CheckNTErrors(total > 0, "There is no training/validation data");
+    CheckNTErrors(total < INT_MAX, "Too many training/validation samples");
+    sampleNum = int(total);
 
-    /* load the number of training samples */
-    fread(&sampleNum, sizeof(sampleNum), 1, fp);
-    CheckNTErrors(sampleNum > 0, "There is no training/validation data");
+    /* start from the first window */
+    windowIdx = isTraining ? int(windows.size()) : 0;
+    LoadBatchToBuf();
 
-    /* reset the buffer size */
-    config->common.bufSize = sampleNum;
+    pipeline.Start(this, config->model.pad, config->model.eos, true,
+                   config->common.prefetchThreadNum, config->common.prefetchBatchNum,
+                   config->common.devID >= 0);
+}
 
-    LoadBatchToBuf();
+/* constructor */
+TrainDataSet::TrainDataSet()
+{
+    isTraining = false;
+    windowIdx = 0;
+    curShard = 0;
+    bucketIdx = 0;
+    sampleNum = 0;
 }
 
 /* de-constructor */
 TrainDataSet::~TrainDataSet()
 {
-    fclose(fp);
+    /* the workers might be reading the shards */
+    pipeline.Stop();
+
+    for (int i = 0; i < int(shards.size()); i++)
+        delete shards[i];
 }
 
 } /* end of the nmt namespace */
\ No newline at end of file
@@ -19,9 +19,14 @@
  * Here we define the data manager for NMT training.
  * Loading the training data requires 4 steps:
  * 1. initialize the dataset class (Init)
- * 2. load samples from the training file (LoadBatchToBuf)
+ * 2. load a window of samples from the corpus (LoadBatchToBuf)
  * 3. build and shuffle bucktes of batches (ShuffleBuckets)
  * 4. load a mini-batch from the buckets (GetBatchSimple)
+ * The corpus is mapped into the memory (see Corpus.h) and split into
+ * windows of "bufsize" samples. Only the lengths of the samples in the
+ * current window are kept, so the memory does not grow with the corpus.
+ * Steps 2-3 are done when the next batches are planned, and the tokens of
+ * the batches are filled in the background (see BatchPipeline.h).
  * 
  * $Created by: HU Chi (huchinlp@gmail.com) 2021-06
  */
@@ -31,6 +36,7 @@
 
 #include "../Config.h"
 #include "../DataSet.h"
+#include "Corpus.h"
 
 using namespace std;
 using namespace nts;
@@ -38,6 +44,30 @@ using namespace nts;
 /* the nmt namespace */
 namespace nmt { 
 
+/* a window of the corpus, i.e., a range of samples that are bucketed together */
+struct CorpusWindow
+{
+    /* the shard */
+    int shard;
+
+    /* the first sample */
+    MTYPE begin;
+
+    /* number of samples */
+    int size;
+};
+
+/* a sample of the current window */
+struct CorpusItem
+{
+    /* index of the sample in the shard */
+    MTYPE id;
+
+    /* source and target sentence length */
+    int srcLen;
+    int tgtLen;
+};
+
 /* The base class of datasets used in the NMT system. */
 struct TrainDataSet : public DataSetBase
 {
@@ -45,27 +75,48 @@ private:
     /* indicates whether it is used for training or validation */
     bool isTraining;
 
-    /* the pointer to file stream */
-    FILE* fp;
+    /* shards of the corpus */
+    vector<CorpusShard*> shards;
 
-    /* a list of random keys */
-    IntList randomKeys;
+    /* windows of the corpus */
+    vector<CorpusWindow> windows;
+
+    /* the order of the windows in an epoch */
+    vector<int> windowOrder;
+
+    /* the current position in the window order */
+    int windowIdx;
+
+    /* the shard of the current window */
+    int curShard;
+
+    /* samples of the current window (sorted by length) */
+    vector<CorpusItem> items;
+
+    /* the first sample of each bucket (and the end of the last bucket) */
+    vector<int> bucketStarts;
+
+    /* the order of the buckets */
+    vector<int> bucketOrder;
+
+    /* the current position in the bucket order */
+    int bucketIdx;
 
 private:
 
-    /* sort buckets by their keys */
+    /* shuffle the buckets */
     void ShuffleBuckets();
 
     /* group data into buckets with similar length */
     void BuildBucket();
 
-    /* calculate the batch size according to the number of tokens */
+    /* move to the next bucket and get its size */
     int GetBucket();
 
-    /* load a pair of sequences from the file  */
+    /* load a pair of sequences from the current window */
     Sample* LoadSample() override;
 
-    /* load the samples into the buffer (a list) */
+    /* load the next window of samples into the buffer */
     bool LoadBatchToBuf() override;
 
 public:
@@ -85,6 +136,12 @@ public:
     /* load the samples into tensors from the buffer */
     bool GetBatchSimple(XList* inputs, XList* golds) override;
 
+    /* pick the samples of the next batch */
+    bool PlanBatch(BatchBuffer* batch) override;
+
+    /* constructor */
+    TrainDataSet();
+
     /* de-constructor */
     ~TrainDataSet();
 };
@@ -41,6 +41,8 @@ Trainer::Trainer()
 /* de-constructor */
 Trainer::~Trainer()
 {
+    ReleaseFlatBuffers();
+
     for (int i = 0; i < moments.count; i++) {
         XTensor* m = (XTensor*)moments.Get(i);
         delete m;
@@ -95,6 +97,10 @@ void Trainer::Run()
     /* set the training flag */
     model->SetTrainingFlag(true);
 
+    /* write the checkpoints in the background */
+    if (config->training.asyncSave)
+        checkpointWriter.Start();
+
     /* initialize the dataloader */
     trainBatchLoader.Init(*config, true);
     validBatchLoader.Init(*config, false);
@@ -145,24 +151,18 @@ void Trainer::Run()
             paddingDec.SetDevice(model->devID);
             label.SetDevice(model->devID);
 
-            XTensor labelOnehot;
-            labelOnehot = IndexToOnehot(label, config->model.tgtVocabSize, config->training.labelSmoothingP);
-
-            /* delete unused data to save memory */
-            label.DestroyData();
-
             CheckNTErrors(batchEnc.order == 2, "Wrong tensor order of the sequence batch");
 
-            /* output probabilities */
+            /* output logits */
             XTensor output;
 
             /* make the network */
             output = model->MakeMT(batchEnc, batchDec, paddingEnc, paddingDec);
 
-            /* get loss and probabilities */
+            /* get loss (the log-softmax and the label smoothing are fused into the loss) */
             XTensor lossTensor;
 
-            lossTensor = CrossEntropy(output, labelOnehot, paddingDec);
+            lossTensor = CrossEntropySparse(output, label, paddingDec, config->training.labelSmoothingP);
 
             float lossBatch = ReduceSumAllValue(lossTensor);
 
@@ -256,7 +256,12 @@ void Trainer::Run()
 
     /* save the final model */
     LOG("saving the final model");
-    model->DumpToFile(config->common.modelFN);
+    vector<CheckpointFile> files;
+    files.push_back({ config->common.modelFN, false });
+    SaveModel(files);
+
+    /* wait until all the files are written */
+    checkpointWriter.Stop();
 }
 
 /*
@@ -308,19 +313,16 @@ float Trainer::Validate()
         paddingDec.FlushToDevice(model->devID);
         label.FlushToDevice(model->devID);
 
-        /* output probabilities */
+        /* output logits */
         XTensor output;
 
         /* make the network */
         output = model->MakeMT(batchEnc, batchDec, paddingEnc, paddingDec);
 
-        /* get loss and probabilities */
-        XTensor labelOnehot;
+        /* get loss */
         XTensor lossTensor;
 
-        labelOnehot = IndexToOnehot(label, config->model.tgtVocabSize, 0.0F);
-
-        lossTensor = CrossEntropy(output, labelOnehot, paddingDec);
+        lossTensor = CrossEntropySparse(output, label, paddingDec, 0.0F);
 
         float lossBatch = ReduceSumAllValue(lossTensor);
 
@@ -357,25 +359,27 @@ void Trainer::MakeCheckpoint(const char* label, int id)
 
     float validLoss = Validate();
     char* fn = new char[MAX_LINE_LENGTH];
+    vector<CheckpointFile> files;
 
     /* update the best checkpoint */
     if (validLoss < bestValidLoss) {
         bestValidLoss = validLoss;
         sprintf(fn, "%s.checkpoint.best", config->common.modelFN);
-        model->DumpToFile(fn);
+        files.push_back({ fn, false });
     }
 
-    /* remove old checkpoints */
-    if (id > config->training.ncheckpoint) {
+    /* save a checkpoint (with the optimizer state) */
+    sprintf(fn, "%s.%s.%03d", config->common.modelFN, label, id);
+    files.push_back({ fn, true });
+    SaveModel(files);
+    LOG("make a checkpoint to `%s`", fn);
+
+    /* remove old checkpoints (the previous checkpoints have been written
+       when the new one is accepted by the writer) */
+    if (config->training.ncheckpoint > 0 && id > config->training.ncheckpoint) {
         sprintf(fn, "%s.%s.%03d", config->common.modelFN, label, id - config->training.ncheckpoint);
         remove(fn);
     }
-    sprintf(fn, "%s.%s.%03d", config->common.modelFN, label, id);
-
-    /* save a checkpoint */
-    model->DumpToFile(fn);
-    DumpOptimizerState(fn);
-    LOG("make a checkpoint to `%s`", fn);
 
     /* enable gradient flow and restore the flags after validating */
     ENABLE_GRAD;
@@ -393,68 +397,70 @@ where
 */
 void Trainer::Update(const float lr)
 {
-    TensorList ws;
-    model->GetParams(ws);
-
     adamBeta1T *= config->training.adamBeta1;
     adamBeta2T *= config->training.adamBeta2;
 
-    for (int i = 0; i < ws.Size(); i++) {
-        XTensor* para = ws[i];
-        XTensor* paraGrad = para->grad;
+    /* the decoupled weight decay */
+    float decay = 0.0F;
+    if (config->training.weightDecay > 0.0F)
+        decay = config->training.weightDecay * lr;
 
-        if (paraGrad == NULL)
-            continue;
+    if (config->training.useAdam) {
 
-        CheckNTErrors(para != NULL, "NULL parameter tensor!");
-        CheckNTErrors(paraGrad != NULL, "NULL gradient tensor!");
+        float e = lr * sqrtf(1.0F - adamBeta2T) / (1.0F - adamBeta1T);
+        float d = config->training.adamDelta * sqrtf(1.0F - adamBeta2T);
 
-        if (config->training.useAdam) {
-            
-            float e = lr * sqrtf(1.0F - adamBeta2T) / (1.0F - adamBeta1T);
-            float d = config->training.adamDelta * sqrtf(1.0F - adamBeta2T);
-
-            /* m = beta_1 * m + (1-beta_1) * grad */
-            XTensor* m = (XTensor*)moments.Get(i);
-            _ScaleAndShiftMe(m, config->training.adamBeta1, 0);
-            _Sum(m, paraGrad, m, (1.0F - config->training.adamBeta1));
-
-            /* v = beta_2 * v + (1-beta_2) * grad * grad*/
-            XTensor* v = (XTensor*)moments2nd.Get(i);
-            _Multiply(paraGrad, paraGrad, v, config->training.adamBeta2 / (1.0F - config->training.adamBeta2));
-            _ScaleAndShiftMe(v, (1.0F - config->training.adamBeta2), 0);
-
-            /* v2 = m / (sqrt(v) + delta) */
-            GMems.GetMem(v->devID)->LockBuf();
-            XTensor* v2 = NewTensorBufV2(v, v->devID, v->mem);
-            _Power(v, v2, 0.5F);
-            _ScaleAndShiftMe(v2, 1.0F, d);
-            _Div(m, v2, v2);
-
-            /* apply weight decay to the parameter */
-            if (config->training.weightDecay > 0.0F)
-                _SubMe(para, para, config->training.weightDecay * lr);
-
-            /* the delta rule */
-            _Sum(para, v2, para, -e);
-
-            DelTensorBuf(v2);
-            GMems.GetMem(v->devID)->UnlockBuf();
-        }
-        else {
-            /* apply weight decay to the parameter */
-            if (config->training.weightDecay > 0.0F)
-                _SubMe(para, para, config->training.weightDecay * lr);
+        /* the moments, the parameters and the gradients (cleared) are
+           updated in one pass over the flat buffers */
+        _AdamUpdate(&flatParams, &flatGrads, &flatMoments, &flatMoments2nd,
+                    config->training.adamBeta1, config->training.adamBeta2,
+                    e, d, decay, true);
+    }
+    else {
+        /* apply weight decay to the parameters */
+        if (decay > 0.0F)
+            _SubMe(&flatParams, &flatParams, decay);
 
-            /* the delta rule */
-            _Sum(para, paraGrad, para, -lr);
-        }
+        /* the delta rule */
+        _Sum(&flatParams, &flatGrads, &flatParams, -lr);
 
-        /* clear gradient */
-        paraGrad->SetZeroAll();
+        /* clear gradients */
+        flatGrads.SetZeroAll();
     }
 }
 
+/*
+let a tensor use a piece of a flat buffer as its data array
+>> tensor - the tensor
+>> buffer - the flat buffer
+>> offset - offset of the piece in the buffer (in items)
+>> copyData - copy the data of the tensor into the buffer
+*/
+static void ShareFlatBuffer(XTensor* tensor, XTensor& buffer, MTYPE offset, bool copyData)
+{
+    void* data = (char*)buffer.data + offset * buffer.unitSize;
+
+    if (copyData && tensor->data != NULL)
+        XMemCopy(data, buffer.devID, tensor->data, tensor->devID, tensor->GetDataSizeInChar());
+
+    tensor->DestroyData();
+    tensor->data = data;
+    tensor->isShared = true;
+    tensor->isInGlobalMem = false;
+}
+
+/*
+let a tensor that uses a piece of a flat buffer have its own data array (with the same data)
+>> tensor - the tensor
+*/
+static void UnshareFlatBuffer(XTensor* tensor)
+{
+    void* data = tensor->data;
+
+    tensor->Resize(tensor->order, tensor->dimSize, tensor->dataType, tensor->denseRatio);
+    XMemCopy(tensor->data, tensor->devID, data, tensor->devID, tensor->GetDataSizeInChar());
+}
+
 /*
 prepare model for training
 */
@@ -467,25 +473,75 @@ void Trainer::PrepareModel()
 
     model->GetParams(ws);
 
+    /* the parameters, the gradients and the moments are kept in flat buffers */
+    int paramNum = 0;
+    for (int i = 0; i < ws.Size(); i++) {
+        CheckNTErrors(ws[i]->dataType == X_FLOAT, "The parameters must be in X_FLOAT for training!");
+        CheckNTErrors(ws[i]->devID == model->devID, "The parameters must be on the device of the model!");
+        paramNum += ws[i]->unitNum;
+    }
+
+    InitTensor1D(&flatParams, paramNum, X_FLOAT, model->devID, false);
+    InitTensor1D(&flatGrads, paramNum, X_FLOAT, model->devID, false);
+    flatGrads.SetZeroAll();
+
+    if (config->training.useAdam) {
+        InitTensor1D(&flatMoments, paramNum, X_FLOAT, model->devID, false);
+        InitTensor1D(&flatMoments2nd, paramNum, X_FLOAT, model->devID, false);
+        flatMoments.SetZeroAll();
+        flatMoments2nd.SetZeroAll();
+    }
+
+    MTYPE offset = 0;
     for (int i = 0; i < ws.Size(); i++) {
         XTensor* para = ws[i];
         XNoder::MakeGrad(para);
         para->isVar = true;
 
+        ShareFlatBuffer(para, flatParams, offset, true);
+        ShareFlatBuffer(para->grad, flatGrads, offset, false);
+
         if (config->training.useAdam) {
-            XTensor* m = new XTensor(para);
-            XTensor* m2 = new XTensor(para);
-            m->SetZeroAll();
-            m2->SetZeroAll();
+            XTensor* m = NewTensor(para, false);
+            XTensor* m2 = NewTensor(para, false);
+            ShareFlatBuffer(m, flatMoments, offset, false);
+            ShareFlatBuffer(m2, flatMoments2nd, offset, false);
             moments.Add(m);
             moments2nd.Add(m2);
         }
+
+        offset += para->unitNum;
     }
 
     adamBeta1T = 1.0F;
     adamBeta2T = 1.0F;
 }
 
+/*
+give the parameters (and their gradients) their own data arrays again, so that
+the model does not use the flat buffers after the trainer is gone
+*/
+void Trainer::ReleaseFlatBuffers()
+{
+    if (flatParams.data == NULL)
+        return;
+
+    TensorList ws;
+
+    model->GetParams(ws);
+
+    for (int i = 0; i < ws.Size(); i++) {
+        XTensor* para = ws[i];
+        if (para->isShared)
+            UnshareFlatBuffer(para);
+        if (para->grad != NULL && para->grad->isShared)
+            UnshareFlatBuffer(para->grad);
+    }
+
+    flatParams.DestroyData();
+    flatGrads.DestroyData();
+}
+
 /* 
 load optimizer state from a checkpoint file 
 >> file - path of the checkpoint file
@@ -513,26 +569,23 @@ void Trainer::LoadOptimizerState(const char* file)
     fclose(f);
 }
 
-/* 
-append the optimizer state to the end of a checkpoint file 
->> file - path of the checkpoint file
+/*
+save the model to files. The parameters and the optimizer state are
+copied into the staging tensors of the checkpoint writer, and the files
+are written in the background if the writer thread is running. A file
+with the optimizer state can be used to resume the training (see
+LoadOptimizerState).
+>> files - the files to write
 */
-void Trainer::DumpOptimizerState(const char* file)
+void Trainer::SaveModel(vector<CheckpointFile>& files)
 {
-    FILE* f = fopen(file, "ab");
+    TensorList params;
+    model->GetParams(params);
 
-    /* save the step number */
-    fwrite(&step, sizeof(step), 1, f);
-
-    /* save moments and 2nd moments to the file */
-    for (int i = 0; i < moments.Size(); i++) {
-        moments[i]->BinaryDump(f);
-    }
-    for (int i = 0; i < moments.Size(); i++) {
-        moments2nd[i]->BinaryDump(f);
-    }
+    vector<char> meta;
+    model->GetMetaData(meta);
 
-    fclose(f);
+    checkpointWriter.Save(params, moments, moments2nd, meta, step, files);
 }
 
 } /* end of the nmt namespace */
\ No newline at end of file
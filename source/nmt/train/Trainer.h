@@ -24,6 +24,7 @@
 
 #include "../Model.h"
 #include "TrainDataSet.h"
+#include "CheckpointWriter.h"
 #include "../../niutensor/train/XLearningRate.h"
 
 using namespace nts;
@@ -58,6 +59,13 @@ public:
     /* list of the 2nd order moment of the parameters */
     TensorList moments2nd;
 
+    /* the flat buffers of the parameters, the gradients and the moments.
+       The tensors of the model and the moments above are views of them. */
+    XTensor flatParams;
+    XTensor flatGrads;
+    XTensor flatMoments;
+    XTensor flatMoments2nd;
+
     /* used for loading batches for training */
     TrainDataSet trainBatchLoader;
 
@@ -67,6 +75,9 @@ public:
     /* the learning rate scheduler */
     XLearningRate LRScheduler;
 
+    /* used for writing checkpoints (in the background) */
+    CheckpointWriter checkpointWriter;
+
 public:
     /* constructor */
     Trainer();
@@ -89,17 +100,20 @@ public:
     /* make a checkpoint */
     void MakeCheckpoint(const char* label, int id);
 
+    /* save the model (and the optimizer state) to files */
+    void SaveModel(vector<CheckpointFile>& files);
+
     /* update the model by delta rule */
     void Update(const float lr);
 
     /* prepare model for training */
     void PrepareModel();
 
+    /* give the parameters their own data arrays again */
+    void ReleaseFlatBuffers();
+
     /* load optimizer state from a file */
     void LoadOptimizerState(const char* file);
-
-    /* dump optimizer state to a file */
-    void DumpOptimizerState(const char* path);
 };
 
 } /* end of the nmt namespace */
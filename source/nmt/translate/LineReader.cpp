@@ -0,0 +1,190 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <string.h>
+#include "LineReader.h"
+#include "../../niutensor/tensor/XGlobal.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* constructor */
+LineReader::LineReader()
+{
+    file = NULL;
+    isOwner = false;
+    mapped = NULL;
+    mappedSize = 0;
+    buffer = NULL;
+    bufferSize = 0;
+    data = NULL;
+    pos = 0;
+    end = 0;
+    isEOF = true;
+}
+
+/* de-constructor */
+LineReader::~LineReader()
+{
+    Close();
+}
+
+/*
+open a file
+>> fn - name of the file (stdin if it is empty)
+>> useMMap - map the file into the memory
+*/
+void LineReader::Open(const char* fn, bool useMMap)
+{
+    Close();
+
+    if (strcmp(fn, "") != 0) {
+        file = fopen(fn, "rb");
+        CheckNTErrors(file, "Failed to open the input file");
+        isOwner = true;
+    }
+    else
+        file = stdin;
+
+    isEOF = false;
+
+#ifndef _WIN32
+    struct stat st;
+    if (useMMap && isOwner && fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size > 0) {
+            void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+            if (p != MAP_FAILED) {
+                mapped = (char*)p;
+                mappedSize = (MTYPE)st.st_size;
+                data = mapped;
+                end = mappedSize;
+#ifdef MADV_SEQUENTIAL
+                madvise(mapped, (size_t)mappedSize, MADV_SEQUENTIAL);
+#endif
+            }
+        }
+
+        /* an empty file has nothing to read */
+        if (mapped != NULL || st.st_size == 0)
+            isEOF = true;
+    }
+#endif
+
+    if (mapped == NULL) {
+        bufferSize = LINE_READER_BLOCK_SIZE;
+        buffer = new char[bufferSize];
+        data = buffer;
+    }
+}
+
+/* close the file */
+void LineReader::Close()
+{
+#ifndef _WIN32
+    if (mapped != NULL)
+        munmap(mapped, (size_t)mappedSize);
+#endif
+    mapped = NULL;
+    mappedSize = 0;
+
+    if (file != NULL && isOwner)
+        fclose(file);
+    file = NULL;
+    isOwner = false;
+
+    delete[] buffer;
+    buffer = NULL;
+    bufferSize = 0;
+
+    data = NULL;
+    pos = 0;
+    end = 0;
+    isEOF = true;
+}
+
+/*
+read the next line. The line is kept in the reader until the next call,
+and it has no line break.
+>> line - the beginning of the line (for return)
+>> length - length of the line (for return)
+<< return - false if there is no more line
+*/
+bool LineReader::ReadLine(const char*& line, int& length)
+{
+    while (true) {
+        const char* p = pos < end ? (const char*)memchr(data + pos, '\n', (size_t)(end - pos)) : NULL;
+
+        if (p != NULL) {
+            line = data + pos;
+            length = (int)(p - line);
+            pos = (MTYPE)(p - data) + 1;
+            return true;
+        }
+
+        /* the last line has no line break */
+        if (isEOF) {
+            if (pos >= end)
+                return false;
+            line = data + pos;
+            length = (int)(end - pos);
+            pos = end;
+            return true;
+        }
+
+        if (!ReadBlock())
+            isEOF = true;
+    }
+}
+
+/*
+read more of the file into the buffer. The rest of the data is moved to
+the beginning of the buffer, and the buffer grows if a line does not fit.
+<< return - false if nothing is read
+*/
+bool LineReader::ReadBlock()
+{
+    MTYPE rest = end - pos;
+    if (rest > 0 && pos > 0)
+        memmove(buffer, buffer + pos, (size_t)rest);
+    pos = 0;
+    end = rest;
+
+    if (end == bufferSize) {
+        char* newBuffer = new char[bufferSize * 2];
+        memcpy(newBuffer, buffer, (size_t)end);
+        delete[] buffer;
+        buffer = newBuffer;
+        bufferSize *= 2;
+        data = buffer;
+    }
+
+    size_t n = fread(buffer + end, 1, (size_t)(bufferSize - end), file);
+    end += n;
+
+    return n > 0;
+}
+
+} /* end of the nmt namespace */
@@ -0,0 +1,98 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The line reader reads the input of translation line by line without
+ * copying the lines into strings. A file is mapped into the memory (or read
+ * in large blocks if it cannot be mapped, e.g., stdin), and a line is given
+ * as a pointer to the buffer and its length.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __LINEREADER_H__
+#define __LINEREADER_H__
+
+#include <stdio.h>
+#include "../../niutensor/tensor/XMem.h"
+
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* the size of a block that is read at a time */
+#define LINE_READER_BLOCK_SIZE 4 * 1024 * 1024
+
+/* the line reader */
+class LineReader
+{
+private:
+    /* the file (NULL if there is no input) */
+    FILE* file;
+
+    /* whether the file is opened by the reader */
+    bool isOwner;
+
+    /* the beginning of the mapped file (NULL if the file is not mapped) */
+    char* mapped;
+
+    /* size of the mapped file */
+    MTYPE mappedSize;
+
+    /* the buffer of the blocks */
+    char* buffer;
+
+    /* size of the buffer */
+    MTYPE bufferSize;
+
+    /* the data that is read (the mapped file or the buffer) */
+    char* data;
+
+    /* position of the next line in the data */
+    MTYPE pos;
+
+    /* the end of the data */
+    MTYPE end;
+
+    /* whether the end of the file is reached */
+    bool isEOF;
+
+public:
+    /* constructor */
+    LineReader();
+
+    /* de-constructor */
+    ~LineReader();
+
+    /* open a file (stdin if the name is empty) */
+    void Open(const char* fn, bool useMMap);
+
+    /* close the file */
+    void Close();
+
+    /* read the next line */
+    bool ReadLine(const char*& line, int& length);
+
+private:
+    /* read more of the file into the buffer */
+    bool ReadBlock();
+};
+
+} /* end of the nmt namespace */
+
+#endif /* __LINEREADER_H__ */
@@ -75,6 +75,9 @@ void StateBundle::MakeStates(int num)
 /* constructor */
 Predictor::Predictor()
 {
+    m = NULL;
+    c = NULL;
+    s = NULL;
     startSymbol = 2;
 }
 
@@ -115,14 +118,16 @@ void Predictor::SetStartSymbol(int symbol)
 /*
 read a state
 >> model - the  model that keeps the network created so far
+>> context - the inference state of the model (decoder caches and etc.)
 >> state - a set of states. It keeps
 1) hypotheses (states)
 2) probabilities of hypotheses
 3) parts of the network for expanding toward the next state
 */
-void Predictor::Read(NMTModel* model, StateBundle* state)
+void Predictor::Read(NMTModel* model, InferenceContext* context, StateBundle* state)
 {
     m = model;
+    c = context;
     s = state;
 }
 
@@ -135,10 +140,11 @@ predict the next state
 >> reorderState - the new order of states
 >> needReorder - whether we need to the states
 >> nstep - current time step of the target sequence
+>> normalized - whether the output is normalized by the log-softmax
 */
 void Predictor::Predict(StateBundle* next, XTensor& encoding,
                         XTensor& inputEnc, XTensor& paddingEnc, XTensor& reorderState, 
-                        bool needReorder, int nstep)
+                        bool needReorder, int nstep, bool normalized)
 {
     int dims[MAX_TENSOR_DIM_NUM];
 
@@ -160,12 +166,7 @@ void Predictor::Predict(StateBundle* next, XTensor& encoding,
         if (removeFinishedCache) {
             inputDec = AutoGather(inputDec, reorderState);
         }
-        for (int i = 0; i < m->decoder->nlayer; i++) {
-            m->decoder->selfAttCache[i].Reorder(reorderState);
-            if (removeFinishedCache) {
-                m->decoder->enDeAttCache[i].Reorder(reorderState);
-            }
-        }
+        c->Reorder(reorderState, removeFinishedCache);
     }
 
     /* prediction probabilities */
@@ -183,14 +184,16 @@ void Predictor::Predict(StateBundle* next, XTensor& encoding,
 
     /* make the decoding network */
     if (m->config->model.decPreLN)
-        decoding = m->decoder->RunFastPreNorm(inputDec, encoding, &maskEncDec, nstep);
+        decoding = m->decoder->RunFastPreNorm(inputDec, encoding, &maskEncDec, nstep,
+                                              c->selfAttCache, c->enDeAttCache);
     else
-        decoding = m->decoder->RunFastPostNorm(inputDec, encoding, &maskEncDec, nstep);
+        decoding = m->decoder->RunFastPostNorm(inputDec, encoding, &maskEncDec, nstep,
+                                               c->selfAttCache, c->enDeAttCache);
 
     CheckNTErrors(decoding.order >= 2, "The tensor must be of order 2 or larger!");
 
     /* generate the output probabilities */
-    output = m->outputLayer->Make(decoding, true);
+    output = m->outputLayer->Make(decoding, normalized, &c->shortlist);
 }
 
 /*
@@ -119,6 +119,9 @@ private:
     /* pointer to the transformer model */
     NMTModel* m;
 
+    /* the inference state (decoder caches and etc.) */
+    InferenceContext* c;
+
     /* current state */
     StateBundle* s;
 
@@ -143,12 +146,12 @@ public:
     void SetStartSymbol(int symbol);
 
     /* read a state */
-    void Read(NMTModel* model, StateBundle* state);
+    void Read(NMTModel* model, InferenceContext* context, StateBundle* state);
 
     /* predict the next state */
     void Predict(StateBundle* next, XTensor& encoding,
                  XTensor& inputEnc, XTensor& paddingEnc, XTensor& reorderState,
-                 bool needReorder, int nstep);
+                 bool needReorder, int nstep, bool normalized = true);
 
     /* get the predictions of the previous step */
     XTensor GetLastPrediction(StateBundle* state, int devID);
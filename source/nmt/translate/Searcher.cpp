@@ -29,6 +29,36 @@ using namespace nts;
 /* the nmt namespace */
 namespace nmt
 {
+/*
+constructor
+>> myIndex - index of the sentence
+>> myLengthLimit - max number of steps
+>> beamSize - size of the beam
+*/
+SearchSlot::SearchSlot(int myIndex, int myLengthLimit, int beamSize)
+{
+    index = myIndex;
+    step = 0;
+    lengthLimit = myLengthLimit;
+    finished = false;
+    states = new State[lengthLimit * beamSize];
+    probs = new float[beamSize];
+    offsets = new int[beamSize];
+    for (int j = 0; j < beamSize; j++) {
+        probs[j] = 0;
+        offsets[j] = j;
+    }
+    hypos.Init(beamSize);
+}
+
+/* de-constructor */
+SearchSlot::~SearchSlot()
+{
+    delete[] states;
+    delete[] probs;
+    delete[] offsets;
+}
+
 /* constructor */
 BeamSearch::BeamSearch()
 {
@@ -40,9 +70,12 @@ BeamSearch::BeamSearch()
     fullHypos = NULL;
     endSymbols = new int[32];
     startSymbol = -1;
+    padSymbol = -1;
+    slotNum = 0;
     isEarlyStop = false;
     needReorder = false;
     scalarMaxLength = 0.0F;
+    shortlist = NULL;
 }
 
 /* de-constructor */
@@ -67,7 +100,9 @@ void BeamSearch::Init(NMTConfig& config)
     alpha = config.translation.lenAlpha;
     endSymbols[0] = config.model.eos;
     startSymbol = config.model.sos;
+    padSymbol = config.model.pad;
     scalarMaxLength = config.translation.maxLenAlpha;
+    slotNum = config.common.sBatchSize;
 
     if (endSymbols[0] >= 0)
         endSymbolNum = 1;
@@ -142,6 +177,16 @@ void BeamSearch::Search(NMTModel* model, XTensor& input, XTensor& padding,
 
     CheckNTErrors(lengthLimit > 0, "no max length specified!");
 
+    /* the decoder caches keep at most lengthLimit steps */
+    context.Init(model);
+    context.Reserve(lengthLimit);
+
+    /* restrict the output layer to the shortlist of the batch */
+    if (shortlist != NULL) {
+        shortlist->Make(input, candidates);
+        model->outputLayer->SetShortlist(&candidates, context.shortlist);
+    }
+
     StateBundle* states = new StateBundle[lengthLimit + 1];
     StateBundle* first = states;
     StateBundle* cur = NULL;
@@ -157,6 +202,9 @@ void BeamSearch::Search(NMTModel* model, XTensor& input, XTensor& padding,
     XTensor reorderState;
     InitTensor1D(&reorderState, batchSize * beamSize, X_INT, input.devID);
 
+    /* the log-softmax and the top-k selection are fused on CPUs */
+    bool fusedPruning = (input.devID < 0);
+
     /* generate the sequence from left to right */
     for (int l = 0; l < lengthLimit; l++) {
 
@@ -164,17 +212,23 @@ void BeamSearch::Search(NMTModel* model, XTensor& input, XTensor& padding,
         next = states + l + 1;
 
         /* read the current state */
-        predictor.Read(model, cur);
+        predictor.Read(model, &context, cur);
 
         /* predict the next state */
         predictor.Predict(next, encodingBeam, inputBeam,
-                          paddingBeam, reorderState, needReorder, l);
+                          paddingBeam, reorderState, needReorder, l, !fusedPruning);
 
-        /* compute the model score (given the prediction probability) */
-        Score(cur, next);
+        if (fusedPruning) {
+            /* the model score and beam pruning in one pass */
+            ScoreAndGenerate(cur, next);
+        }
+        else {
+            /* compute the model score (given the prediction probability) */
+            Score(cur, next);
 
-        /* beam pruning */
-        Generate(cur, next);
+            /* beam pruning */
+            Generate(cur, next);
+        }
 
         /* expand the search graph */
         Expand(cur, next, reorderState);
@@ -211,9 +265,361 @@ void BeamSearch::Search(NMTModel* model, XTensor& input, XTensor& padding,
 
     Dump(outputs, &score);
 
+    if (shortlist != NULL)
+        model->outputLayer->SetShortlist(NULL, context.shortlist);
+
     delete[] states;
 }
 
+/* make a tensor of indices (on CPUs) from a list */
+static XTensor MakeIndexTensor(IntList& list)
+{
+    XTensor index;
+    InitTensor1D(&index, list.Size(), X_INT, -1);
+    index.SetData(list.items, list.Size());
+    return index;
+}
+
+/*
+search for the translations of all the sentences in a queue with continuous
+batching. The batch keeps at most slotNum sentences, each with a beam of
+beamSize states. A sentence leaves the batch as soon as its translation is
+done, and the next sentences take the free slots in the middle of the search:
+they run through the encoder, the keys and values of their encoder output are
+appended to the encoder-decoder caches, and their states have no history in
+the self-attention caches (see Cache::Reorder). Each sentence is searched as
+if it were in a batch of its own, i.e., it is at its own step and stops by
+its own length limit or when all its hypotheses are completed. The batch is
+rearranged only if a quarter of the slots are free (or all the sentences are
+done), so that the caches are not copied at every step.
+>> model - the transformer model
+>> queue - the sentences to translate (and where the translations go)
+*/
+void BeamSearch::SearchContinuous(NMTModel* model, SentenceQueue* queue)
+{
+    CheckNTErrors(endSymbolNum > 0, "The search class is not initialized!");
+    CheckNTErrors(startSymbol >= 0, "The search class is not initialized!");
+    CheckNTErrors(model->devID < 0, "Continuous batching runs on CPUs only!");
+
+    /* the sentences in the batch (in the order of their states) */
+    vector<SearchSlot*> slots;
+
+    /* the sentences that wait for free slots */
+    XTensor waitInput;
+    XTensor waitPadding;
+    IntList waitIndices;
+    int waitNext = 0;
+    bool queueDone = false;
+
+    /* the source padding of each state and the encoder-decoder mask */
+    XTensor padding;
+    XTensor maskEncDec;
+
+    /* the encoder output of the last sentences that join the batch (the
+       encoder-decoder attention reads the keys and values in the caches) */
+    XTensor encoding;
+
+    slotNum = MAX(slotNum, 1);
+    context.Init(model);
+
+    while (true) {
+        if (waitNext >= waitIndices.Size() && !queueDone) {
+            waitNext = 0;
+            if (!queue->Next(waitInput, waitPadding, waitIndices)) {
+                waitIndices.Clear();
+                queueDone = true;
+            }
+        }
+
+        int finishedNum = 0;
+        for (size_t g = 0; g < slots.size(); g++) {
+            if (slots[g]->finished)
+                finishedNum++;
+        }
+        int freeNum = slotNum - (int)slots.size() + finishedNum;
+        bool hasWaiting = waitNext < waitIndices.Size();
+
+        if (finishedNum == (int)slots.size() ||
+            (freeNum * 4 >= slotNum && (finishedNum > 0 || hasWaiting))) {
+
+            /* the states of the unfinished sentences are kept in the same order */
+            vector<SearchSlot*> kept;
+            IntList keptStates;
+            IntList order;
+            for (size_t g = 0; g < slots.size(); g++) {
+                SearchSlot* slot = slots[g];
+                if (slot->finished) {
+                    delete slot;
+                    continue;
+                }
+                kept.push_back(slot);
+                for (int j = 0; j < beamSize; j++) {
+                    keptStates.Add((int)g * beamSize + j);
+                    order.Add((int)g * beamSize + slot->offsets[j]);
+                }
+            }
+
+            /* the next sentences take the free slots */
+            vector<SearchSlot*> admitted;
+            int maxSrcLen = 0;
+            int maxLengthLimit = 0;
+            while ((int)(kept.size() + admitted.size()) < slotNum) {
+                if (waitNext >= waitIndices.Size()) {
+                    waitNext = 0;
+                    if (queueDone || !queue->Next(waitInput, waitPadding, waitIndices)) {
+                        waitIndices.Clear();
+                        queueDone = true;
+                        break;
+                    }
+                }
+
+                int i = waitNext++;
+                int len = waitInput.GetDim(1);
+                const int* words = (int*)waitInput.data + i * len;
+                const float* mask = (float*)waitPadding.data + i * len;
+                int srcLen = 0;
+                while (srcLen < len && mask[srcLen] != 0)
+                    srcLen++;
+
+                /* max output-length = scalar * source-length */
+                int lengthLimit = int(float(srcLen) * scalarMaxLength) + maxLen;
+                CheckNTErrors(lengthLimit > 0, "no max length specified!");
+
+                SearchSlot* slot = new SearchSlot(waitIndices[i], lengthLimit, beamSize);
+                for (int t = 0; t < srcLen; t++)
+                    slot->words.Add(words[t]);
+                admitted.push_back(slot);
+
+                maxSrcLen = MAX(maxSrcLen, srcLen);
+                maxLengthLimit = MAX(maxLengthLimit, lengthLimit);
+            }
+
+            if (kept.empty() && admitted.empty())
+                break;
+
+            if (!admitted.empty()) {
+                int newNum = (int)admitted.size();
+                int* inputData = new int[newNum * maxSrcLen];
+                float* paddingData = new float[newNum * maxSrcLen];
+                for (int i = 0; i < newNum; i++) {
+                    IntList& words = admitted[i]->words;
+                    for (int t = 0; t < maxSrcLen; t++) {
+                        inputData[i * maxSrcLen + t] = t < words.Size() ? words[t] : padSymbol;
+                        paddingData[i * maxSrcLen + t] = t < words.Size() ? 1.0F : 0.0F;
+                    }
+                }
+
+                XTensor input;
+                XTensor inputPadding;
+                XTensor maskEnc;
+                InitTensor2D(&input, newNum, maxSrcLen, X_INT, -1);
+                InitTensor2D(&inputPadding, newNum, maxSrcLen, X_FLOAT, -1);
+                input.SetData(inputData, input.unitNum);
+                inputPadding.SetData(paddingData, inputPadding.unitNum);
+                delete[] inputData;
+                delete[] paddingData;
+
+                /* make the encoding network for the new sentences */
+                model->MakeMTMaskEnc(inputPadding, maskEnc);
+                if (model->config->model.encPreLN)
+                    encoding = model->encoder->RunFastPreNorm(input, &maskEnc);
+                else
+                    encoding = model->encoder->RunFastPostNorm(input, &maskEnc);
+
+                XTensor paddingBeam;
+                paddingBeam = Unsqueeze(inputPadding, inputPadding.order - 1, beamSize);
+                paddingBeam.ReshapeMerged(paddingBeam.order - 3);
+
+                padding = KeepAndAppend(padding, keptStates, paddingBeam);
+                model->decoder->AppendEnDeCache(keptStates, encoding, beamSize, context.enDeAttCache);
+
+                /* the new states have no history */
+                for (int i = 0; i < newNum * beamSize; i++)
+                    order.Add(-1);
+
+                context.Reserve(maxLengthLimit);
+            }
+            else {
+                XTensor keptIndex = MakeIndexTensor(keptStates);
+                padding = AutoGather(padding, keptIndex);
+                for (int i = 0; i < context.nlayer; i++)
+                    context.enDeAttCache[i].Reorder(keptIndex);
+            }
+
+            XTensor orderIndex = MakeIndexTensor(order);
+            for (int i = 0; i < context.nlayer; i++)
+                context.selfAttCache[i].Reorder(orderIndex);
+
+            slots = kept;
+            slots.insert(slots.end(), admitted.begin(), admitted.end());
+
+            maskEncDec = model->MakeMTMaskDecInference(padding);
+
+            /* restrict the output layer to the shortlist of the sentences in the batch */
+            if (shortlist != NULL) {
+                IntList words;
+                for (size_t g = 0; g < slots.size(); g++) {
+                    for (int t = 0; t < slots[g]->words.Size(); t++)
+                        words.Add(slots[g]->words[t]);
+                }
+                XTensor source = MakeIndexTensor(words);
+                shortlist->Make(source, candidates);
+                model->outputLayer->SetShortlist(&candidates, context.shortlist);
+            }
+        }
+        else {
+            /* reorder the states in the beams */
+            IntList order;
+            bool reorder = false;
+            for (size_t g = 0; g < slots.size(); g++) {
+                for (int j = 0; j < beamSize; j++) {
+                    order.Add((int)g * beamSize + slots[g]->offsets[j]);
+                    if (slots[g]->offsets[j] != j)
+                        reorder = true;
+                }
+            }
+            if (reorder) {
+                XTensor orderIndex = MakeIndexTensor(order);
+                for (int i = 0; i < context.nlayer; i++)
+                    context.selfAttCache[i].Reorder(orderIndex);
+            }
+        }
+
+        /* the input of each state: <SOS> at the first step, and the last prediction otherwise */
+        int stateNum = (int)slots.size() * beamSize;
+        XTensor inputDec;
+        XTensor steps;
+        XTensor prev;
+        XTensor firstMask;
+        InitTensor2D(&inputDec, stateNum, 1, X_INT, -1);
+        InitTensor1D(&steps, stateNum, X_INT, -1);
+        InitTensor1D(&prev, stateNum, X_FLOAT, -1);
+        InitTensor1D(&firstMask, stateNum, X_FLOAT, -1);
+
+        int* inputData = (int*)inputDec.data;
+        int* stepData = (int*)steps.data;
+        float* prevData = (float*)prev.data;
+        float* maskData = (float*)firstMask.data;
+        bool hasFirst = false;
+
+        for (size_t g = 0; g < slots.size(); g++) {
+            SearchSlot* slot = slots[g];
+            for (int j = 0; j < beamSize; j++) {
+                int k = (int)g * beamSize + j;
+                if (slot->finished || slot->step == 0) {
+                    inputData[k] = startSymbol;
+                    stepData[k] = 0;
+                    prevData[k] = 0;
+
+                    /* mask the hypotheses in the beam except the first one */
+                    maskData[k] = (!slot->finished && j != 0) ? -2e4F : 0;
+                    hasFirst = hasFirst || !slot->finished;
+                }
+                else {
+                    inputData[k] = slot->states[(slot->step - 1) * beamSize + j].prediction;
+                    stepData[k] = slot->step;
+                    prevData[k] = slot->probs[j];
+                    maskData[k] = 0;
+                }
+            }
+        }
+
+        /* make the decoding network */
+        XTensor decoding;
+        if (model->config->model.decPreLN)
+            decoding = model->decoder->RunFastPreNorm(inputDec, encoding, &maskEncDec, 0,
+                                                      context.selfAttCache, context.enDeAttCache, &steps);
+        else
+            decoding = model->decoder->RunFastPostNorm(inputDec, encoding, &maskEncDec, 0,
+                                                       context.selfAttCache, context.enDeAttCache, &steps);
+
+        XTensor output;
+        output = model->outputLayer->Make(decoding, false, &context.shortlist);
+
+        /* the log-softmax, the scores of the paths and beam pruning in one pass */
+        XTensor value;
+        XTensor index;
+        InitTensor2D(&value, (int)slots.size(), beamSize, X_FLOAT, -1);
+        InitTensor2D(&index, (int)slots.size(), beamSize, X_INT, -1);
+        _LogSoftmaxTopK(&output, &prev, hasFirst ? &firstMask : NULL, beamSize, beamSize, 1.0F,
+                        &value, NULL, &index);
+
+        const float* valueData = (float*)value.data;
+        const int* indexData = (int*)index.data;
+        const int* candidateData = shortlist != NULL ? (int*)candidates.data : NULL;
+        int sizeVocab = output.GetDim(-1);
+
+        /* expand the search graph of each sentence (see Expand() and Collect()) */
+        for (size_t g = 0; g < slots.size(); g++) {
+            SearchSlot* slot = slots[g];
+            if (slot->finished)
+                continue;
+
+            /* the GNMT-like length penalty */
+            float lp = LengthPenalizer::GNMT(float(slot->step + 1), alpha);
+
+            State* cur = slot->states + slot->step * beamSize;
+            State* last = slot->step > 0 ? cur - beamSize : NULL;
+            bool allCompleted = true;
+
+            for (int j = 0; j < beamSize; j++) {
+                int k = (int)g * beamSize + j;
+                int offset = indexData[k] / sizeVocab;
+                int prediction = indexData[k] % sizeVocab;
+                if (candidateData != NULL)
+                    prediction = candidateData[prediction];
+
+                State& state = cur[j];
+                state.pid = 0;
+                state.isStart = false;
+                if (last == NULL) {
+                    state.last = NULL;
+                    state.nstep = 0;
+                    state.isCompleted = false;
+                }
+                else {
+                    state.last = last + offset;
+                    state.nstep = state.last->nstep + 1;
+                    state.isCompleted = state.last->isCompleted;
+                }
+
+                state.modelScore = valueData[k] / lp;
+                state.prediction = prediction;
+                state.isEnd = IsEnd(prediction);
+                state.isCompleted = (state.isCompleted || state.isEnd);
+
+                slot->probs[j] = valueData[k];
+                slot->offsets[j] = offset;
+
+                /* we push the hypothesis into the heap when it is completed */
+                if (state.isEnd || state.isCompleted)
+                    slot->hypos.Push(HeapNode<float>(&state, state.modelScore));
+
+                if (!state.isCompleted)
+                    allCompleted = false;
+            }
+
+            slot->step++;
+
+            /* the translation is done */
+            if (allCompleted || slot->step >= slot->lengthLimit) {
+                FillHeap(slot->hypos, cur);
+
+                IntList* translation = new IntList();
+                Dump(slot->hypos, translation);
+                queue->Save(slot->index, translation);
+
+                slot->finished = true;
+                for (int j = 0; j < beamSize; j++)
+                    slot->offsets[j] = j;
+            }
+        }
+    }
+
+    if (shortlist != NULL)
+        model->outputLayer->SetShortlist(NULL, context.shortlist);
+}
+
 /*
 compute the model score for each hypotheses
 >> prev - the beam of the previous state
@@ -307,11 +713,72 @@ void BeamSearch::Generate(StateBundle* prev, StateBundle* beam)
        in the vocabulary by dividing it with vocab-size and computing the remainder. */
     ModMe(index, sizeVocab);
 
+    /* the offsets are positions in the shortlist if it is used */
+    if (shortlist != NULL)
+        Shortlist::MapToVocab(index, candidates);
+
     /* the GNMT-like length penalty */
     float lp = LengthPenalizer::GNMT(beam->nstep, alpha);
     score = probPath / lp;
 }
 
+/*
+compute the model scores and generate tokens for the next state via beam
+pruning. It is the same as Score() followed by Generate(), but the output of
+the predictor is not normalized, and the log-softmax, the sum with the scores
+of the previous state, the top-k selection and the length penalty are done in
+one pass over each row (see _LogSoftmaxTopK). No tensor of the vocabulary
+size is made for the scores.
+>> prev - the last beam
+>> beam - the beam that keeps a number of states
+*/
+void BeamSearch::ScoreAndGenerate(StateBundle* prev, StateBundle* beam)
+{
+    int dimsTopK[MAX_TENSOR_DIM_NUM];
+
+    XTensor& score = beam->modelScore;
+    XTensor& index = beam->prediction;
+    XTensor& preID = beam->preID;
+    XTensor& output = beam->probPath;
+
+    int order = output.order;
+    for (int i = 0; i < order; i++)
+        dimsTopK[i] = output.dimSize[i];
+
+    int sizeVocab = output.dimSize[order - 1];
+
+    dimsTopK[order - 3] /= beamSize;
+    dimsTopK[order - 1] = beamSize;
+
+    beam->nstep = prev->nstep + 1.0F;
+
+    /* mask the hypotheses in the beam except the first one */
+    XTensor firstMask;
+    if (prev->isStart)
+        firstMask = MakeFirstMask(beam);
+
+    XTensor probPath;
+    InitTensor(&probPath, order, dimsTopK, X_FLOAT, output.devID);
+    InitTensor(&score, order, dimsTopK, X_FLOAT, output.devID);
+    InitTensor(&index, order, dimsTopK, X_INT, output.devID);
+
+    /* the GNMT-like length penalty */
+    float lp = LengthPenalizer::GNMT(beam->nstep, alpha);
+
+    _LogSoftmaxTopK(&output, prev->isStart ? NULL : &prev->probPath, prev->isStart ? &firstMask : NULL,
+                    beamSize, beamSize, lp, &probPath, &score, &index);
+
+    beam->probPath = std::move(probPath);
+
+    /* the id of the previous state and the offset in the vocabulary (see Generate()) */
+    preID = Descale(index, sizeVocab);
+    ModMe(index, sizeVocab);
+
+    /* the offsets are positions in the shortlist if it is used */
+    if (shortlist != NULL)
+        Shortlist::MapToVocab(index, candidates);
+}
+
 /*
 expand the search graph
 >> prev - the last beam
@@ -462,19 +929,30 @@ void BeamSearch::FillHeap(StateBundle* beam)
     State* states = beam->states;
 
     for (int i = 0; i < beam->stateNum / beamSize; i++) {
-        for (int j = 0; j < beamSize; j++) {
-            State& state = states[i * beamSize + j];
+        State* beamStates = states + i * beamSize;
+        FillHeap(fullHypos[beamStates[0].pid], beamStates);
+    }
+}
 
-            /* we push the incomplete hypothesis into the heap */
-            if (fullHypos[state.pid].Count() == 0) {
-                fullHypos[state.pid].Push(HeapNode<float>(&state, state.modelScore));
-            }
-            else {
-                HeapNode<float> node = fullHypos[state.pid].Top();
-                float score = node.value;
-                if (score < state.modelScore)
-                    fullHypos[state.pid].Push(HeapNode<float>(&state, state.modelScore));
-            }
+/*
+fill the hypothesis heap of a sentence with its incomplete hypotheses
+>> heap - the heap of the sentence
+>> states - the states in the beam of the sentence (final)
+*/
+void BeamSearch::FillHeap(XHeap<MIN_HEAP, float>& heap, State* states)
+{
+    for (int j = 0; j < beamSize; j++) {
+        State& state = states[j];
+
+        /* we push the incomplete hypothesis into the heap */
+        if (heap.Count() == 0) {
+            heap.Push(HeapNode<float>(&state, state.modelScore));
+        }
+        else {
+            HeapNode<float> node = heap.Top();
+            float score = node.value;
+            if (score < state.modelScore)
+                heap.Push(HeapNode<float>(&state, state.modelScore));
         }
     }
 }
@@ -493,37 +971,46 @@ void BeamSearch::Dump(IntList** output, XTensor* score)
 
     /* heap for an input sentence in the batch */
     for (int h = 0; h < batchSize; h++) {
-        IntList* tgt = output[h];
-        XHeap<MIN_HEAP, float>& heap = fullHypos[h];
-        int c = heap.Count();
-
-        float bestScore = -2e4F;
-        State* state = NULL;
-        for (int i = 0; i < c; i++) {
-            auto node = heap.Pop();
-            State* s = (State*)node.index;
-            if (i == 0 || bestScore < node.value) {
-                state = s;
-                bestScore = node.value;
-            }
+        float bestScore = Dump(fullHypos[h], output[h]);
+        score->Set2D(bestScore, h, 0);
+    }
+}
+
+/*
+save the best output sequence of a sentence (the heap is emptied)
+>> heap - the heap of final hypotheses of the sentence
+>> output - the output sequence (for return)
+<< return - score of the sequence
+*/
+float BeamSearch::Dump(XHeap<MIN_HEAP, float>& heap, IntList* output)
+{
+    int c = heap.Count();
+
+    float bestScore = -2e4F;
+    State* state = NULL;
+    for (int i = 0; i < c; i++) {
+        auto node = heap.Pop();
+        State* s = (State*)node.index;
+        if (i == 0 || bestScore < node.value) {
+            state = s;
+            bestScore = node.value;
         }
+    }
 
-        int count = 0;
-        bool isCompleted = true;
+    bool isCompleted = true;
 
-        /* we track the state from the end to the beginning */
-        while (state != NULL) {
-            if (!state->isCompleted)
-                isCompleted = false;
-            if (!isCompleted) {
-                tgt->Add(state->prediction);
-            }
-            state = state->last;
+    /* we track the state from the end to the beginning */
+    while (state != NULL) {
+        if (!state->isCompleted)
+            isCompleted = false;
+        if (!isCompleted) {
+            output->Add(state->prediction);
         }
-        tgt->Reverse();
-
-        score->Set2D(bestScore, h, 0);
+        state = state->last;
     }
+    output->Reverse();
+
+    return bestScore;
 }
 
 /*
@@ -657,6 +1144,7 @@ GreedySearch::GreedySearch()
     endSymbols = new int[32];
     startSymbol = -1;
     scalarMaxLength = -1;
+    shortlist = NULL;
 }
 
 /* de-constructor */
@@ -752,6 +1240,16 @@ void GreedySearch::Search(NMTModel* model, XTensor& input,
 
     CheckNTErrors(lengthLimit > 0, "Invalid maximum output length");
 
+    /* the decoder caches keep at most lengthLimit steps */
+    context.Init(model);
+    context.Reserve(lengthLimit);
+
+    /* restrict the output layer to the shortlist of the batch */
+    if (shortlist != NULL) {
+        shortlist->Make(input, candidates);
+        model->outputLayer->SetShortlist(&candidates, context.shortlist);
+    }
+
     /* the first token */
     XTensor inputDec;
     InitTensor2D(&inputDec, batchSize, 1, X_INT, input.devID);
@@ -778,17 +1276,23 @@ void GreedySearch::Search(NMTModel* model, XTensor& input,
 
         /* make the decoding network */
         if (model->config->model.decPreLN)
-            decoding = model->decoder->RunFastPreNorm(inputDec, encoding, &maskEncDec, l);
+            decoding = model->decoder->RunFastPreNorm(inputDec, encoding, &maskEncDec, l,
+                                                      context.selfAttCache, context.enDeAttCache);
         else
-            decoding = model->decoder->RunFastPostNorm(inputDec, encoding, &maskEncDec, l);
+            decoding = model->decoder->RunFastPostNorm(inputDec, encoding, &maskEncDec, l,
+                                                       context.selfAttCache, context.enDeAttCache);
 
         /* generate the output probabilities */
-        prob = model->outputLayer->Make(decoding, false);
+        prob = model->outputLayer->Make(decoding, false, &context.shortlist);
 
         /* get the most promising predictions */
         prob.Reshape(prob.dimSize[0], prob.dimSize[prob.order - 1]);
         TopK(prob, bestScore, inputDec, -1, 1);
 
+        /* the predictions are positions in the shortlist if it is used */
+        if (shortlist != NULL)
+            Shortlist::MapToVocab(inputDec, candidates);
+
         /* save the predictions */
         CopyValues(inputDec, indexCPU);
 
@@ -808,6 +1312,9 @@ void GreedySearch::Search(NMTModel* model, XTensor& input,
         }
     }
 
+    if (shortlist != NULL)
+        model->outputLayer->SetShortlist(NULL, context.shortlist);
+
     delete[] finishedFlags;
 }
 
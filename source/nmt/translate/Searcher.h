@@ -25,6 +25,7 @@
 
 #include "../Model.h"
 #include "Predictor.h"
+#include "Shortlist.h"
 
 using namespace std;
 
@@ -32,6 +33,55 @@ using namespace std;
 namespace nmt
 {
 
+/* the sentences to translate with continuous batching (see BeamSearch::SearchContinuous) */
+class SentenceQueue
+{
+public:
+    /* get the next batch of sentences (false if there is no more) */
+    virtual bool Next(XTensor& input, XTensor& padding, IntList& indices) = 0;
+
+    /* save the translation of a sentence (the queue owns the output afterwards) */
+    virtual void Save(int index, IntList* output) = 0;
+};
+
+/* a sentence in the batch of continuous batching. It keeps the states of
+   all the steps for backtracking and its own heap of final hypotheses. */
+struct SearchSlot
+{
+    /* index of the sentence */
+    int index;
+
+    /* number of steps that are done */
+    int step;
+
+    /* max number of steps */
+    int lengthLimit;
+
+    /* indicates whether the translation is done */
+    bool finished;
+
+    /* the source words (for the vocabulary shortlist) */
+    IntList words;
+
+    /* the states of all the steps, (lengthLimit, beamSize) */
+    State* states;
+
+    /* the score of each hypothesis in the beam (without the length penalty) */
+    float* probs;
+
+    /* the hypothesis of the previous step that each one in the beam comes from */
+    int* offsets;
+
+    /* the final hypotheses */
+    XHeap<MIN_HEAP, float> hypos;
+
+    /* constructor */
+    SearchSlot(int myIndex, int myLengthLimit, int beamSize);
+
+    /* de-constructor */
+    ~SearchSlot();
+};
+
 /* The class organizes the search process. It calls "predictors" to generate
    distributions of the predictions and prunes the search space by beam pruning.
    This makes a graph where each path represents a translation hypotheses.
@@ -63,19 +113,34 @@ private:
     /* start symbol */
     int startSymbol;
 
+    /* padding symbol */
+    int padSymbol;
+
     /* scalar of the input sequence (for max number of search steps) */
     float scalarMaxLength;
 
+    /* the number of sentences in the batch of continuous batching */
+    int slotNum;
+
     /* indicate whether the early stop strategy is used */
     bool isEarlyStop;
 
     /* whether we need to reorder the states */
     bool needReorder;
 
+    /* the words in the shortlist of the current batch */
+    XTensor candidates;
+
 public:
+    /* the inference state of the model (decoder caches and etc.) */
+    InferenceContext context;
+
     /* predictor */
     Predictor predictor;
 
+    /* the vocabulary shortlist (NULL for the whole vocabulary) */
+    Shortlist* shortlist;
+
     /* constructor */
     BeamSearch();
 
@@ -88,6 +153,9 @@ public:
     /* search for the most promising states */
     void Search(NMTModel* model, XTensor& input, XTensor& padding, IntList** output, XTensor& score);
 
+    /* search for the translations of all the sentences in a queue with continuous batching */
+    void SearchContinuous(NMTModel* model, SentenceQueue* queue);
+
     /* preparation */
     void Prepare(int myBatchSize, int myBeamSize);
 
@@ -97,6 +165,9 @@ public:
     /* generate token indices via beam pruning */
     void Generate(StateBundle* prev, StateBundle* beam);
 
+    /* compute the model scores and generate token indices in one pass */
+    void ScoreAndGenerate(StateBundle* prev, StateBundle* beam);
+
     /* expand the search graph */
     void Expand(StateBundle* prev, StateBundle* beam, XTensor& reorderState);
 
@@ -106,9 +177,15 @@ public:
     /* fill the hypotheses heap with incomplete hypotheses */
     void FillHeap(StateBundle* beam);
 
+    /* fill the hypotheses heap of a sentence with its incomplete hypotheses */
+    void FillHeap(XHeap<MIN_HEAP, float>& heap, State* states);
+
     /* save the output sequences and score */
     void Dump(IntList** output, XTensor* score);
 
+    /* save the best output sequence of a sentence */
+    float Dump(XHeap<MIN_HEAP, float>& heap, IntList* output);
+
     /* check if the token is an end symbol */
     bool IsEnd(int token);
 
@@ -146,7 +223,15 @@ private:
     /* scalar of the input sequence (for max number of search steps) */
     float scalarMaxLength;
 
+    /* the words in the shortlist of the current batch */
+    XTensor candidates;
+
 public:
+    /* the inference state of the model (decoder caches and etc.) */
+    InferenceContext context;
+
+    /* the vocabulary shortlist (NULL for the whole vocabulary) */
+    Shortlist* shortlist;
 
     /* constructor */
     GreedySearch();
@@ -0,0 +1,555 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <iostream>
+#include "Server.h"
+#include "../../niutensor/tensor/XUtility.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/*
+constructor
+>> mySocket - the socket of the connection (-1 for stdout)
+*/
+ServerClient::ServerClient(int mySocket)
+{
+    socket = mySocket;
+}
+
+/* de-constructor */
+ServerClient::~ServerClient()
+{
+#ifndef _WIN32
+    if (socket >= 0)
+        close(socket);
+#endif
+}
+
+/*
+send a line to the client
+>> line - the line (without the line break)
+*/
+void ServerClient::Reply(const string& line)
+{
+    if (socket < 0) {
+        cout << line << "\n";
+        return;
+    }
+
+#ifndef _WIN32
+    string msg = line + "\n";
+    size_t sent = 0;
+    while (sent < msg.size()) {
+        ssize_t n = send(socket, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+
+        /* the client has gone, and so has the reply */
+        if (n <= 0 && errno != EINTR)
+            return;
+        if (n > 0)
+            sent += n;
+    }
+#endif
+}
+
+/* make sure that all replies are sent */
+void ServerClient::Flush()
+{
+    if (socket < 0)
+        cout.flush();
+}
+
+#ifndef _WIN32
+/* the listening socket of the server to stop on signals */
+static volatile sig_atomic_t stopListener = -1;
+
+/*
+stop accepting connections on SIGINT and SIGTERM. Shutting the
+listening socket down wakes up the thread blocked in accept().
+>> sig - the signal
+*/
+static void HandleStopSignal(int sig)
+{
+    if (stopListener >= 0)
+        shutdown(stopListener, SHUT_RDWR);
+}
+#endif
+
+/* constructor */
+TranslationServer::TranslationServer()
+{
+    model = NULL;
+    config = NULL;
+    closed = false;
+    listener = -1;
+}
+
+/* de-constructor */
+TranslationServer::~TranslationServer()
+{
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (readers[i].joinable())
+            readers[i].join();
+    }
+
+    CloseConnections();
+
+    for (size_t i = 0; i < queue.size(); i++) {
+        delete queue[i]->sample;
+        delete queue[i];
+    }
+
+#ifndef _WIN32
+    if (listener >= 0) {
+        stopListener = -1;
+        close(listener);
+    }
+#endif
+}
+
+/*
+initialize the server
+>> myConfig - configuration of the NMT system
+>> myModel - the translation model
+*/
+void TranslationServer::Init(NMTConfig& myConfig, NMTModel& myModel)
+{
+    model = &myModel;
+    config = &myConfig;
+
+    translator.Init(myConfig, myModel);
+    batchLoader.InitVocab(myConfig);
+
+    if (config->translation.port <= 0) {
+        LOG("serving requests from stdin (max latency=%dms)", config->translation.maxLatency);
+        return;
+    }
+
+#ifndef _WIN32
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    CheckNTErrors(listener >= 0, "Cannot create the socket of the server");
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    /* only local clients can connect */
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)config->translation.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    CheckNTErrors(bind(listener, (sockaddr*)&addr, sizeof(addr)) == 0, "Cannot bind the port of the server");
+    CheckNTErrors(listen(listener, SOMAXCONN) == 0, "Cannot listen on the port of the server");
+
+    stopListener = listener;
+    signal(SIGINT, HandleStopSignal);
+    signal(SIGTERM, HandleStopSignal);
+
+    LOG("serving requests on 127.0.0.1:%d (max latency=%dms)", config->translation.port, config->translation.maxLatency);
+#else
+    ShowNTErrors("The TCP server is not supported on Windows, please serve requests from stdin!");
+#endif
+}
+
+/*
+make a request from a line of input
+>> line - the line (tokens separated by spaces)
+>> client - who sent the line
+<< return - the request
+*/
+ServerRequest* TranslationServer::MakeRequest(const string& line, shared_ptr<ServerClient>& client)
+{
+    ServerRequest* request = new ServerRequest();
+    request->client = client;
+    request->arrival = chrono::steady_clock::now();
+    request->sample = NULL;
+
+    /* clients on the network might end lines with "\r\n" */
+    string text = line;
+    if (text.size() > 0 && text[text.size() - 1] == '\r')
+        text.erase(text.size() - 1);
+
+    /* empty lines are translated into empty lines */
+    if (text.find_first_not_of(" \t") != string::npos)
+        request->sample = batchLoader.LoadSample(text);
+
+    return request;
+}
+
+/* add a request to the queue and inform the batcher */
+void TranslationServer::AddRequest(ServerRequest* request)
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        queue.push_back(request);
+    }
+    queueCond.notify_one();
+}
+
+/* read requests from stdin until it is closed */
+void TranslationServer::ReadStdin()
+{
+    shared_ptr<ServerClient> client(new ServerClient(-1));
+
+    string line;
+    while (getline(cin, line))
+        AddRequest(MakeRequest(line, client));
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        closed = true;
+    }
+    queueCond.notify_one();
+}
+
+/*
+accept connections from the local port (a thread for each connection)
+until the server is stopped. Then the connections are no longer read,
+and the queue is closed when the requests from them are all in it.
+*/
+void TranslationServer::Accept()
+{
+#ifndef _WIN32
+    while (true) {
+        int s = accept(listener, NULL, NULL);
+        if (s < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        ReapConnections();
+
+        ServerConnection* connection = new ServerConnection();
+        connection->client.reset(new ServerClient(s));
+        connection->finished = false;
+
+        lock_guard<mutex> lock(connectionMutex);
+        connections.push_back(connection);
+        connection->reader = thread(&TranslationServer::ReadClient, this, connection);
+    }
+
+    CloseConnections();
+#endif
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        closed = true;
+    }
+    queueCond.notify_one();
+}
+
+/*
+read requests from a connection until the client closes it (or the server
+stops). The connection is closed when all the requests from it are answered.
+>> connection - the connection
+*/
+void TranslationServer::ReadClient(ServerConnection* connection)
+{
+#ifndef _WIN32
+    shared_ptr<ServerClient> client = connection->client;
+    char buf[4096];
+    string line;
+    while (true) {
+        ssize_t n = recv(client->socket, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] == '\n') {
+                AddRequest(MakeRequest(line, client));
+                line.clear();
+            }
+            else
+                line += buf[i];
+        }
+    }
+
+    /* the last line might not end with a line break */
+    if (line.size() > 0)
+        AddRequest(MakeRequest(line, client));
+#endif
+
+    /* the socket is closed when the last reply is sent */
+    lock_guard<mutex> lock(connectionMutex);
+    connection->client.reset();
+    connection->finished = true;
+}
+
+/* release the connections whose readers have finished */
+void TranslationServer::ReapConnections()
+{
+    vector<ServerConnection*> finished;
+    {
+        lock_guard<mutex> lock(connectionMutex);
+        size_t num = 0;
+        for (size_t i = 0; i < connections.size(); i++) {
+            if (connections[i]->finished)
+                finished.push_back(connections[i]);
+            else
+                connections[num++] = connections[i];
+        }
+        connections.resize(num);
+    }
+
+    for (size_t i = 0; i < finished.size(); i++) {
+        finished[i]->reader.join();
+        delete finished[i];
+    }
+}
+
+/*
+stop reading from the connections and release them. The readers are woken
+up by shutting down the reading side of the sockets, so that the replies
+to the requests they have read can still be sent.
+*/
+void TranslationServer::CloseConnections()
+{
+    vector<ServerConnection*> all;
+    {
+        lock_guard<mutex> lock(connectionMutex);
+        all.swap(connections);
+#ifndef _WIN32
+        for (size_t i = 0; i < all.size(); i++) {
+            if (all[i]->client != NULL)
+                shutdown(all[i]->client->socket, SHUT_RD);
+        }
+#endif
+    }
+
+    for (size_t i = 0; i < all.size(); i++) {
+        all[i]->reader.join();
+        delete all[i];
+    }
+}
+
+/*
+wait for the next batch of requests. The batch is the longest prefix of the
+queue that fits the batch size, and we wait until it is full, or the oldest
+request has waited for long enough, or no more requests will come.
+>> batch - the requests to translate
+<< return - false if the server has nothing more to do
+*/
+bool TranslationServer::NextBatch(vector<ServerRequest*>& batch)
+{
+    int beamSize = config->translation.beamSize;
+    int sBatchSize = config->common.sBatchSize;
+    int wBatchSize = config->common.wBatchSize;
+    chrono::milliseconds maxLatency(config->translation.maxLatency);
+
+    batch.clear();
+
+    unique_lock<mutex> lock(queueMutex);
+
+    while (true) {
+        if (queue.empty()) {
+            if (closed)
+                return false;
+            queueCond.wait(lock);
+            continue;
+        }
+
+        /* the longest prefix that fits in a batch (in both sentences and padded tokens) */
+        int num = 0;
+        int maxLen = 0;
+        bool full = false;
+        for (size_t i = 0; i < queue.size(); i++) {
+            ServerRequest* request = queue[i];
+            int len = request->sample != NULL ? request->sample->srcSeq->Size() : 0;
+            int newMaxLen = MAX(maxLen, len);
+            if (num >= sBatchSize || (num > 0 && (num + 1) * newMaxLen * beamSize > wBatchSize)) {
+                full = true;
+                break;
+            }
+            num++;
+            maxLen = newMaxLen;
+        }
+        if (num * maxLen * beamSize >= wBatchSize)
+            full = true;
+
+        chrono::steady_clock::time_point deadline = queue.front()->arrival + maxLatency;
+
+        if (full || closed || chrono::steady_clock::now() >= deadline) {
+            batch.assign(queue.begin(), queue.begin() + num);
+            queue.erase(queue.begin(), queue.begin() + num);
+            return true;
+        }
+
+        queueCond.wait_until(lock, deadline);
+    }
+}
+
+/*
+turn a sequence of target ids into a line of tokens
+>> ids - the target ids
+>> vocab - the target vocabulary
+>> line - the line (for return)
+*/
+static void MakeLine(IntList* ids, Vocab& vocab, string& line)
+{
+    for (int j = 0; j < ids->Size(); j++) {
+        if (j > 0)
+            line += " ";
+        int length;
+        const char* token = vocab.GetToken(ids->Get(j), length);
+        line.append(token, length);
+    }
+}
+
+/*
+translate a batch of requests
+>> batch - the requests (the translation is kept in each request)
+*/
+void TranslationServer::TranslateRequests(vector<ServerRequest*>& batch)
+{
+    TranslationCache* cache = translator.GetCache();
+
+    /* the sources of the requests to translate */
+    vector<IntList*> sources(batch.size(), NULL);
+
+    /* move the inputs to the buffer of the batch loader (the hits of the cache are done here) */
+    batchLoader.ClearBuf();
+    for (size_t i = 0; i < batch.size(); i++) {
+        Sample* sample = batch[i]->sample;
+        if (sample == NULL)
+            continue;
+
+        if (cache != NULL) {
+            IntList output;
+            if (cache->Lookup(sample->srcSeq, &output)) {
+                MakeLine(&output, batchLoader.tgtVocab, batch[i]->output);
+                delete sample;
+                batch[i]->sample = NULL;
+                continue;
+            }
+        }
+
+        sample->index = int(i);
+        sources[i] = sample->srcSeq;
+        batchLoader.buf->Add(sample);
+        batch[i]->sample = NULL;
+    }
+    batchLoader.SortBySrcLengthDescending();
+
+    /* inputs */
+    XTensor batchEnc;
+    XTensor paddingEnc;
+
+    /* sentence information */
+    XList info;
+    XList inputs;
+    int wordCount;
+    IntList indices;
+    inputs.Add(&batchEnc);
+    inputs.Add(&paddingEnc);
+    info.Add(&wordCount);
+    info.Add(&indices);
+
+    while (!batchLoader.IsEmpty()) {
+        batchLoader.GetBatchSimple(&inputs, &info);
+
+        int batchSize = batchEnc.GetDim(0);
+        IntList** outputs = new IntList * [batchSize];
+        for (int i = 0; i < batchSize; i++)
+            outputs[i] = new IntList();
+
+        translator.TranslateBatch(batchEnc, paddingEnc, outputs);
+
+        for (int i = 0; i < batchSize; i++) {
+            MakeLine(outputs[i], batchLoader.tgtVocab, batch[indices[i]]->output);
+            if (cache != NULL)
+                cache->Add(sources[indices[i]], outputs[i]);
+            delete outputs[i];
+        }
+        delete[] outputs;
+    }
+
+    batchLoader.ClearBuf();
+}
+
+/* serve requests until the input is closed (for the stdin mode) */
+void TranslationServer::Run()
+{
+    if (listener >= 0)
+        readers.push_back(thread(&TranslationServer::Accept, this));
+    else
+        readers.push_back(thread(&TranslationServer::ReadStdin, this));
+
+    int sentCount = 0;
+    int batchCount = 0;
+    double startT = GetClockSec();
+
+    vector<ServerRequest*> batch;
+    while (NextBatch(batch)) {
+        TranslateRequests(batch);
+
+        /* reply in the order of the requests */
+        for (size_t i = 0; i < batch.size(); i++)
+            batch[i]->client->Reply(batch[i]->output);
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (i + 1 == batch.size() || batch[i]->client != batch[i + 1]->client)
+                batch[i]->client->Flush();
+        }
+
+        sentCount += int(batch.size());
+        batchCount++;
+
+        for (size_t i = 0; i < batch.size(); i++)
+            delete batch[i];
+    }
+
+    LOG("served %d sentences in %d batches (took %.1fs)", sentCount, batchCount, GetClockSec() - startT);
+
+    translator.CloseCache();
+}
+
+/*
+stop accepting connections. The requests that have been received are
+still served, and Run() returns when they are answered. It has no effect
+in the stdin mode, where the server stops when the input is closed.
+*/
+void TranslationServer::Stop()
+{
+#ifndef _WIN32
+    if (listener >= 0)
+        shutdown(listener, SHUT_RDWR);
+#endif
+}
+
+} /* end of the nmt namespace */
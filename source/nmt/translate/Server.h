@@ -0,0 +1,186 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A long-lived translation server. The model stays in the memory, and
+ * requests (one sentence per line) come from stdin or from the clients
+ * of a local TCP port. The requests are collected by a dynamic batcher:
+ * a batch is sent to the searcher as soon as it is full (see -sbatch and
+ * -wbatch) or its oldest request has waited for -maxlatency milliseconds.
+ * The translations are sent back to the clients in the order of the requests.
+ * The TCP server stops accepting connections on SIGINT or SIGTERM, and it
+ * exits after the requests it has received are answered.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <condition_variable>
+#include "Translator.h"
+
+using namespace std;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* a client of the server (stdout or a connection) */
+class ServerClient
+{
+public:
+    /* the socket (-1 for stdout) */
+    int socket;
+
+public:
+    /* constructor */
+    ServerClient(int mySocket);
+
+    /* de-constructor (the socket is closed) */
+    ~ServerClient();
+
+    /* send a line to the client */
+    void Reply(const string& line);
+
+    /* make sure that all replies are sent */
+    void Flush();
+};
+
+/* a request of translation */
+struct ServerRequest
+{
+    /* the input sequence (NULL for an empty line) */
+    Sample* sample;
+
+    /* the client that sent the request */
+    shared_ptr<ServerClient> client;
+
+    /* when the request arrived */
+    chrono::steady_clock::time_point arrival;
+
+    /* the translation */
+    string output;
+};
+
+/* a connection and the thread that reads requests from it */
+struct ServerConnection
+{
+    /* the client of the connection */
+    shared_ptr<ServerClient> client;
+
+    /* the thread that reads requests */
+    thread reader;
+
+    /* indicates whether the reader has finished */
+    bool finished;
+};
+
+/* the translation server */
+class TranslationServer
+{
+private:
+    /* the translation model */
+    NMTModel* model;
+
+    /* configuration of the NMT system */
+    NMTConfig* config;
+
+    /* the translator that runs the search */
+    Translator translator;
+
+    /* vocabularies and batching */
+    TranslateDataset batchLoader;
+
+    /* requests that are waiting for translation */
+    deque<ServerRequest*> queue;
+
+    /* a lock to protect the queue */
+    mutex queueMutex;
+
+    /* to inform the batcher of new requests */
+    condition_variable queueCond;
+
+    /* indicates whether no more requests will come */
+    bool closed;
+
+    /* the listening socket (-1 for the stdin mode) */
+    int listener;
+
+    /* the threads that read requests (from stdin or accept connections) */
+    vector<thread> readers;
+
+    /* the connections of the clients */
+    vector<ServerConnection*> connections;
+
+    /* a lock to protect the connections */
+    mutex connectionMutex;
+
+private:
+    /* make a request from a line of input */
+    ServerRequest* MakeRequest(const string& line, shared_ptr<ServerClient>& client);
+
+    /* add a request to the queue */
+    void AddRequest(ServerRequest* request);
+
+    /* read requests from stdin */
+    void ReadStdin();
+
+    /* accept connections from the local port */
+    void Accept();
+
+    /* read requests from a connection */
+    void ReadClient(ServerConnection* connection);
+
+    /* release the connections whose readers have finished */
+    void ReapConnections();
+
+    /* stop reading from the connections and release them */
+    void CloseConnections();
+
+    /* wait for the next batch of requests */
+    bool NextBatch(vector<ServerRequest*>& batch);
+
+    /* translate a batch of requests */
+    void TranslateRequests(vector<ServerRequest*>& batch);
+
+public:
+    /* constructor */
+    TranslationServer();
+
+    /* de-constructor */
+    ~TranslationServer();
+
+    /* initialize the server */
+    void Init(NMTConfig& myConfig, NMTModel& myModel);
+
+    /* serve requests until the input is closed */
+    void Run();
+
+    /* stop accepting connections (the requests received are still served) */
+    void Stop();
+};
+
+} /* end of the nmt namespace */
+
+#endif /* __SERVER_H__ */
@@ -0,0 +1,195 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "Vocab.h"
+#include "Shortlist.h"
+#include "../../niutensor/tensor/XUtility.h"
+#include "../../niutensor/tensor/core/CHeader.h"
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* constructor */
+Shortlist::Shortlist()
+{
+    tgtVocabSize = 0;
+    topN = 0;
+}
+
+/*
+load the lexical table. Each line of the table is a source word, a target
+word and the probability of translating the source word into the target word.
+We keep the most probable translations of each source word. The target words
+are assumed to be sorted by frequency in the vocabulary (as the vocabularies
+of BPE are), so that the most frequent words have the smallest ids.
+>> config - configuration of the NMT system
+*/
+void Shortlist::Load(NMTConfig& config)
+{
+    Vocab srcVocab;
+    Vocab tgtVocab;
+    srcVocab.Load(config.common.srcVocabFN);
+    if (strcmp(config.common.srcVocabFN, config.common.tgtVocabFN) == 0)
+        tgtVocab.CopyFrom(srcVocab);
+    else
+        tgtVocab.Load(config.common.tgtVocabFN);
+
+    const int srcVocabSize = config.model.srcVocabSize;
+    const int transN = config.translation.shortlistTransN;
+
+    tgtVocabSize = config.model.tgtVocabSize;
+    topN = MIN(MAX(config.translation.shortlistTopN, 0), tgtVocabSize);
+
+    reserved.clear();
+    reserved.push_back(config.model.eos);
+    reserved.push_back(config.model.unk);
+
+    /* read the (source word, target word, probability) entries */
+    vector<vector<pair<float, int>>> entries(srcVocabSize);
+    ifstream f(config.translation.shortlistFN, ios::in);
+    CheckNTErrors(f.is_open(), "Failed to open the lexical table of the shortlist");
+
+    int entryNum = 0;
+    string line;
+    while (getline(f, line)) {
+        istringstream fields(line);
+        string src;
+        string tgt;
+        float prob = 1.0F;
+        if (!(fields >> src >> tgt))
+            continue;
+        fields >> prob;
+
+        int s = srcVocab.FindID(src);
+        int t = tgtVocab.FindID(tgt);
+        if (s < 0 || t < 0)
+            continue;
+        if (s >= srcVocabSize || t >= tgtVocabSize)
+            continue;
+
+        entries[s].push_back(make_pair(prob, t));
+        entryNum++;
+    }
+    f.close();
+
+    /* keep the most probable translations */
+    translations.clear();
+    translations.resize(srcVocabSize);
+    for (int i = 0; i < srcVocabSize; i++) {
+        vector<pair<float, int>>& e = entries[i];
+        int num = MIN((int)e.size(), transN);
+        partial_sort(e.begin(), e.begin() + num, e.end(),
+            [](const pair<float, int>& a, const pair<float, int>& b) {
+                return a.first > b.first;
+            });
+        for (int j = 0; j < num; j++)
+            translations[i].push_back(e[j].second);
+    }
+
+    LOG("loaded the shortlist (%d entries, top %d words + %d translations per source word)",
+        entryNum, topN, transN);
+}
+
+/*
+make the shortlist of a batch, i.e., the most frequent target words and the
+translations of all the source words in the batch
+>> input - the source sequences, (B, L)
+>> candidates - the target words in the shortlist (in ascending order), (V')
+*/
+void Shortlist::Make(XTensor& input, XTensor& candidates)
+{
+    CheckNTErrors(input.dataType == X_INT, "The input must be word ids!");
+
+    XTensor inputCPU;
+    if (input.devID >= 0) {
+        InitTensorOnCPU(&inputCPU, &input);
+        CopyValues(input, inputCPU);
+    }
+    const int* words = input.devID >= 0 ? (int*)inputCPU.data : (int*)input.data;
+
+    vector<bool> selected(tgtVocabSize, false);
+    for (int i = 0; i < topN; i++)
+        selected[i] = true;
+    for (size_t i = 0; i < reserved.size(); i++) {
+        if (reserved[i] >= 0 && reserved[i] < tgtVocabSize)
+            selected[reserved[i]] = true;
+    }
+    for (int i = 0; i < input.unitNum; i++) {
+        int w = words[i];
+        if (w < 0 || w >= (int)translations.size())
+            continue;
+        for (size_t j = 0; j < translations[w].size(); j++)
+            selected[translations[w][j]] = true;
+    }
+
+    int* ids = new int[tgtVocabSize];
+    int count = 0;
+    for (int i = 0; i < tgtVocabSize; i++) {
+        if (selected[i])
+            ids[count++] = i;
+    }
+
+    InitTensor1D(&candidates, count, X_INT, input.devID);
+    candidates.SetData(ids, count);
+
+    delete[] ids;
+}
+
+/*
+map the positions in the shortlist back to word ids, i.e., index(i) = candidates(index(i))
+>> index - the positions in the shortlist (replaced by the word ids)
+>> candidates - the target words in the shortlist
+*/
+void Shortlist::MapToVocab(XTensor& index, XTensor& candidates)
+{
+    CheckNTErrors(index.dataType == X_INT && candidates.dataType == X_INT, "The ids must be integers!");
+
+    XTensor indexCPU;
+    XTensor candidatesCPU;
+    XTensor* i = &index;
+    XTensor* c = &candidates;
+
+    if (index.devID >= 0) {
+        InitTensorOnCPU(&indexCPU, &index);
+        CopyValues(index, indexCPU);
+        i = &indexCPU;
+    }
+    if (candidates.devID >= 0) {
+        InitTensorOnCPU(&candidatesCPU, &candidates);
+        CopyValues(candidates, candidatesCPU);
+        c = &candidatesCPU;
+    }
+
+    int* iData = (int*)i->data;
+    const int* cData = (int*)c->data;
+    for (int k = 0; k < i->unitNum; k++) {
+        CheckNTErrors(iData[k] >= 0 && iData[k] < c->unitNum, "Wrong position in the shortlist!");
+        iData[k] = cData[iData[k]];
+    }
+
+    if (i != &index)
+        CopyValues(*i, index);
+}
+
+} /* end of the nmt namespace */
@@ -0,0 +1,73 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The vocabulary shortlist restricts the output layer to the target words
+ * that are likely to appear in the translation of a batch, i.e., the most
+ * frequent words plus the translations of the source words in a lexical
+ * table. The projection, the softmax and the top-k selection then run over
+ * the shortlist instead of the whole vocabulary.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __SHORTLIST_H__
+#define __SHORTLIST_H__
+
+#include <vector>
+#include "../Config.h"
+#include "../../niutensor/tensor/XTensor.h"
+
+using namespace std;
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* the vocabulary shortlist */
+class Shortlist
+{
+private:
+    /* the size of the target vocabulary */
+    int tgtVocabSize;
+
+    /* the number of the most frequent target words in every shortlist */
+    int topN;
+
+    /* the target words that are always in the shortlist (e.g., <eos>) */
+    vector<int> reserved;
+
+    /* the translations of each source word */
+    vector<vector<int>> translations;
+
+public:
+    /* constructor */
+    Shortlist();
+
+    /* load the lexical table */
+    void Load(NMTConfig& config);
+
+    /* make the shortlist of a batch */
+    void Make(XTensor& input, XTensor& candidates);
+
+    /* map the positions in the shortlist back to word ids */
+    static void MapToVocab(XTensor& index, XTensor& candidates);
+};
+
+} /* end of the nmt namespace */
+
+#endif /* __SHORTLIST_H__ */
@@ -19,7 +19,6 @@
  * $Created by: HU Chi (huchinlp@gmail.com) 2021-06
  */
 
-#include <iostream>
 #include <algorithm>
 #include "TranslateDataSet.h"
 #include "../../niutensor/tensor/XTensor.h"
@@ -35,25 +34,41 @@ unsigned int pow2[pow2Num];
 /* transfrom a line to a sequence */
 Sample* TranslateDataset::LoadSample(const string& line)
 {
-    const string delimiter = " ";
+    return LoadSample(line.data(), int(line.size()));
+}
 
-    /* split a line to tokens by spaces */
-    vector<string> srcTokens = SplitString(line, delimiter,
-                                           config->model.maxSrcLen - 1);
+/*
+transfrom a line to a sequence. The tokens are separated by spaces, and
+they are looked up in the vocabulary without being copied.
+>> line - the beginning of the line
+>> length - length of the line
+<< return - the sample
+*/
+Sample* TranslateDataset::LoadSample(const char* line, int length)
+{
+    const int maxNum = config->model.maxSrcLen - 1;
 
-    IntList* srcSeq = new IntList(int(srcTokens.size()));
+    IntList* srcSeq = new IntList(MIN(length / 2 + 2, maxNum + 1));
     Sample* sample = new Sample(srcSeq);
 
-    /* transform tokens to ids */
-    for (const string& token : srcTokens) {
-        if (srcVocab.token2id.find(token) == srcVocab.token2id.end())
-            srcSeq->Add(srcVocab.unkID);
-        else
-            srcSeq->Add(srcVocab.token2id.at(token));
+    /* split the line by spaces and transform the tokens to ids */
+    const char* p = line;
+    const char* end = line + length;
+    while (p < end && srcSeq->Size() < maxNum) {
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+
+        const char* token = p;
+        while (p < end && *p != ' ')
+            p++;
+
+        srcSeq->Add(srcVocab.GetID(token, int(p - token)));
     }
 
     /* the sequence should end with EOS */
-    if(srcSeq->Get(-1) != srcVocab.eosID)
+    if (srcSeq->Size() == 0 || srcSeq->Get(-1) != srcVocab.eosID)
         srcSeq->Add(srcVocab.eosID);
     
     return sample;
@@ -68,13 +83,14 @@ bool TranslateDataset::LoadBatchToBuf()
     ClearBuf();
     emptyLines.Clear();
 
-    string line;
+    const char* line;
+    int length;
 
-    while (getline(*ifp, line) && id < config->common.bufSize) {
+    while (id < config->common.bufSize && reader.ReadLine(line, length)) {
 
         /* handle empty lines */
-        if (line.size() > 0) {
-            Sample* sequence = LoadSample(line);
+        if (length > 0) {
+            Sample* sequence = LoadSample(line, length);
             sequence->index = id;
             buf->Add(sequence);
         }
@@ -133,7 +149,6 @@ void initPower2() {
 /* constructor */
 TranslateDataset::TranslateDataset()
 {
-    ifp = NULL;
     appendEmptyLine = false;
 
     initPower2();
@@ -156,14 +171,15 @@ bool isShapeFit(const int n, const int m, const int devID) {
 }
 
 /*
-load a batch of sequences from the buffer to the host for translating
->> inputs - a list of input tensors (batchEnc and paddingEnc)
-   batchEnc - a tensor to store the batch of input
-   paddingEnc - a tensor to store the batch of paddings
->> info - the total length and indices of sequences
+pick the sequences of the next batch from the buffer
+>> batch - the batch
+<< return - false if all the sequences in the buffer are used
 */
-bool TranslateDataset::GetBatchSimple(XList* inputs, XList* info)
+bool TranslateDataset::PlanBatch(BatchBuffer* batch)
 {
+    if (bufIdx >= int(buf->Size()))
+        return false;
+
     int realBatchSize = 1;
 
     /* get the maximum sequence length in a mini-batch */
@@ -188,49 +204,53 @@ bool TranslateDataset::GetBatchSimple(XList* inputs, XList* info)
 
     CheckNTErrors(maxLen != 0, "Invalid length");
 
-    int* batchValues = new int[realBatchSize * maxLen];
-    float* paddingValues = new float[realBatchSize * maxLen];
-
-    for (int i = 0; i < realBatchSize * maxLen; i++) {
-        batchValues[i] = srcVocab.padID;
-        paddingValues[i] = 1.0F;
-    }
-    
-    int* totalLength = (int*)(info->Get(0));
-    IntList* indices = (IntList*)(info->Get(1));
-    *totalLength = 0;
-    indices->Clear();
-
-    /* right padding */
-    int curSrc = 0;
+    batch->samples.resize(realBatchSize);
     for (int i = 0; i < realBatchSize; ++i) {
         Sample* sequence = (Sample*)(buf->Get(bufIdx + i));
-        IntList* src = sequence->srcSeq;
-        indices->Add(sequence->index);
-        *totalLength += src->Size();
-
-        curSrc = maxLen * i;
-        for (int i = 0; i < src->Size(); i++) {
-            batchValues[curSrc + i] = src->Get(i);
-        }
-        curSrc += src->Size();
-
-        while (curSrc < maxLen * (i + 1))
-            paddingValues[curSrc++] = 0.0F;
+        BatchSample& sample = batch->samples[i];
+        sample.src = sequence->srcSeq->items;
+        sample.srcLen = int(sequence->srcSeq->Size());
+        sample.tgt = NULL;
+        sample.tgtLen = 0;
+        sample.index = sequence->index;
     }
 
     bufIdx += realBatchSize;
 
+    return true;
+}
+
+/*
+load a batch of sequences from the buffer to the host for translating
+>> inputs - a list of input tensors (batchEnc and paddingEnc)
+   batchEnc - a tensor to store the batch of input
+   paddingEnc - a tensor to store the batch of paddings
+>> info - the total length and indices of sequences
+<< return - false if there is no more batch
+*/
+bool TranslateDataset::GetBatchSimple(XList* inputs, XList* info)
+{
+    BatchBuffer* batch = pipeline.Next();
+    if (batch == NULL)
+        return false;
+
+    int realBatchSize = int(batch->samples.size());
+    int maxLen = batch->maxSrcLen;
+
+    int* totalLength = (int*)(info->Get(0));
+    IntList* indices = (IntList*)(info->Get(1));
+    *totalLength = batch->srcWordNum;
+    indices->Clear();
+    for (int i = 0; i < realBatchSize; ++i)
+        indices->Add(batch->samples[i].index);
+
     /* store the data on the CPU */
     XTensor* batchEnc = (XTensor*)(inputs->Get(0));
     XTensor* paddingEnc = (XTensor*)(inputs->Get(1));
     InitTensor2D(batchEnc, realBatchSize, maxLen, X_INT, -1);
     InitTensor2D(paddingEnc, realBatchSize, maxLen, X_FLOAT, -1);
-    batchEnc->SetData(batchValues, batchEnc->unitNum);
-    paddingEnc->SetData(paddingValues, paddingEnc->unitNum);
-
-    delete[] batchValues;
-    delete[] paddingValues;
+    batchEnc->SetData(batch->enc.data, batchEnc->unitNum);
+    paddingEnc->SetData(batch->encPadding.data, paddingEnc->unitNum);
 
     return true;
 }
@@ -241,6 +261,20 @@ constructor
 >> notUsed - as it is
 */
 void TranslateDataset::Init(NMTConfig& myConfig, bool notUsed)
+{
+    InitVocab(myConfig);
+
+    /* translate the content in a file (or stdin if there is no file) */
+    reader.Open(config->translation.inputFN, config->common.useMMap);
+
+    LoadBatchToBuf();
+}
+
+/*
+load the source and target vocabularies
+>> myConfig - configuration of the NMT system
+*/
+void TranslateDataset::InitVocab(NMTConfig& myConfig)
 {
     config = &myConfig;
 
@@ -258,16 +292,8 @@ void TranslateDataset::Init(NMTConfig& myConfig, bool notUsed)
     tgtVocab.SetSpecialID(config->model.sos, config->model.eos,
                           config->model.pad, config->model.unk);
 
-    /* translate the content in a file */
-    if (strcmp(config->translation.inputFN, "") != 0) {
-        ifp = new ifstream(config->translation.inputFN);
-        CheckNTErrors(ifp, "Failed to open the input file");
-    }
-    /* translate the content in stdin */
-    else
-        ifp = &cin;
-
-    LoadBatchToBuf();
+    pipeline.Start(this, srcVocab.padID, srcVocab.eosID, false,
+                   config->common.prefetchThreadNum, config->common.prefetchBatchNum, false);
 }
 
 /* this is a place-holder function to avoid errors */
@@ -276,9 +302,9 @@ Sample* TranslateDataset::LoadSample()
     return nullptr;
 }
 
-/* check if the buffer is empty */
+/* check if all the batches in the buffer are used */
 bool TranslateDataset::IsEmpty() {
-    if (bufIdx < buf->Size())
+    if (bufIdx < buf->Size() || pipeline.HasPending())
         return false;
     return true;
 }
@@ -286,10 +312,7 @@ bool TranslateDataset::IsEmpty() {
 /* de-constructor */
 TranslateDataset::~TranslateDataset()
 {
-    if (ifp != NULL && strcmp(config->translation.inputFN, "") != 0) {
-        ((ifstream*)(ifp))->close();
-        delete ifp;
-    }
+    reader.Close();
 }
 
 } /* end of the nmt namespace */
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include <string>
 #include <fstream>
 #include "Vocab.h"
+#include "LineReader.h"
 #include "../DataSet.h"
 
 using namespace std;
@@ -50,25 +51,34 @@ public:
     /* the target vocabulary */
     Vocab tgtVocab;
 
-    /* the input file stream */
-    istream* ifp;
+    /* the reader of the input */
+    LineReader reader;
 
 public:
-    /* check if the buffer is empty */
+    /* check if all the batches in the buffer are used */
     bool IsEmpty();
 
     /* initialization function */
     void Init(NMTConfig& myConfig, bool notUsed) override;
 
+    /* load the vocabularies (without opening the input) */
+    void InitVocab(NMTConfig& myConfig);
+
     /* load a sample from the buffer */
     Sample* LoadSample() override;
 
     /* transfrom a line to a sequence */
     Sample* LoadSample(const string& line);
 
+    /* transfrom a line (without copying it) to a sequence */
+    Sample* LoadSample(const char* line, int length);
+
     /* load the samples into tensors from the buffer */
     bool GetBatchSimple(XList* inputs, XList* info) override;
 
+    /* pick the sequences of the next batch */
+    bool PlanBatch(BatchBuffer* batch) override;
+
     /* load the samples into the buffer (a list) */
     bool LoadBatchToBuf() override;
 
@@ -0,0 +1,359 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "TranslationCache.h"
+#include "../../niutensor/tensor/XGlobal.h"
+#include "../../niutensor/tensor/XModelFile.h"
+
+/* the nmt namespace */
+namespace nmt
+{
+
+/* the header of a cache file */
+struct TranslationCacheHeader
+{
+    /* the magic number, i.e., TRANSLATION_CACHE_MAGIC */
+    char magic[8];
+
+    /* version of the format */
+    int version;
+
+    /* reserved */
+    int reserved;
+
+    /* the hash of the options that the translations are made with */
+    MTYPE optionKey;
+
+    /* number of translations */
+    MTYPE entryNum;
+};
+
+/*
+the FNV-1a hash of a piece of data
+>> data - the data
+>> size - size of the data (in bytes)
+>> seed - the hash to begin with
+*/
+static MTYPE HashBytes(const void* data, size_t size, MTYPE seed)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    MTYPE h = seed;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/*
+hash the identity of a file, i.e., its name, size and modification time.
+For a model file of the container format (see XModelFile), the checksums
+of the meta data and the index are used as well. The index keeps the
+checksums of all tensors, so a retrained model gets another key even if
+it is written at the same time with the same size.
+>> fn - name of the file (nothing is hashed if it is empty)
+>> seed - the hash to begin with
+*/
+static MTYPE HashFile(const char* fn, MTYPE seed)
+{
+    MTYPE h = HashBytes(fn, strlen(fn), seed);
+
+    if (strlen(fn) == 0)
+        return h;
+
+    struct stat st;
+    if (stat(fn, &st) == 0) {
+        MTYPE size = (MTYPE)st.st_size;
+        MTYPE mtime = (MTYPE)st.st_mtime;
+        h = HashBytes(&size, sizeof(size), h);
+        h = HashBytes(&mtime, sizeof(mtime), h);
+    }
+
+    if (XModelFile::IsModelFile(fn)) {
+        XModelFile model;
+        model.Open(fn, false);
+        h = HashBytes(&model.header.metaChecksum, sizeof(model.header.metaChecksum), h);
+        h = HashBytes(&model.header.indexChecksum, sizeof(model.header.indexChecksum), h);
+        h = HashBytes(&model.header.dataSize, sizeof(model.header.dataSize), h);
+    }
+
+    return h;
+}
+
+/* constructor */
+TranslationCache::TranslationCache()
+{
+    hitNum = 0;
+    missNum = 0;
+    capacity = 0;
+    optionKey = 0;
+}
+
+/* de-constructor */
+TranslationCache::~TranslationCache()
+{
+}
+
+/*
+initialize the cache. The translations in the cache file are loaded if
+there is one.
+>> config - the configuration of the NMT system
+*/
+void TranslationCache::Init(NMTConfig& config)
+{
+    capacity = config.translation.cacheSize;
+    fn = config.translation.cacheFN;
+
+    /* the files and the options that change the translation of a sentence.
+       The files are identified by their contents (as far as we can tell
+       cheaply) rather than their names, so that the cache file is not used
+       with a model or vocabulary that is replaced at the same path. */
+    TranslationConfig& t = config.translation;
+    MTYPE h = 14695981039346656037ULL;
+    h = HashFile(config.common.modelFN, h);
+    h = HashFile(config.common.srcVocabFN, h);
+    h = HashFile(config.common.tgtVocabFN, h);
+    h = HashFile(t.shortlistFN, h);
+    h = HashBytes(&t.beamSize, sizeof(t.beamSize), h);
+    h = HashBytes(&t.lenAlpha, sizeof(t.lenAlpha), h);
+    h = HashBytes(&t.maxLenAlpha, sizeof(t.maxLenAlpha), h);
+    h = HashBytes(&t.maxLen, sizeof(t.maxLen), h);
+    h = HashBytes(&t.shortlistTopN, sizeof(t.shortlistTopN), h);
+    h = HashBytes(&t.shortlistTransN, sizeof(t.shortlistTransN), h);
+    h = HashBytes(&config.common.useFP16, sizeof(config.common.useFP16), h);
+    h = HashBytes(&config.common.useINT8, sizeof(config.common.useINT8), h);
+    optionKey = h;
+
+    if (fn.size() > 0)
+        Load(fn.c_str());
+
+    LOG("translating with a cache of %d sentences", capacity);
+}
+
+/*
+look up the translation of a source sequence. A translation that is found
+becomes the most recently used one.
+>> src - the source ids
+>> tgt - the target ids (for return)
+<< return - whether the translation is found
+*/
+bool TranslationCache::Lookup(const IntList* src, IntList* tgt)
+{
+    MTYPE key = Hash(src->items, src->count, optionKey);
+
+    lock_guard<mutex> lock(cacheMutex);
+
+    auto entry = Find(key, src->items, src->count);
+    if (entry == entries.end()) {
+        missNum++;
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, entry);
+
+    tgt->Clear();
+    for (size_t i = 0; i < entry->tgt.size(); i++)
+        tgt->Add(entry->tgt[i]);
+
+    hitNum++;
+    return true;
+}
+
+/*
+add the translation of a source sequence. The least recently used
+translation is dropped if the cache is full.
+>> src - the source ids
+>> tgt - the target ids
+*/
+void TranslationCache::Add(const IntList* src, const IntList* tgt)
+{
+    if (capacity <= 0)
+        return;
+
+    MTYPE key = Hash(src->items, src->count, optionKey);
+
+    lock_guard<mutex> lock(cacheMutex);
+
+    auto entry = Find(key, src->items, src->count);
+    if (entry != entries.end()) {
+        entries.splice(entries.begin(), entries, entry);
+        return;
+    }
+
+    AddEntry(key, src->items, src->count, tgt->items, tgt->count);
+}
+
+/*
+find the translation of a source sequence
+>> key - the key of the sequence
+>> src - the source ids
+>> srcLen - number of the source ids
+<< return - the translation (entries.end() if it is not found)
+*/
+list<TranslationCacheEntry>::iterator TranslationCache::Find(MTYPE key, const int* src, int srcLen)
+{
+    auto range = table.equal_range(key);
+    for (auto i = range.first; i != range.second; i++) {
+        const vector<int>& s = i->second->src;
+        if ((int)s.size() == srcLen && (srcLen == 0 || memcmp(s.data(), src, sizeof(int) * srcLen) == 0))
+            return i->second;
+    }
+    return entries.end();
+}
+
+/*
+add a translation as the most recently used one (the cache is locked)
+>> key - the key of the source sequence
+>> src - the source ids
+>> srcLen - number of the source ids
+>> tgt - the target ids
+>> tgtLen - number of the target ids
+*/
+void TranslationCache::AddEntry(MTYPE key, const int* src, int srcLen, const int* tgt, int tgtLen)
+{
+    TranslationCacheEntry entry;
+    entry.key = key;
+    entry.src.assign(src, src + srcLen);
+    entry.tgt.assign(tgt, tgt + tgtLen);
+
+    entries.push_front(entry);
+    table.insert(make_pair(key, entries.begin()));
+
+    /* drop the least recently used translations */
+    while ((int)entries.size() > capacity) {
+        auto last = prev(entries.end());
+        auto range = table.equal_range(last->key);
+        for (auto i = range.first; i != range.second; i++) {
+            if (i->second == last) {
+                table.erase(i);
+                break;
+            }
+        }
+        entries.pop_back();
+    }
+}
+
+/*
+load the cache from a file. The file is ignored if it does not exist or
+its translations are made with other options.
+>> myFN - name of the file
+*/
+void TranslationCache::Load(const char* myFN)
+{
+    FILE* file = fopen(myFN, "rb");
+    if (file == NULL)
+        return;
+
+    TranslationCacheHeader header;
+    CheckNTErrors(fread(&header, sizeof(header), 1, file) == 1 &&
+                  memcmp(header.magic, TRANSLATION_CACHE_MAGIC, sizeof(header.magic)) == 0,
+                  "Invalid translation cache file!");
+    CheckNTErrors(header.version <= TRANSLATION_CACHE_VERSION, "The translation cache file is of a newer version!");
+
+    if (header.optionKey != optionKey) {
+        LOG("the translation cache file is made with other options or files, and it is not used");
+        fclose(file);
+        return;
+    }
+
+    lock_guard<mutex> lock(cacheMutex);
+
+    /* the translations are kept from the least recently used one */
+    vector<int> src;
+    vector<int> tgt;
+    for (MTYPE i = 0; i < header.entryNum; i++) {
+        int len[2];
+        CheckNTErrors(fread(len, sizeof(int), 2, file) == 2 && len[0] >= 0 && len[1] >= 0,
+                      "Incomplete translation cache file!");
+        src.resize(len[0]);
+        tgt.resize(len[1]);
+        CheckNTErrors(fread(src.data(), sizeof(int), len[0], file) == (size_t)len[0] &&
+                      fread(tgt.data(), sizeof(int), len[1], file) == (size_t)len[1],
+                      "Incomplete translation cache file!");
+
+        MTYPE key = Hash(src.data(), len[0], optionKey);
+        if (Find(key, src.data(), len[0]) == entries.end())
+            AddEntry(key, src.data(), len[0], tgt.data(), len[1]);
+    }
+
+    fclose(file);
+
+    LOG("loaded %d translations from the cache file %s", (int)entries.size(), myFN);
+}
+
+/*
+save the cache to a file
+>> myFN - name of the file
+*/
+void TranslationCache::Save(const char* myFN)
+{
+    FILE* file = fopen(myFN, "wb");
+    CheckNTErrors(file, "Cannot open the translation cache file!");
+
+    lock_guard<mutex> lock(cacheMutex);
+
+    TranslationCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRANSLATION_CACHE_MAGIC, sizeof(header.magic));
+    header.version = TRANSLATION_CACHE_VERSION;
+    header.optionKey = optionKey;
+    header.entryNum = entries.size();
+    fwrite(&header, sizeof(header), 1, file);
+
+    for (auto entry = entries.rbegin(); entry != entries.rend(); entry++) {
+        int len[2] = { (int)entry->src.size(), (int)entry->tgt.size() };
+        fwrite(len, sizeof(int), 2, file);
+        fwrite(entry->src.data(), sizeof(int), len[0], file);
+        fwrite(entry->tgt.data(), sizeof(int), len[1], file);
+    }
+
+    CheckNTErrors(fclose(file) == 0, "Failed to write the translation cache file!");
+}
+
+/* save the cache to its file (if there is one) */
+void TranslationCache::Save()
+{
+    if (fn.size() > 0)
+        Save(fn.c_str());
+}
+
+/* show the statistics */
+void TranslationCache::ShowStats()
+{
+    MTYPE total = hitNum + missNum;
+    LOG("translation cache: %d sentences, %llu hits, %llu misses (hit rate %.1f%%)",
+        (int)entries.size(), hitNum, missNum, total > 0 ? 100.0F * hitNum / total : 0.0F);
+}
+
+/*
+get the hash of a sequence of ids
+>> ids - the ids
+>> num - number of the ids
+>> seed - the hash to begin with
+*/
+MTYPE TranslationCache::Hash(const int* ids, int num, MTYPE seed)
+{
+    return HashBytes(ids, sizeof(int) * num, seed);
+}
+
+} /* end of the nmt namespace */
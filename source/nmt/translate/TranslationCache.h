@@ -0,0 +1,133 @@
+/* NiuTrans.NMT - an open-source neural machine translation system.
+ * Copyright (C) 2020 NiuTrans Research. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The translation cache keeps the translations of recent source sentences,
+ * so that a sentence that comes again (e.g., boilerplate and UI strings) is
+ * not translated again. The key of a sentence is the hash of its source ids
+ * seeded by the options that change the translation (the model, the
+ * vocabularies and the search settings). The least recently used
+ * translation is dropped when the cache is full, and the cache can be kept
+ * in a file across runs.
+ *
+ * $Created by: NiuTrans Team 2026-10-16
+ */
+
+#ifndef __TRANSLATIONCACHE_H__
+#define __TRANSLATIONCACHE_H__
+
+#include <list>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include "../Config.h"
+#include "../../niutensor/tensor/XMem.h"
+#include "../../niutensor/tensor/XList.h"
+
+using namespace std;
+using namespace nts;
+
+/* the nmt namespace */
+namespace nmt
+{
+
+#define TRANSLATION_CACHE_MAGIC "NIUTCACH"
+#define TRANSLATION_CACHE_VERSION 1
+
+/* a translation in the cache */
+struct TranslationCacheEntry
+{
+    /* the key (hash of the source ids and the options) */
+    MTYPE key;
+
+    /* the source ids */
+    vector<int> src;
+
+    /* the target ids */
+    vector<int> tgt;
+};
+
+/* the translation cache (least recently used first out) */
+class TranslationCache
+{
+public:
+    /* number of lookups that found the translation */
+    MTYPE hitNum;
+
+    /* number of lookups that did not find the translation */
+    MTYPE missNum;
+
+private:
+    /* the maximum number of translations */
+    int capacity;
+
+    /* the hash of the options that change the translation */
+    MTYPE optionKey;
+
+    /* the file that keeps the cache (empty for no file) */
+    string fn;
+
+    /* the translations (the most recently used first) */
+    list<TranslationCacheEntry> entries;
+
+    /* the translations of each key */
+    unordered_multimap<MTYPE, list<TranslationCacheEntry>::iterator> table;
+
+    /* a lock of the cache */
+    mutex cacheMutex;
+
+public:
+    /* constructor */
+    TranslationCache();
+
+    /* de-constructor */
+    ~TranslationCache();
+
+    /* initialize the cache */
+    void Init(NMTConfig& config);
+
+    /* look up the translation of a source sequence */
+    bool Lookup(const IntList* src, IntList* tgt);
+
+    /* add the translation of a source sequence */
+    void Add(const IntList* src, const IntList* tgt);
+
+    /* load the cache from a file */
+    void Load(const char* myFN);
+
+    /* save the cache to a file */
+    void Save(const char* myFN);
+
+    /* save the cache to its file (if there is one) */
+    void Save();
+
+    /* show the statistics */
+    void ShowStats();
+
+    /* get the hash of a sequence of ids */
+    static MTYPE Hash(const int* ids, int num, MTYPE seed);
+
+private:
+    /* find the translation of a source sequence */
+    list<TranslationCacheEntry>::iterator Find(MTYPE key, const int* src, int srcLen);
+
+    /* add a translation (the cache is locked) */
+    void AddEntry(MTYPE key, const int* src, int srcLen, const int* tgt, int tgtLen);
+};
+
+} /* end of the nmt namespace */
+
+#endif /* __TRANSLATIONCACHE_H__ */
@@ -20,12 +20,15 @@
  * $Modified by: HU Chi (huchinlp@gmail.com) 2020-04, 2020-06
  */
 
+#include <thread>
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
 #include "Searcher.h"
 #include "Translator.h"
 #include "../../niutensor/tensor/XTensor.h"
 #include "../../niutensor/tensor/XUtility.h"
+#include "../../niutensor/tensor/XArena.h"
 #include "../../niutensor/tensor/core/CHeader.h"
 
 using namespace nts;
@@ -39,18 +42,28 @@ Translator::Translator()
 {
     config = NULL;
     model = NULL;
-    seacher = NULL;
+    shortlist = NULL;
+    workers = NULL;
+    workerNum = 0;
+    continuous = false;
+    sentCount = 0;
+    cache = NULL;
     outputBuf = new XList;
 }
 
 /* de-constructor */
 Translator::~Translator()
 {
-    if (config->translation.beamSize > 1)
-        delete (BeamSearch*)seacher;
-    else
-        delete (GreedySearch*)seacher;
+    for (int i = 0; i < workerNum; i++) {
+        if (config->translation.beamSize > 1)
+            delete (BeamSearch*)workers[i].searcher;
+        else
+            delete (GreedySearch*)workers[i].searcher;
+    }
+    delete[] workers;
     delete outputBuf;
+    delete shortlist;
+    delete cache;
 }
 
 /* initialize the model */
@@ -63,18 +76,71 @@ void Translator::Init(NMTConfig& myConfig, NMTModel& myModel)
         LOG("Translating with beam search (beam=%d, batchSize= %d sents | %d tokens, lenAlpha=%.2f, maxLenAlpha=%.2f) ", 
             config->translation.beamSize, config->common.sBatchSize, config->common.wBatchSize,
             config->translation.lenAlpha, config->translation.maxLenAlpha);
-        seacher = new BeamSearch();
-        ((BeamSearch*)seacher)->Init(myConfig);
     }
     else if (config->translation.beamSize == 1) {
         LOG("translating with greedy search (batchSize= %d sents | %d tokens, maxLenAlpha=%.2f)", 
             config->common.sBatchSize, config->common.wBatchSize, config->translation.maxLenAlpha);
-        seacher = new GreedySearch();
-        ((GreedySearch*)seacher)->Init(myConfig);
     }
     else {
         CheckNTErrors(false, "Invalid beam size\n");
     }
+
+    /* the workers translate different batches on CPUs */
+    workerNum = MAX(config->translation.workerNum, 1);
+    if (config->common.devID >= 0 && workerNum > 1) {
+        LOG("only one worker is used on GPUs");
+        workerNum = 1;
+    }
+    if (workerNum > 1)
+        LOG("translating with %d workers", workerNum);
+
+    /* continuous batching needs the decoder caches that are kept in the buffers */
+    continuous = config->translation.continuousBatching;
+    if (continuous && (config->translation.beamSize == 1 || config->common.devID >= 0 ||
+                       config->common.useFP16 || config->model.maxRelativeLength > 0)) {
+        LOG("continuous batching is only for beam search on CPUs (with no fp16 or relative positions)");
+        continuous = false;
+    }
+    if (continuous)
+        LOG("translating with continuous batching (%d sentences in the batch)", config->common.sBatchSize);
+
+    /* the shortlist of the output vocabulary */
+    if (strcmp(config->translation.shortlistFN, "") != 0) {
+        shortlist = new Shortlist();
+        shortlist->Load(myConfig);
+    }
+
+    /* the cache of recent translations */
+    if (config->translation.cacheSize > 0) {
+        cache = new TranslationCache();
+        cache->Init(myConfig);
+    }
+
+    workers = new TranslationWorker[workerNum];
+    for (int i = 0; i < workerNum; i++) {
+        TranslationWorker& worker = workers[i];
+
+        if (config->translation.beamSize > 1) {
+            BeamSearch* searcher = new BeamSearch();
+            searcher->Init(myConfig);
+            searcher->shortlist = shortlist;
+            worker.searcher = searcher;
+        }
+        else {
+            GreedySearch* searcher = new GreedySearch();
+            searcher->Init(myConfig);
+            searcher->shortlist = shortlist;
+            worker.searcher = searcher;
+        }
+
+        /* the tensors of a batch are kept in a memory pool of the worker on CPUs
+           (the pool is owned by GMems as the model may keep some tensors in it).
+           The buffer of the shared pool has no lock, so each worker has a pool
+           if there are more than one. */
+        worker.arena = NULL;
+        if (config->common.devID < 0 && (config->translation.useArena || workerNum > 1))
+            worker.arena = GMems.NewThreadMem(ARENA_CHUNK_SIZE);
+    }
 }
 
 /* reorder the outputs by the indices */
@@ -89,12 +155,14 @@ void Translator::ReorderOutputs()
 
 /* 
 translate a batch of sequences 
+>> worker - the worker
 >> batchEnc - the batch of inputs
 >> paddingEnc - the paddings of inputs
 >> indices - indices of input sequences
 the results will be saved in the output buffer
 */
-void Translator::TranslateBatch(XTensor& batchEnc, XTensor& paddingEnc, IntList& indices)
+void Translator::TranslateBatch(TranslationWorker& worker, XTensor& batchEnc, 
+                                XTensor& paddingEnc, IntList& indices)
 {
     int batchSize = batchEnc.GetDim(0);
 
@@ -102,37 +170,276 @@ void Translator::TranslateBatch(XTensor& batchEnc, XTensor& paddingEnc, IntList&
     for (int i = 0; i < batchSize; i++)
         outputs[i] = new IntList();
 
+    TranslateBatch(worker, batchEnc, paddingEnc, outputs);
+
+    /* save the outputs to the buffer */
+    lock_guard<mutex> lock(outputMutex);
+
+    for (int i = 0; i < batchSize; i++) {
+        Sample* sample = new Sample(NULL, outputs[i]);
+        sample->index = indices[i];
+        outputBuf->Add(sample);
+    }
+
+    sentCount += batchSize;
+    if (batchLoader.appendEmptyLine)
+        fprintf(stderr, "%d/%d\n", sentCount - 1, batchLoader.buf->Size() - 1);
+    else
+        fprintf(stderr, "%d/%d\n", sentCount, batchLoader.buf->Size());
+
+    delete[] outputs;
+}
+
+/*
+translate a batch of sequences and keep the results in a list of sequences
+(with the first worker)
+>> batchEnc - the batch of inputs
+>> paddingEnc - the paddings of inputs
+>> outputs - the (empty) lists to keep the translation of each input
+*/
+void Translator::TranslateBatch(XTensor& batchEnc, XTensor& paddingEnc, IntList** outputs)
+{
+    TranslateBatch(workers[0], batchEnc, paddingEnc, outputs);
+}
+
+/* get the translation cache (NULL for no cache) */
+TranslationCache* Translator::GetCache()
+{
+    return cache;
+}
+
+/* show the statistics of the translation cache and save it to its file */
+void Translator::CloseCache()
+{
+    if (cache == NULL)
+        return;
+
+    cache->ShowStats();
+    cache->Save();
+}
+
+/*
+take the sentences that need no translation out of the buffer, i.e., the
+sentences in the cache (their translations go to the output buffer at once)
+and the repeats of the sentences earlier in the buffer (they take the
+translations of their first occurrences in UpdateCache)
+*/
+void Translator::LookUpCache()
+{
+    XList* buf = batchLoader.buf;
+    XList kept;
+
+    /* the sentences to translate by the hash of their source ids */
+    unordered_multimap<MTYPE, Sample*> seen;
+
+    for (int i = 0; i < buf->Size(); i++) {
+        Sample* sample = (Sample*)buf->Get(i);
+        IntList* src = sample->srcSeq;
+        MTYPE key = TranslationCache::Hash(src->items, src->count, 0);
+
+        Sample* first = NULL;
+        auto range = seen.equal_range(key);
+        for (auto s = range.first; s != range.second && first == NULL; s++) {
+            IntList* firstSrc = s->second->srcSeq;
+            if (firstSrc->count == src->count &&
+                memcmp(firstSrc->items, src->items, sizeof(int) * src->count) == 0)
+                first = s->second;
+        }
+
+        if (first != NULL) {
+            repeats.push_back(sample);
+            firsts.push_back(first->index);
+            continue;
+        }
+
+        IntList* output = new IntList();
+        if (cache->Lookup(src, output)) {
+            Sample* result = new Sample(NULL, output);
+            result->index = sample->index;
+            outputBuf->Add(result);
+            delete sample;
+            continue;
+        }
+        delete output;
+
+        seen.insert(make_pair(key, sample));
+        kept.Add(sample);
+    }
+
+    buf->Clear();
+    for (int i = 0; i < kept.Size(); i++)
+        buf->Add(kept.GetItem(i));
+
+    LOG("%d sentences to translate (%d in the cache, %d repeated)", kept.Size(),
+        (int)cache->hitNum, (int)repeats.size());
+}
+
+/*
+add the new translations to the cache, and give the repeated sentences the
+translations of their first occurrences
+*/
+void Translator::UpdateCache()
+{
+    /* the translations by the indices of the sentences */
+    int num = 0;
+    for (int i = 0; i < outputBuf->Size(); i++)
+        num = MAX(num, ((Sample*)outputBuf->GetItem(i))->index + 1);
+
+    vector<IntList*> outputs(num, NULL);
+    for (int i = 0; i < outputBuf->Size(); i++) {
+        Sample* sample = (Sample*)outputBuf->GetItem(i);
+        outputs[sample->index] = sample->tgtSeq;
+    }
+
+    XList* buf = batchLoader.buf;
+    for (int i = 0; i < buf->Size(); i++) {
+        Sample* sample = (Sample*)buf->Get(i);
+        cache->Add(sample->srcSeq, outputs[sample->index]);
+    }
+
+    /* a repeat is a hit of the cache now (unless the cache is too small to keep it) */
+    for (size_t i = 0; i < repeats.size(); i++) {
+        IntList* output = new IntList();
+        if (!cache->Lookup(repeats[i]->srcSeq, output)) {
+            IntList* firstOutput = outputs[firsts[i]];
+            for (int j = 0; j < firstOutput->Size(); j++)
+                output->Add(firstOutput->Get(j));
+        }
+
+        Sample* result = new Sample(NULL, output);
+        result->index = repeats[i]->index;
+        outputBuf->Add(result);
+        delete repeats[i];
+    }
+
+    repeats.clear();
+    firsts.clear();
+}
+
+/*
+translate a batch of sequences and keep the results in a list of sequences
+>> worker - the worker
+>> batchEnc - the batch of inputs
+>> paddingEnc - the paddings of inputs
+>> outputs - the (empty) lists to keep the translation of each input
+*/
+void Translator::TranslateBatch(TranslationWorker& worker, XTensor& batchEnc, 
+                                XTensor& paddingEnc, IntList** outputs)
+{
+    XMem* arena = worker.arena;
+    InferenceContext* context = NULL;
+
+    /* the temporary tensors go to the pool of the worker, and they are
+       freed at once when the batch is done */
+    if (arena != NULL)
+        GMems.SetThreadMem(arena);
+
     /* greedy search */
     if (config->translation.beamSize == 1) {
-        ((GreedySearch*)seacher)->Search(model, batchEnc, paddingEnc, outputs);
+        GreedySearch* searcher = (GreedySearch*)worker.searcher;
+        searcher->Search(model, batchEnc, paddingEnc, outputs);
+        context = &searcher->context;
     }
 
     /* beam search */
     if (config->translation.beamSize > 1) {
         XTensor score;
-        ((BeamSearch*)seacher)->Search(model, batchEnc, paddingEnc, outputs, score);
+        BeamSearch* searcher = (BeamSearch*)worker.searcher;
+        searcher->Search(model, batchEnc, paddingEnc, outputs, score);
+        context = &searcher->context;
     }
 
-    /* reset the cache in decoder layers */
-    for (int i = 0; i < model->decoder->nlayer; ++i) {
-        model->decoder->selfAttCache[i].miss = true;
-        model->decoder->enDeAttCache[i].miss = true;
+    /* reset the decoder caches */
+    context->Reset(arena != NULL);
+
+    if (arena != NULL) {
+        arena->Clear();
+        GMems.SetThreadMem(NULL);
     }
+}
 
-    /* save the outputs to the buffer */
-    for (int i = 0; i < batchSize; i++) {
-        Sample* sample = new Sample(NULL, outputs[i]);
-        sample->index = indices[i];
-        outputBuf->Add(sample);
+/*
+translate all the sentences with continuous batching, i.e., the worker takes
+new sentences as soon as some in its batch are done
+>> worker - the worker
+*/
+void Translator::TranslateContinuous(TranslationWorker& worker)
+{
+    XMem* arena = worker.arena;
+    BeamSearch* searcher = (BeamSearch*)worker.searcher;
+
+    /* the pieces of the pool are reused by the size class as the batch changes */
+    if (arena != NULL)
+        GMems.SetThreadMem(arena);
+
+    searcher->SearchContinuous(model, this);
+
+    /* reset the decoder caches */
+    searcher->context.Reset(arena != NULL);
+
+    if (arena != NULL) {
+        arena->Clear();
+        GMems.SetThreadMem(NULL);
     }
+}
 
-    delete[] outputs;
+/*
+get the next batch of sentences from the batch loader (for continuous batching)
+>> input - the batch of inputs
+>> padding - the paddings of inputs
+>> indices - indices of input sequences
+<< return - false if there is no more batch
+*/
+bool Translator::Next(XTensor& input, XTensor& padding, IntList& indices)
+{
+    XList info;
+    XList inputs;
+    int wordCount;
+    inputs.Add(&input);
+    inputs.Add(&padding);
+    info.Add(&wordCount);
+    info.Add(&indices);
+
+    lock_guard<mutex> lock(batchMutex);
+    return batchLoader.GetBatchSimple(&inputs, &info);
 }
 
-/* the translation function */
-bool Translator::Translate()
+/*
+save the translation of a sentence to the output buffer (for continuous batching)
+>> index - index of the sentence
+>> output - the translation
+*/
+void Translator::Save(int index, IntList* output)
 {
-    batchLoader.Init(*config, false);
+    lock_guard<mutex> lock(outputMutex);
+
+    Sample* sample = new Sample(NULL, output);
+    sample->index = index;
+    outputBuf->Add(sample);
+
+    int total = batchLoader.buf->Size();
+    sentCount++;
+    if (sentCount % MAX(config->common.sBatchSize, 1) == 0 || sentCount == total) {
+        if (batchLoader.appendEmptyLine)
+            fprintf(stderr, "%d/%d\n", sentCount - 1, total - 1);
+        else
+            fprintf(stderr, "%d/%d\n", sentCount, total);
+    }
+}
+
+/*
+the loop of a worker. It takes the next batch from the batch loader until
+there is no more batch.
+>> id - id of the worker
+*/
+void Translator::WorkerLoop(int id)
+{
+    TranslationWorker& worker = workers[id];
+
+    if (continuous) {
+        TranslateContinuous(worker);
+        return;
+    }
 
     /* inputs */
     XTensor batchEnc;
@@ -148,14 +455,36 @@ bool Translator::Translate()
     info.Add(&wordCount);
     info.Add(&indices);
 
-    /* the loop of translation process */
-    while (!batchLoader.IsEmpty()) {
-        batchLoader.GetBatchSimple(&inputs, &info);
-        TranslateBatch(batchEnc, paddingEnc, indices);
-        if (batchLoader.appendEmptyLine)
-            fprintf(stderr, "%d/%d\n", batchLoader.bufIdx - 1, batchLoader.buf->Size() - 1);
-        else
-            fprintf(stderr, "%d/%d\n", batchLoader.bufIdx, batchLoader.buf->Size());                                                                                       
+    while (true) {
+        {
+            lock_guard<mutex> lock(batchMutex);
+            if (!batchLoader.GetBatchSimple(&inputs, &info))
+                break;
+        }
+        TranslateBatch(worker, batchEnc, paddingEnc, indices);
+    }
+}
+
+/* the translation function */
+bool Translator::Translate()
+{
+    batchLoader.Init(*config, false);
+
+    /* the sentences in the cache (or repeated in the input) are not translated */
+    if (cache != NULL)
+        LookUpCache();
+
+    /* the loop of translation process (the next batches are prepared in the background) */
+    sentCount = 0;
+    if (workerNum == 1) {
+        WorkerLoop(0);
+    }
+    else {
+        vector<thread> threads;
+        for (int i = 0; i < workerNum; i++)
+            threads.push_back(thread(&Translator::WorkerLoop, this, i));
+        for (int i = 0; i < workerNum; i++)
+            threads[i].join();
     }
 
     /* handle empty lines */
@@ -165,6 +494,27 @@ bool Translator::Translate()
         outputBuf->Add(sample);
     }
 
+    if (cache != NULL) {
+        UpdateCache();
+        CloseCache();
+    }
+
+    if (workers[0].arena != NULL) {
+        MTYPE reserved = 0;
+        MTYPE peak = 0;
+        MTYPE allocNum = 0;
+        MTYPE resetNum = 0;
+        for (int i = 0; i < workerNum; i++) {
+            XArena* a = workers[i].arena->arena;
+            reserved += a->reservedSize;
+            peak += a->peakSize;
+            allocNum += a->allocNum;
+            resetNum += a->resetNum;
+        }
+        LOG("arena: %.1fMB reserved, %.1fMB at peak, %llu allocations, %llu resets",
+            (float)reserved / MILLION, (float)peak / MILLION, allocNum, resetNum);
+    }
+
     /* reorder the outputs by their original indices */
     ReorderOutputs();
 
@@ -193,8 +543,10 @@ void Translator::DumpResToFile(const char* ofn)
         Sample* sample = (Sample*)outputBuf->Get(i);
         if (sample->tgtSeq != NULL) {
             for (int j = 0; j < sample->tgtSeq->Size(); j++) {
-                int id = sample->tgtSeq->Get(j);
-                f << batchLoader.tgtVocab.id2token.at(id) << " ";
+                int length;
+                const char* token = batchLoader.tgtVocab.GetToken(sample->tgtSeq->Get(j), length);
+                f.write(token, length);
+                f << " ";
             }
         }
         f << "\n";
@@ -210,8 +562,10 @@ void Translator::DumpResToStdout()
         Sample* sample = (Sample*)outputBuf->Get(i);
         if (sample->tgtSeq != NULL) {
             for (int j = 0; j < sample->tgtSeq->Size(); j++) {
-                int id = sample->tgtSeq->Get(j);
-                cout << batchLoader.tgtVocab.id2token.at(id) <<  " ";
+                int length;
+                const char* token = batchLoader.tgtVocab.GetToken(sample->tgtSeq->Get(j), length);
+                cout.write(token, length);
+                cout << " ";
             }
         }
         cout << "\n";
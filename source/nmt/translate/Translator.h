@@ -23,19 +23,47 @@ It will dump the result to the output file if specified, else the standard outpu
 #ifndef __TRANSLATOR_H__
 #define __TRANSLATOR_H__
 
+#include <mutex>
 #include "../Model.h"
 #include "Searcher.h"
 #include "TranslateDataSet.h"
+#include "TranslationCache.h"
 
 /* the nmt namespace */
 namespace nmt
 {
 
-class Translator
+/* a translation worker. The workers share the (read-only) model, and each
+   of them keeps a searcher with the inference state and a memory pool. */
+struct TranslationWorker
+{
+    /* the searcher for translation */
+    void* searcher;
+
+    /* the size-class memory pool for the tensors of a batch (NULL for the shared pool) */
+    XMem* arena;
+};
+
+class Translator : public SentenceQueue
 {
 private:
     /* translate a batch of sequences */
-    void TranslateBatch(XTensor& batchEnc, XTensor& paddingEnc, IntList& indices);
+    void TranslateBatch(TranslationWorker& worker, XTensor& batchEnc, XTensor& paddingEnc, IntList& indices);
+
+    /* translate a batch of sequences and keep the results in a list of sequences */
+    void TranslateBatch(TranslationWorker& worker, XTensor& batchEnc, XTensor& paddingEnc, IntList** outputs);
+
+    /* translate all the sentences with continuous batching */
+    void TranslateContinuous(TranslationWorker& worker);
+
+    /* the loop of a worker */
+    void WorkerLoop(int id);
+
+    /* take the sentences that need no translation out of the buffer */
+    void LookUpCache();
+
+    /* add the new translations to the cache */
+    void UpdateCache();
 
 private:
     /* the translation model */
@@ -50,10 +78,35 @@ private:
     /* output buffer */
     XList* outputBuf;
 
-public:
-    /* the searcher for translation */
-    void* seacher;
+    /* the vocabulary shortlist (NULL for the whole vocabulary) */
+    Shortlist* shortlist;
+
+    /* the workers */
+    TranslationWorker* workers;
 
+    /* number of workers */
+    int workerNum;
+
+    /* indicates whether the sentences are translated with continuous batching */
+    bool continuous;
+
+    /* number of translated sentences */
+    int sentCount;
+
+    /* the lock of the batch loader */
+    mutex batchMutex;
+
+    /* the lock of the output buffer */
+    mutex outputMutex;
+
+    /* the translation cache (NULL for no cache) */
+    TranslationCache* cache;
+
+    /* the sentences that occur earlier in the buffer, and the indices of their first occurrences */
+    vector<Sample*> repeats;
+    vector<int> firsts;
+
+public:
     /* constructor */
     Translator();
 
@@ -66,6 +119,21 @@ public:
     /* the translation function */
     bool Translate();
 
+    /* translate a batch of sequences and keep the results in a list of sequences */
+    void TranslateBatch(XTensor& batchEnc, XTensor& paddingEnc, IntList** outputs);
+
+    /* get the translation cache (NULL for no cache) */
+    TranslationCache* GetCache();
+
+    /* show the statistics of the translation cache and save it to its file */
+    void CloseCache();
+
+    /* get the next batch of sentences (for continuous batching) */
+    bool Next(XTensor& input, XTensor& padding, IntList& indices);
+
+    /* save the translation of a sentence (for continuous batching) */
+    void Save(int index, IntList* output);
+
     /* reorder the outputs by the indices */
     void ReorderOutputs();
 
@@ -20,6 +20,7 @@
  */
 
 #include <fstream>
+#include <string.h>
 #include "Vocab.h"
 #include "../Config.h"
 
@@ -35,8 +36,34 @@ void Vocab::SetSpecialID(int sos, int eos, int pad, int unk)
     unkID = unk;
 }
 
-/* load a vocabulary from a file */
+/* 
+load a vocabulary from a file. The format is known by the magic number
+at the beginning of the file.
+>> vocabFN - name of the file
+*/
 void Vocab::Load(const string& vocabFN)
+{
+    FILE* file = fopen(vocabFN.c_str(), "rb");
+    CheckNTErrors(file, "Failed to open the vocabulary file");
+
+    char magic[8];
+    if (fread(magic, sizeof(magic), 1, file) == 1 &&
+        memcmp(magic, VOCAB_FILE_MAGIC, sizeof(magic)) == 0) {
+        fseek(file, 0, SEEK_SET);
+        LoadBinary(file);
+        fclose(file);
+        return;
+    }
+
+    fclose(file);
+    LoadText(vocabFN);
+}
+
+/* 
+load a vocabulary in the text format
+>> vocabFN - name of the file
+*/
+void Vocab::LoadText(const string& vocabFN)
 {
     string vsz, sid;
     ifstream f(vocabFN, ios::in);
@@ -44,48 +71,277 @@ void Vocab::Load(const string& vocabFN)
 
     /* get the vocab size and the start id */
     f >> vsz >> sid;
-    sosID = (int)stol(sid);
+    startID = (int)stol(sid);
+    sosID = startID;
     vocabSize = (int)stol(vsz);
 
+    vector<string> tokens(MAX(vocabSize, 0));
+
     string word, id;
-    for (int i = 0; i < vocabSize - sosID; i++) {
-        f >> word >> id;
-        token2id[word] = (int)stol(id);
-        id2token[(int)stol(id)] = word;
-    }
-    for (int i = 0; i < sosID; i++) {
-        id2token[i] = "";
+    for (int i = 0; i < vocabSize - startID; i++) {
+        if (!(f >> word >> id))
+            break;
+        int wordID = (int)stol(id);
+        CheckNTErrors(wordID >= 0, "Invalid token id in the vocabulary file");
+        if (wordID >= (int)tokens.size())
+            tokens.resize(wordID + 1);
+        tokens[wordID] = word;
     }
 
     f.close();
+
+    /* put the tokens into the pool (the reserved ids have empty tokens) */
+    size_t poolSize = 0;
+    for (size_t i = 0; i < tokens.size(); i++)
+        poolSize += tokens[i].size();
+
+    tokenPool.clear();
+    tokenPool.reserve(poolSize);
+    offsets.resize(tokens.size() + 1);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        offsets[i] = (int)tokenPool.size();
+        tokenPool.insert(tokenPool.end(), tokens[i].begin(), tokens[i].end());
+    }
+    offsets[tokens.size()] = (int)tokenPool.size();
+
+    BuildTable();
 }
 
-/* save a vocabulary to a file */
+/* 
+load a vocabulary in the binary format
+>> file - the file (at the beginning)
+*/
+void Vocab::LoadBinary(FILE* file)
+{
+    VocabFileHeader header;
+    CheckNTErrors(fread(&header, sizeof(header), 1, file) == 1, "Incomplete vocabulary file!");
+    CheckNTErrors(header.version <= VOCAB_FILE_VERSION, "The vocabulary file is of a newer version!");
+    CheckNTErrors(header.idNum >= 0 && header.slotNum > 0 &&
+                  (header.slotNum & (header.slotNum - 1)) == 0 && header.slotNum > header.idNum,
+                  "Invalid vocabulary file!");
+
+    vocabSize = header.vocabSize;
+    startID = header.startID;
+    sosID = startID;
+
+    offsets.resize(header.idNum + 1);
+    slots.resize(header.slotNum);
+    tokenPool.resize(header.poolSize);
+
+    CheckNTErrors(fread(offsets.data(), sizeof(int), offsets.size(), file) == offsets.size() &&
+                  fread(slots.data(), sizeof(VocabSlot), slots.size(), file) == slots.size() &&
+                  fread(tokenPool.data(), 1, tokenPool.size(), file) == tokenPool.size(),
+                  "Incomplete vocabulary file!");
+
+    for (int i = 0; i < header.idNum; i++)
+        CheckNTErrors(offsets[i] >= 0 && offsets[i] <= offsets[i + 1], "Invalid vocabulary file!");
+    CheckNTErrors(offsets[0] == 0 && (MTYPE)offsets[header.idNum] == header.poolSize,
+                  "Invalid vocabulary file!");
+
+    /* the ids in the table are unique, and there must be an empty slot (-1)
+       to end the probing in FindID() */
+    vector<bool> used(header.idNum, false);
+    int emptyNum = 0;
+    for (int i = 0; i < header.slotNum; i++) {
+        int id = slots[i].id;
+        CheckNTErrors(id >= -1 && id < header.idNum, "Invalid vocabulary file!");
+        if (id < 0) {
+            emptyNum++;
+            continue;
+        }
+        CheckNTErrors(!used[id], "Invalid vocabulary file!");
+        used[id] = true;
+    }
+    CheckNTErrors(emptyNum > 0, "Invalid vocabulary file!");
+}
+
+/* 
+save a vocabulary to a file in the text format
+>> vocabFN - name of the file
+*/
 void Vocab::Save(const string& vocabFN)
 {
     ofstream f(vocabFN, ios::out);
+    CheckNTErrors(f.is_open(), "Cannot open the vocabulary file!");
 
     /* the first line: size of the vocab and the start id */
-    f << vocabSize << "\t" << sosID;
+    f << vocabSize << "\t" << startID << "\n";
 
     /* other lines: words and indices */
-    for (const auto& p : token2id)
-        f << p.first << "\t" << p.second;
+    for (int i = 0; i + 1 < (int)offsets.size(); i++) {
+        int length = offsets[i + 1] - offsets[i];
+        if (length == 0)
+            continue;
+        f.write(tokenPool.data() + offsets[i], length);
+        f << "\t" << i << "\n";
+    }
 
     f.close();
 }
 
+/* 
+save a vocabulary to a file in the binary format
+>> vocabFN - name of the file
+*/
+void Vocab::SaveBinary(const string& vocabFN)
+{
+    FILE* file = fopen(vocabFN.c_str(), "wb");
+    CheckNTErrors(file, "Cannot open the vocabulary file!");
+
+    VocabFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VOCAB_FILE_MAGIC, sizeof(header.magic));
+    header.version = VOCAB_FILE_VERSION;
+    header.vocabSize = vocabSize;
+    header.startID = startID;
+    header.idNum = (int)offsets.size() - 1;
+    header.slotNum = (int)slots.size();
+    header.poolSize = tokenPool.size();
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(offsets.data(), sizeof(int), offsets.size(), file);
+    fwrite(slots.data(), sizeof(VocabSlot), slots.size(), file);
+    fwrite(tokenPool.data(), 1, tokenPool.size(), file);
+
+    CheckNTErrors(fclose(file) == 0, "Failed to write the vocabulary file!");
+}
+
 /*
 copy data from another vocabulary
 >> v - the target vocabulary
 */
 void Vocab::CopyFrom(const Vocab& v)
 {
-    for (const auto& w2i : v.token2id)
-        token2id.insert(w2i);
+    vocabSize = v.vocabSize;
+    startID = v.startID;
+    tokenPool = v.tokenPool;
+    offsets = v.offsets;
+    slots = v.slots;
+}
+
+/*
+build the token table from the pool. The table has at least twice as
+many entries as the ids, and the token of a later id replaces the same
+token of an earlier id.
+*/
+void Vocab::BuildTable()
+{
+    int idNum = (int)offsets.size() - 1;
+
+    size_t slotNum = 16;
+    while (slotNum < (size_t)idNum * 2)
+        slotNum *= 2;
+
+    VocabSlot empty;
+    empty.hash = 0;
+    empty.id = -1;
+    slots.assign(slotNum, empty);
+
+    for (int id = 0; id < idNum; id++) {
+        int length = offsets[id + 1] - offsets[id];
+        if (length == 0)
+            continue;
+
+        const char* token = tokenPool.data() + offsets[id];
+        unsigned int h = Hash(token, length);
+        size_t i = h & (slotNum - 1);
+        while (slots[i].id >= 0) {
+            const VocabSlot& slot = slots[i];
+            if (slot.hash == h && offsets[slot.id + 1] - offsets[slot.id] == length &&
+                memcmp(tokenPool.data() + offsets[slot.id], token, length) == 0)
+                break;
+            i = (i + 1) & (slotNum - 1);
+        }
+
+        slots[i].hash = h;
+        slots[i].id = id;
+    }
+}
+
+/*
+get the id of a token
+>> token - the beginning of the token
+>> length - length of the token
+<< return - id of the token (unkID if it is not in the vocabulary)
+*/
+int Vocab::GetID(const char* token, int length) const
+{
+    int id = FindID(token, length);
+    return id >= 0 ? id : unkID;
+}
+
+/*
+find the id of a token
+>> token - the beginning of the token
+>> length - length of the token
+<< return - id of the token (-1 if it is not in the vocabulary)
+*/
+int Vocab::FindID(const char* token, int length) const
+{
+    if (slots.empty())
+        return -1;
 
-    for (const auto& i2w : v.id2token)
-        id2token.insert(i2w);
+    size_t mask = slots.size() - 1;
+    unsigned int h = Hash(token, length);
+    for (size_t i = h & mask; slots[i].id >= 0; i = (i + 1) & mask) {
+        const VocabSlot& slot = slots[i];
+        if (slot.hash == h && offsets[slot.id + 1] - offsets[slot.id] == length &&
+            memcmp(tokenPool.data() + offsets[slot.id], token, length) == 0)
+            return slot.id;
+    }
+
+    return -1;
+}
+
+/*
+find the id of a token
+>> token - the token
+<< return - id of the token (-1 if it is not in the vocabulary)
+*/
+int Vocab::FindID(const string& token) const
+{
+    return FindID(token.data(), (int)token.size());
+}
+
+/*
+get the token of an id (it is not ended with '\0')
+>> id - the id
+>> length - length of the token (for return)
+<< return - the beginning of the token
+*/
+const char* Vocab::GetToken(int id, int& length) const
+{
+    CheckNTErrors(id >= 0 && id + 1 < (int)offsets.size(), "Invalid token id!");
+
+    length = offsets[id + 1] - offsets[id];
+    return tokenPool.data() + offsets[id];
+}
+
+/*
+get the token of an id
+>> id - the id
+<< return - the token
+*/
+string Vocab::GetToken(int id) const
+{
+    int length;
+    const char* token = GetToken(id, length);
+    return string(token, length);
+}
+
+/*
+the FNV-1a hash of a token
+>> token - the beginning of the token
+>> length - length of the token
+*/
+unsigned int Vocab::Hash(const char* token, int length)
+{
+    unsigned int h = 2166136261U;
+    for (int i = 0; i < length; i++) {
+        h ^= (unsigned char)token[i];
+        h *= 16777619U;
+    }
+    return h;
 }
 
 /* constructor */
@@ -96,6 +352,7 @@ Vocab::Vocab()
     padID = -1;
     unkID = -1;
     vocabSize = -1;
+    startID = 0;
 }
 
 } /* end of the nmt namespace */
@@ -23,14 +23,65 @@
 #define __VOCAB_H__
 
 #include <cstdio>
-#include <unordered_map>
+#include <string>
+#include <vector>
+#include "../../niutensor/tensor/XMem.h"
 
 using namespace std;
+using namespace nts;
 
 /* the nmt namespace */
 namespace nmt {
 
-/* the vocabulary class */
+#define VOCAB_FILE_MAGIC "NIUVOCAB"
+#define VOCAB_FILE_VERSION 1
+
+/* the header of a vocabulary in the binary format (40 bytes) */
+struct VocabFileHeader
+{
+    /* the magic number, i.e., VOCAB_FILE_MAGIC */
+    char magic[8];
+
+    /* version of the format */
+    int version;
+
+    /* size of the vocabulary */
+    int vocabSize;
+
+    /* the first id of the tokens (the ids below are reserved) */
+    int startID;
+
+    /* number of ids in the offset array */
+    int idNum;
+
+    /* number of entries of the token table (a power of two) */
+    int slotNum;
+
+    /* reserved */
+    int reserved;
+
+    /* size of the token pool (in bytes) */
+    MTYPE poolSize;
+};
+
+/* an entry of the token table */
+struct VocabSlot
+{
+    /* hash of the token */
+    unsigned int hash;
+
+    /* id of the token (-1 for an empty entry) */
+    int id;
+};
+
+/* 
+the vocabulary class. The tokens are kept in one pool in the order of 
+their ids, so that the token of an id is found by the offset array, and
+the id of a token is found by the token table (open addressing). A
+vocabulary is either in the text format, i.e., the size and the start id
+followed by a token and its id in each line, or in the binary format,
+i.e., the header, the offset array, the token table and the token pool.
+*/
 struct Vocab
 {
     /* id of start-of-sequence token */
@@ -48,26 +99,64 @@ struct Vocab
     /* size of the vocabulary */
     int vocabSize;
 
-    /* a dict that maps tokens to ids */
-    unordered_map<string, int> token2id;
+    /* the first id of the tokens in the vocabulary file */
+    int startID;
+
+    /* the tokens (in the order of their ids) */
+    vector<char> tokenPool;
+
+    /* offset of the token of each id in the pool (the token of id i is
+       [offsets[i], offsets[i + 1])) */
+    vector<int> offsets;
 
-    /* a dict that maps ids to words */
-    unordered_map<int, string> id2token;
+    /* the token table */
+    vector<VocabSlot> slots;
 
     /* set ids for special tokens */
     void SetSpecialID(int sos, int eos, int pad, int unk);
 
-    /* load a vocabulary from a file */
+    /* load a vocabulary from a file (in the text or binary format) */
     void Load(const string& vocabFN);
 
-    /* save a vocabulary to a file */
+    /* save a vocabulary to a file in the text format */
     void Save(const string& vocabFN);
 
+    /* save a vocabulary to a file in the binary format */
+    void SaveBinary(const string& vocabFN);
+
     /* copy data from another vocab */
     void CopyFrom(const Vocab& v);
 
+    /* get the id of a token (unkID if it is not in the vocabulary) */
+    int GetID(const char* token, int length) const;
+
+    /* find the id of a token (-1 if it is not in the vocabulary) */
+    int FindID(const char* token, int length) const;
+
+    /* find the id of a token (-1 if it is not in the vocabulary) */
+    int FindID(const string& token) const;
+
+    /* get the token of an id */
+    const char* GetToken(int id, int& length) const;
+
+    /* get the token of an id */
+    string GetToken(int id) const;
+
+    /* the hash of a token */
+    static unsigned int Hash(const char* token, int length);
+
     /* constructor */
     Vocab();
+
+private:
+    /* load a vocabulary in the text format */
+    void LoadText(const string& vocabFN);
+
+    /* load a vocabulary in the binary format */
+    void LoadBinary(FILE* file);
+
+    /* build the token table from the pool */
+    void BuildTable();
 };
 
 } /* end of the nmt namespace */
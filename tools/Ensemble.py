@@ -10,6 +10,7 @@ import numpy as np
 from glob import glob
 from struct import pack
 from struct import unpack
+from ModelFile import META_SIZE, is_model_file, read_model, write_model
 
 parser = argparse.ArgumentParser(
     description='A model ensemble tool for NiuTrans.NMT')
@@ -24,10 +25,21 @@ model_files = glob(args.i)
 meta_info = None
 parameters = []
 
+# models in the container format are averaged tensor by tensor
+if all(is_model_file(file) for file in model_files):
+    models = [read_model(file) for file in model_files]
+    meta_info = models[0][0]
+    tensors = []
+    for i, (name, value) in enumerate(models[0][1]):
+        values = np.mean(np.array([m[1][i][1] for m in models]), axis=0)
+        tensors.append((name, values.astype(value.dtype)))
+    write_model(args.o, meta_info, tensors)
+    print("Model ensemble finished")
+    exit(0)
+
 for file in model_files:
     with open(file, "rb") as f:
-        # meta infomation includes 11 booleans and 18 integers, detailed in Model.cpp:InitModel()
-        meta_info = f.read(11 * 1 + 18 * 4)
+        meta_info = f.read(META_SIZE)
         data = f.read()
         values = unpack('f' * (len(data) // 4), data)
         print("Loaded {} parameters from: {}".format(len(values), file))
@@ -9,6 +9,7 @@ import numpy as np
 from glob import glob
 from struct import pack
 from struct import unpack
+from ModelFile import META_SIZE, is_model_file, read_model, write_model
 
 parser = argparse.ArgumentParser(
     description='The format converter for NiuTrans.NMT (FP32 <-> FP16)')
@@ -22,6 +23,16 @@ args = parser.parse_args()
 args.format = args.format.lower()
 
 
+# models in the container format keep the data type of each tensor
+if is_model_file(args.i):
+    meta_info, tensors = read_model(args.i)
+    target = np.float32 if args.format == 'fp32' else np.float16
+    tensors = [(name, value.astype(target) if value.dtype in [np.float32, np.float16] else value)
+               for name, value in tensors]
+    write_model(args.o, meta_info, tensors)
+    print("Converted {} tensors from: {}".format(len(tensors), args.i))
+    exit(0)
+
 if args.format == 'fp32':
     PARAM_LEN = 2
 elif args.format == 'fp16':
@@ -31,8 +42,7 @@ else:
 
 with open(args.i, "rb") as f:
 
-    # meta infomation includes 11 booleans and 18 integers, detailed in Model.cpp:InitModel()
-    meta_info = f.read(11 * 1 + 18 * 4)
+    meta_info = f.read(META_SIZE)
     data = f.read()
     if args.format == 'fp32':
         values = unpack('e' * (len(data) // PARAM_LEN), data)
@@ -0,0 +1,120 @@
+'''
+Read and write NiuTrans.NMT model files.
+A model file is either in the (legacy) raw format, i.e., configurations followed by
+a flat stream of parameters, or in the container format (see XModelFile.h):
+    header | meta data (configurations) | tensor index | aligned tensors
+'''
+
+import zlib
+import numpy as np
+from struct import calcsize, pack, unpack_from
+
+MAGIC = b'NIUMODEL'
+VERSION = 1
+ALIGNMENT = 64
+NAME_SIZE = 64
+MAX_DIM_NUM = 8
+
+# meta infomation includes 11 booleans and 18 integers, detailed in Model.cpp:InitModel()
+META_SIZE = 11 * 1 + 18 * 4
+
+# header: magic, version, tensorNum, alignment, entrySize, metaOffset, metaSize,
+# indexOffset, dataOffset, dataSize, metaChecksum, indexChecksum, headerChecksum, reserved
+HEADER_FORMAT = '<8siiiiQQQQQIIII'
+HEADER_SIZE = calcsize(HEADER_FORMAT)
+HEADER_CHECKED_SIZE = HEADER_SIZE - 8
+
+# entry: name, dataType, order, dimSize, offset, size, checksum, reserved
+ENTRY_FORMAT = '<{}sii{}iQQII'.format(NAME_SIZE, MAX_DIM_NUM)
+ENTRY_SIZE = calcsize(ENTRY_FORMAT)
+
+# TENSOR_DATA_TYPE in XDataType.h
+DTYPES = {0: np.int32, 1: np.int8, 2: np.float32, 3: np.float16, 4: np.float64}
+DTYPE_IDS = {np.dtype(v): k for k, v in DTYPES.items()}
+
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def is_model_file(path):
+    with open(path, 'rb') as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+def read_model(path):
+    """
+    Read a model file in the container format
+    Args:
+        path - path of the model file
+    Return:
+        meta - the meta data (bytes)
+        tensors - a list of (name, array) where the arrays are of the stored shapes and data types
+    """
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    header = unpack_from(HEADER_FORMAT, data, 0)
+    (magic, version, tensor_num, alignment, entry_size, meta_offset, meta_size,
+     index_offset, data_offset, data_size, meta_checksum, index_checksum, header_checksum, _) = header
+    assert magic == MAGIC, 'not a model file: {}'.format(path)
+    assert version <= VERSION, 'the model file is of a newer version'
+    assert entry_size == ENTRY_SIZE, 'unknown layout of the model file'
+    assert header_checksum == zlib.crc32(data[:HEADER_CHECKED_SIZE]), 'the header is corrupted'
+
+    meta = data[meta_offset:meta_offset + meta_size]
+    index = data[index_offset:index_offset + tensor_num * ENTRY_SIZE]
+    assert meta_checksum == zlib.crc32(meta), 'the meta data is corrupted'
+    assert index_checksum == zlib.crc32(index), 'the tensor index is corrupted'
+
+    tensors = []
+    for i in range(tensor_num):
+        entry = unpack_from(ENTRY_FORMAT, index, i * ENTRY_SIZE)
+        name = entry[0].split(b'\0', 1)[0].decode()
+        dtype, order = entry[1], entry[2]
+        shape = entry[3:3 + order]
+        offset, size, checksum = entry[3 + MAX_DIM_NUM:6 + MAX_DIM_NUM]
+        block = data[offset:offset + size]
+        assert checksum == zlib.crc32(block), 'tensor {} is corrupted'.format(name)
+        tensors.append((name, np.frombuffer(block, dtype=DTYPES[dtype]).reshape(shape)))
+
+    return meta, tensors
+
+
+def write_model(path, meta, tensors):
+    """
+    Write a model file in the container format
+    Args:
+        path - path of the model file
+        meta - the meta data (bytes)
+        tensors - a list of (name, array)
+    """
+    meta_offset = align(HEADER_SIZE)
+    index_offset = align(meta_offset + len(meta))
+    data_offset = align(index_offset + len(tensors) * ENTRY_SIZE)
+
+    index = b''
+    blocks = []
+    offset = data_offset
+    for i, (name, array) in enumerate(tensors):
+        block = np.ascontiguousarray(array).tobytes()
+        dims = list(array.shape) + [0] * (MAX_DIM_NUM - array.ndim)
+        index += pack(ENTRY_FORMAT, name.encode()[:NAME_SIZE - 1], DTYPE_IDS[array.dtype], array.ndim,
+                      *dims, offset, len(block), zlib.crc32(block), 0)
+        blocks.append((offset, block))
+        offset = align(offset + len(block)) if i < len(tensors) - 1 else offset + len(block)
+
+    header = pack(HEADER_FORMAT, MAGIC, VERSION, len(tensors), ALIGNMENT, ENTRY_SIZE,
+                  meta_offset, len(meta), index_offset, data_offset, offset - data_offset,
+                  zlib.crc32(meta), zlib.crc32(index), 0, 0)
+    header = header[:HEADER_CHECKED_SIZE] + pack('<II', zlib.crc32(header[:HEADER_CHECKED_SIZE]), 0)
+
+    with open(path, 'wb') as f:
+        f.write(header)
+        f.seek(meta_offset)
+        f.write(meta)
+        f.seek(index_offset)
+        f.write(index)
+        for offset, block in blocks:
+            f.seek(offset)
+            f.write(block)
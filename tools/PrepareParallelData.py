@@ -2,7 +2,7 @@
 Binarize the training data for NiuTrans.NMT
 Help: python3 PrepareParallelData.py -h
 
-Training data format (binary):
+Training data format (binary, raw):
 1. first 16 bits: source & target vocabulary size
 2. second 8 bits: number of sentence pairs
 3. subsequent segements:
@@ -10,10 +10,18 @@ source sentence length (4 bits)
 target sentence length (4 bits)
 source tokens (4 bits per token)
 target tokens (4 bits per token)
+
+Training data format (binary, corpus, see source/nmt/train/Corpus.h):
+1. header (64 bytes): magic, version, vocabulary sizes, user-defined tokens,
+   number of sentence pairs, offset of the tokens, offset of the length index
+2. tokens: source tokens and target tokens of each sentence pair
+3. length index: offset (in tokens, 8 bytes), source and target length
+   (4 bytes each) of each sentence pair
+With -shardsize, the pairs are written to the shards <output>.0, <output>.1, ...
 '''
 
 import argparse
-from struct import pack
+from struct import pack, calcsize
 
 # User defined words
 PAD = 1
@@ -37,8 +45,16 @@ parser.add_argument(
     '-tv', help='Path to the target language vocab file', type=str, default='')
 parser.add_argument('-output', help='Path to the binarized training file',
                     type=str, required=True, default='')
+parser.add_argument('-format', help='Format of the binarized training file, default: raw',
+                    type=str, choices=['raw', 'corpus'], default='raw')
+parser.add_argument(
+    '-shardsize', help='The maximum number of sentence pairs in a shard (corpus format only), default: 0 (no sharding)', type=int, default=0)
 args = parser.parse_args()
 
+CORPUS_MAGIC = b'NIUCORPS'
+CORPUS_VERSION = 1
+CORPUS_HEADER_FORMAT = '<8si2i4iiQQQ'
+
 sv = dict()
 tv = dict()
 cut_num = 0
@@ -70,27 +86,103 @@ if (not isinstance(tv_size, int)) or (sv_size <= 0):
     raise ValueError("Invalid target vocabulary size")
 
 
-with open(args.src, 'r', encoding='utf8') as fs:
-    with open(args.tgt, 'r', encoding='utf8') as ft:
-        src_sentences, tgt_sentences = list(), list()
-        for ls in fs:
-            ls = ls.split()
-            lt = ft.readline().split()
-
-            # limit the source/target sequence length
-            if len(ls) >= args.maxsrc:
-                cut_num += 1
-                ls = ls[:args.maxsrc - 1]
-            if len(lt) >= args.maxtgt:
-                cut_num += 1
-                lt = lt[:args.maxtgt - 1]
 
-            # append EOS to the begin of source sequence
-            src_sent = [get_id(sv, w) for w in ls] + [EOS]
+class CorpusWriter:
+    """
+    Write sentence pairs to shards in the corpus format. The tokens are
+    written as they come, and the length index is written at the end.
+    """
+
+    def __init__(self, output, shard_size, sv_size, tv_size):
+        self.output = output
+        self.shard_size = shard_size
+        self.vocab_size = [sv_size, tv_size]
+        self.shard_id = 0
+        self.fo = None
+
+    def open_shard(self):
+        name = self.output
+        if self.shard_size > 0:
+            name = '{}.{}'.format(self.output, self.shard_id)
+        self.shard_id += 1
+        self.fo = open(name, 'wb')
+        self.fo.write(bytes(calcsize(CORPUS_HEADER_FORMAT)))
+        self.index = list()
+        self.token_num = 0
+
+    def close_shard(self):
+        if self.fo is None:
+            return
+        data_offset = calcsize(CORPUS_HEADER_FORMAT)
+        index_offset = data_offset + self.token_num * 4
+        for offset, src_len, tgt_len in self.index:
+            self.fo.write(pack('<Qii', offset, src_len, tgt_len))
+        self.fo.seek(0)
+        self.fo.write(pack(CORPUS_HEADER_FORMAT, CORPUS_MAGIC, CORPUS_VERSION,
+                           *self.vocab_size, PAD, SOS, EOS, UNK, 0,
+                           len(self.index), data_offset, index_offset))
+        self.fo.close()
+        self.fo = None
+
+    def add(self, src_sent, tgt_sent):
+        if self.fo is None:
+            self.open_shard()
+        self.index.append((self.token_num, len(src_sent), len(tgt_sent)))
+        self.fo.write(pack('<' + 'i' * len(src_sent), *src_sent))
+        self.fo.write(pack('<' + 'i' * len(tgt_sent), *tgt_sent))
+        self.token_num += len(src_sent) + len(tgt_sent)
+        if self.shard_size > 0 and len(self.index) >= self.shard_size:
+            self.close_shard()
+
+
+def read_pairs(fs, ft):
+    """
+    Read sentence pairs and map them to token ids
+    """
+    global cut_num
+    for ls in fs:
+        ls = ls.split()
+        lt = ft.readline().split()
+
+        # limit the source/target sequence length
+        if len(ls) >= args.maxsrc:
+            cut_num += 1
+            ls = ls[:args.maxsrc - 1]
+        if len(lt) >= args.maxtgt:
+            cut_num += 1
+            lt = lt[:args.maxtgt - 1]
+
+        # append EOS to the begin of source sequence
+        src_sent = [get_id(sv, w) for w in ls] + [EOS]
+
+        # append SOS to the end of target sequence
+        tgt_sent = [SOS] + [get_id(tv, w, False) for w in lt]
+
+        yield src_sent, tgt_sent
+
+
+if args.format == 'corpus':
+    # the pairs are written as they are read, so that the memory does not grow with the corpus
+    with open(args.src, 'r', encoding='utf8') as fs:
+        with open(args.tgt, 'r', encoding='utf8') as ft:
+            writer = CorpusWriter(args.output, args.shardsize, sv_size, tv_size)
+            pair_num, src_tokens, tgt_tokens = 0, 0, 0
+            for src_sent, tgt_sent in read_pairs(fs, ft):
+                writer.add(src_sent, tgt_sent)
+                pair_num += 1
+                src_tokens += len(src_sent) - 1
+                tgt_tokens += len(tgt_sent) - 1
+            writer.close_shard()
+            print("{}: {} sents, {} tokens".format(args.src, pair_num, src_tokens))
+            print("{}: {} sents, {} tokens".format(args.tgt, pair_num, tgt_tokens))
+            print("{} shard(s) written".format(writer.shard_id))
+    exit(0)
 
-            # append SOS to the end of target sequence
-            tgt_sent = [SOS] + [get_id(tv, w, False) for w in lt]
 
+with open(args.src, 'r', encoding='utf8') as fs:
+    with open(args.tgt, 'r', encoding='utf8') as ft:
+        src_sentences, tgt_sentences = list(), list()
+        for src_sent, tgt_sent in read_pairs(fs, ft):
             src_sentences.append(src_sent)
             tgt_sentences.append(tgt_sent)
 
@@ -0,0 +1,129 @@
+'''
+Read and write NiuTrans.NMT vocabularies, and convert them between the formats.
+A vocabulary is either in the text format, i.e., the vocabulary size and the start id
+in the first line, followed by a token and its id in each line, or in the binary format
+(see source/nmt/translate/Vocab.h):
+    header | offset array | token table | token pool
+Usage: python3 VocabFile.py -i [vocab] -o [new_vocab] -format [binary|text]
+'''
+
+import argparse
+from struct import calcsize, pack, unpack_from
+
+MAGIC = b'NIUVOCAB'
+VERSION = 1
+
+# header: magic, version, vocabSize, startID, idNum, slotNum, reserved, poolSize
+HEADER_FORMAT = '<8siiiiiiQ'
+HEADER_SIZE = calcsize(HEADER_FORMAT)
+
+# entry of the token table: hash, id (-1 for an empty entry)
+SLOT_FORMAT = '<Ii'
+
+
+def is_binary_vocab(path):
+    with open(path, 'rb') as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+def token_hash(token):
+    """
+    The FNV-1a hash of a token (as in Vocab::Hash)
+    """
+    h = 2166136261
+    for b in token:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def read_vocab(path):
+    """
+    Read a vocabulary in either format
+    Args:
+        path - path of the vocabulary
+    Return:
+        vocab_size - size of the vocabulary
+        start_id - the first id of the tokens
+        tokens - a list of tokens (bytes) indexed by id, the reserved ids have empty tokens
+    """
+    if is_binary_vocab(path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        magic, version, vocab_size, start_id, id_num, slot_num, _, pool_size = \
+            unpack_from(HEADER_FORMAT, data, 0)
+        assert version <= VERSION, 'the vocabulary file is of a newer version: {}'.format(path)
+        offsets = unpack_from('<{}i'.format(id_num + 1), data, HEADER_SIZE)
+        pool_offset = HEADER_SIZE + 4 * (id_num + 1) + calcsize(SLOT_FORMAT) * slot_num
+        pool = data[pool_offset:pool_offset + pool_size]
+        tokens = [pool[offsets[i]:offsets[i + 1]] for i in range(id_num)]
+        return vocab_size, start_id, tokens
+
+    with open(path, 'rb') as f:
+        fields = f.read().split()
+    vocab_size, start_id = int(fields[0]), int(fields[1])
+    tokens = [b''] * vocab_size
+    for i in range(2, min(len(fields) - 1, 2 * (vocab_size - start_id) + 2), 2):
+        token_id = int(fields[i + 1])
+        if token_id >= len(tokens):
+            tokens.extend([b''] * (token_id + 1 - len(tokens)))
+        tokens[token_id] = fields[i]
+    return vocab_size, start_id, tokens
+
+
+def write_text_vocab(path, vocab_size, start_id, tokens):
+    with open(path, 'wb') as f:
+        f.write('{}\t{}\n'.format(vocab_size, start_id).encode())
+        for i, token in enumerate(tokens):
+            if len(token) > 0:
+                f.write(token + '\t{}\n'.format(i).encode())
+
+
+def write_binary_vocab(path, vocab_size, start_id, tokens):
+    """
+    Write a vocabulary in the binary format. The token table is built as in
+    Vocab::BuildTable(), i.e., linear probing over at least twice as many
+    entries as the ids, and the token of a later id replaces the same token.
+    """
+    offsets = [0]
+    for token in tokens:
+        offsets.append(offsets[-1] + len(token))
+
+    slot_num = 16
+    while slot_num < len(tokens) * 2:
+        slot_num *= 2
+    slots = [(0, -1)] * slot_num
+    for token_id, token in enumerate(tokens):
+        if len(token) == 0:
+            continue
+        h = token_hash(token)
+        i = h & (slot_num - 1)
+        while slots[i][1] >= 0 and not (slots[i][0] == h and tokens[slots[i][1]] == token):
+            i = (i + 1) & (slot_num - 1)
+        slots[i] = (h, token_id)
+
+    with open(path, 'wb') as f:
+        f.write(pack(HEADER_FORMAT, MAGIC, VERSION, vocab_size, start_id,
+                     len(tokens), slot_num, 0, offsets[-1]))
+        f.write(pack('<{}i'.format(len(offsets)), *offsets))
+        for h, token_id in slots:
+            f.write(pack(SLOT_FORMAT, h, token_id))
+        f.write(b''.join(tokens))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Convert a NiuTrans.NMT vocabulary between the text and binary formats')
+    parser.add_argument(
+        '-i', help='Path of the vocabulary (in either format)', type=str, required=True)
+    parser.add_argument(
+        '-o', help='Path of the vocabulary to be saved', type=str, required=True)
+    parser.add_argument('-format', help='Format of the saved vocabulary, default: binary',
+                        type=str, choices=['binary', 'text'], default='binary')
+    args = parser.parse_args()
+
+    vocab_size, start_id, tokens = read_vocab(args.i)
+    if args.format == 'binary':
+        write_binary_vocab(args.o, vocab_size, start_id, tokens)
+    else:
+        write_text_vocab(args.o, vocab_size, start_id, tokens)
+    print("Converted {} tokens from: {}".format(sum(1 for t in tokens if len(t) > 0), args.i))